@@ -49,6 +49,7 @@
 #include "qdeclarativeroutemapitem_p.h"
 #include "qdeclarativepolylinemapitem_p.h"
 #include "qdeclarativepolygonmapitem_p.h"
+#include "qdeclarativemarkerlayermapitem_p.h"
 
 //Place includes
 #include "qdeclarativecategory_p.h"
@@ -157,6 +158,10 @@ public:
             qmlRegisterUncreatableType<QQuickGeoMapGestureArea, 1>(uri, major, minor, "MapGestureArea",
                                         QStringLiteral("(Map)GestureArea is not intended instantiable by developer."));
 
+            // Register the 5.7 types
+            minor = 7;
+            qmlRegisterType<QDeclarativeMarkerLayerMapItem          >(uri, major, minor, "MapMarkerLayer");
+
 
             //registrations below are version independent
             qRegisterMetaType<QPlaceCategory>();
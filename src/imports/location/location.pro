@@ -23,6 +23,7 @@ HEADERS += \
            qdeclarativepolygonmapitem_p.h \
            qdeclarativepolylinemapitem_p.h \
            qdeclarativeroutemapitem_p.h \
+           qdeclarativemarkerlayermapitem_p.h \
            qgeomapitemgeometry_p.h \
            qdeclarativegeomapcopyrightsnotice_p.h \
            error_messages.h \
@@ -49,6 +50,7 @@ SOURCES += \
            qdeclarativepolygonmapitem.cpp \
            qdeclarativepolylinemapitem.cpp \
            qdeclarativeroutemapitem.cpp \
+           qdeclarativemarkerlayermapitem.cpp \
            qgeomapitemgeometry.cpp \
            qdeclarativegeomapcopyrightsnotice.cpp \
            error_messages.cpp \
@@ -89,9 +89,12 @@ QT_BEGIN_NAMESPACE
 
     \section2 Performance
 
-    MapCircle performance is almost equivalent to that of a MapPolygon with
-    125 vertices. There is a small amount of additional overhead with
-    respect to calculating the vertices first.
+    MapCircle picks the number of vertices from its size on screen, so small
+    circles are cheaper to draw than large ones. As long as a circle does not
+    cover a pole or cross the 180th meridian, it is drawn directly as a fan
+    of triangles around its center. Such circles can be moved around or
+    resized at a much lower cost than a MapPolygon. Other circles are drawn
+    like a MapPolygon with 125 vertices.
 
     Like the other map objects, MapCircle is normally drawn without a smooth
     appearance. Setting the opacity property will force the object to be
@@ -131,6 +134,7 @@ struct Vertex
 };
 
 QGeoMapCircleGeometry::QGeoMapCircleGeometry()
+:   rimRadius_(0), rimSegments_(0), rimPathValid_(false), rimWestIndex_(0)
 {
 }
 
@@ -149,7 +153,7 @@ void QGeoMapCircleGeometry::updateScreenPointsInvert(const QGeoMap &map)
 
     QPointF origin = map.coordinateToItemPosition(srcOrigin_, false).toPointF();
 
-    QPainterPath ppi = srcPath_;
+    QPainterPath ppi = assumeSimple_ ? srcPath_ : srcPath_.simplified();
 
     clear();
 
@@ -295,6 +299,207 @@ static void calculatePeripheralPoints(QList<QGeoCoordinate> &path, const QGeoCoo
     }
 }
 
+// the rim of an analytic circle takes every 2^k-th entry of this table
+static const int RIM_TABLE_SIZE = 1024;
+static const int MIN_RIM_SEGMENTS = 16;
+
+// how far the chords of the rim may cut into the circle, in pixels
+static const double RIM_TOLERANCE = 0.25;
+
+// larger circles are clipped to the viewport through the polygon geometry
+// rather than drawn as a fan of triangles with far off-screen vertices
+static const double MAX_FAN_EXTENT = 1 << 16;
+
+struct UnitCircleTable
+{
+    UnitCircleTable()
+    {
+        for (int i = 0; i < RIM_TABLE_SIZE; ++i) {
+            sine[i] = std::sin(2 * M_PI * i / RIM_TABLE_SIZE);
+            cosine[i] = std::cos(2 * M_PI * i / RIM_TABLE_SIZE);
+        }
+    }
+
+    double sine[RIM_TABLE_SIZE];
+    double cosine[RIM_TABLE_SIZE];
+};
+
+Q_GLOBAL_STATIC(UnitCircleTable, unitCircleTable)
+
+/*
+    The fewest segments, as a power of two, that keep the sagitta of the
+    chords r * (1 - cos(pi / n)) within RIM_TOLERANCE.
+*/
+static int rimSegmentsForRadius(double screenRadius)
+{
+    const UnitCircleTable *table = unitCircleTable();
+    int segments = MIN_RIM_SEGMENTS;
+    while (segments < RIM_TABLE_SIZE
+           && screenRadius * (1.0 - table->cosine[RIM_TABLE_SIZE / (2 * segments)]) > RIM_TOLERANCE) {
+        segments *= 2;
+    }
+    return segments;
+}
+
+/*!
+    \internal
+    Builds the rim of the circle in mercator units relative to its center.
+    This is the same spherical model as calculatePeripheralPoints(), with
+    the azimuths taken from the unit circle table.
+*/
+void QGeoMapCircleGeometry::updateRim(const QGeoCoordinate &center, qreal radius, int segments)
+{
+    rimCenter_ = center;
+    rimRadius_ = radius;
+    rimSegments_ = segments;
+    rimPathValid_ = false;
+
+    const double latRad = qgeocoordinate_degToRad(center.latitude());
+    const double sinLat = std::sin(latRad);
+    const double cosLat = std::cos(latRad);
+    const double ratio = radius / (qgeocoordinate_EARTH_MEAN_RADIUS * 1000.0);
+    const double sinRatio = std::sin(ratio);
+    const double cosRatio = std::cos(ratio);
+    const double centerY = QGeoProjection::coordToMercator(center).y();
+
+    const UnitCircleTable *table = unitCircleTable();
+    const int stride = RIM_TABLE_SIZE / segments;
+
+    rimMercator_.resize(2 * segments);
+    rimGeo_.resize(2 * segments);
+    double *mercator = rimMercator_.data();
+    double *geo = rimGeo_.data();
+    double west = 0.0;
+    rimWestIndex_ = 0;
+    for (int i = 0; i < segments; ++i) {
+        const double sinAzimuth = table->sine[i * stride];
+        const double cosAzimuth = table->cosine[i * stride];
+        const double sinResultLat = sinLat * cosRatio + cosLat * sinRatio * cosAzimuth;
+        const double resultLatRad = std::asin(sinResultLat);
+        const double deltaLonRad = std::atan2(sinAzimuth * cosLat * sinRatio,
+                                              cosRatio - sinLat * sinResultLat);
+
+        mercator[2 * i] = deltaLonRad / (2 * M_PI);
+        mercator[2 * i + 1] = 0.5 - std::log(std::tan(M_PI / 4 + resultLatRad / 2)) / (2 * M_PI)
+                              - centerY;
+        geo[2 * i] = qgeocoordinate_radToDeg(resultLatRad);
+        geo[2 * i + 1] = center.longitude() + qgeocoordinate_radToDeg(deltaLonRad);
+
+        if (deltaLonRad < west) {
+            west = deltaLonRad;
+            rimWestIndex_ = i;
+        }
+    }
+}
+
+/*!
+    \internal
+    Lays the circle out on screen as a fan of triangles around its center,
+    without the triangulation and clipping of the polygon geometry. The rim
+    is only recomputed when the center, the radius or the number of segments
+    changes; panning just scales it.
+
+    Returns false, leaving the geometry alone, for circles that cover a pole,
+    cross the 180th meridian, are too large on screen, or when the map has no
+    mercator transform. Those go through the polygon geometry instead.
+*/
+bool QGeoMapCircleGeometry::updateCircle(const QGeoMap &map, const QGeoCoordinate &center, qreal radius)
+{
+    const QGeoMercatorTransform transform = map.mercatorTransform();
+    if (!transform.isValid() || map.width() == 0 || map.height() == 0
+            || !(radius > 0) || crossEarthPole(center, radius)) {
+        return false;
+    }
+
+    // a circle around neither pole is widest this far east and west of its center
+    const double ratio = radius / (qgeocoordinate_EARTH_MEAN_RADIUS * 1000.0);
+    const double cosLat = std::cos(qgeocoordinate_degToRad(center.latitude()));
+    const double halfWidth = qgeocoordinate_radToDeg(std::asin(qMin(1.0, std::sin(ratio) / cosLat)));
+    if (center.longitude() - halfWidth <= -180.0 || center.longitude() + halfWidth >= 180.0)
+        return false;
+
+    const int segments = rimSegmentsForRadius(transform.scaleX() * halfWidth / 360.0);
+    if (segments != rimSegments_ || radius != rimRadius_ || center != rimCenter_)
+        updateRim(center, radius, segments);
+
+    const double scaleX = transform.scaleX();
+    const double scaleY = transform.scaleY();
+    const double *rim = rimMercator_.constData();
+
+    // the center is at 0, 0 and inside the rim
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    for (int i = 0; i < segments; ++i) {
+        minX = qMin(minX, scaleX * rim[2 * i]);
+        maxX = qMax(maxX, scaleX * rim[2 * i]);
+        minY = qMin(minY, scaleY * rim[2 * i + 1]);
+        maxY = qMax(maxY, scaleY * rim[2 * i + 1]);
+    }
+    if (qMax(maxX - minX, maxY - minY) > MAX_FAN_EXTENT)
+        return false;
+
+    clear();
+
+    screenVertices_.resize(segments + 1);
+    QPointF *points = screenVertices_.data();
+    points[0] = QPointF(-minX, -minY);
+    QPainterPath outline;
+    for (int i = 0; i < segments; ++i) {
+        points[i + 1] = QPointF(scaleX * rim[2 * i] - minX, scaleY * rim[2 * i + 1] - minY);
+        if (i == 0)
+            outline.moveTo(points[i + 1]);
+        else
+            outline.lineTo(points[i + 1]);
+    }
+    outline.closeSubpath();
+
+    // the rim is star-shaped around the center, so a fan covers it exactly
+    screenIndices_.resize(3 * segments);
+    quint32 *indices = screenIndices_.data();
+    for (int i = 0; i < segments; ++i) {
+        indices[3 * i] = 0;
+        indices[3 * i + 1] = i + 1;
+        indices[3 * i + 2] = (i + 1) % segments + 1;
+    }
+
+    // the first rim point is the origin, as for the border drawn along rimPath()
+    srcOrigin_ = QGeoCoordinate(rimGeo_.at(0), rimGeo_.at(1), center.altitude());
+    firstPointOffset_ = points[1];
+    originToCenter_ = points[0] - points[1];
+    screenOutline_ = outline;
+    screenBounds_ = QRectF(0, 0, maxX - minX, maxY - minY);
+    sourceBounds_ = screenBounds_;
+    return true;
+}
+
+/*!
+    \internal
+    The closed rim of the last updateCircle(), for drawing the border.
+*/
+const QList<QGeoCoordinate> &QGeoMapCircleGeometry::rimPath()
+{
+    if (!rimPathValid_) {
+        rimPath_.clear();
+        rimPath_.reserve(rimSegments_ + 1);
+        for (int i = 0; i < rimSegments_; ++i)
+            rimPath_ << QGeoCoordinate(rimGeo_.at(2 * i), rimGeo_.at(2 * i + 1), rimCenter_.altitude());
+        if (!rimPath_.isEmpty())
+            rimPath_ << rimPath_.first();
+        rimPathValid_ = true;
+    }
+    return rimPath_;
+}
+
+/*!
+    \internal
+*/
+QGeoCoordinate QGeoMapCircleGeometry::rimLeftBound()
+{
+    return rimPath().at(rimWestIndex_);
+}
+
 QDeclarativeCircleMapItem::QDeclarativeCircleMapItem(QQuickItem *parent)
 :   QDeclarativeGeoMapItemBase(parent), color_(Qt::transparent), radius_(0), dirtyMaterial_(true),
     updatingGeometry_(false)
@@ -458,23 +663,35 @@ void QDeclarativeCircleMapItem::updatePolish()
     QScopedValueRollback<bool> rollback(updatingGeometry_);
     updatingGeometry_ = true;
 
-    if (geometry_.isSourceDirty()) {
+    bool preserve = true;
+    QGeoCoordinate leftBoundCoord;
+    const bool analytic = geometry_.updateCircle(*map(), center_, radius_);
+    if (analytic) {
         circlePath_.clear();
-        calculatePeripheralPoints(circlePath_, center_, radius_, 125);
-    }
+        leftBoundCoord = geometry_.rimLeftBound();
+    } else {
+        if (geometry_.isSourceDirty() || circlePath_.isEmpty()) {
+            circlePath_.clear();
+            calculatePeripheralPoints(circlePath_, center_, radius_, 125);
+        }
 
-    QGeoCoordinate leftBoundCoord;
-    int pathCount = circlePath_.size();
-    bool preserve = preserveCircleGeometry(circlePath_, center_, radius_, leftBoundCoord);
-    geometry_.setPreserveGeometry(preserve, leftBoundCoord);
-    geometry_.updateSourcePoints(*map(), circlePath_);
-    if (crossEarthPole(center_, radius_) && circlePath_.size() == pathCount)
-        geometry_.updateScreenPointsInvert(*map()); // invert fill area for really huge circles
-    else geometry_.updateScreenPoints(*map());
+        int pathCount = circlePath_.size();
+        preserve = preserveCircleGeometry(circlePath_, center_, radius_, leftBoundCoord);
+        geometry_.setPreserveGeometry(preserve, leftBoundCoord);
+        geometry_.updateSourcePoints(*map(), circlePath_);
+        if (crossEarthPole(center_, radius_) && circlePath_.size() == pathCount)
+            geometry_.updateScreenPointsInvert(*map()); // invert fill area for really huge circles
+        else geometry_.updateScreenPoints(*map());
+    }
 
     if (border_.color() != Qt::transparent && border_.width() > 0) {
-        QList<QGeoCoordinate> closedPath = circlePath_;
-        closedPath << closedPath.first();
+        QList<QGeoCoordinate> closedPath;
+        if (analytic) {
+            closedPath = geometry_.rimPath();
+        } else {
+            closedPath = circlePath_;
+            closedPath << closedPath.first();
+        }
         borderGeometry_.setPreserveGeometry(preserve, leftBoundCoord);
         borderGeometry_.updateSourcePoints(*map(), closedPath);
         borderGeometry_.updateScreenPoints(*map(), border_.width());
@@ -491,7 +708,10 @@ void QDeclarativeCircleMapItem::updatePolish()
         setHeight(geometry_.screenBoundingBox().height());
     }
 
-    setPositionOnMap(circlePath_.at(0), geometry_.firstPointOffset());
+    if (analytic)
+        setPositionOnMap(center_, geometry_.centerOffset());
+    else
+        setPositionOnMap(circlePath_.at(0), geometry_.firstPointOffset());
 }
 
 /*!
@@ -542,6 +762,17 @@ bool QDeclarativeCircleMapItem::contains(const QPointF &point) const
     return (geometry_.contains(point) || borderGeometry_.contains(point));
 }
 
+/*!
+    \internal
+    The border geometry already adds half of the border width, square caps
+    can reach out by the other half.
+*/
+QRectF QDeclarativeCircleMapItem::hitTestBounds() const
+{
+    const qreal w = 0.5 * border_.width();
+    return boundingRect().adjusted(-w, -w, w, w);
+}
+
 /*!
     \internal
 */
@@ -62,6 +62,26 @@ public:
     QGeoMapCircleGeometry();
 
     void updateScreenPointsInvert(const QGeoMap &map);
+
+    bool updateCircle(const QGeoMap &map, const QGeoCoordinate &center, qreal radius);
+    inline QPointF centerOffset() const { return firstPointOffset_ + originToCenter_; }
+    const QList<QGeoCoordinate> &rimPath();
+    QGeoCoordinate rimLeftBound();
+
+private:
+    void updateRim(const QGeoCoordinate &center, qreal radius, int segments);
+
+    // the rim of the circle in mercator units relative to its center, at
+    // rimSegments_ points spaced evenly by azimuth and starting in the north
+    QGeoCoordinate rimCenter_;
+    qreal rimRadius_;
+    int rimSegments_;
+    QVector<double> rimMercator_;
+    QVector<double> rimGeo_;           // latitude, longitude pairs in degrees
+    QList<QGeoCoordinate> rimPath_;    // closed, built when a border needs it
+    bool rimPathValid_;
+    int rimWestIndex_;
+    QPointF originToCenter_;
 };
 
 class QDeclarativeCircleMapItem : public QDeclarativeGeoMapItemBase
@@ -91,6 +111,7 @@ public:
     QDeclarativeMapLineProperties *border();
 
     bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+    QRectF hitTestBounds() const Q_DECL_OVERRIDE;
 
 Q_SIGNALS:
     void centerChanged(const QGeoCoordinate &center);
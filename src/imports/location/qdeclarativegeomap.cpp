@@ -50,6 +50,7 @@
 #include <QtQuick/private/qquickwindow_p.h>
 #include <QtQml/qqmlinfo.h>
 #include <cmath>
+#include <algorithm>
 
 QT_BEGIN_NAMESPACE
 
@@ -183,7 +184,9 @@ QDeclarativeGeoMap::QDeclarativeGeoMap(QQuickItem *parent)
         m_componentCompleted(false),
         m_mappingManagerInitialized(false),
         m_pendingFitViewport(false),
-        m_copyrightsVisible(true)
+        m_copyrightsVisible(true),
+        m_itemIndex(64.0),
+        m_nextItemId(0)
 {
     setAcceptHoverEvents(false);
     setAcceptedMouseButtons(Qt::LeftButton);
@@ -1098,6 +1101,7 @@ void QDeclarativeGeoMap::addMapItem(QDeclarativeGeoMapItemBase *item)
     if (m_map)
         item->setMap(this, m_map);
     m_mapItems.append(item);
+    indexMapItem(item);
     emit mapItemsChanged();
     m_updateMutex.unlock();
 }
@@ -1123,6 +1127,142 @@ QList<QObject *> QDeclarativeGeoMap::mapItems()
     return ret;
 }
 
+/*!
+    \qmlmethod list<MapItem> QtLocation::Map::itemsAt(point position)
+
+    Returns the map items under \a position, given in the coordinate system
+    of the map, topmost item first. Each item is tested against its actual
+    shape, so a polyline is only returned when \a position is on its stroke.
+
+    The lookup goes through a spatial index of the item bounds and does not
+    visit items away from \a position.
+
+    \sa itemsIn, mapItems
+    \since 5.7
+*/
+QList<QObject *> QDeclarativeGeoMap::itemsAt(const QPointF &position) const
+{
+    updateMapItemIndex();
+
+    QVector<int> hits;
+    foreach (int id, m_itemIndex.containing(position)) {
+        QDeclarativeGeoMapItemBase *item = m_indexedItems.value(id);
+        if (item->contains(item->mapFromItem(this, position)))
+            hits.append(id);
+    }
+    return mapItemsInStackingOrder(hits);
+}
+
+/*!
+    \qmlmethod list<MapItem> QtLocation::Map::itemsIn(rect rectangle)
+
+    Returns the visible map items whose bounds intersect \a rectangle, given
+    in the coordinate system of the map, topmost item first. Unlike \l itemsAt
+    this only looks at the bounds and not at the shape of the items.
+
+    \sa itemsAt, mapItems
+    \since 5.7
+*/
+QList<QObject *> QDeclarativeGeoMap::itemsIn(const QRectF &rect) const
+{
+    updateMapItemIndex();
+    return mapItemsInStackingOrder(m_itemIndex.intersecting(rect.normalized()));
+}
+
+static bool isStackedAbove(const QDeclarativeGeoMapItemBase *a, const QDeclarativeGeoMapItemBase *b)
+{
+    return a->z() > b->z();
+}
+
+/*!
+    \internal
+    Items added later are drawn on top of earlier ones with the same z, and
+    \a ids come in ascending order, so walking them backwards and then
+    sorting stably by z gives the topmost item first.
+*/
+QList<QObject *> QDeclarativeGeoMap::mapItemsInStackingOrder(const QVector<int> &ids) const
+{
+    QList<QDeclarativeGeoMapItemBase *> items;
+    items.reserve(ids.size());
+    for (int i = ids.size() - 1; i >= 0; --i)
+        items.append(m_indexedItems.value(ids.at(i)));
+    std::stable_sort(items.begin(), items.end(), isStackedAbove);
+
+    QList<QObject *> ret;
+    ret.reserve(items.size());
+    foreach (QDeclarativeGeoMapItemBase *item, items)
+        ret.append(item);
+    return ret;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::indexMapItem(QDeclarativeGeoMapItemBase *item)
+{
+    if (m_itemIds.contains(item))
+        return;
+    const int id = m_nextItemId++;
+    m_itemIds.insert(item, id);
+    m_indexedItems.insert(id, item);
+    m_dirtyItems.insert(item);
+
+    connect(item, SIGNAL(xChanged()), this, SLOT(mapItemBoundsChanged()));
+    connect(item, SIGNAL(yChanged()), this, SLOT(mapItemBoundsChanged()));
+    connect(item, SIGNAL(widthChanged()), this, SLOT(mapItemBoundsChanged()));
+    connect(item, SIGNAL(heightChanged()), this, SLOT(mapItemBoundsChanged()));
+    connect(item, SIGNAL(visibleChanged()), this, SLOT(mapItemBoundsChanged()));
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::unindexMapItem(QDeclarativeGeoMapItemBase *item)
+{
+    QHash<QDeclarativeGeoMapItemBase *, int>::iterator it = m_itemIds.find(item);
+    if (it == m_itemIds.end())
+        return;
+    m_indexedItems.remove(it.value());
+    m_itemIndex.remove(it.value());
+    m_itemIds.erase(it);
+    m_dirtyItems.remove(item);
+    disconnect(item, 0, this, SLOT(mapItemBoundsChanged()));
+}
+
+/*!
+    \internal
+    Marks the bounds of \a item as stale. Items move on every frame while the
+    map pans, so the index is only brought up to date when it is queried.
+*/
+void QDeclarativeGeoMap::invalidateMapItemBounds(QDeclarativeGeoMapItemBase *item)
+{
+    if (m_itemIds.contains(item))
+        m_dirtyItems.insert(item);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::mapItemBoundsChanged()
+{
+    invalidateMapItemBounds(static_cast<QDeclarativeGeoMapItemBase *>(sender()));
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMap::updateMapItemIndex() const
+{
+    foreach (QDeclarativeGeoMapItemBase *item, m_dirtyItems) {
+        const int id = m_itemIds.value(item);
+        if (item->isVisible())
+            m_itemIndex.insert(id, item->mapRectToItem(this, item->hitTestBounds()));
+        else
+            m_itemIndex.remove(id);
+    }
+    m_dirtyItems.clear();
+}
+
 /*!
     \qmlmethod void QtLocation::Map::removeMapItem(MapItem item)
 
@@ -1134,7 +1274,12 @@ QList<QObject *> QDeclarativeGeoMap::mapItems()
 */
 void QDeclarativeGeoMap::removeMapItem(QDeclarativeGeoMapItemBase *ptr)
 {
-    if (!ptr || !m_map)
+    if (!ptr)
+        return;
+    // drop the index entry even without a map, this is also reached from
+    // the item's destructor
+    unindexMapItem(ptr);
+    if (!m_map)
         return;
     QPointer<QDeclarativeGeoMapItemBase> item(ptr);
     if (!m_mapItems.contains(item))
@@ -1162,6 +1307,7 @@ void QDeclarativeGeoMap::clearMapItems()
     m_updateMutex.lock();
     for (int i = 0; i < m_mapItems.count(); ++i) {
         if (m_mapItems.at(i)) {
+            unindexMapItem(m_mapItems.at(i).data());
             m_mapItems.at(i).data()->setParentItem(0);
             m_mapItems.at(i).data()->setMap(0, 0);
         }
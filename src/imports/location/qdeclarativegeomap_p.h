@@ -52,9 +52,12 @@
 #include "qdeclarativegeomapitemview_p.h"
 #include "qquickgeomapgesturearea_p.h"
 #include "qgeocameradata_p.h"
+#include <QtLocation/private/qgeogridindex_p.h>
 #include <QtQuick/QQuickItem>
 #include <QtCore/QPointer>
 #include <QtCore/QMutex>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtGui/QColor>
 #include <QtPositioning/qgeoshape.h>
 
@@ -122,6 +125,8 @@ public:
     Q_INVOKABLE void addMapItem(QDeclarativeGeoMapItemBase *item);
     Q_INVOKABLE void clearMapItems();
     QList<QObject *> mapItems();
+    Q_INVOKABLE QList<QObject *> itemsAt(const QPointF &position) const;
+    Q_INVOKABLE QList<QObject *> itemsIn(const QRectF &rect) const;
 
     Q_INVOKABLE QGeoCoordinate toCoordinate(const QPointF &position, bool clipToViewPort = true) const;
     Q_INVOKABLE QPointF fromCoordinate(const QGeoCoordinate &coordinate, bool clipToViewPort = true) const;
@@ -174,8 +179,14 @@ private Q_SLOTS:
     void mapZoomLevelChanged(qreal zoom);
     void pluginReady();
     void onMapChildrenChanged();
+    void mapItemBoundsChanged();
 
 private:
+    void indexMapItem(QDeclarativeGeoMapItemBase *item);
+    void unindexMapItem(QDeclarativeGeoMapItemBase *item);
+    void invalidateMapItemBounds(QDeclarativeGeoMapItemBase *item);
+    void updateMapItemIndex() const;
+    QList<QObject *> mapItemsInStackingOrder(const QVector<int> &ids) const;
     void setupMapView(QDeclarativeGeoMapItemView *view);
     void populateMap();
     void fitViewportToMapItemsRefine(bool refine);
@@ -205,7 +216,15 @@ private:
     bool m_pendingFitViewport;
     bool m_copyrightsVisible;
 
+    // screen bounds of the map items, refreshed lazily before each lookup
+    mutable QGeoGridIndex m_itemIndex;
+    mutable QSet<QDeclarativeGeoMapItemBase *> m_dirtyItems;
+    QHash<QDeclarativeGeoMapItemBase *, int> m_itemIds;
+    QHash<int, QDeclarativeGeoMapItemBase *> m_indexedItems;
+    int m_nextItemId;
+
     friend class QDeclarativeGeoMapItem;
+    friend class QDeclarativeGeoMapItemBase;
     friend class QDeclarativeGeoMapItemView;
     friend class QQuickGeoMapGestureArea;
     Q_DISABLE_COPY(QDeclarativeGeoMap)
@@ -178,6 +178,10 @@ void QDeclarativeGeoMapItemBase::setPositionOnMap(const QGeoCoordinate &coordina
     QPointF topLeft = map_->coordinateToItemPosition(coordinate, false).toPointF() - offset;
 
     setPosition(topLeft);
+
+    // the hit test bounds may change without moving the item, e.g. with the
+    // width of a line
+    quickMap_->invalidateMapItemBounds(this);
 }
 
 /*!
@@ -200,17 +204,32 @@ bool QDeclarativeGeoMapItemBase::childMouseEventFilter(QQuickItem *item, QEvent
     case QEvent::MouseButtonPress:
     case QEvent::MouseButtonRelease:
     case QEvent::MouseMove:
-        if (contains(static_cast<QMouseEvent*>(event)->pos())) {
+    {
+        // reject on the bounds before the exact and much costlier shape test
+        const QPointF pos = static_cast<QMouseEvent*>(event)->pos();
+        if (hitTestBounds().contains(pos) && contains(pos)) {
             return false;
         } else {
             event->setAccepted(false);
             return true;
         }
+    }
     default:
         return false;
     }
 }
 
+/*!
+    \internal
+    Returns a rectangle in item coordinates that encloses everything
+    contains() can accept. The map indexes items by these bounds for
+    hit testing. The default is the bounding rectangle of the item.
+*/
+QRectF QDeclarativeGeoMapItemBase::hitTestBounds() const
+{
+    return boundingRect();
+}
+
 /*!
     \internal
 */
@@ -40,12 +40,17 @@
 #include "qdeclarativegeomap_p.h"
 #include "qdeclarativegeomapitembase_p.h"
 #include "mapitemviewdelegateincubator.h"
+#include "qgeomap_p.h"
 
 #include <QtCore/QAbstractItemModel>
+#include <QtPositioning/QGeoShape>
+#include <QtPositioning/private/qgeoprojection_p.h>
 #include <QtQml/QQmlContext>
 #include <QtQml/QQmlIncubator>
 #include <QtQml/private/qqmlopenmetaobject_p.h>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 /*!
@@ -71,11 +76,26 @@ QT_BEGIN_NAMESPACE
     \snippet declarative/maps.qml QtLocation import
     \codeline
     \snippet declarative/maps.qml MapRoute
+
+    \section2 Large Models
+
+    By default a map item is created for every row of the model. With
+    \l virtualized set, items are only created for rows whose coordinate,
+    given by \l coordinateRole, is in view or within \l cacheBuffer pixels
+    of it. As the map is panned and zoomed, items of rows that leave that
+    area are handed over to rows that enter it, so a model with tens of
+    thousands of rows costs only as many items as are on screen.
 */
 
+// size of the cells of the index over the rows, in mercator units
+static const double ROW_INDEX_CELL_SIZE = 1.0 / 1024;
+
 QDeclarativeGeoMapItemView::QDeclarativeGeoMapItemView(QQuickItem *parent)
     : QObject(parent), componentCompleted_(false), delegate_(0),
-      itemModel_(0), map_(0), fitViewport_(false), m_metaObjectType(0)
+      itemModel_(0), map_(0), fitViewport_(false), m_metaObjectType(0),
+      m_virtualized(false), m_coordinateRole(QStringLiteral("coordinate")),
+      m_coordinateRoleKey(-1), m_cacheBuffer(100.0), m_index(ROW_INDEX_CELL_SIZE),
+      m_visibleRowsUpdatePending(false)
 {
 }
 
@@ -102,7 +122,7 @@ void QDeclarativeGeoMapItemView::incubatorStatusChanged(MapItemViewDelegateIncub
 
     for (int i = 0; i < m_itemData.length(); ++i) {
         ItemData *itemData = m_itemData.at(i);
-        if (itemData->incubator != incubator)
+        if (!itemData || itemData->incubator != incubator)
             continue;
 
         switch (status) {
@@ -113,7 +133,7 @@ void QDeclarativeGeoMapItemView::incubatorStatusChanged(MapItemViewDelegateIncub
                 delete incubator->object();
             } else {
                 map_->addMapItem(itemData->item);
-                if (fitViewport_)
+                if (fitViewport_ && !m_virtualized)
                     fitViewport();
             }
             delete itemData->incubator;
@@ -170,6 +190,7 @@ void QDeclarativeGeoMapItemView::setModel(const QVariant &model)
         m_metaObjectType = 0;
 
         itemModel_ = 0;
+        updateCoordinateRole();
     }
 
     if (itemModel) {
@@ -188,6 +209,7 @@ void QDeclarativeGeoMapItemView::setModel(const QVariant &model)
         foreach (const QByteArray &name, itemModel_->roleNames())
             m_metaObjectType->createProperty(name);
 
+        updateCoordinateRole();
         instantiateAllItems();
     }
 
@@ -212,6 +234,16 @@ void QDeclarativeGeoMapItemView::itemModelRowsInserted(const QModelIndex &index,
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (m_virtualized) {
+        const int count = end - start + 1;
+        m_itemData.insert(start, count, 0);
+        shiftRows(start, count);
+        for (int i = start; i <= end; ++i)
+            indexRow(i);
+        scheduleVisibleRowsUpdate();
+        return;
+    }
+
     for (int i = start; i <= end; ++i) {
         const QModelIndex insertedIndex = itemModel_->index(i, 0, index);
         createItemForIndex(insertedIndex);
@@ -231,6 +263,25 @@ void QDeclarativeGeoMapItemView::itemModelRowsRemoved(const QModelIndex &index,
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (m_virtualized) {
+        const int count = end - start + 1;
+        QVector<int> rows;
+        foreach (int row, m_visibleRows) {
+            if (row < start || row > end)
+                rows.append(row);
+        }
+        for (int i = end; i >= start; --i) {
+            releaseRow(i);
+            m_index.remove(i);
+            m_unlocatedRows.remove(i);
+        }
+        m_itemData.remove(start, count);
+        m_visibleRows = rows;
+        shiftRows(end + 1, -count);
+        scheduleVisibleRowsUpdate();
+        return;
+    }
+
     for (int i = end; i >= start; --i) {
         ItemData *itemData = m_itemData.takeAt(i);
         if (!itemData)
@@ -263,23 +314,16 @@ void QDeclarativeGeoMapItemView::itemModelDataChanged(const QModelIndex &topLeft
     Q_UNUSED(roles)
 
     for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
-        const QModelIndex index = itemModel_->index(i, 0);
-        ItemData *itemData = m_itemData.at(i);
-
-        QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
-        while (iterator.hasNext()) {
-            iterator.next();
+        if (m_virtualized)
+            indexRow(i);
 
-            QVariant modelData = itemModel_->data(index, iterator.key());
-            if (!modelData.isValid())
-                continue;
-
-            itemData->context->setContextProperty(QString::fromLatin1(iterator.value().constData()),
-                                                  modelData);
-
-            itemData->modelDataMeta->setValue(iterator.value(), modelData);
-        }
+        ItemData *itemData = m_itemData.value(i);
+        if (itemData)
+            setItemModelData(itemData, itemModel_->index(i, 0));
     }
+
+    if (m_virtualized)
+        scheduleVisibleRowsUpdate();
 }
 
 /*!
@@ -326,6 +370,91 @@ void QDeclarativeGeoMapItemView::setAutoFitViewport(const bool &fitViewport)
     emit autoFitViewportChanged();
 }
 
+/*!
+    \qmlproperty bool QtLocation::MapItemView::virtualized
+
+    This property controls whether map items are only created for the rows
+    of the model that are near the visible part of the map. The position of
+    a row is taken from its \l coordinateRole; rows without one always get
+    an item. Since the items depend on the viewport, \l autoFitViewport
+    has no effect on a virtualized view.
+
+    Defaults to false.
+*/
+bool QDeclarativeGeoMapItemView::isVirtualized() const
+{
+    return m_virtualized;
+}
+
+void QDeclarativeGeoMapItemView::setVirtualized(bool virtualized)
+{
+    if (virtualized == m_virtualized)
+        return;
+
+    removeInstantiatedItems();
+    m_virtualized = virtualized;
+    m_index.clear();
+    m_unlocatedRows.clear();
+    instantiateAllItems();
+    emit virtualizedChanged();
+}
+
+/*!
+    \qmlproperty string QtLocation::MapItemView::coordinateRole
+
+    This property holds the name of the model role that gives the position
+    of a row when the view is \l virtualized. The role may hold a
+    coordinate, a geo shape, whose center is used, or an object with a
+    \c coordinate property or a \c location property that has one, as
+    places from a PlaceSearchModel do.
+
+    Defaults to "coordinate".
+*/
+QString QDeclarativeGeoMapItemView::coordinateRole() const
+{
+    return m_coordinateRole;
+}
+
+void QDeclarativeGeoMapItemView::setCoordinateRole(const QString &role)
+{
+    if (role == m_coordinateRole)
+        return;
+
+    m_coordinateRole = role;
+    updateCoordinateRole();
+    if (m_virtualized && componentCompleted_ && map_ && delegate_ && itemModel_) {
+        rebuildIndex();
+        scheduleVisibleRowsUpdate();
+    }
+    emit coordinateRoleChanged();
+}
+
+/*!
+    \qmlproperty real QtLocation::MapItemView::cacheBuffer
+
+    This property holds how far outside the visible part of the map, in
+    pixels, rows still get map items when the view is \l virtualized.
+    Items of rows within this margin are ready before they are panned into
+    view.
+
+    Defaults to 100.
+*/
+qreal QDeclarativeGeoMapItemView::cacheBuffer() const
+{
+    return m_cacheBuffer;
+}
+
+void QDeclarativeGeoMapItemView::setCacheBuffer(qreal cacheBuffer)
+{
+    cacheBuffer = qMax(qreal(0.0), cacheBuffer);
+    if (cacheBuffer == m_cacheBuffer)
+        return;
+
+    m_cacheBuffer = cacheBuffer;
+    scheduleVisibleRowsUpdate();
+    emit cacheBufferChanged();
+}
+
 /*!
     \internal
 */
@@ -346,6 +475,13 @@ void QDeclarativeGeoMapItemView::setMap(QDeclarativeGeoMap *map)
     if (!map || map_) // changing map on the fly not supported
         return;
     map_ = map;
+
+    connect(map_, SIGNAL(centerChanged(QGeoCoordinate)), this, SLOT(scheduleVisibleRowsUpdate()));
+    connect(map_, SIGNAL(zoomLevelChanged(qreal)), this, SLOT(scheduleVisibleRowsUpdate()));
+    connect(map_, SIGNAL(widthChanged()), this, SLOT(scheduleVisibleRowsUpdate()));
+    connect(map_, SIGNAL(heightChanged()), this, SLOT(scheduleVisibleRowsUpdate()));
+    // emitted once the plugin is ready and the map has been created
+    connect(map_, SIGNAL(activeMapTypeChanged()), this, SLOT(scheduleVisibleRowsUpdate()));
 }
 
 /*!
@@ -357,22 +493,37 @@ void QDeclarativeGeoMapItemView::removeInstantiatedItems()
         return;
 
     foreach (ItemData *itemData, m_itemData) {
+        if (!itemData)
+            continue;
         map_->removeMapItem(itemData->item);
         delete itemData;
     }
     m_itemData.clear();
+
+    // pooled items are already off the map
+    qDeleteAll(m_pool);
+    m_pool.clear();
+    m_visibleRows.clear();
 }
 
 /*!
     \internal
 
-    Instantiates all items.
+    Instantiates all items, or only those near the viewport when the view
+    is virtualized.
 */
 void QDeclarativeGeoMapItemView::instantiateAllItems()
 {
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (m_virtualized) {
+        m_itemData.fill(0, itemModel_->rowCount());
+        rebuildIndex();
+        updateVisibleRows();
+        return;
+    }
+
     for (int i = 0; i < itemModel_->rowCount(); ++i) {
         const QModelIndex index = itemModel_->index(i, 0);
         createItemForIndex(index);
@@ -407,27 +558,284 @@ void QDeclarativeGeoMapItemView::createItemForIndex(const QModelIndex &index)
     itemData->modelDataMeta = new QQmlOpenMetaObject(itemData->modelData, m_metaObjectType, false);
     itemData->context = new QQmlContext(qmlContext(this));
 
+    setItemModelData(itemData, index);
+
+    itemData->context->setContextProperty(QLatin1String("model"), itemData->modelData);
+    itemData->context->setContextProperty(QLatin1String("index"), index.row());
+
+    itemData->incubator = new MapItemViewDelegateIncubator(this);
+    delegate_->create(*itemData->incubator, itemData->context);
+
+    if (m_virtualized)
+        m_itemData[index.row()] = itemData;
+    else
+        m_itemData.insert(index.row(), itemData);
+}
+
+/*!
+    \internal
+
+    Sets the values of the roles of \a index as context properties of
+    \a itemData. Roles without a value are reset as well, so that an item
+    handed over from another row keeps nothing of it.
+*/
+void QDeclarativeGeoMapItemView::setItemModelData(ItemData *itemData, const QModelIndex &index)
+{
     QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
     while (iterator.hasNext()) {
         iterator.next();
 
         QVariant modelData = itemModel_->data(index, iterator.key());
-        if (!modelData.isValid())
-            continue;
-
         itemData->context->setContextProperty(QString::fromLatin1(iterator.value().constData()),
                                               modelData);
 
         itemData->modelDataMeta->setValue(iterator.value(), modelData);
     }
+}
 
-    itemData->context->setContextProperty(QLatin1String("model"), itemData->modelData);
-    itemData->context->setContextProperty(QLatin1String("index"), index.row());
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::updateCoordinateRole()
+{
+    m_coordinateRoleKey = -1;
+    if (!itemModel_)
+        return;
 
-    itemData->incubator = new MapItemViewDelegateIncubator(this);
-    delegate_->create(*itemData->incubator, itemData->context);
+    const QByteArray name = m_coordinateRole.toUtf8();
+    QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
+    while (iterator.hasNext()) {
+        iterator.next();
+        if (iterator.value() == name) {
+            m_coordinateRoleKey = iterator.key();
+            break;
+        }
+    }
+}
+
+static QGeoCoordinate coordinateFromValue(const QVariant &value, int depth = 0)
+{
+    if (value.userType() == qMetaTypeId<QGeoCoordinate>())
+        return value.value<QGeoCoordinate>();
+    if (value.canConvert<QGeoShape>())
+        return value.value<QGeoShape>().center();
+
+    QObject *object = value.value<QObject *>();
+    if (!object || depth > 1)
+        return QGeoCoordinate();
+
+    const QVariant coordinate = object->property("coordinate");
+    if (coordinate.isValid())
+        return coordinateFromValue(coordinate, depth + 1);
+    return coordinateFromValue(object->property("location"), depth + 1);
+}
+
+/*!
+    \internal
+
+    Puts \a row into the index at its coordinate, or into the rows without
+    one.
+*/
+void QDeclarativeGeoMapItemView::indexRow(int row)
+{
+    QGeoCoordinate coordinate;
+    if (m_coordinateRoleKey >= 0)
+        coordinate = coordinateFromValue(itemModel_->data(itemModel_->index(row, 0), m_coordinateRoleKey));
+
+    if (!coordinate.isValid()) {
+        m_index.remove(row);
+        m_unlocatedRows.insert(row);
+        return;
+    }
+
+    const QPointF mercator = QGeoProjection::coordToMercator(coordinate).toPointF();
+    m_index.insert(row, QRectF(mercator, mercator));
+    m_unlocatedRows.remove(row);
+}
+
+/*!
+    \internal
+
+    Renumbers the rows from \a from on by \a delta in the index, the rows
+    with items and the index property of their items, after rows were
+    inserted or removed. m_itemData is expected to be updated already.
+*/
+void QDeclarativeGeoMapItemView::shiftRows(int from, int delta)
+{
+    m_index.shiftIds(from, delta);
+
+    QSet<int> unlocatedRows;
+    unlocatedRows.reserve(m_unlocatedRows.size());
+    foreach (int row, m_unlocatedRows)
+        unlocatedRows.insert(row >= from ? row + delta : row);
+    m_unlocatedRows.swap(unlocatedRows);
+
+    for (int i = 0; i < m_visibleRows.size(); ++i) {
+        const int row = m_visibleRows.at(i);
+        if (row < from)
+            continue;
+        m_visibleRows[i] = row + delta;
+        if (ItemData *itemData = m_itemData.at(row + delta))
+            itemData->context->setContextProperty(QLatin1String("index"), row + delta);
+    }
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::rebuildIndex()
+{
+    m_index.clear();
+    m_unlocatedRows.clear();
+
+    const int rows = itemModel_->rowCount();
+    for (int i = 0; i < rows; ++i)
+        indexRow(i);
+}
+
+/*!
+    \internal
+
+    Returns the rows within cacheBuffer pixels of the viewport and the rows
+    without a coordinate, in ascending order. Until the map can tell the
+    mercator area it shows, only the rows without a coordinate are returned.
+*/
+QVector<int> QDeclarativeGeoMapItemView::visibleRows() const
+{
+    QVector<int> rows;
+    const QGeoMercatorTransform transform = map_->m_map ? map_->m_map->mercatorTransform()
+                                                        : QGeoMercatorTransform();
+    if (!transform.isValid() || transform.scaleX() <= 0.0 || transform.scaleY() <= 0.0) {
+        foreach (int row, m_unlocatedRows)
+            rows.append(row);
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    const double margin = m_cacheBuffer;
+    const double left = transform.centerX() + (-margin - transform.offsetX()) / transform.scaleX();
+    const double right = transform.centerX() + (map_->width() + margin - transform.offsetX()) / transform.scaleX();
+    const double top = (-margin - transform.offsetY()) / transform.scaleY();
+    const double bottom = (map_->height() + margin - transform.offsetY()) / transform.scaleY();
+
+    if (right - left >= 1.0) {
+        rows = m_index.intersecting(QRectF(QPointF(0.0, top), QPointF(1.0, bottom)));
+    } else {
+        // the area in mercator x may cross the dateline on either side
+        for (int wrap = -1; wrap <= 1; ++wrap) {
+            const double l = qMax(left + wrap, 0.0);
+            const double r = qMin(right + wrap, 1.0);
+            if (l <= r)
+                rows += m_index.intersecting(QRectF(QPointF(l, top), QPointF(r, bottom)));
+        }
+    }
 
-    m_itemData.insert(index.row(), itemData);
+    foreach (int row, m_unlocatedRows)
+        rows.append(row);
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::scheduleVisibleRowsUpdate()
+{
+    if (!m_virtualized || m_visibleRowsUpdatePending)
+        return;
+
+    m_visibleRowsUpdatePending = true;
+    QMetaObject::invokeMethod(this, "updateVisibleRows", Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Gives items to the rows that came near the viewport and takes them from
+    the ones that left it. Taken items go to a pool and are handed to new
+    rows before any delegate is created.
+*/
+void QDeclarativeGeoMapItemView::updateVisibleRows()
+{
+    m_visibleRowsUpdatePending = false;
+    if (!m_virtualized || !componentCompleted_ || !map_ || !delegate_ || !itemModel_)
+        return;
+
+    // without a camera only rows without a coordinate are shown; look again
+    // as soon as the map has one
+    if (map_->m_map) {
+        const QGeoMercatorTransform transform = map_->m_map->mercatorTransform();
+        if (transform.isValid() && transform.scaleX() > 0.0 && transform.scaleY() > 0.0) {
+            disconnect(map_->m_map, SIGNAL(cameraDataChanged(QGeoCameraData)),
+                       this, SLOT(scheduleVisibleRowsUpdate()));
+        } else {
+            connect(map_->m_map, SIGNAL(cameraDataChanged(QGeoCameraData)),
+                    this, SLOT(scheduleVisibleRowsUpdate()), Qt::UniqueConnection);
+        }
+    }
+
+    const QVector<int> rows = visibleRows();
+
+    // both lists are sorted
+    QVector<int>::const_iterator it = rows.constBegin();
+    foreach (int row, m_visibleRows) {
+        while (it != rows.constEnd() && *it < row)
+            ++it;
+        if (it == rows.constEnd() || *it != row)
+            releaseRow(row);
+    }
+
+    foreach (int row, rows) {
+        if (!m_itemData.at(row))
+            instantiateRow(row);
+    }
+    m_visibleRows = rows;
+
+    // keep no more spare items than there are items in use
+    while (m_pool.size() > rows.size())
+        delete m_pool.takeLast();
+}
+
+/*!
+    \internal
+
+    Gives \a row an item, reusing one from the pool if there is one.
+*/
+void QDeclarativeGeoMapItemView::instantiateRow(int row)
+{
+    const QModelIndex index = itemModel_->index(row, 0);
+    if (m_pool.isEmpty()) {
+        createItemForIndex(index);
+        return;
+    }
+
+    ItemData *itemData = m_pool.takeLast();
+    setItemModelData(itemData, index);
+    itemData->context->setContextProperty(QLatin1String("index"), row);
+    m_itemData[row] = itemData;
+    map_->addMapItem(itemData->item);
+}
+
+/*!
+    \internal
+
+    Takes the item of \a row off the map and into the pool. Items that are
+    still being created are dropped instead.
+*/
+void QDeclarativeGeoMapItemView::releaseRow(int row)
+{
+    ItemData *itemData = m_itemData.at(row);
+    if (!itemData)
+        return;
+    m_itemData[row] = 0;
+
+    map_->removeMapItem(itemData->item);
+    if (itemData->incubator || !itemData->item)
+        delete itemData;
+    else
+        m_pool.append(itemData);
 }
 
 QDeclarativeGeoMapItemView::ItemData::~ItemData()
@@ -51,6 +51,8 @@
 //
 
 #include <QtCore/QModelIndex>
+#include <QtCore/QSet>
+#include <QtLocation/private/qgeogridindex_p.h>
 #include <QtQml/QQmlParserStatus>
 #include <QtQml/QQmlIncubator>
 #include <QtQml/qqml.h>
@@ -75,6 +77,9 @@ class QDeclarativeGeoMapItemView : public QObject, public QQmlParserStatus
     Q_PROPERTY(QVariant model READ model WRITE setModel NOTIFY modelChanged)
     Q_PROPERTY(QQmlComponent *delegate READ delegate WRITE setDelegate NOTIFY delegateChanged)
     Q_PROPERTY(bool autoFitViewport READ autoFitViewport WRITE setAutoFitViewport NOTIFY autoFitViewportChanged)
+    Q_PROPERTY(bool virtualized READ isVirtualized WRITE setVirtualized NOTIFY virtualizedChanged)
+    Q_PROPERTY(QString coordinateRole READ coordinateRole WRITE setCoordinateRole NOTIFY coordinateRoleChanged)
+    Q_PROPERTY(qreal cacheBuffer READ cacheBuffer WRITE setCacheBuffer NOTIFY cacheBufferChanged)
 
 public:
     explicit QDeclarativeGeoMapItemView(QQuickItem *parent = 0);
@@ -89,6 +94,15 @@ public:
     bool autoFitViewport() const;
     void setAutoFitViewport(const bool &);
 
+    bool isVirtualized() const;
+    void setVirtualized(bool virtualized);
+
+    QString coordinateRole() const;
+    void setCoordinateRole(const QString &role);
+
+    qreal cacheBuffer() const;
+    void setCacheBuffer(qreal cacheBuffer);
+
     void setMap(QDeclarativeGeoMap *);
     void repopulate();
     void removeInstantiatedItems();
@@ -105,6 +119,9 @@ Q_SIGNALS:
     void modelChanged();
     void delegateChanged();
     void autoFitViewportChanged();
+    void virtualizedChanged();
+    void coordinateRoleChanged();
+    void cacheBufferChanged();
 
 protected:
     void incubatorStatusChanged(MapItemViewDelegateIncubator *incubator,
@@ -118,6 +135,8 @@ private Q_SLOTS:
                             const QModelIndex &destination, int row);
     void itemModelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
                               const QVector<int> &roles);
+    void scheduleVisibleRowsUpdate();
+    void updateVisibleRows();
 
 private:
     struct ItemData {
@@ -136,8 +155,17 @@ private:
     };
 
     void createItemForIndex(const QModelIndex &index);
+    void setItemModelData(ItemData *itemData, const QModelIndex &index);
     void fitViewport();
 
+    void updateCoordinateRole();
+    void indexRow(int row);
+    void shiftRows(int from, int delta);
+    void rebuildIndex();
+    QVector<int> visibleRows() const;
+    void instantiateRow(int row);
+    void releaseRow(int row);
+
     bool componentCompleted_;
     QQmlComponent *delegate_;
     QAbstractItemModel *itemModel_;
@@ -147,6 +175,18 @@ private:
 
     QQmlOpenMetaObjectType *m_metaObjectType;
 
+    // virtualized mode: only rows near the viewport have items, the others
+    // are found through a grid over their mercator coordinates
+    bool m_virtualized;
+    QString m_coordinateRole;
+    int m_coordinateRoleKey;
+    qreal m_cacheBuffer;
+    QGeoGridIndex m_index;
+    QSet<int> m_unlocatedRows;      // rows without a coordinate, always instantiated
+    QVector<int> m_visibleRows;     // rows with items, ascending
+    QVector<ItemData *> m_pool;     // items of rows that left the viewport, for reuse
+    bool m_visibleRowsUpdatePending;
+
     friend class QTypeInfo<ItemData>;
     friend class MapItemViewDelegateIncubator;
 };
@@ -0,0 +1,609 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qdeclarativemarkerlayermapitem_p.h"
+#include "locationvaluetypehelper_p.h"
+#include "qdoublevector2d_p.h"
+#include "qgeomap_p.h"
+
+#include <QtGui/QMouseEvent>
+#include <QtGui/QPainter>
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtQml/QQmlFile>
+#include <QtQml/QQmlInfo>
+#include <QtQml/private/qqmlengine_p.h>
+#include <QtQuick/QQuickWindow>
+#include <qnumeric.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \qmltype MapMarkerLayer
+    \instantiates QDeclarativeMarkerLayerMapItem
+    \inqmlmodule QtLocation
+    \ingroup qml-QtLocation5-maps
+    \since Qt Location 5.7
+
+    \brief The MapMarkerLayer type displays many small symbols on a Map.
+
+    The MapMarkerLayer type draws a symbol at each of its \l coordinates.
+    Where thousands of MapQuickItem or MapCircle objects would each be an
+    item of their own, with their own updates on every change of the
+    viewport, a MapMarkerLayer is one item drawing all of its markers in one
+    batch.
+
+    The symbols come from the image given by \l source, cut into cells of
+    \l symbolSize from left to right and top to bottom; \l symbols picks the
+    cell for each marker. Without a source every marker is a dot of
+    \l color. The \l anchorPoint of the symbol lines up with the coordinate
+    of the marker.
+
+    Markers are picked by their rectangles with markerAt() and markersIn(),
+    and a click on a marker emits clicked() with its index. Clicks that miss
+    all markers go to the items below, including the Map itself.
+
+    \section2 Example Usage
+
+    \code
+    MapMarkerLayer {
+        coordinates: stations
+        source: "symbols.png"
+        symbolSize: Qt.size(24, 24)
+        symbols: stationKinds
+        anchorPoint: Qt.point(12, 24)
+        onClicked: console.log("station", index)
+    }
+    \endcode
+*/
+
+// the size of the dot drawn without a source
+static const int DEFAULT_DOT_SIZE = 12;
+
+QDeclarativeMarkerLayerMapItem::QDeclarativeMarkerLayerMapItem(QQuickItem *parent)
+:   QDeclarativeGeoMapItemBase(parent), anchorPointSet_(false), color_(Qt::red),
+    imageDirty_(true), verticesDirty_(true), pressedMarker_(-1)
+{
+    setFlag(ItemHasContents, true);
+    setAcceptedMouseButtons(Qt::LeftButton);
+    updateImage();
+}
+
+QDeclarativeMarkerLayerMapItem::~QDeclarativeMarkerLayerMapItem()
+{
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::setMap(QDeclarativeGeoMap *quickMap, QGeoMap *map)
+{
+    QDeclarativeGeoMapItemBase::setMap(quickMap, map);
+    if (map)
+        polishAndUpdate();
+}
+
+/*!
+    \qmlproperty list<coordinate> MapMarkerLayer::coordinates
+
+    This property holds the coordinates of the markers. Markers are drawn in
+    this order, so later ones are on top.
+*/
+QJSValue QDeclarativeMarkerLayerMapItem::coordinates() const
+{
+    QQmlContext *context = QQmlEngine::contextForObject(parent());
+    QQmlEngine *engine = context->engine();
+    QV4::ExecutionEngine *v4 = QQmlEnginePrivate::getV4Engine(engine);
+
+    QV4::Scope scope(v4);
+    QV4::Scoped<QV4::ArrayObject> array(scope, v4->newArrayObject(coordinates_.length()));
+    for (int i = 0; i < coordinates_.length(); ++i) {
+        const QGeoCoordinate &c = coordinates_.at(i);
+
+        QV4::ScopedValue cv(scope, v4->fromVariant(QVariant::fromValue(c)));
+        array->putIndexed(i, cv);
+    }
+
+    return QJSValue(v4, array.asReturnedValue());
+}
+
+void QDeclarativeMarkerLayerMapItem::setCoordinates(const QJSValue &value)
+{
+    if (!value.isArray())
+        return;
+
+    QList<QGeoCoordinate> coordinates;
+    quint32 length = value.property(QStringLiteral("length")).toUInt();
+    coordinates.reserve(length);
+    for (quint32 i = 0; i < length; ++i) {
+        bool ok;
+        QGeoCoordinate c = parseCoordinate(value.property(i), &ok);
+
+        if (!ok) {
+            qmlInfo(this) << "Unsupported coordinate type";
+            return;
+        }
+
+        coordinates.append(c);
+    }
+
+    setCoordinatesFromGeoList(coordinates);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::setCoordinatesFromGeoList(const QList<QGeoCoordinate> &coordinates)
+{
+    if (coordinates_ == coordinates)
+        return;
+
+    coordinates_ = coordinates;
+    mercator_.resize(2 * coordinates_.size());
+    for (int i = 0; i < coordinates_.size(); ++i) {
+        const QGeoCoordinate &c = coordinates_.at(i);
+        const QDoubleVector2D m = c.isValid() ? QGeoProjection::coordToMercator(c)
+                                              : QDoubleVector2D(qQNaN(), qQNaN());
+        mercator_[2 * i] = m.x();
+        mercator_[2 * i + 1] = m.y();
+    }
+
+    polishAndUpdate();
+    emit coordinatesChanged();
+}
+
+/*!
+    \qmlproperty int MapMarkerLayer::count
+
+    This property holds the number of markers.
+*/
+int QDeclarativeMarkerLayerMapItem::count() const
+{
+    return coordinates_.size();
+}
+
+/*!
+    \qmlmethod void MapMarkerLayer::setCoordinate(int index, coordinate coordinate)
+
+    Moves the marker at \a index to \a coordinate without replacing all of
+    the \l coordinates.
+*/
+void QDeclarativeMarkerLayerMapItem::setCoordinate(int index, const QGeoCoordinate &coordinate)
+{
+    if (index < 0 || index >= coordinates_.size() || coordinates_.at(index) == coordinate)
+        return;
+
+    coordinates_[index] = coordinate;
+    const QDoubleVector2D m = coordinate.isValid() ? QGeoProjection::coordToMercator(coordinate)
+                                                   : QDoubleVector2D(qQNaN(), qQNaN());
+    mercator_[2 * index] = m.x();
+    mercator_[2 * index + 1] = m.y();
+
+    polishAndUpdate();
+    emit coordinatesChanged();
+}
+
+/*!
+    \qmlproperty list<int> MapMarkerLayer::symbols
+
+    This property holds the symbol of each marker, as the index of a cell of
+    \l source. Markers beyond the end of the list use the first symbol.
+*/
+QList<int> QDeclarativeMarkerLayerMapItem::symbols() const
+{
+    return symbols_;
+}
+
+void QDeclarativeMarkerLayerMapItem::setSymbols(const QList<int> &symbols)
+{
+    if (symbols_ == symbols)
+        return;
+
+    symbols_ = symbols;
+    polishAndUpdate();
+    emit symbolsChanged();
+}
+
+/*!
+    \qmlproperty url MapMarkerLayer::source
+
+    This property holds the image the symbols are taken from. It is loaded
+    synchronously, so it has to be a local file or a resource.
+*/
+QUrl QDeclarativeMarkerLayerMapItem::source() const
+{
+    return source_;
+}
+
+void QDeclarativeMarkerLayerMapItem::setSource(const QUrl &source)
+{
+    if (source_ == source)
+        return;
+
+    source_ = source;
+    updateImage();
+    polishAndUpdate();
+    emit sourceChanged();
+}
+
+/*!
+    \qmlproperty size MapMarkerLayer::symbolSize
+
+    This property holds the size of one symbol in \l source, which is also
+    the size the markers are drawn at. If it is not set the whole image is
+    one symbol. Without a source it is the size of the dot.
+*/
+QSize QDeclarativeMarkerLayerMapItem::symbolSize() const
+{
+    return symbolSize_;
+}
+
+void QDeclarativeMarkerLayerMapItem::setSymbolSize(const QSize &size)
+{
+    if (symbolSize_ == size)
+        return;
+
+    symbolSize_ = size;
+    if (source_.isEmpty())
+        updateImage();
+    polishAndUpdate();
+    emit symbolSizeChanged();
+}
+
+/*!
+    \qmlproperty point MapMarkerLayer::anchorPoint
+
+    This property holds the point of a symbol, in pixels from its top left
+    corner, that lines up with the coordinate of the marker. It defaults to
+    the center of the symbol.
+*/
+QPointF QDeclarativeMarkerLayerMapItem::anchorPoint() const
+{
+    return effectiveAnchorPoint();
+}
+
+void QDeclarativeMarkerLayerMapItem::setAnchorPoint(const QPointF &anchorPoint)
+{
+    if (anchorPointSet_ && anchorPoint_ == anchorPoint)
+        return;
+
+    anchorPoint_ = anchorPoint;
+    anchorPointSet_ = true;
+    polishAndUpdate();
+    emit anchorPointChanged();
+}
+
+/*!
+    \qmlproperty color MapMarkerLayer::color
+
+    This property holds the color of the dots drawn when there is no
+    \l source.
+*/
+QColor QDeclarativeMarkerLayerMapItem::color() const
+{
+    return color_;
+}
+
+void QDeclarativeMarkerLayerMapItem::setColor(const QColor &color)
+{
+    if (color_ == color)
+        return;
+
+    color_ = color;
+    if (source_.isEmpty())
+        updateImage();
+    update();
+    emit colorChanged();
+}
+
+/*!
+    \qmlmethod int MapMarkerLayer::markerAt(point position)
+
+    Returns the index of the topmost marker whose symbol covers
+    \a position, in the coordinates of the map, or -1 if there is none.
+*/
+int QDeclarativeMarkerLayerMapItem::markerAt(const QPointF &position) const
+{
+    const QVector<int> markers = hitIndex_.containing(position);
+    return markers.isEmpty() ? -1 : markers.last();
+}
+
+/*!
+    \qmlmethod list<int> MapMarkerLayer::markersIn(rect rect)
+
+    Returns the indices of the markers whose symbols intersect \a rect, in
+    the coordinates of the map, in ascending order.
+*/
+QList<int> QDeclarativeMarkerLayerMapItem::markersIn(const QRectF &rect) const
+{
+    return hitIndex_.intersecting(rect).toList();
+}
+
+/*!
+    \internal
+*/
+bool QDeclarativeMarkerLayerMapItem::contains(const QPointF &point) const
+{
+    return markerAt(point) >= 0;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::mousePressEvent(QMouseEvent *event)
+{
+    pressedMarker_ = markerAt(event->localPos());
+    if (pressedMarker_ < 0)
+        event->ignore();
+    else
+        event->accept();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::mouseReleaseEvent(QMouseEvent *event)
+{
+    const int marker = pressedMarker_;
+    pressedMarker_ = -1;
+    if (marker >= 0 && markerAt(event->localPos()) == marker)
+        emit clicked(marker);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::mouseUngrabEvent()
+{
+    pressedMarker_ = -1;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeMarkerLayerMapItem::afterViewportChanged(const QGeoMapViewportChangeEvent &event)
+{
+    if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
+        return;
+
+    // every marker keeps its size on screen, so any change moves them all
+    polishAndUpdate();
+}
+
+/*!
+    \internal
+
+    Places the markers that are on screen. The layer covers the whole map,
+    so its item coordinates are those of the map.
+*/
+void QDeclarativeMarkerLayerMapItem::updatePolish()
+{
+    if (!map() || !quickMap())
+        return;
+
+    const QSizeF mapSize(quickMap()->width(), quickMap()->height());
+    setPosition(QPointF(0, 0));
+    setSize(mapSize);
+
+    vertices_.clear();
+    hitIndex_.clear();
+    verticesDirty_ = true;
+
+    const QSizeF size = effectiveSymbolSize();
+    if (size.isEmpty() || image_.isNull())
+        return;
+
+    const QPointF anchor = effectiveAnchorPoint();
+    const QRectF viewport(QPointF(0, 0), mapSize);
+    hitIndex_.setCellSize(qMax(size.width(), size.height()));
+
+    // the cells of the atlas, left to right and top to bottom
+    const int columns = qMax(1, int(image_.width() / size.width()));
+    const int rows = qMax(1, int(image_.height() / size.height()));
+    const qreal cellWidth = size.width() / image_.width();
+    const qreal cellHeight = size.height() / image_.height();
+
+    const QGeoMercatorTransform transform = map()->mercatorTransform();
+    const int count = coordinates_.size();
+    for (int i = 0; i < count; ++i) {
+        QPointF position;
+        if (transform.isValid()) {
+            if (qIsNaN(mercator_.at(2 * i)))
+                continue;
+            position = transform.map(QDoubleVector2D(mercator_.at(2 * i), mercator_.at(2 * i + 1))).toPointF();
+        } else {
+            if (!coordinates_.at(i).isValid())
+                continue;
+            position = map()->coordinateToItemPosition(coordinates_.at(i), false).toPointF();
+        }
+
+        QRectF rect(position - anchor, size);
+        if (!qIsFinite(rect.left()) || !qIsFinite(rect.top()) || !rect.intersects(viewport))
+            continue;
+
+        // symbols are drawn unscaled; on whole pixels every pixel samples
+        // exactly one texel of its own cell
+        rect.moveTopLeft(QPointF(qRound(rect.left()), qRound(rect.top())));
+
+        hitIndex_.insert(i, rect);
+
+        const int symbol = qBound(0, symbols_.value(i, 0), columns * rows - 1);
+        const qreal tx = (symbol % columns) * cellWidth;
+        const qreal ty = (symbol / columns) * cellHeight;
+
+        QSGGeometry::TexturedPoint2D topLeft, topRight, bottomLeft, bottomRight;
+        topLeft.set(rect.left(), rect.top(), tx, ty);
+        topRight.set(rect.right(), rect.top(), tx + cellWidth, ty);
+        bottomLeft.set(rect.left(), rect.bottom(), tx, ty + cellHeight);
+        bottomRight.set(rect.right(), rect.bottom(), tx + cellWidth, ty + cellHeight);
+        vertices_ << topLeft << bottomLeft << topRight
+                  << topRight << bottomLeft << bottomRight;
+    }
+}
+
+/*!
+    \internal
+*/
+QSGNode *QDeclarativeMarkerLayerMapItem::updateMapItemPaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    if (image_.isNull()) {
+        delete oldNode;
+        return 0;
+    }
+
+    MapMarkerLayerNode *node = static_cast<MapMarkerLayerNode *>(oldNode);
+    if (!node) {
+        node = new MapMarkerLayerNode();
+        imageDirty_ = true;
+        verticesDirty_ = true;
+    }
+
+    if (imageDirty_) {
+        // texture coordinates depend on where the image ends up
+        node->updateTexture(window(), image_);
+        imageDirty_ = false;
+        verticesDirty_ = true;
+    }
+    if (verticesDirty_) {
+        node->updateGeometry(vertices_);
+        verticesDirty_ = false;
+    }
+    return node;
+}
+
+/*!
+    \internal
+
+    Loads the symbols from the source, or draws the dot used without one.
+*/
+void QDeclarativeMarkerLayerMapItem::updateImage()
+{
+    image_ = QImage();
+    imageDirty_ = true;
+
+    if (!source_.isEmpty()) {
+        const QString path = QQmlFile::urlToLocalFileOrQrc(source_);
+        if (!image_.load(path))
+            qmlInfo(this) << "Cannot load marker symbols from " << source_.toString();
+        return;
+    }
+
+    const QSize size = symbolSize_.isEmpty() ? QSize(DEFAULT_DOT_SIZE, DEFAULT_DOT_SIZE)
+                                             : symbolSize_;
+    image_ = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    image_.fill(Qt::transparent);
+
+    QPainter painter(&image_);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(color_);
+    painter.drawEllipse(QRectF(QPointF(0, 0), size));
+}
+
+QSizeF QDeclarativeMarkerLayerMapItem::effectiveSymbolSize() const
+{
+    if (!symbolSize_.isEmpty())
+        return symbolSize_;
+    return image_.size();
+}
+
+QPointF QDeclarativeMarkerLayerMapItem::effectiveAnchorPoint() const
+{
+    if (anchorPointSet_)
+        return anchorPoint_;
+    const QSizeF size = effectiveSymbolSize();
+    return QPointF(size.width() / 2.0, size.height() / 2.0);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+/*!
+    \internal
+*/
+MapMarkerLayerNode::MapMarkerLayerNode()
+:   geometry_(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0),
+    texture_(0)
+{
+    geometry_.setDrawingMode(GL_TRIANGLES);
+    // linear filtering would blend in the edges of the neighbouring cells
+    material_.setFiltering(QSGTexture::Nearest);
+    setGeometry(&geometry_);
+    setMaterial(&material_);
+}
+
+/*!
+    \internal
+*/
+MapMarkerLayerNode::~MapMarkerLayerNode()
+{
+    delete texture_;
+}
+
+/*!
+    \internal
+*/
+void MapMarkerLayerNode::updateTexture(QQuickWindow *window, const QImage &image)
+{
+    delete texture_;
+    texture_ = 0;
+    if (window && !image.isNull())
+        texture_ = window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel);
+
+    material_.setTexture(texture_);
+    markDirty(DirtyMaterial);
+}
+
+/*!
+    \internal
+
+    Takes \a vertices with texture coordinates relative to the whole image
+    and maps them into the texture, which may be part of an atlas.
+*/
+void MapMarkerLayerNode::updateGeometry(const QVector<QSGGeometry::TexturedPoint2D> &vertices)
+{
+    geometry_.allocate(vertices.size());
+
+    const QRectF sub = texture_ ? texture_->normalizedTextureSubRect() : QRectF(0, 0, 1, 1);
+    QSGGeometry::TexturedPoint2D *out = geometry_.vertexDataAsTexturedPoint2D();
+    for (int i = 0; i < vertices.size(); ++i) {
+        const QSGGeometry::TexturedPoint2D &v = vertices.at(i);
+        out[i].set(v.x, v.y, sub.x() + v.tx * sub.width(), sub.y() + v.ty * sub.height());
+    }
+    markDirty(DirtyGeometry);
+}
+
+QT_END_NAMESPACE
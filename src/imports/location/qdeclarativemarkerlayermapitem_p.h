@@ -0,0 +1,171 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QDECLARATIVEMARKERLAYERMAPITEM_H
+#define QDECLARATIVEMARKERLAYERMAPITEM_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qdeclarativegeomapitembase_p.h"
+
+#include <QtCore/QUrl>
+#include <QtGui/QImage>
+#include <QtQuick/QSGGeometryNode>
+#include <QtQuick/QSGTextureMaterial>
+#include <QtLocation/private/qgeogridindex_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QDeclarativeMarkerLayerMapItem : public QDeclarativeGeoMapItemBase
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QJSValue coordinates READ coordinates WRITE setCoordinates NOTIFY coordinatesChanged)
+    Q_PROPERTY(QList<int> symbols READ symbols WRITE setSymbols NOTIFY symbolsChanged)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QSize symbolSize READ symbolSize WRITE setSymbolSize NOTIFY symbolSizeChanged)
+    Q_PROPERTY(QPointF anchorPoint READ anchorPoint WRITE setAnchorPoint NOTIFY anchorPointChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+    Q_PROPERTY(int count READ count NOTIFY coordinatesChanged)
+
+public:
+    explicit QDeclarativeMarkerLayerMapItem(QQuickItem *parent = 0);
+    ~QDeclarativeMarkerLayerMapItem();
+
+    virtual void setMap(QDeclarativeGeoMap *quickMap, QGeoMap *map) Q_DECL_OVERRIDE;
+    virtual QSGNode *updateMapItemPaintNode(QSGNode *, UpdatePaintNodeData *) Q_DECL_OVERRIDE;
+
+    QJSValue coordinates() const;
+    void setCoordinates(const QJSValue &value);
+    void setCoordinatesFromGeoList(const QList<QGeoCoordinate> &coordinates);
+    int count() const;
+
+    QList<int> symbols() const;
+    void setSymbols(const QList<int> &symbols);
+
+    QUrl source() const;
+    void setSource(const QUrl &source);
+
+    QSize symbolSize() const;
+    void setSymbolSize(const QSize &size);
+
+    QPointF anchorPoint() const;
+    void setAnchorPoint(const QPointF &anchorPoint);
+
+    QColor color() const;
+    void setColor(const QColor &color);
+
+    Q_INVOKABLE void setCoordinate(int index, const QGeoCoordinate &coordinate);
+    Q_INVOKABLE int markerAt(const QPointF &position) const;
+    Q_INVOKABLE QList<int> markersIn(const QRectF &rect) const;
+
+    bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void coordinatesChanged();
+    void symbolsChanged();
+    void sourceChanged();
+    void symbolSizeChanged();
+    void anchorPointChanged();
+    void colorChanged();
+    void clicked(int index);
+
+protected:
+    void updatePolish() Q_DECL_OVERRIDE;
+    void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    void mouseReleaseEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    void mouseUngrabEvent() Q_DECL_OVERRIDE;
+
+protected Q_SLOTS:
+    virtual void afterViewportChanged(const QGeoMapViewportChangeEvent &event) Q_DECL_OVERRIDE;
+
+private:
+    void updateImage();
+    QSizeF effectiveSymbolSize() const;
+    QPointF effectiveAnchorPoint() const;
+
+    QList<QGeoCoordinate> coordinates_;
+    QVector<double> mercator_;      // x, y pairs, NaN for invalid coordinates
+    QList<int> symbols_;
+    QUrl source_;
+    QSize symbolSize_;
+    QPointF anchorPoint_;
+    bool anchorPointSet_;
+    QColor color_;
+
+    QImage image_;                  // symbol atlas, or a dot in color_ without a source
+    bool imageDirty_;
+
+    // two triangles for every marker on screen, texture coordinates relative
+    // to image_, and the rectangles of those markers for hit testing
+    QVector<QSGGeometry::TexturedPoint2D> vertices_;
+    QGeoGridIndex hitIndex_;
+    bool verticesDirty_;
+
+    int pressedMarker_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+class MapMarkerLayerNode : public QSGGeometryNode
+{
+public:
+    MapMarkerLayerNode();
+    ~MapMarkerLayerNode();
+
+    void updateTexture(QQuickWindow *window, const QImage &image);
+    void updateGeometry(const QVector<QSGGeometry::TexturedPoint2D> &vertices);
+
+private:
+    QSGTextureMaterial material_;
+    QSGGeometry geometry_;
+    QSGTexture *texture_;
+};
+
+QT_END_NAMESPACE
+
+QML_DECLARE_TYPE(QDeclarativeMarkerLayerMapItem)
+
+#endif
@@ -40,14 +40,21 @@
 #include "error_messages.h"
 #include "locationvaluetypehelper_p.h"
 
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
 #include <QtCore/QScopedValueRollback>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtGui/private/qtriangulator_p.h>
 #include <QtQml/QQmlInfo>
 #include <QtQml/private/qqmlengine_p.h>
 #include <QPainter>
 #include <QPainterPath>
+#include <QTransform>
 #include <qnumeric.h>
 
+#include <cmath>
+
 #include "qdoublevector2d_p.h"
 
 /* poly2tri triangulator includes */
@@ -103,8 +110,9 @@ QT_BEGIN_NAMESPACE
     of vertices. This means that the per frame cost of having a Polygon on the
     Map grows in direct proportion to the number of points on the Polygon. There
     is an additional triangulation cost (approximately O(n log n)) which is
-    currently paid with each frame, but in future may be paid only upon adding
-    or removing points.
+    paid when the points change or the zoom level changes their level of
+    detail. Polygons with many points are triangulated in the background and
+    keep their previous shape until the new one is ready.
 
     Like the other map objects, MapPolygon is normally drawn without a smooth
     appearance. Setting the \l {Item::opacity}{opacity} property will force the object to
@@ -137,9 +145,176 @@ struct Vertex
     QVector2D position;
 };
 
+// Cached triangulations are kept in mercator units scaled by this, which
+// keeps poly2tri's fixed epsilon well below the size of small polygons.
+static const double TRIANGULATION_SCALE = 1 << 24;
+
+// Screen space points closer than this to the previous or the first point
+// of their ring are left out. A scaled mercator unit is 16 pixels at zoom
+// level 20, so cached triangulations only leave out exact repeats.
+static const double SCREEN_DUPLICATE_EPSILON = 0.1;
+
+// Above this size in pixels the cached triangulation is not used for a
+// clipped update: vertices are passed on as floats and would lose precision,
+// so the visible part is clipped and triangulated instead.
+static const double MAX_TRIANGULATION_EXTENT = 1 << 16;
+
+// Polygons with at least this many vertices at their level of detail are
+// triangulated on a worker thread, when the geometry has an owner to notify.
+static const int BACKGROUND_TRIANGULATION_VERTICES = 512;
+
+static void triangulate(const QVector<QGeoPolygonClipper::Ring> &rings, double epsilon,
+                        QVector<double> *vertices, QVector<quint32> *indices);
+
+/*
+    Everything needed to triangulate one level of detail of a polygon. The
+    input is a snapshot of the geometry's path taken when the task is created,
+    the results are written once by the worker. The owner is cleared under
+    the mutex when the task is cancelled, so the worker never notifies an
+    item that is gone or has moved on to another path.
+*/
+struct QGeoMapPolygonTriangulationTask
+{
+    QGeoMapPolygonTriangulationTask(const QVector<double> &path, bool assumeSimple, QObject *owner)
+    :   path(path), assumeSimple(assumeSimple), owner(owner), cancelled(false), finished(false)
+    {
+    }
+
+    bool isCancelled()
+    {
+        QMutexLocker locker(&mutex);
+        return cancelled;
+    }
+
+    bool isFinished()
+    {
+        QMutexLocker locker(&mutex);
+        return finished;
+    }
+
+    void cancel()
+    {
+        QMutexLocker locker(&mutex);
+        cancelled = true;
+        owner = 0;
+    }
+
+    const QVector<double> path;
+    const bool assumeSimple;
+
+    QMutex mutex;
+    QObject *owner;
+    bool cancelled;
+    bool finished;
+
+    QVector<QGeoPolygonClipper::Ring> rings;
+    QPainterPath outline;
+    QRectF bounds;
+    QVector<double> vertices;
+    QVector<quint32> indices;
+};
+
+class QGeoMapPolygonTriangulationRunnable : public QRunnable
+{
+public:
+    explicit QGeoMapPolygonTriangulationRunnable(const QSharedPointer<QGeoMapPolygonTriangulationTask> &task)
+    :   task_(task)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    QSharedPointer<QGeoMapPolygonTriangulationTask> task_;
+};
+
+// keeps a core free for the GUI and render threads
+class QGeoMapItemThreadPool : public QThreadPool
+{
+public:
+    QGeoMapItemThreadPool()
+    {
+        setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    }
+};
+
+Q_GLOBAL_STATIC(QGeoMapItemThreadPool, mapItemThreadPool)
+
 QGeoMapPolygonGeometry::QGeoMapPolygonGeometry()
-:   assumeSimple_(false)
+:   assumeSimple_(false),
+    srcRingsDirty_(true),
+    mercatorRingsValid_(false),
+    triangulationDirty_(true),
+    backgroundOwner_(0)
+{
+}
+
+QGeoMapPolygonGeometry::~QGeoMapPolygonGeometry()
+{
+    cancelTriangulation();
+}
+
+/*!
+    \internal
+
+    Lets large polygons be triangulated on a worker thread. Until a
+    triangulation is done the geometry keeps showing the previous one, and
+    when it is done the polishAndUpdate() slot of \a owner is invoked. The
+    owner must outlive the geometry. Pass 0 to triangulate synchronously.
+*/
+void QGeoMapPolygonGeometry::setBackgroundTriangulation(QObject *owner)
 {
+    if (backgroundOwner_ == owner)
+        return;
+
+    backgroundOwner_ = owner;
+    if (triangulationTask_) {
+        cancelTriangulation();
+        mercatorRingsValid_ = false;
+    }
+}
+
+/*!
+    \internal
+*/
+void QGeoMapPolygonGeometry::setAssumeSimple(bool value)
+{
+    if (assumeSimple_ == value)
+        return;
+
+    assumeSimple_ = value;
+    srcRingsDirty_ = true;
+    mercatorRingsValid_ = false;
+    triangulationDirty_ = true;
+}
+
+/*!
+    \internal
+
+    Splits \a path into rings for QGeoPolygonClipper, resolving self
+    intersections first unless the polygon is assumed to be simple.
+*/
+static QVector<QGeoPolygonClipper::Ring> pathToRings(const QPainterPath &path, bool assumeSimple)
+{
+    const QPainterPath simple = assumeSimple ? path : path.simplified();
+
+    QVector<QGeoPolygonClipper::Ring> rings;
+    for (int i = 0; i < simple.elementCount(); ++i) {
+        const QPainterPath::Element e = simple.elementAt(i);
+        if (e.isMoveTo())
+            rings.append(QGeoPolygonClipper::Ring());
+        if (!rings.isEmpty())
+            rings.last() << e.x << e.y;
+    }
+    for (int i = 0; i < rings.size(); ++i) {
+        // drop the point closeSubpath() repeats
+        QGeoPolygonClipper::Ring &ring = rings[i];
+        const int n = ring.size();
+        if (n >= 4 && ring.at(0) == ring.at(n - 2) && ring.at(1) == ring.at(n - 1))
+            ring.resize(n - 2);
+    }
+    QGeoPolygonClipper::orient(rings);
+    return rings;
 }
 
 /*!
@@ -157,18 +332,21 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
     QDoubleVector2D origin;
     QDoubleVector2D lastPoint;
     srcPath_ = QPainterPath();
+    srcRingsDirty_ = true;
 
     double unwrapBelowX = 0;
     if (preserveGeometry_ )
         unwrapBelowX = map.coordinateToItemPosition(geoLeftBound_, false).x();
 
-    for (int i = 0; i < path.size(); ++i) {
-        const QGeoCoordinate &coord = path.at(i);
+    if (projectPath(map, path))
+        mercatorRingsValid_ = false;
+    const double *positions = projectedPath_.constData();
 
-        if (!coord.isValid())
-            continue;
+    for (int j = 0; j < lodIndices_.size(); ++j) {
+        const int i = mercatorIndices_.at(lodIndices_.at(j));
+        const QGeoCoordinate &coord = path.at(i);
 
-        QDoubleVector2D point = map.coordinateToItemPosition(coord, false);
+        QDoubleVector2D point(positions[2 * j], positions[2 * j + 1]);
 
         // We can get NaN if the map isn't set up correctly, or the projection
         // is faulty -- probably best thing to do is abort
@@ -179,7 +357,7 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
         if (preserveGeometry_ && point.x() < unwrapBelowX
                 && !qFuzzyCompare(point.x(), unwrapBelowX)
                 && !qFuzzyCompare(geoLeftBound_.longitude(), coord.longitude()))
-            point.setX(unwrapBelowX + geoDistanceToScreenWidth(map, geoLeftBound_, coord));
+            point.setX(unwrapBelowX + unwrapDistance(map, j));
 
         if (i == 0) {
             origin = point;
@@ -200,18 +378,259 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
 
     srcPath_.closeSubpath();
 
-    if (!assumeSimple_)
-        srcPath_ = srcPath_.simplified();
+    if (!mercatorRingsValid_)
+        updateMercatorRings();
 
     sourceBounds_ = srcPath_.boundingRect();
     geoLeftBound_ = map.itemPositionToCoordinate(QDoubleVector2D(minX, 0), false);
 }
 
+/*!
+    \internal
+
+    Builds the rings of a polygon in mercator space from its level of detail
+    \a path, relative to the first coordinate and unwrapped across the
+    dateline, along with their outline and bounds. A path that winds around
+    the globe, like a circle over a pole, has no such shape and gives no
+    rings. This runs on worker threads as well, so it touches nothing but
+    its arguments.
+
+    Every edge is unwrapped the shorter way around the globe, so an edge
+    spanning more than 180 degrees of longitude crosses the dateline here.
+    updateSourcePoints() instead places every point east of the polygon's
+    left bound, where such an edge may go the long way round.
+*/
+static void buildMercatorRings(const QVector<double> &path, bool assumeSimple,
+                               QVector<QGeoPolygonClipper::Ring> *rings,
+                               QPainterPath *outline, QRectF *bounds)
+{
+    rings->clear();
+    *outline = QPainterPath();
+    *bounds = QRectF();
+
+    const int count = path.size() / 2;
+    const double *mercator = path.constData();
+    QPainterPath ring;
+    double x = 0.0;
+    ring.moveTo(0.0, 0.0);
+    for (int i = 1; i < count; ++i) {
+        double dx = mercator[2 * i] - mercator[2 * i - 2];
+        dx -= std::floor(dx + 0.5);
+        x += dx;
+        ring.lineTo(x * TRIANGULATION_SCALE, (mercator[2 * i + 1] - mercator[1]) * TRIANGULATION_SCALE);
+    }
+    ring.closeSubpath();
+
+    double dx = mercator[0] - mercator[2 * count - 2];
+    dx -= std::floor(dx + 0.5);
+    if (qAbs(x + dx) > 0.5)
+        return;
+
+    *rings = pathToRings(ring, assumeSimple);
+    foreach (const QGeoPolygonClipper::Ring &r, *rings) {
+        for (int i = 0; i < r.size(); i += 2) {
+            if (i == 0)
+                outline->moveTo(r.at(i), r.at(i + 1));
+            else
+                outline->lineTo(r.at(i), r.at(i + 1));
+        }
+        outline->closeSubpath();
+    }
+    *bounds = outline->boundingRect();
+}
+
+void QGeoMapPolygonTriangulationRunnable::run()
+{
+    if (task_->isCancelled())
+        return;
+
+    QVector<QGeoPolygonClipper::Ring> rings;
+    QPainterPath outline;
+    QRectF bounds;
+    buildMercatorRings(task_->path, task_->assumeSimple, &rings, &outline, &bounds);
+
+    if (task_->isCancelled())
+        return;
+
+    QVector<double> vertices;
+    QVector<quint32> indices;
+    triangulate(rings, 0.0, &vertices, &indices);
+
+    QMutexLocker locker(&task_->mutex);
+    if (task_->cancelled)
+        return;
+    task_->rings = rings;
+    task_->outline = outline;
+    task_->bounds = bounds;
+    task_->vertices = vertices;
+    task_->indices = indices;
+    task_->finished = true;
+    QMetaObject::invokeMethod(task_->owner, "polishAndUpdate", Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Rebuilds the rings of the polygon in mercator space. They only change
+    with the path and its level of detail, so the triangulation built from
+    them is reused for every viewport in between.
+
+    Large polygons with a background owner are handed to the worker pool
+    instead, superseding any triangulation still running for an earlier path
+    or level of detail. The current rings stay in place until the result is
+    taken in updateScreenPoints().
+*/
+void QGeoMapPolygonGeometry::updateMercatorRings()
+{
+    mercatorRingsValid_ = true;
+    cancelTriangulation();
+
+    const int count = lodIndices_.size();
+    if (backgroundOwner_ && count >= BACKGROUND_TRIANGULATION_VERTICES
+            && mercatorIndices_.first() == 0) {
+        triangulationTask_ = QSharedPointer<QGeoMapPolygonTriangulationTask>(
+                    new QGeoMapPolygonTriangulationTask(lodPath_, assumeSimple_, backgroundOwner_));
+        mapItemThreadPool()->start(new QGeoMapPolygonTriangulationRunnable(triangulationTask_));
+        return;
+    }
+
+    triangulationDirty_ = true;
+    if (count < 3 || mercatorIndices_.first() != 0) {
+        mercatorRings_.clear();
+        mercatorOutline_ = QPainterPath();
+        mercatorBounds_ = QRectF();
+        return;
+    }
+    buildMercatorRings(lodPath_, assumeSimple_, &mercatorRings_, &mercatorOutline_, &mercatorBounds_);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapPolygonGeometry::cancelTriangulation()
+{
+    if (!triangulationTask_)
+        return;
+    triangulationTask_->cancel();
+    triangulationTask_.clear();
+}
+
+/*!
+    \internal
+
+    Swaps in the result of a finished background triangulation. Returns
+    false while there is none.
+*/
+bool QGeoMapPolygonGeometry::takeTriangulation()
+{
+    if (!triangulationTask_ || !triangulationTask_->isFinished())
+        return false;
+
+    // the worker is done with the task, no need to lock
+    QGeoMapPolygonTriangulationTask *task = triangulationTask_.data();
+    mercatorRings_ = task->rings;
+    mercatorOutline_ = task->outline;
+    mercatorBounds_ = task->bounds;
+    triangulationVertices_ = task->vertices;
+    triangulationIndices_ = task->indices;
+    triangulationDirty_ = false;
+    triangulationTask_.clear();
+    return true;
+}
+
+/*!
+    \internal
+
+    Triangulates \a rings, outer rings with a positive signed area and holes
+    with a negative one as QGeoPolygonClipper produces them, into
+    \a vertices (x, y pairs) and \a indices. The poly2tri points live in one
+    array for the whole call, and their position in it is the vertex index.
+
+    The triangulator cannot handle repeated points, so points no further
+    than \a epsilon from the previous or the first one of their ring are
+    left out. An \a epsilon of 0 leaves out exact repeats only.
+*/
+static void triangulate(const QVector<QGeoPolygonClipper::Ring> &rings, double epsilon,
+                        QVector<double> *vertices, QVector<quint32> *indices)
+{
+    vertices->clear();
+    indices->clear();
+
+    int total = 0;
+    foreach (const QGeoPolygonClipper::Ring &ring, rings)
+        total += ring.size() / 2;
+
+    // reserved up front so that pointers into it stay valid
+    std::vector<p2t::Point> arena;
+    arena.reserve(total);
+
+    QVector<std::vector<p2t::Point *> > polylines(rings.size());
+    QVector<double> areas(rings.size());
+    for (int r = 0; r < rings.size(); ++r) {
+        const QGeoPolygonClipper::Ring &ring = rings.at(r);
+        std::vector<p2t::Point *> &polyline = polylines[r];
+        polyline.reserve(ring.size() / 2);
+        for (int i = 0; i < ring.size(); i += 2) {
+            const double x = ring.at(i);
+            const double y = ring.at(i + 1);
+            if (!polyline.empty()
+                    && ((qAbs(x - polyline.back()->x) <= epsilon && qAbs(y - polyline.back()->y) <= epsilon)
+                        || (qAbs(x - polyline.front()->x) <= epsilon && qAbs(y - polyline.front()->y) <= epsilon))) {
+                continue;
+            }
+            arena.push_back(p2t::Point(x, y));
+            polyline.push_back(&arena.back());
+        }
+        areas[r] = QGeoPolygonClipper::signedArea(ring);
+    }
+
+    // every hole goes into the smallest outer ring around it
+    QVector<int> parents(rings.size(), -1);
+    for (int h = 0; h < rings.size(); ++h) {
+        if (areas.at(h) >= 0.0 || polylines.at(h).size() < 3)
+            continue;
+        for (int r = 0; r < rings.size(); ++r) {
+            if (areas.at(r) > 0.0
+                    && (parents.at(h) < 0 || areas.at(r) < areas.at(parents.at(h)))
+                    && QGeoPolygonClipper::contains(rings.at(r), rings.at(h).at(0), rings.at(h).at(1))) {
+                parents[h] = r;
+            }
+        }
+    }
+
+    for (int r = 0; r < rings.size(); ++r) {
+        if (areas.at(r) <= 0.0 || polylines.at(r).size() < 3)
+            continue;
+
+        p2t::CDT cdt(polylines.at(r));
+        for (int h = 0; h < rings.size(); ++h) {
+            if (parents.at(h) == r)
+                cdt.AddHole(polylines.at(h));
+        }
+        cdt.Triangulate();
+
+        std::vector<p2t::Triangle*> tris = cdt.GetTriangles();
+        indices->reserve(indices->size() + 3 * int(tris.size()));
+        for (size_t i = 0; i < tris.size(); ++i) {
+            p2t::Triangle *t = tris.at(i);
+            for (int j = 0; j < 3; ++j)
+                *indices << quint32(t->GetPoint(j) - &arena.front());
+        }
+    }
+
+    vertices->reserve(2 * int(arena.size()));
+    for (size_t i = 0; i < arena.size(); ++i)
+        *vertices << arena[i].x << arena[i].y;
+}
+
 /*!
     \internal
 */
 void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMap &map)
 {
+    if (takeTriangulation())
+        screenDirty_ = true;
+
     if (!screenDirty_)
         return;
 
@@ -220,6 +639,54 @@ void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMap &map)
         return;
     }
 
+    // nothing to show until the first background triangulation is done;
+    // triangulating in screen space instead is what it is there to avoid
+    if (triangulationTask_ && mercatorRings_.isEmpty()) {
+        clear();
+        screenOutline_ = QPainterPath();
+        screenBounds_ = QRectF();
+        return;
+    }
+
+    // item positions relative to the first coordinate are the cached
+    // mercator rings scaled by the map's transform
+    const double scaleX = transform_.scaleX() / TRIANGULATION_SCALE;
+    const double scaleY = transform_.scaleY() / TRIANGULATION_SCALE;
+    if (transform_.isValid() && !mercatorRings_.isEmpty()
+            && (!clipToViewport_
+                || qMax(scaleX * mercatorBounds_.width(),
+                        scaleY * mercatorBounds_.height()) <= MAX_TRIANGULATION_EXTENT)) {
+        if (triangulationDirty_) {
+            triangulate(mercatorRings_, 0.0, &triangulationVertices_, &triangulationIndices_);
+            triangulationDirty_ = false;
+        }
+
+        clear();
+
+        const double left = scaleX * mercatorBounds_.left();
+        const double top = scaleY * mercatorBounds_.top();
+        const double *vertices = triangulationVertices_.constData();
+        const int count = triangulationVertices_.size() / 2;
+        screenVertices_.resize(count);
+        QPointF *points = screenVertices_.data();
+        for (int i = 0; i < count; ++i)
+            points[i] = QPointF(scaleX * vertices[2 * i] - left, scaleY * vertices[2 * i + 1] - top);
+        screenIndices_ = triangulationIndices_;
+
+        firstPointOffset_ = QPointF(-left, -top);
+        screenOutline_ = QTransform(scaleX, 0, 0, scaleY, -left, -top).map(mercatorOutline_);
+        screenBounds_ = QRectF(0, 0, scaleX * mercatorBounds_.width(), scaleY * mercatorBounds_.height());
+        return;
+    }
+
+    // polygons larger than MAX_TRIANGULATION_EXTENT on screen are clipped
+    // to the viewport and triangulated here, on the GUI thread, however many
+    // vertices they have
+    if (srcRingsDirty_) {
+        srcRings_ = pathToRings(srcPath_, assumeSimple_);
+        srcRingsDirty_ = false;
+    }
+
     QDoubleVector2D origin = map.coordinateToItemPosition(srcOrigin_, false);
 
     // Create the viewport rect in the same coordinate system
@@ -227,92 +694,54 @@ void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMap &map)
     QRectF viewport(0, 0, map.width(), map.height());
     viewport.translate(-1 * origin.toPointF());
 
-    QPainterPath vpPath;
-    vpPath.addRect(viewport);
-
-    QPainterPath ppi;
+    QVector<QGeoPolygonClipper::Ring> rings;
     if (clipToViewport_)
-        ppi = srcPath_.intersected(vpPath); // get the clipped version of the path
-    else ppi = srcPath_;
+        rings = QGeoPolygonClipper::clip(srcRings_, viewport); // get the clipped version of the path
+    else
+        rings = srcRings_;
 
     clear();
 
-    // a polygon requires at least 3 points;
-    if (ppi.elementCount() < 3)
+    if (rings.isEmpty())
         return;
 
-    // Intersection between the viewport and a concave polygon can create multiple polygons
-    // joined by a line at the viewport border, and poly2tri does not triangulate this very well
-    // so use the full src path if the resulting polygon is concave.
-    if (clipToViewport_) {
-        int changeInX = 0;
-        int changeInY = 0;
-        QPainterPath::Element e1 = ppi.elementAt(1);
-        QPainterPath::Element e = ppi.elementAt(0);
-        QVector2D edgeA(e1.x - e.x ,e1.y - e.y);
-        for (int i = 2; i <= ppi.elementCount(); ++i) {
-            e = ppi.elementAt(i % ppi.elementCount());
-            if (e.x == e1.x && e.y == e1.y)
-                continue;
-            QVector2D edgeB(e.x - e1.x, e.y - e1.y);
-            if ((edgeA.x() < 0) == (edgeB.x() >= 0))
-                changeInX++;
-            if ((edgeA.y() < 0) == (edgeB.y() >= 0))
-                changeInY++;
-            edgeA = edgeB;
-            e1 = e;
-        }
-        if (changeInX > 2 || changeInY > 2) // polygon is concave
-            ppi = srcPath_;
-    }
-
-    // translate the path into top-left-centric coordinates
-    QRectF bb = ppi.boundingRect();
-    ppi.translate(-bb.left(), -bb.top());
-    firstPointOffset_ = -1 * bb.topLeft();
-
-    ppi.closeSubpath();
-
-    screenOutline_ = ppi;
-
-    std::vector<p2t::Point*> curPts;
-    curPts.reserve(ppi.elementCount());
-    for (int i = 0; i < ppi.elementCount(); ++i) {
-        const QPainterPath::Element e = ppi.elementAt(i);
-        if (e.isMoveTo() || i == ppi.elementCount() - 1
-                || (qAbs(e.x - curPts.front()->x) < 0.1
-                    && qAbs(e.y - curPts.front()->y) < 0.1)) {
-            if (curPts.size() > 2) {
-                p2t::CDT *cdt = new p2t::CDT(curPts);
-                cdt->Triangulate();
-                std::vector<p2t::Triangle*> tris = cdt->GetTriangles();
-                screenVertices_.reserve(screenVertices_.size() + int(tris.size()));
-                for (size_t i = 0; i < tris.size(); ++i) {
-                    p2t::Triangle *t = tris.at(i);
-                    for (int j = 0; j < 3; ++j) {
-                        p2t::Point *p = t->GetPoint(j);
-                        screenVertices_ << QPointF(p->x, p->y);
-                    }
-                }
-                delete cdt;
-            }
-            curPts.clear();
-            curPts.reserve(ppi.elementCount() - i);
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else if (e.isLineTo()) {
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else {
-            qWarning("Unhandled element type in polygon painterpath");
+    // translate the rings into top-left-centric coordinates
+    double minX = rings.first().at(0);
+    double minY = rings.first().at(1);
+    double maxX = minX;
+    double maxY = minY;
+    foreach (const QGeoPolygonClipper::Ring &ring, rings) {
+        for (int i = 0; i < ring.size(); i += 2) {
+            minX = qMin(minX, ring.at(i));
+            maxX = qMax(maxX, ring.at(i));
+            minY = qMin(minY, ring.at(i + 1));
+            maxY = qMax(maxY, ring.at(i + 1));
         }
     }
-
-    if (curPts.size() > 0) {
-        qDeleteAll(curPts.begin(), curPts.end());
-        curPts.clear();
+    firstPointOffset_ = QPointF(-minX, -minY);
+
+    QPainterPath outline;
+    for (int r = 0; r < rings.size(); ++r) {
+        QGeoPolygonClipper::Ring &ring = rings[r];
+        for (int i = 0; i < ring.size(); i += 2) {
+            ring[i] -= minX;
+            ring[i + 1] -= minY;
+            if (i == 0)
+                outline.moveTo(ring.at(i), ring.at(i + 1));
+            else
+                outline.lineTo(ring.at(i), ring.at(i + 1));
+        }
+        outline.closeSubpath();
     }
+    screenOutline_ = outline;
 
-    screenBounds_ = ppi.boundingRect();
+    QVector<double> vertices;
+    triangulate(rings, SCREEN_DUPLICATE_EPSILON, &vertices, &screenIndices_);
+    screenVertices_.resize(vertices.size() / 2);
+    for (int i = 0; i < screenVertices_.size(); ++i)
+        screenVertices_[i] = QPointF(vertices.at(2 * i), vertices.at(2 * i + 1));
 
+    screenBounds_ = QRectF(0, 0, maxX - minX, maxY - minY);
 }
 
 QDeclarativePolygonMapItem::QDeclarativePolygonMapItem(QQuickItem *parent)
@@ -320,6 +749,7 @@ QDeclarativePolygonMapItem::QDeclarativePolygonMapItem(QQuickItem *parent)
     updatingGeometry_(false)
 {
     setFlag(ItemHasContents, true);
+    geometry_.setBackgroundTriangulation(this);
     QObject::connect(&border_, SIGNAL(colorChanged(QColor)),
                      this, SLOT(handleBorderUpdated()));
     QObject::connect(&border_, SIGNAL(widthChanged(qreal)),
@@ -530,10 +960,15 @@ void QDeclarativePolygonMapItem::updatePolish()
     geometry_.updateSourcePoints(*map(), path_);
     geometry_.updateScreenPoints(*map());
 
-    QList<QGeoCoordinate> closedPath = path_;
-    closedPath << closedPath.first();
+    // keep the closed path between updates so the border geometry can
+    // reuse its mercator cache
+    if (!path_.isSharedWith(closedPathSource_)) {
+        closedPathSource_ = path_;
+        closedPath_ = path_;
+        closedPath_ << path_.first();
+    }
     borderGeometry_.clear();
-    borderGeometry_.updateSourcePoints(*map(), closedPath);
+    borderGeometry_.updateSourcePoints(*map(), closedPath_);
 
     if (border_.color() != Qt::transparent && border_.width() > 0)
         borderGeometry_.updateScreenPoints(*map(), border_.width());
@@ -592,6 +1027,17 @@ bool QDeclarativePolygonMapItem::contains(const QPointF &point) const
     return (geometry_.contains(point) || borderGeometry_.contains(point));
 }
 
+/*!
+    \internal
+    The border geometry already adds half of the border width, square caps
+    can reach out by the other half.
+*/
+QRectF QDeclarativePolygonMapItem::hitTestBounds() const
+{
+    const qreal w = 0.5 * border_.width();
+    return boundingRect().adjusted(-w, -w, w, w);
+}
+
 /*!
     \internal
 */
@@ -677,7 +1123,7 @@ bool MapPolygonNode::isSubtreeBlocked() const
 */
 void MapPolygonNode::update(const QColor &fillColor, const QColor &borderColor,
                             const QGeoMapItemGeometry *fillShape,
-                            const QGeoMapItemGeometry *borderShape)
+                            const QGeoMapPolylineGeometry *borderShape)
 {
     /* Do the border update first */
     border_->update(borderColor, borderShape);
@@ -687,7 +1133,7 @@ void MapPolygonNode::update(const QColor &fillColor, const QColor &borderColor,
      * we're a little conservative here (maybe at the expense of rendering
      * accuracy) */
     if (fillShape->size() == 0) {
-        if (borderShape->size() == 0) {
+        if (borderShape->isEmpty()) {
             blocked_ = true;
             return;
         } else {
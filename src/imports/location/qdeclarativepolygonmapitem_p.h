@@ -51,20 +51,25 @@
 #include "qdeclarativegeomapitembase_p.h"
 #include "qdeclarativepolylinemapitem_p.h"
 #include "qgeomapitemgeometry_p.h"
+#include "qgeopolygonclipper_p.h"
 
+#include <QtCore/QSharedPointer>
 #include <QSGGeometryNode>
 #include <QSGFlatColorMaterial>
 
 QT_BEGIN_NAMESPACE
 
 class MapPolygonNode;
+struct QGeoMapPolygonTriangulationTask;
 
 class QGeoMapPolygonGeometry : public QGeoMapItemGeometry
 {
 public:
     QGeoMapPolygonGeometry();
+    ~QGeoMapPolygonGeometry();
 
-    inline void setAssumeSimple(bool value) { assumeSimple_ = value; }
+    void setAssumeSimple(bool value);
+    void setBackgroundTriangulation(QObject *owner);
 
     void updateSourcePoints(const QGeoMap &map,
                             const QList<QGeoCoordinate> &path);
@@ -72,8 +77,30 @@ public:
     void updateScreenPoints(const QGeoMap &map);
 
 protected:
+    void updateMercatorRings();
+    void cancelTriangulation();
+    bool takeTriangulation();
+
     QPainterPath srcPath_;
+    QVector<QGeoPolygonClipper::Ring> srcRings_; // srcPath_ as oriented rings for clipping
     bool assumeSimple_;
+    bool srcRingsDirty_;
+
+    // the polygon in scaled mercator space relative to its first coordinate,
+    // with a triangulation that lasts until the path or its level of detail
+    // changes
+    QVector<QGeoPolygonClipper::Ring> mercatorRings_;
+    QPainterPath mercatorOutline_;
+    QRectF mercatorBounds_;
+    bool mercatorRingsValid_;
+    QVector<double> triangulationVertices_;
+    QVector<quint32> triangulationIndices_;
+    bool triangulationDirty_;
+
+    // large polygons are triangulated on a worker thread, after which
+    // backgroundOwner_ gets polished to pick up the result
+    QObject *backgroundOwner_;
+    QSharedPointer<QGeoMapPolygonTriangulationTask> triangulationTask_;
 };
 
 class QDeclarativePolygonMapItem : public QDeclarativeGeoMapItemBase
@@ -104,6 +131,7 @@ public:
     QDeclarativeMapLineProperties *border();
 
     bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+    QRectF hitTestBounds() const Q_DECL_OVERRIDE;
 
 Q_SIGNALS:
     void pathChanged();
@@ -122,6 +150,8 @@ private:
 
     QDeclarativeMapLineProperties border_;
     QList<QGeoCoordinate> path_;
+    QList<QGeoCoordinate> closedPath_;       // path_ with the first coordinate repeated
+    QList<QGeoCoordinate> closedPathSource_; // shares data with path_ until it is modified
     QColor color_;
     bool dirtyMaterial_;
     QGeoMapPolygonGeometry geometry_;
@@ -140,7 +170,7 @@ public:
 
     void update(const QColor &fillColor, const QColor &borderColor,
                 const QGeoMapItemGeometry *fillShape,
-                const QGeoMapItemGeometry *borderShape);
+                const QGeoMapPolylineGeometry *borderShape);
 
     bool isSubtreeBlocked() const;
 
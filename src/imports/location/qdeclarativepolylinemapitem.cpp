@@ -47,8 +47,13 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <QPainterPathStroker>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QVector4D>
 #include <qnumeric.h>
 
+#include <cmath>
+#include <cstring>
+
 #include <QtGui/private/qvectorpath_p.h>
 #include <QtGui/private/qtriangulatingstroker_p.h>
 #include <QtGui/private/qtriangulator_p.h>
@@ -172,10 +177,149 @@ struct Vertex
     QVector2D position;
 };
 
+// Above this size in pixels the line is stroked on the CPU: the shader works
+// in floats and would lose precision. Clipping keeps the CPU path bounded.
+static const double MAX_SHADER_STROKE_EXTENT = 1 << 20;
+
 QGeoMapPolylineGeometry::QGeoMapPolylineGeometry()
+:   lineExtent_(1.0),
+    lineRevision_(0),
+    lineVerticesValid_(false),
+    strokeInShader_(false),
+    strokeWidth_(0.0)
 {
 }
 
+/*!
+    \internal
+
+    Rebuilds the vertex data of the centre line from the mercator path. It
+    only changes with the path itself or its level of detail; zooming in
+    between changes the scale the shader is given and panning only moves
+    the item.
+*/
+void QGeoMapPolylineGeometry::updateLineVertices()
+{
+    static int revision = 0;
+
+    lineVerticesValid_ = true;
+    lineRevision_ = ++revision;
+    lineVertices_.clear();
+    lineBounds_ = QRectF();
+    lineExtent_ = 1.0;
+
+    const int count = lodIndices_.size();
+    if (count < 2)
+        return;
+
+    // unwrapped across the dateline and without repeated points, which
+    // would have no direction to stroke along
+    const double *mercator = lodPath_.constData();
+    QVector<double> line;
+    line.reserve(2 * count);
+    line << 0.0 << 0.0;
+    double x = 0.0;
+    double minX = 0.0;
+    double maxX = 0.0;
+    double minY = 0.0;
+    double maxY = 0.0;
+    double extent = 0.0;
+    for (int i = 1; i < count; ++i) {
+        double dx = mercator[2 * i] - mercator[2 * i - 2];
+        dx -= std::floor(dx + 0.5);
+        const double y = mercator[2 * i + 1] - mercator[1];
+        if (dx == 0.0 && y == line.last())
+            continue;
+        x += dx;
+        line << x << y;
+        minX = qMin(minX, x);
+        maxX = qMax(maxX, x);
+        minY = qMin(minY, y);
+        maxY = qMax(maxY, y);
+        extent = qMax(extent, qMax(qAbs(x), qAbs(y)));
+    }
+
+    const int points = line.size() / 2;
+    if (points < 2)
+        return;
+
+    lineBounds_ = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    lineExtent_ = extent;
+
+    // the ends come as one pair of vertices, the points in between as two:
+    // one ending the incoming segment and one starting the outgoing one
+    lineVertices_.resize(4 * points - 4);
+    LineVertex *vertices = lineVertices_.data();
+    for (int i = 0; i < points; ++i) {
+        const int previous = qMax(i - 1, 0);
+        const int next = qMin(i + 1, points - 1);
+        LineVertex v;
+        v.x = line.at(2 * i) / extent;
+        v.y = line.at(2 * i + 1) / extent;
+        v.previousX = line.at(2 * previous) / extent;
+        v.previousY = line.at(2 * previous + 1) / extent;
+        v.nextX = line.at(2 * next) / extent;
+        v.nextY = line.at(2 * next + 1) / extent;
+        const int pairs = (i == 0 || i == points - 1) ? 1 : 2;
+        for (int j = 0; j < pairs; ++j) {
+            v.outgoing = i == 0 ? 1.0f : float(j);
+            v.side = 1.0f;
+            *vertices++ = v;
+            v.side = -1.0f;
+            *vertices++ = v;
+        }
+    }
+}
+
+/*!
+    \internal
+*/
+bool QGeoMapPolylineGeometry::isEmpty() const
+{
+    if (strokeInShader_)
+        return lineVertices_.isEmpty() || strokeWidth_ <= 0.0;
+    return size() == 0;
+}
+
+/*!
+    \internal
+
+    Returns the item pixels per unit of the line vertices.
+*/
+QPointF QGeoMapPolylineGeometry::lineScale() const
+{
+    return QPointF(transform_.scaleX() * lineExtent_, transform_.scaleY() * lineExtent_);
+}
+
+/*!
+    \internal
+
+    Returns whether \a point, in item coordinates, is within half the stroke
+    width of the centre line stroked by the shader.
+*/
+bool QGeoMapPolylineGeometry::strokeContains(const QPointF &point) const
+{
+    const QPointF scale = lineScale();
+    const double halfWidth = strokeWidth_ / 2.0;
+    const double px = point.x() - firstPointOffset_.x();
+    const double py = point.y() - firstPointOffset_.y();
+
+    for (int i = 2; i < lineVertices_.size(); i += 2) {
+        const double ax = scale.x() * lineVertices_.at(i - 2).x;
+        const double ay = scale.y() * lineVertices_.at(i - 2).y;
+        const double dx = scale.x() * lineVertices_.at(i).x - ax;
+        const double dy = scale.y() * lineVertices_.at(i).y - ay;
+        const double length = dx * dx + dy * dy;
+        double t = length > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / length : 0.0;
+        t = qBound(0.0, t, 1.0);
+        const double ex = ax + t * dx - px;
+        const double ey = ay + t * dy - py;
+        if (ex * ex + ey * ey <= halfWidth * halfWidth)
+            return true;
+    }
+    return false;
+}
+
 /*!
     \internal
 */
@@ -191,11 +335,38 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
     if (!sourceDirty_)
         return;
 
+    if (projectPath(map, path))
+        lineVerticesValid_ = false;
+
+    // stroke in the shader when the whole line fits into floats
+    strokeInShader_ = false;
+    strokeWidth_ = 0.0;
+    if (transform_.isValid()) {
+        if (!lineVerticesValid_)
+            updateLineVertices();
+
+        const QRectF bounds(transform_.scaleX() * lineBounds_.left(),
+                            transform_.scaleY() * lineBounds_.top(),
+                            transform_.scaleX() * lineBounds_.width(),
+                            transform_.scaleY() * lineBounds_.height());
+        if (!lineVertices_.isEmpty()
+                && qMax(bounds.width(), bounds.height()) <= MAX_SHADER_STROKE_EXTENT
+                && qIsFinite(projectedPath_.at(0)) && qIsFinite(projectedPath_.at(1))) {
+            strokeInShader_ = true;
+            srcOrigin_ = path.at(mercatorIndices_.first());
+            sourceBounds_ = bounds;
+            geoLeftBound_ = map.itemPositionToCoordinate(
+                        QDoubleVector2D(bounds.left() + projectedPath_.at(0),
+                                        bounds.top() + projectedPath_.at(1)), false);
+            return;
+        }
+    }
+
     // clear the old data and reserve enough memory
     srcPoints_.clear();
-    srcPoints_.reserve(path.size() * 2);
+    srcPoints_.reserve(lodIndices_.size() * 2);
     srcPointTypes_.clear();
-    srcPointTypes_.reserve(path.size());
+    srcPointTypes_.reserve(lodIndices_.size());
 
     QDoubleVector2D origin, lastPoint, lastAddedPoint;
 
@@ -204,13 +375,13 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
     if (preserveGeometry_)
         unwrapBelowX = map.coordinateToItemPosition(geoLeftBound_, false).x();
 
-    for (int i = 0; i < path.size(); ++i) {
-        const QGeoCoordinate &coord = path.at(i);
+    const double *positions = projectedPath_.constData();
 
-        if (!coord.isValid())
-            continue;
+    for (int j = 0; j < lodIndices_.size(); ++j) {
+        const int i = mercatorIndices_.at(lodIndices_.at(j));
+        const QGeoCoordinate &coord = path.at(i);
 
-        QDoubleVector2D point = map.coordinateToItemPosition(coord, false);
+        QDoubleVector2D point(positions[2 * j], positions[2 * j + 1]);
 
         // We can get NaN if the map isn't set up correctly, or the projection
         // is faulty -- probably best thing to do is abort
@@ -222,7 +393,7 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
                 && !qFuzzyCompare(geoLeftBound_.longitude(), coord.longitude())
                 && !qFuzzyCompare(point.x(), unwrapBelowX)
                 && !qFuzzyCompare(mapWidthHalf, point.x()))
-            point.setX(unwrapBelowX + geoDistanceToScreenWidth(map, geoLeftBound_, coord));
+            point.setX(unwrapBelowX + unwrapDistance(map, j));
 
         if (!foundValid) {
             foundValid = true;
@@ -385,6 +556,15 @@ void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
     if (!screenDirty_)
         return;
 
+    if (strokeInShader_) {
+        clear();
+        strokeWidth_ = strokeWidth;
+        const qreal halfWidth = strokeWidth / 2.0;
+        screenBounds_ = sourceBounds_.adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+        this->translate( -1 * sourceBounds_.topLeft());
+        return;
+    }
+
     QPointF origin = map.coordinateToItemPosition(srcOrigin_, false).toPointF();
 
     if (!qIsFinite(origin.x()) || !qIsFinite(origin.y())) {
@@ -845,6 +1025,9 @@ QSGNode *QDeclarativePolylineMapItem::updateMapItemPaintNode(QSGNode *oldNode, U
 
 bool QDeclarativePolylineMapItem::contains(const QPointF &point) const
 {
+    if (geometry_.strokeInShader())
+        return geometry_.strokeContains(point);
+
     QVector<QPointF> vertices = geometry_.vertices();
     QPolygonF tri;
     for (int i = 0; i < vertices.size(); ++i) {
@@ -859,16 +1042,209 @@ bool QDeclarativePolylineMapItem::contains(const QPointF &point) const
     return false;
 }
 
+/*!
+    \internal
+    Square caps reach out up to a full line width from the centre line.
+*/
+QRectF QDeclarativePolylineMapItem::hitTestBounds() const
+{
+    const qreal w = line_.width();
+    return boundingRect().adjusted(-w, -w, w, w);
+}
+
 //////////////////////////////////////////////////////////////////////
 
+/*
+    Strokes the centre line: every vertex is pushed out to its side along the
+    normal of its segment. A point between two segments ends one and starts
+    the other, so the strip has a separate quad per segment and the two
+    triangles between them fill the bevel, like the default QPen join of the
+    CPU stroker. Hairpin turns only make those triangles degenerate, where a
+    shared miter would twist the quad. Ends get square caps like QPen's
+    default. Plain GLSL ES 1.0 so that it runs on software GL implementations
+    as well.
+*/
+static const char polylineVertexShader[] =
+        "uniform highp mat4 qt_Matrix;\n"
+        "uniform highp vec2 scale;\n"
+        "uniform highp vec2 offset;\n"
+        "uniform highp float halfWidth;\n"
+        "attribute highp vec2 position;\n"
+        "attribute highp vec2 previous;\n"
+        "attribute highp vec2 next;\n"
+        "attribute highp float side;\n"
+        "attribute highp float outgoing;\n"
+        "highp vec2 direction(highp vec2 from, highp vec2 to)\n"
+        "{\n"
+        "    highp vec2 d = (to - from) * scale;\n"
+        "    highp float l = length(d);\n"
+        "    return l > 0.0 ? d / l : vec2(0.0);\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "    highp vec2 pos = position * scale + offset;\n"
+        "    highp vec2 dirIn = direction(previous, position);\n"
+        "    highp vec2 dirOut = direction(position, next);\n"
+        "    if (dirIn == vec2(0.0)) {\n"
+        "        dirIn = dirOut;\n"
+        "        pos -= dirOut * halfWidth;\n"
+        "    }\n"
+        "    if (dirOut == vec2(0.0)) {\n"
+        "        dirOut = dirIn;\n"
+        "        pos += dirIn * halfWidth;\n"
+        "    }\n"
+        "    highp vec2 dir = outgoing > 0.5 ? dirOut : dirIn;\n"
+        "    highp vec2 normal = vec2(-dir.y, dir.x);\n"
+        "    gl_Position = qt_Matrix * vec4(pos + normal * halfWidth * side, 0.0, 1.0);\n"
+        "}\n";
+
+static const char polylineFragmentShader[] =
+        "uniform lowp vec4 color;\n"
+        "uniform lowp float qt_Opacity;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = color * qt_Opacity;\n"
+        "}\n";
+
+class MapPolylineShader : public QSGMaterialShader
+{
+public:
+    MapPolylineShader()
+    :   matrixId_(-1), opacityId_(-1), colorId_(-1), scaleId_(-1), offsetId_(-1), halfWidthId_(-1)
+    {
+    }
+
+    const char *vertexShader() const Q_DECL_OVERRIDE { return polylineVertexShader; }
+    const char *fragmentShader() const Q_DECL_OVERRIDE { return polylineFragmentShader; }
+
+    char const *const *attributeNames() const Q_DECL_OVERRIDE
+    {
+        static char const *const names[] = { "position", "previous", "next", "side", "outgoing", 0 };
+        return names;
+    }
+
+    void updateState(const RenderState &state, QSGMaterial *newMaterial, QSGMaterial *oldMaterial) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(oldMaterial);
+
+        if (state.isMatrixDirty())
+            program()->setUniformValue(matrixId_, state.combinedMatrix());
+        if (state.isOpacityDirty())
+            program()->setUniformValue(opacityId_, state.opacity());
+
+        // every line has its own material, so the values are always set
+        const MapPolylineMaterial *material = static_cast<const MapPolylineMaterial *>(newMaterial);
+        const QColor c = material->color();
+        program()->setUniformValue(colorId_, QVector4D(c.redF() * c.alphaF(), c.greenF() * c.alphaF(),
+                                                       c.blueF() * c.alphaF(), c.alphaF()));
+        program()->setUniformValue(scaleId_, material->scale());
+        program()->setUniformValue(offsetId_, material->offset());
+        program()->setUniformValue(halfWidthId_, GLfloat(material->width() / 2.0));
+    }
+
+private:
+    void initialize() Q_DECL_OVERRIDE
+    {
+        matrixId_ = program()->uniformLocation("qt_Matrix");
+        opacityId_ = program()->uniformLocation("qt_Opacity");
+        colorId_ = program()->uniformLocation("color");
+        scaleId_ = program()->uniformLocation("scale");
+        offsetId_ = program()->uniformLocation("offset");
+        halfWidthId_ = program()->uniformLocation("halfWidth");
+    }
+
+    int matrixId_;
+    int opacityId_;
+    int colorId_;
+    int scaleId_;
+    int offsetId_;
+    int halfWidthId_;
+};
+
+/*!
+    \internal
+*/
+MapPolylineMaterial::MapPolylineMaterial()
+:   color_(Qt::black), width_(0.0)
+{
+}
+
+/*!
+    \internal
+*/
+QSGMaterialType *MapPolylineMaterial::type() const
+{
+    static QSGMaterialType type;
+    return &type;
+}
+
+/*!
+    \internal
+*/
+QSGMaterialShader *MapPolylineMaterial::createShader() const
+{
+    return new MapPolylineShader;
+}
+
+/*!
+    \internal
+*/
+int MapPolylineMaterial::compare(const QSGMaterial *other) const
+{
+    const MapPolylineMaterial *m = static_cast<const MapPolylineMaterial *>(other);
+    if (color_.rgba() != m->color_.rgba())
+        return color_.rgba() < m->color_.rgba() ? -1 : 1;
+    if (scale_ != m->scale_ || offset_ != m->offset_ || width_ != m->width_)
+        return this < m ? -1 : 1;
+    return 0;
+}
+
+/*!
+    \internal
+
+    Returns true if any of the values changed.
+*/
+bool MapPolylineMaterial::update(const QColor &color, const QPointF &scale,
+                                 const QPointF &offset, qreal width)
+{
+    if (color_ == color && scale_ == scale && offset_ == offset && width_ == width)
+        return false;
+
+    color_ = color;
+    scale_ = scale;
+    offset_ = offset;
+    width_ = width;
+    setFlag(Blending, color_.alpha() < 255);
+    return true;
+}
+
+static const QSGGeometry::AttributeSet &lineAttributes()
+{
+    static QSGGeometry::Attribute attributes[] = {
+        QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),
+        QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(2, 2, GL_FLOAT),
+        QSGGeometry::Attribute::create(3, 1, GL_FLOAT),
+        QSGGeometry::Attribute::create(4, 1, GL_FLOAT)
+    };
+    static QSGGeometry::AttributeSet attributeSet = {
+        5, sizeof(QGeoMapPolylineGeometry::LineVertex), attributes
+    };
+    return attributeSet;
+}
+
 /*!
     \internal
 */
 MapPolylineNode::MapPolylineNode() :
     geometry_(QSGGeometry::defaultAttributes_Point2D(),0),
+    line_geometry_(lineAttributes(), 0),
+    line_revision_(0),
     blocked_(true)
 {
     geometry_.setDrawingMode(GL_TRIANGLE_STRIP);
+    line_geometry_.setDrawingMode(GL_TRIANGLE_STRIP);
+    line_geometry_.setVertexDataPattern(QSGGeometry::StaticPattern);
     QSGGeometryNode::setMaterial(&fill_material_);
     QSGGeometryNode::setGeometry(&geometry_);
 }
@@ -893,15 +1269,46 @@ bool MapPolylineNode::isSubtreeBlocked() const
     \internal
 */
 void MapPolylineNode::update(const QColor &fillColor,
-                             const QGeoMapItemGeometry *shape)
+                             const QGeoMapPolylineGeometry *shape)
 {
-    if (shape->size() == 0) {
+    if (shape->isEmpty()) {
         blocked_ = true;
         return;
     } else {
         blocked_ = false;
     }
 
+    if (shape->strokeInShader()) {
+        if (QSGGeometryNode::geometry() != &line_geometry_) {
+            QSGGeometryNode::setGeometry(&line_geometry_);
+            QSGGeometryNode::setMaterial(&line_material_);
+            line_revision_ = 0;
+            markDirty(DirtyMaterial);
+        }
+
+        // the centre line is only uploaded when the path changed
+        if (line_revision_ != shape->lineRevision()) {
+            const QVector<QGeoMapPolylineGeometry::LineVertex> &vertices = shape->lineVertices();
+            line_geometry_.allocate(vertices.size());
+            memcpy(line_geometry_.vertexData(), vertices.constData(),
+                   vertices.size() * sizeof(QGeoMapPolylineGeometry::LineVertex));
+            line_revision_ = shape->lineRevision();
+            markDirty(DirtyGeometry);
+        }
+
+        if (line_material_.update(fillColor, shape->lineScale(), shape->firstPointOffset(),
+                                  shape->strokeWidth())) {
+            markDirty(DirtyMaterial);
+        }
+        return;
+    }
+
+    if (QSGGeometryNode::geometry() != &geometry_) {
+        QSGGeometryNode::setGeometry(&geometry_);
+        QSGGeometryNode::setMaterial(&fill_material_);
+        markDirty(DirtyMaterial);
+    }
+
     QSGGeometry *fill = QSGGeometryNode::geometry();
     shape->allocateAndFill(fill);
     markDirty(DirtyGeometry);
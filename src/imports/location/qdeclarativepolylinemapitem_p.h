@@ -53,6 +53,7 @@
 
 #include <QSGGeometryNode>
 #include <QSGFlatColorMaterial>
+#include <QSGMaterial>
 
 QT_BEGIN_NAMESPACE
 
@@ -86,6 +87,20 @@ private:
 class QGeoMapPolylineGeometry : public QGeoMapItemGeometry
 {
 public:
+    // a point of the centre line, once for each side of the line and, but
+    // for the ends, once for each of its two segments
+    struct LineVertex
+    {
+        float x;
+        float y;
+        float previousX;
+        float previousY;
+        float nextX;
+        float nextY;
+        float side;
+        float outgoing;
+    };
+
     QGeoMapPolylineGeometry();
 
     void updateSourcePoints(const QGeoMap &map,
@@ -94,13 +109,35 @@ public:
     void updateScreenPoints(const QGeoMap &map,
                             qreal strokeWidth);
 
+    bool isEmpty() const;
+
+    inline bool strokeInShader() const { return strokeInShader_; }
+    inline const QVector<LineVertex> &lineVertices() const { return lineVertices_; }
+    inline int lineRevision() const { return lineRevision_; }
+    inline qreal strokeWidth() const { return strokeWidth_; }
+    QPointF lineScale() const;
+    bool strokeContains(const QPointF &point) const;
+
 private:
+    void updateLineVertices();
+
     QVector<qreal> srcPoints_;
     QVector<QPainterPath::ElementType> srcPointTypes_;
 
-
+    // the centre line in mercator units relative to the first coordinate,
+    // divided by lineExtent_ so that it fits into floats without losing
+    // precision; the shader scales it back and strokes it
+    QVector<LineVertex> lineVertices_;
+    QRectF lineBounds_;
+    double lineExtent_;
+    int lineRevision_;
+    bool lineVerticesValid_;
+    bool strokeInShader_;
+    qreal strokeWidth_;
 };
 
+Q_DECLARE_TYPEINFO(QGeoMapPolylineGeometry::LineVertex, Q_PRIMITIVE_TYPE);
+
 class QDeclarativePolylineMapItem : public QDeclarativeGeoMapItemBase
 {
     Q_OBJECT
@@ -129,6 +166,7 @@ public:
     virtual void setPath(const QJSValue &value);
 
     bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+    QRectF hitTestBounds() const Q_DECL_OVERRIDE;
 
     QDeclarativeMapLineProperties *line();
 
@@ -157,6 +195,29 @@ private:
 
 //////////////////////////////////////////////////////////////////////
 
+class MapPolylineMaterial : public QSGMaterial
+{
+public:
+    MapPolylineMaterial();
+
+    QSGMaterialType *type() const Q_DECL_OVERRIDE;
+    QSGMaterialShader *createShader() const Q_DECL_OVERRIDE;
+    int compare(const QSGMaterial *other) const Q_DECL_OVERRIDE;
+
+    bool update(const QColor &color, const QPointF &scale, const QPointF &offset, qreal width);
+
+    inline QColor color() const { return color_; }
+    inline QPointF scale() const { return scale_; }
+    inline QPointF offset() const { return offset_; }
+    inline qreal width() const { return width_; }
+
+private:
+    QColor color_;
+    QPointF scale_;
+    QPointF offset_;
+    qreal width_;
+};
+
 class MapPolylineNode : public QSGGeometryNode
 {
 
@@ -164,12 +225,15 @@ public:
     MapPolylineNode();
     ~MapPolylineNode();
 
-    void update(const QColor &fillColor, const QGeoMapItemGeometry *shape);
+    void update(const QColor &fillColor, const QGeoMapPolylineGeometry *shape);
     bool isSubtreeBlocked() const;
 
 private:
     QSGFlatColorMaterial fill_material_;
     QSGGeometry geometry_;
+    MapPolylineMaterial line_material_;
+    QSGGeometry line_geometry_;
+    int line_revision_;
     bool blocked_;
 };
 
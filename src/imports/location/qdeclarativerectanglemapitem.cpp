@@ -407,6 +407,17 @@ bool QDeclarativeRectangleMapItem::contains(const QPointF &point) const
     return (geometry_.contains(point) || borderGeometry_.contains(point));
 }
 
+/*!
+    \internal
+    The border geometry already adds half of the border width, square caps
+    can reach out by the other half.
+*/
+QRectF QDeclarativeRectangleMapItem::hitTestBounds() const
+{
+    const qreal w = 0.5 * border_.width();
+    return boundingRect().adjusted(-w, -w, w, w);
+}
+
 /*!
     \internal
 */
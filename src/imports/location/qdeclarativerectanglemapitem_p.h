@@ -97,6 +97,7 @@ public:
     QDeclarativeMapLineProperties *border();
 
     bool contains(const QPointF &point) const Q_DECL_OVERRIDE;
+    QRectF hitTestBounds() const Q_DECL_OVERRIDE;
 
 Q_SIGNALS:
     void topLeftChanged(const QGeoCoordinate &topLeft);
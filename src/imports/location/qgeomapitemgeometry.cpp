@@ -39,11 +39,23 @@
 #include "qlocationutils_p.h"
 #include <QtQuick/QSGGeometry>
 #include "qdoublevector2d_p.h"
+#include <QtPositioning/private/qgeoprojection_p.h>
+
+#include <climits>
+#include <cmath>
 
 QT_BEGIN_NAMESPACE
 
+// Paths are simplified to this many pixels at the zoom level a level of
+// detail is made for, and to at most twice as many in between.
+static const double LOD_TOLERANCE = 0.5;
+
+// lodLevel_ when every vertex is kept
+static const int LOD_ALL_VERTICES = INT_MIN;
+
 QGeoMapItemGeometry::QGeoMapItemGeometry()
-:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false)
+:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false),
+    simplifierValid_(false), lodLevel_(LOD_ALL_VERTICES), leftBoundMercatorX_(0.0)
 {
 }
 
@@ -68,6 +80,15 @@ void QGeoMapItemGeometry::allocateAndFill(QSGGeometry *geom) const
     const QVector<QPointF> &vx = screenVertices_;
     const QVector<quint32> &ix = screenIndices_;
 
+    if (isIndexed() && vx.size() > 0xffff && geom->indexType() == GL_UNSIGNED_SHORT) {
+        // too many vertices for 16 bit indices, draw the triangles unindexed
+        geom->allocate(ix.size());
+        QSGGeometry::Point2D *pts = geom->vertexDataAsPoint2D();
+        for (int i = 0; i < ix.size(); ++i)
+            pts[i].set(vx[ix[i]].x(), vx[ix[i]].y());
+        return;
+    }
+
     if (isIndexed()) {
         geom->allocate(vx.size(), ix.size());
         if (geom->indexType() == GL_UNSIGNED_SHORT) {
@@ -137,4 +158,143 @@ double QGeoMapItemGeometry::geoDistanceToScreenWidth(const QGeoMap &map,
     return halfScreenDist.x() * 2.0;
 }
 
+/*!
+    \internal
+
+    Projects the valid coordinates of \a path to item positions in
+    projectedPath_. The path is converted to mercator space only when it
+    differs from the one used last time, after that a change of the viewport
+    costs a single pass of the map's mercator transform over the vertices.
+    Maps without such a transform are projected one coordinate at a time.
+
+    Only the vertices in lodIndices_ are projected. Once the path is in
+    mercator space it is simplified for every tolerance at once, and each
+    power of two of the map scale gets the vertices that matter at that
+    zoom, picked in time proportional to their number. Maps without a
+    mercator transform keep every vertex.
+
+    Returns true if the mercator path or the vertices kept of it changed.
+*/
+bool QGeoMapItemGeometry::projectPath(const QGeoMap &map, const QList<QGeoCoordinate> &path)
+{
+    bool rebuilt = false;
+    if (!path.isSharedWith(mercatorSource_) && path != mercatorSource_) {
+        rebuilt = true;
+        mercatorSource_ = path;
+        mercatorIndices_.clear();
+        mercatorIndices_.reserve(path.size());
+        mercatorPath_.clear();
+        mercatorPath_.reserve(path.size() * 2);
+
+        for (int i = 0; i < path.size(); ++i) {
+            const QGeoCoordinate &coord = path.at(i);
+            if (!coord.isValid())
+                continue;
+
+            QDoubleVector2D mercator = QGeoProjection::coordToMercator(coord);
+            mercatorIndices_ << i;
+            mercatorPath_ << mercator.x() << mercator.y();
+        }
+
+        simplifierValid_ = false;
+        simplifier_.clear();
+        lodLevel_ = LOD_ALL_VERTICES;
+        lodIndices_.clear();
+        lodPath_.clear();
+    }
+
+    transform_ = map.mercatorTransform();
+
+    int level = LOD_ALL_VERTICES;
+    if (transform_.isValid() && transform_.scaleX() > 0.0) {
+        std::frexp(transform_.scaleX(), &level);
+        level -= 1;
+    }
+
+    if (level != lodLevel_ || (lodIndices_.isEmpty() && !mercatorIndices_.isEmpty())) {
+        rebuilt = true;
+        lodLevel_ = level;
+        selectLevelOfDetail();
+    }
+
+    const int count = lodIndices_.size();
+    projectedPath_.resize(count * 2);
+
+    if (transform_.isValid()) {
+        transform_.map(lodPath_.constData(), projectedPath_.data(), count);
+        if (preserveGeometry_)
+            leftBoundMercatorX_ = QGeoProjection::coordToMercator(geoLeftBound_).x();
+    } else {
+        double *positions = projectedPath_.data();
+        for (int i = 0; i < count; ++i) {
+            QDoubleVector2D point = map.coordinateToItemPosition(
+                        mercatorSource_.at(mercatorIndices_.at(lodIndices_.at(i))), false);
+            positions[2 * i] = point.x();
+            positions[2 * i + 1] = point.y();
+        }
+    }
+
+    return rebuilt;
+}
+
+/*!
+    \internal
+
+    Fills lodIndices_ and lodPath_ with the vertices of the mercator path
+    kept at lodLevel_.
+*/
+void QGeoMapItemGeometry::selectLevelOfDetail()
+{
+    const int count = mercatorIndices_.size();
+
+    if (lodLevel_ == LOD_ALL_VERTICES) {
+        lodIndices_.resize(count);
+        for (int i = 0; i < count; ++i)
+            lodIndices_[i] = i;
+        lodPath_ = mercatorPath_;
+        return;
+    }
+
+    if (!simplifierValid_) {
+        // simplify the path unwrapped across the dateline
+        simplifierValid_ = true;
+        QVector<double> unwrapped(mercatorPath_);
+        double *points = unwrapped.data();
+        for (int i = 1; i < count; ++i) {
+            double dx = points[2 * i] - points[2 * i - 2];
+            dx -= std::floor(dx + 0.5);
+            points[2 * i] = points[2 * i - 2] + dx;
+        }
+        simplifier_.build(unwrapped.constData(), count);
+    }
+
+    simplifier_.select(LOD_TOLERANCE / std::ldexp(1.0, lodLevel_), &lodIndices_);
+
+    lodPath_.resize(2 * lodIndices_.size());
+    const double *mercator = mercatorPath_.constData();
+    double *points = lodPath_.data();
+    for (int i = 0; i < lodIndices_.size(); ++i) {
+        points[2 * i] = mercator[2 * lodIndices_.at(i)];
+        points[2 * i + 1] = mercator[2 * lodIndices_.at(i) + 1];
+    }
+}
+
+/*!
+    \internal
+
+    Returns the screen distance eastwards from geoLeftBound_ to the projected
+    point at \a index, as geoDistanceToScreenWidth() does.
+*/
+double QGeoMapItemGeometry::unwrapDistance(const QGeoMap &map, int index)
+{
+    if (!transform_.isValid()) {
+        return geoDistanceToScreenWidth(map, geoLeftBound_,
+                mercatorSource_.at(mercatorIndices_.at(lodIndices_.at(index))));
+    }
+
+    double dx = lodPath_.at(2 * index) - leftBoundMercatorX_;
+    dx -= std::floor(dx);
+    return dx * transform_.scaleX();
+}
+
 QT_END_NAMESPACE
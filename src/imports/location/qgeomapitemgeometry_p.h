@@ -55,6 +55,8 @@
 #include <QGeoCoordinate>
 #include <QVector2D>
 #include <QList>
+#include <QtLocation/private/qgeomercatortransform_p.h>
+#include <QtLocation/private/qgeopathsimplifier_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -124,6 +126,10 @@ public:
 
 
 protected:
+    bool projectPath(const QGeoMap &map, const QList<QGeoCoordinate> &path);
+    void selectLevelOfDetail();
+    double unwrapDistance(const QGeoMap &map, int index);
+
     bool sourceDirty_;
     bool screenDirty_;
     bool clipToViewport_;
@@ -141,6 +147,19 @@ protected:
 
     QVector<QPointF> screenVertices_;
     QVector<quint32> screenIndices_;
+
+    // source path in mercator space, rebuilt only when the path itself changes
+    QList<QGeoCoordinate> mercatorSource_;
+    QVector<int> mercatorIndices_;  // index in the source path of every valid coordinate
+    QVector<double> mercatorPath_;  // x, y pairs
+    QGeoPathSimplifier simplifier_; // mercatorPath_ at every level of detail
+    bool simplifierValid_;
+    int lodLevel_;
+    QVector<int> lodIndices_;       // index in mercatorIndices_ of every vertex kept at lodLevel_
+    QVector<double> lodPath_;       // mercatorPath_ of those vertices
+    QVector<double> projectedPath_; // item positions of lodPath_, x, y pairs
+    QGeoMercatorTransform transform_;
+    double leftBoundMercatorX_;
 };
 
 QT_END_NAMESPACE
@@ -51,6 +51,14 @@ PRIVATE_HEADERS += \
                     maps/qgeoserviceprovider_p.h \
                     maps/qabstractgeotilecache_p.h \
                     maps/qgeofiletilecache_p.h \
+                    maps/qgeotilepackstore_p.h \
+                    maps/qgeotileatlas_p.h \
+                    maps/qgeotilerequesttable_p.h \
+                    maps/qgeotileseedjob_p.h \
+                    maps/qgeomercatortransform_p.h \
+                    maps/qgeopolygonclipper_p.h \
+                    maps/qgeopathsimplifier_p.h \
+                    maps/qgeogridindex_p.h \
                     maps/qgeotiledmapreply_p.h \
                     maps/qgeotiledmapreply_p_p.h \
                     maps/qgeotilespec_p.h \
@@ -84,6 +92,14 @@ SOURCES += \
             maps/qgeoserviceproviderfactory.cpp \
             maps/qabstractgeotilecache.cpp \
             maps/qgeofiletilecache.cpp \
+            maps/qgeotilepackstore.cpp \
+            maps/qgeotileatlas.cpp \
+            maps/qgeotilerequesttable.cpp \
+            maps/qgeotileseedjob.cpp \
+            maps/qgeomercatortransform.cpp \
+            maps/qgeopolygonclipper.cpp \
+            maps/qgeopathsimplifier.cpp \
+            maps/qgeogridindex.cpp \
             maps/qgeotiledmapreply.cpp \
             maps/qgeotilespec.cpp \
             maps/qgeotiledmap.cpp
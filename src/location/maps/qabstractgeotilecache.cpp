@@ -73,6 +73,43 @@ void QAbstractGeoTileCache::printStats()
 {
 }
 
+/*
+    Non-blocking variant of get(). Returns the texture if it is ready to be
+    used. Otherwise, if the tile is cached but still has to be read or decoded,
+    sets \a pending to true and emits tileLoaded() or tileLoadFailed() once
+    that has been done in the background.
+
+    The default implementation falls back to the blocking get().
+*/
+QSharedPointer<QGeoTileTexture> QAbstractGeoTileCache::getAsync(const QGeoTileSpec &spec, bool *pending)
+{
+    *pending = false;
+    return get(spec);
+}
+
+/*
+    Withdraws interest in a pending getAsync() of \a spec. Once everyone who
+    asked for the tile has cancelled, the background load is abandoned and
+    neither tileLoaded() nor tileLoadFailed() is emitted for it.
+
+    The default implementation does nothing.
+*/
+void QAbstractGeoTileCache::cancelAsync(const QGeoTileSpec &spec)
+{
+    Q_UNUSED(spec);
+}
+
+/*
+    Returns true if \a spec is held in one of the cache \a areas. Caches that
+    cannot tell return false, so callers fetch the tile again.
+*/
+bool QAbstractGeoTileCache::contains(const QGeoTileSpec &spec, QGeoTiledMappingManagerEngine::CacheAreas areas) const
+{
+    Q_UNUSED(spec);
+    Q_UNUSED(areas);
+    return false;
+}
+
 void QAbstractGeoTileCache::handleError(const QGeoTileSpec &, const QString &error)
 {
     qWarning() << "tile request error " << error;
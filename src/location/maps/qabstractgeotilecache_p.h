@@ -105,6 +105,10 @@ public:
     virtual void clearAll() = 0;
 
     virtual QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec) = 0;
+    virtual QSharedPointer<QGeoTileTexture> getAsync(const QGeoTileSpec &spec, bool *pending);
+    virtual void cancelAsync(const QGeoTileSpec &spec);
+    virtual bool contains(const QGeoTileSpec &spec,
+                          QGeoTiledMappingManagerEngine::CacheAreas areas = QGeoTiledMappingManagerEngine::AllCaches) const;
 
     virtual void insert(const QGeoTileSpec &spec,
                 const QByteArray &bytes,
@@ -114,6 +118,10 @@ public:
 
     static QString baseCacheDirectory();
 
+Q_SIGNALS:
+    void tileLoaded(const QGeoTileSpec &spec);
+    void tileLoadFailed(const QGeoTileSpec &spec);
+
 protected:
     QAbstractGeoTileCache(QObject *parent = 0);
 
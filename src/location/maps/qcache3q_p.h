@@ -160,6 +160,7 @@ public:
     bool insert(const Key &key, QSharedPointer<T> object, int cost = 1);
     QSharedPointer<T> object(const Key &key) const;
     QSharedPointer<T> operator[](const Key &key) const;
+    bool contains(const Key &key) const;
 
     void remove(const Key &key);
 
@@ -231,12 +232,14 @@ void QCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key
     int bufferSize = keys.size();
     if (bufferSize == 0)
         return;
-    clear();
+    // keys already in the cache are left alone, so that several queues can be restored in turn
     Queue *queue = queueNumber == 1 ? q1_ :
                    queueNumber == 2 ? q2_ :
                    queueNumber == 3 ? q3_ :
                                       q1_evicted_;
     for (int i = 0; i<bufferSize; ++i) {
+        if (lookup_.contains(keys[i]))
+            continue;
         Node *node = new Node;
         node->v = values[i];
         node->k = keys[i];
@@ -424,6 +427,14 @@ void QCache3Q<Key,T,EvPolicy>::remove(const Key &key)
     delete n;
 }
 
+// unlike object(), this does not count as a use of the entry
+template <class Key, class T, class EvPolicy>
+bool QCache3Q<Key,T,EvPolicy>::contains(const Key &key) const
+{
+    Node *n = lookup_.value(key, 0);
+    return n && n->q != q1_evicted_;
+}
+
 template <class Key, class T, class EvPolicy>
 QSharedPointer<T> QCache3Q<Key,T,EvPolicy>::object(const Key &key) const
 {
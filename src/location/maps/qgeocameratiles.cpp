@@ -47,10 +47,14 @@
 #include <QSet>
 #include <QSize>
 #include <cmath>
+#include <climits>
 
 QT_BEGIN_NAMESPACE
 #define PREFETCH_FRUSTUM_SCALE 2.0
 
+// Priority band reserved for each zoom layer away from the camera's layer.
+static const int TILE_PRIORITY_LAYER_STRIDE = 1 << 24;
+
 struct Frustum
 {
     QDoubleVector3D topLeftNear;
@@ -86,8 +90,49 @@ public:
     bool m_dirtyGeometry;
     bool m_dirtyMetadata;
 
+    /*
+        Tile coverage of one footprint polygon: one span of columns per row,
+        kept in flat buffers indexed by row - firstRow. The buffers keep their
+        capacity from update to update.
+    */
+    struct TileMap
+    {
+        TileMap();
+
+        void reset(int first, int last);
+        void add(int tileX, int tileY);
+
+        int firstRow;
+        int rowCount;
+        QVector<int> minX;
+        QVector<int> maxX;
+    };
+
+    struct Span
+    {
+        int min;
+        int max;
+    };
+
+    // coverage behind m_tiles, diffed against the next update
+    TileMap m_left;
+    TileMap m_right;
+    int m_coverageZoom;
+
+    TileMap m_nextLeft;
+    TileMap m_nextRight;
+    QVector<int> m_cornerX;
+    QVector<int> m_cornerY;
+
     void updateMetadata();
-    void updateGeometry(double viewExpansion = 1.0);
+    void updateVisibleTiles(bool incremental);
+    void updateGeometry(double viewExpansion, QSet<QGeoTileSpec> &tiles);
+    void computeCoverage(double viewExpansion, TileMap &left, TileMap &right);
+    void appendTiles(const TileMap &map, QSet<QGeoTileSpec> &tiles) const;
+    void updateRow(int y, const Span *spans, int count, bool insert);
+
+    static int rowSpans(const TileMap &left, const TileMap &right, int y, Span *spans);
+    static int subtractSpans(const Span *a, int countA, const Span *b, int countB, Span *result);
 
     Frustum createFrustum(double fieldOfViewGradient) const;
 
@@ -107,17 +152,39 @@ public:
     QPair<PolygonVector, PolygonVector> splitPolygonAtAxisValue(const PolygonVector &polygon, int axis, double value) const;
     QPair<PolygonVector, PolygonVector> clipFootprintToMap(const PolygonVector &footprint) const;
 
-    QList<QPair<double, int> > tileIntersections(double p1, int t1, double p2, int t2) const;
-    QSet<QGeoTileSpec> tilesFromPolygon(const PolygonVector &polygon) const;
+    void tilesFromPolygon(const PolygonVector &polygon, TileMap &map);
+};
 
-    struct TileMap
-    {
-        TileMap();
+/*
+    Walks the tile boundaries crossed by one coordinate of a polygon edge,
+    running from p1 in tile t1 to p2 in tile t2, in the order they are met.
+    fraction() is where along the edge the current boundary lies.
+*/
+class EdgeIntersections
+{
+public:
+    EdgeIntersections(double p1, int t1, double p2, int t2)
+        : m_p1(p1), m_delta(p2 - p1), m_t1(t1), m_step(t1 > t2 ? -1 : 1),
+          m_count(1 + qAbs(t2 - t1)), m_index(1) {}
 
-        void add(int tileX, int tileY);
+    bool atEnd() const { return m_index >= m_count; }
+    void next() { ++m_index; }
 
-        QMap<int, QPair<int, int> > data;
-    };
+    int tile() const { return m_t1 + m_step * m_index; }
+    double fraction() const
+    {
+        if (m_step == 1)
+            return (m_t1 + m_index - m_p1) / m_delta;
+        return (m_t1 - m_index + 1 - m_p1) / m_delta;
+    }
+
+private:
+    double m_p1;
+    double m_delta;
+    int m_t1;
+    int m_step;
+    int m_count;
+    int m_index;
 };
 
 QGeoCameraTiles::QGeoCameraTiles()
@@ -132,10 +199,10 @@ QSet<QGeoTileSpec> QGeoCameraTiles::prefetchTiles(PrefetchStle style)
     int currentIntZoom = static_cast<int>(std::floor(d_ptr->m_camera.zoomLevel()));
     double currentFloatZoom = d_ptr->m_camera.zoomLevel();
 
-    d_ptr->m_tiles.clear();
+    QSet<QGeoTileSpec> tiles;
     d_ptr->m_intZoomLevel = currentIntZoom;
     d_ptr->m_sideLength = 1 << d_ptr->m_intZoomLevel ;
-    d_ptr->updateGeometry(PREFETCH_FRUSTUM_SCALE);
+    d_ptr->updateGeometry(PREFETCH_FRUSTUM_SCALE, tiles);
 
     switch (style) {
 
@@ -150,7 +217,7 @@ QSet<QGeoTileSpec> QGeoCameraTiles::prefetchTiles(PrefetchStle style)
             // Approx heuristic, keeping total # prefetched tiles roughly independent of the
             // fractional zoom level.
             double neighbourScale = (1.0 + zoomFraction)/2.0;
-            d_ptr->updateGeometry(PREFETCH_FRUSTUM_SCALE * neighbourScale);
+            d_ptr->updateGeometry(PREFETCH_FRUSTUM_SCALE * neighbourScale, tiles);
         }
         break;
     }
@@ -162,13 +229,13 @@ QSet<QGeoTileSpec> QGeoCameraTiles::prefetchTiles(PrefetchStle style)
             d_ptr->m_intZoomLevel = currentIntZoom - 1;
             d_ptr->m_sideLength = 1 << d_ptr->m_intZoomLevel;
             d_ptr->m_camera.setZoomLevel(d_ptr->m_intZoomLevel);
-            d_ptr->updateGeometry(0.5);
+            d_ptr->updateGeometry(0.5, tiles);
         }
         if (currentIntZoom < d_ptr->m_maxZoom) {
             d_ptr->m_intZoomLevel = currentIntZoom + 1;
             d_ptr->m_sideLength = 1 << d_ptr->m_intZoomLevel;
             d_ptr->m_camera.setZoomLevel(d_ptr->m_intZoomLevel);
-            d_ptr->updateGeometry(1.0);
+            d_ptr->updateGeometry(1.0, tiles);
         }
     }
     }
@@ -176,7 +243,30 @@ QSet<QGeoTileSpec> QGeoCameraTiles::prefetchTiles(PrefetchStle style)
     d_ptr->m_intZoomLevel = currentIntZoom;
     d_ptr->m_sideLength = 1 << d_ptr->m_intZoomLevel;
     d_ptr->m_camera.setZoomLevel(currentFloatZoom);
-    return d_ptr->m_tiles;
+    return tiles;
+}
+
+/*
+    Returns the fetch priority of \a spec for the current camera; lower values
+    should be fetched first. Tiles on the camera's integer zoom layer rank
+    ahead of every other layer, and within a layer tiles are ordered by their
+    squared distance, in tiles, from the centre of the screen.
+*/
+int QGeoCameraTiles::tilePriority(const QGeoTileSpec &spec) const
+{
+    const int intZoom = static_cast<int>(std::floor(d_ptr->m_camera.zoomLevel()));
+    const int layer = qMin(qAbs(spec.zoom() - intZoom), 64);
+
+    const double side = std::pow(2.0, spec.zoom());
+    const QDoubleVector2D center = QGeoProjection::coordToMercator(d_ptr->m_camera.center()) * side;
+
+    double dx = std::fabs(spec.x() + 0.5 - center.x());
+    if (dx > side / 2.0)
+        dx = side - dx; // closer across the dateline
+    const double dy = spec.y() + 0.5 - center.y();
+    const double distance = qMin(dx * dx + dy * dy, double(TILE_PRIORITY_LAYER_STRIDE - 1));
+
+    return layer * TILE_PRIORITY_LAYER_STRIDE + static_cast<int>(distance);
 }
 
 void QGeoCameraTiles::setCameraData(const QGeoCameraData &camera)
@@ -252,8 +342,8 @@ void QGeoCameraTiles::setMaximumZoomLevel(int maxZoom)
 const QSet<QGeoTileSpec>& QGeoCameraTiles::visibleTiles()
 {
     if (d_ptr->m_dirtyGeometry) {
-        d_ptr->m_tiles.clear();
-        d_ptr->updateGeometry();
+        // tiles built under stale metadata cannot be diffed, rebuild them
+        d_ptr->updateVisibleTiles(!d_ptr->m_dirtyMetadata);
         d_ptr->m_dirtyGeometry = false;
     }
 
@@ -272,7 +362,8 @@ QGeoCameraTilesPrivate::QGeoCameraTilesPrivate()
     m_intZoomLevel(0),
     m_sideLength(0),
     m_dirtyGeometry(false),
-    m_dirtyMetadata(false)
+    m_dirtyMetadata(false),
+    m_coverageZoom(-1)
 {
 }
 
@@ -295,7 +386,7 @@ void QGeoCameraTilesPrivate::updateMetadata()
     m_tiles = newTiles;
 }
 
-void QGeoCameraTilesPrivate::updateGeometry(double viewExpansion)
+void QGeoCameraTilesPrivate::computeCoverage(double viewExpansion, TileMap &left, TileMap &right)
 {
     // Find the frustum from the camera / screen / viewport information
     // The larger frustum when stationary is a form of prefetching
@@ -307,17 +398,140 @@ void QGeoCameraTilesPrivate::updateGeometry(double viewExpansion)
     // Clip the polygon to the map, split it up if it cross the dateline
     QPair<PolygonVector, PolygonVector> polygons = clipFootprintToMap(footprint);
 
-    if (!polygons.first.isEmpty()) {
-        QSet<QGeoTileSpec> tilesLeft = tilesFromPolygon(polygons.first);
-        m_tiles.unite(tilesLeft);
+    tilesFromPolygon(polygons.first, left);
+    tilesFromPolygon(polygons.second, right);
+}
+
+void QGeoCameraTilesPrivate::updateGeometry(double viewExpansion, QSet<QGeoTileSpec> &tiles)
+{
+    computeCoverage(viewExpansion, m_nextLeft, m_nextRight);
+    appendTiles(m_nextLeft, tiles);
+    appendTiles(m_nextRight, tiles);
+}
+
+/*
+    Brings m_tiles up to date with the camera. When the previous coverage is
+    on the same zoom level only the rows that changed are touched, and only
+    the tiles that entered or left a row are inserted or removed, so a pan
+    costs in proportion to the tiles crossing the edge of the view.
+*/
+void QGeoCameraTilesPrivate::updateVisibleTiles(bool incremental)
+{
+    computeCoverage(1.0, m_nextLeft, m_nextRight);
+
+    if (!incremental || m_coverageZoom != m_intZoomLevel) {
+        m_tiles.clear();
+        appendTiles(m_nextLeft, m_tiles);
+        appendTiles(m_nextRight, m_tiles);
+    } else {
+        int first = INT_MAX;
+        int last = INT_MIN;
+        const TileMap *maps[] = { &m_left, &m_right, &m_nextLeft, &m_nextRight };
+        for (int i = 0; i < 4; ++i) {
+            if (maps[i]->rowCount == 0)
+                continue;
+            first = qMin(first, maps[i]->firstRow);
+            last = qMax(last, maps[i]->firstRow + maps[i]->rowCount - 1);
+        }
+
+        Span oldSpans[2];
+        Span newSpans[2];
+        Span delta[6];
+        for (int y = first; y <= last; ++y) {
+            int oldCount = rowSpans(m_left, m_right, y, oldSpans);
+            int newCount = rowSpans(m_nextLeft, m_nextRight, y, newSpans);
+
+            updateRow(y, delta, subtractSpans(oldSpans, oldCount, newSpans, newCount, delta), false);
+            updateRow(y, delta, subtractSpans(newSpans, newCount, oldSpans, oldCount, delta), true);
+        }
     }
 
-    if (!polygons.second.isEmpty()) {
-        QSet<QGeoTileSpec> tilesRight = tilesFromPolygon(polygons.second);
-        m_tiles.unite(tilesRight);
+    qSwap(m_left, m_nextLeft);
+    qSwap(m_right, m_nextRight);
+    m_coverageZoom = m_intZoomLevel;
+}
+
+void QGeoCameraTilesPrivate::appendTiles(const TileMap &map, QSet<QGeoTileSpec> &tiles) const
+{
+    for (int row = 0; row < map.rowCount; ++row) {
+        const int y = map.firstRow + row;
+        for (int x = map.minX.at(row); x <= map.maxX.at(row); ++x)
+            tiles.insert(QGeoTileSpec(m_pluginString, m_mapType.mapId(), m_intZoomLevel, x, y, m_mapVersion));
     }
 }
 
+void QGeoCameraTilesPrivate::updateRow(int y, const Span *spans, int count, bool insert)
+{
+    for (int i = 0; i < count; ++i) {
+        for (int x = spans[i].min; x <= spans[i].max; ++x) {
+            QGeoTileSpec spec(m_pluginString, m_mapType.mapId(), m_intZoomLevel, x, y, m_mapVersion);
+            if (insert)
+                m_tiles.insert(spec);
+            else
+                m_tiles.remove(spec);
+        }
+    }
+}
+
+/*
+    Writes the columns covered in row \a y by the two halves of a footprint to
+    \a spans as at most two sorted, disjoint spans and returns their number.
+*/
+int QGeoCameraTilesPrivate::rowSpans(const TileMap &left, const TileMap &right, int y, Span *spans)
+{
+    int count = 0;
+    const TileMap *maps[] = { &left, &right };
+    for (int i = 0; i < 2; ++i) {
+        const int row = y - maps[i]->firstRow;
+        if (row < 0 || row >= maps[i]->rowCount || maps[i]->minX.at(row) > maps[i]->maxX.at(row))
+            continue;
+        spans[count].min = maps[i]->minX.at(row);
+        spans[count].max = maps[i]->maxX.at(row);
+        ++count;
+    }
+
+    if (count == 2) {
+        if (spans[1].min < spans[0].min)
+            qSwap(spans[0], spans[1]);
+        if (spans[1].min <= spans[0].max + 1) {
+            spans[0].max = qMax(spans[0].max, spans[1].max);
+            count = 1;
+        }
+    }
+
+    return count;
+}
+
+/*
+    Writes the columns of \a a that are not in \a b to \a result and returns
+    the number of spans written. Both inputs must be sorted and disjoint;
+    \a result needs room for countA * (countB + 1) spans.
+*/
+int QGeoCameraTilesPrivate::subtractSpans(const Span *a, int countA, const Span *b, int countB, Span *result)
+{
+    int count = 0;
+    for (int i = 0; i < countA; ++i) {
+        int start = a[i].min;
+        const int end = a[i].max;
+        for (int j = 0; j < countB && start <= end; ++j) {
+            if (b[j].max < start || b[j].min > end)
+                continue;
+            if (b[j].min > start) {
+                result[count].min = start;
+                result[count].max = b[j].min - 1;
+                ++count;
+            }
+            start = b[j].max + 1;
+        }
+        if (start <= end) {
+            result[count].min = start;
+            result[count].max = end;
+            ++count;
+        }
+    }
+    return count;
+}
+
 Frustum QGeoCameraTilesPrivate::createFrustum(double fieldOfViewGradient) const
 {
     QDoubleVector3D center = m_sideLength * QGeoProjection::coordToMercator(m_camera.center());
@@ -743,49 +957,19 @@ QPair<PolygonVector, PolygonVector> QGeoCameraTilesPrivate::clipFootprintToMap(c
 
 }
 
-QList<QPair<double, int> > QGeoCameraTilesPrivate::tileIntersections(double p1, int t1, double p2, int t2) const
-{
-    if (t1 == t2) {
-        QList<QPair<double, int> > results = QList<QPair<double, int> >();
-        results.append(QPair<double, int>(0.0, t1));
-        return results;
-    }
-
-    int step = 1;
-    if (t1 > t2) {
-        step = -1;
-    }
-
-    int size = 1 + ((t2 - t1) / step);
-
-    QList<QPair<double, int> > results = QList<QPair<double, int> >();
-
-    results.append(QPair<double, int>(0.0, t1));
-
-    if (step == 1) {
-        for (int i = 1; i < size; ++i) {
-            double f = (t1 + i - p1) / (p2 - p1);
-            results.append(QPair<double, int>(f, t1 + i));
-        }
-    } else {
-        for (int i = 1; i < size; ++i) {
-            double f = (t1 - i + 1 - p1) / (p2 - p1);
-            results.append(QPair<double, int>(f, t1 - i));
-        }
-    }
-
-    return results;
-}
-
-QSet<QGeoTileSpec> QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector &polygon) const
+void QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector &polygon, TileMap &map)
 {
     int numPoints = polygon.size();
 
-    if (numPoints == 0)
-        return QSet<QGeoTileSpec>();
+    if (numPoints == 0) {
+        map.reset(0, -1);
+        return;
+    }
 
-    QVector<int> tilesX(polygon.size());
-    QVector<int> tilesY(polygon.size());
+    QVector<int> &tilesX = m_cornerX;
+    QVector<int> &tilesY = m_cornerY;
+    tilesX.resize(numPoints);
+    tilesY.resize(numPoints);
 
     // grab tiles at the corners of the polygon
     for (int i = 0; i < numPoints; ++i) {
@@ -815,7 +999,15 @@ QSet<QGeoTileSpec> QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector
         tilesY[i] = y;
     }
 
-    QGeoCameraTilesPrivate::TileMap map;
+    // edges never leave the rows spanned by the corners, but tiles on a
+    // boundary also pull in the row above
+    int minY = tilesY.at(0);
+    int maxY = tilesY.at(0);
+    for (int i = 1; i < numPoints; ++i) {
+        minY = qMin(minY, tilesY.at(i));
+        maxY = qMax(maxY, tilesY.at(i));
+    }
+    map.reset(qMax(0, minY - 1), maxY);
 
     // walk along the edges of the polygon and add all tiles covered by them
     for (int i1 = 0; i1 < numPoints; ++i1) {
@@ -827,11 +1019,7 @@ QSet<QGeoTileSpec> QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector
         bool xFixed = qFuzzyCompare(x1, x2);
         bool xIntegral = qFuzzyCompare(x1, std::floor(x1)) || qFuzzyCompare(x1 + 1.0, std::floor(x1 + 1.0));
 
-        QList<QPair<double, int> > xIntersects
-                = tileIntersections(x1,
-                                    tilesX.at(i1),
-                                    x2,
-                                    tilesX.at(i2));
+        EdgeIntersections xIntersects(x1, tilesX.at(i1), x2, tilesX.at(i2));
 
         double y1 = polygon.at(i1).get(1);
         double y2 = polygon.at(i2).get(1);
@@ -839,14 +1027,10 @@ QSet<QGeoTileSpec> QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector
         bool yFixed = qFuzzyCompare(y1, y2);
         bool yIntegral = qFuzzyCompare(y1, std::floor(y1)) || qFuzzyCompare(y1 + 1.0, std::floor(y1 + 1.0));
 
-        QList<QPair<double, int> > yIntersects
-                = tileIntersections(y1,
-                                    tilesY.at(i1),
-                                    y2,
-                                    tilesY.at(i2));
+        EdgeIntersections yIntersects(y1, tilesY.at(i1), y2, tilesY.at(i2));
 
-        int x = xIntersects.takeFirst().second;
-        int y = yIntersects.takeFirst().second;
+        int x = tilesX.at(i1);
+        int y = tilesY.at(i1);
 
 
         /*
@@ -921,77 +1105,75 @@ QSet<QGeoTileSpec> QGeoCameraTilesPrivate::tilesFromPolygon(const PolygonVector
         // the boundaries, we move along the edge and add tiles until
         // the x and y intersection lists are exhausted
 
-        while (!xIntersects.isEmpty() && !yIntersects.isEmpty()) {
-            QPair<double, int> nextX = xIntersects.first();
-            QPair<double, int> nextY = yIntersects.first();
-            if (nextX.first < nextY.first) {
-                x = nextX.second;
+        while (!xIntersects.atEnd() && !yIntersects.atEnd()) {
+            double nextX = xIntersects.fraction();
+            double nextY = yIntersects.fraction();
+            if (nextX < nextY) {
+                x = xIntersects.tile();
                 map.add(x, y);
-                xIntersects.removeFirst();
+                xIntersects.next();
 
-            } else if (nextX.first > nextY.first) {
-                y = nextY.second;
+            } else if (nextX > nextY) {
+                y = yIntersects.tile();
                 map.add(x, y);
-                yIntersects.removeFirst();
+                yIntersects.next();
 
             } else {
-                map.add(x, nextY.second);
-                map.add(nextX.second, y);
-                x = nextX.second;
-                y = nextY.second;
+                map.add(x, yIntersects.tile());
+                map.add(xIntersects.tile(), y);
+                x = xIntersects.tile();
+                y = yIntersects.tile();
                 map.add(x, y);
-                xIntersects.removeFirst();
-                yIntersects.removeFirst();
+                xIntersects.next();
+                yIntersects.next();
             }
         }
 
-        while (!xIntersects.isEmpty()) {
-            x = xIntersects.takeFirst().second;
+        while (!xIntersects.atEnd()) {
+            x = xIntersects.tile();
+            xIntersects.next();
             map.add(x, y);
             if (yIntegral && yFixed)
                 map.add(x, yOther);
 
         }
 
-        while (!yIntersects.isEmpty()) {
-            y = yIntersects.takeFirst().second;
+        while (!yIntersects.atEnd()) {
+            y = yIntersects.tile();
+            yIntersects.next();
             map.add(x, y);
             if (xIntegral && xFixed)
                 map.add(xOther, y);
         }
     }
+}
 
-    QSet<QGeoTileSpec> results;
-
-    int z = m_intZoomLevel;
-
-    typedef QMap<int, QPair<int, int> >::const_iterator iter;
-    iter i = map.data.constBegin();
-    iter end = map.data.constEnd();
-
-    for (; i != end; ++i) {
-        int y = i.key();
-        int minX = i->first;
-        int maxX = i->second;
-        for (int x = minX; x <= maxX; ++x) {
-            results.insert(QGeoTileSpec(m_pluginString, m_mapType.mapId(), z, x, y, m_mapVersion));
-        }
-    }
-
-    return results;
+QGeoCameraTilesPrivate::TileMap::TileMap()
+:   firstRow(0),
+    rowCount(0)
+{
 }
 
-QGeoCameraTilesPrivate::TileMap::TileMap() {}
+void QGeoCameraTilesPrivate::TileMap::reset(int first, int last)
+{
+    firstRow = first;
+    rowCount = qMax(0, last - first + 1);
+
+    // an empty row has minX > maxX; resize() keeps the capacity
+    minX.resize(rowCount);
+    maxX.resize(rowCount);
+    minX.fill(INT_MAX);
+    maxX.fill(INT_MIN);
+}
 
 void QGeoCameraTilesPrivate::TileMap::add(int tileX, int tileY)
 {
-    if (data.contains(tileY)) {
-        int oldMinX = data.value(tileY).first;
-        int oldMaxX = data.value(tileY).second;
-        data.insert(tileY, QPair<int, int>(qMin(tileX, oldMinX), qMax(tileX, oldMaxX)));
-    } else {
-        data.insert(tileY, QPair<int, int>(tileX, tileX));
-    }
+    const int row = tileY - firstRow;
+    if (row < 0 || row >= rowCount)
+        return;
+
+    minX[row] = qMin(minX.at(row), tileX);
+    maxX[row] = qMax(maxX.at(row), tileX);
 }
 
 QT_END_NAMESPACE
@@ -78,6 +78,7 @@ public:
 
     const QSet<QGeoTileSpec>& visibleTiles();
     QSet<QGeoTileSpec> prefetchTiles(PrefetchStle style);
+    int tilePriority(const QGeoTileSpec &spec) const;
 
 protected:
     QScopedPointer<QGeoCameraTilesPrivate> d_ptr;
@@ -36,11 +36,14 @@
 #include "qgeofiletilecache_p.h"
 
 #include "qgeotilespec_p.h"
+#include "qgeotilepackstore_p.h"
 
 #include "qgeomappingmanager_p.h"
 
 #include <QDir>
+#include <QRunnable>
 #include <QStandardPaths>
+#include <QThread>
 #include <QMetaType>
 #include <QPixmap>
 #include <QDebug>
@@ -65,6 +68,86 @@ public:
     QString format;
 };
 
+struct QGeoTileLoadResult
+{
+    QGeoTileSpec spec;
+    QByteArray bytes;
+    QString format;
+    QImage image;
+    QSharedPointer<QAtomicInt> cancelled;
+    int generation;
+    bool fromDisk;
+    bool ok;
+};
+
+/* Finished background loads, handed back to the cache's thread in batches */
+class QGeoTileLoadResults
+{
+public:
+    QMutex mutex;
+    QList<QGeoTileLoadResult> results;
+};
+
+/* Reads a tile from disk if needed and decodes it off the GUI thread */
+class QGeoTileLoadJob : public QRunnable
+{
+public:
+    QGeoTileLoadJob(QGeoFileTileCache *cache, const QGeoTileSpec &spec,
+                    const QSharedPointer<QAtomicInt> &cancelled)
+        : cache_(cache), results_(cache->loadResults_)
+    {
+        result_.spec = spec;
+        result_.cancelled = cancelled;
+        result_.generation = cache->loadGeneration_;
+        policy_ = cache->textureFormatPolicy_;
+        result_.fromDisk = false;
+        result_.ok = false;
+    }
+
+    void fromMemory(const QByteArray &bytes, const QString &format)
+    {
+        result_.bytes = bytes;
+        result_.format = format;
+    }
+
+    void fromDisk(const QString &filename)
+    {
+        filename_ = filename;
+        result_.fromDisk = true;
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        /* nothing is reported for cancelled loads, the cache has forgotten them */
+        if (result_.cancelled->load())
+            return;
+        if (result_.fromDisk)
+            result_.bytes = cache_->readDiskTile(result_.spec, filename_, &result_.format);
+        if (result_.cancelled->load())
+            return;
+
+        result_.ok = !result_.bytes.isEmpty() && result_.image.loadFromData(result_.bytes);
+        if (result_.ok)
+            result_.image = QGeoFileTileCache::textureImage(result_.image, policy_);
+
+        bool notify;
+        {
+            QMutexLocker locker(&results_->mutex);
+            notify = results_->results.isEmpty();
+            results_->results.append(result_);
+        }
+        if (notify)
+            QMetaObject::invokeMethod(cache_, "processLoadedTiles", Qt::QueuedConnection);
+    }
+
+private:
+    QGeoFileTileCache *cache_;
+    QSharedPointer<QGeoTileLoadResults> results_;
+    QGeoTileLoadResult result_;
+    QGeoFileTileCache::TextureFormatPolicy policy_;
+    QString filename_;
+};
+
 void QCache3QTileEvictionPolicy::aboutToBeRemoved(const QGeoTileSpec &key, QSharedPointer<QGeoCachedTileDisk> obj)
 {
     Q_UNUSED(key);
@@ -86,8 +169,16 @@ QGeoCachedTileDisk::~QGeoCachedTileDisk()
 }
 
 QGeoFileTileCache::QGeoFileTileCache(const QString &directory, QObject *parent)
+    : QGeoFileTileCache(directory, FilePerTileStorage, parent)
+{
+}
+
+QGeoFileTileCache::QGeoFileTileCache(const QString &directory, StorageType storageType, QObject *parent)
     : QAbstractGeoTileCache(parent), directory_(directory),
-      minTextureUsage_(0), extraTextureUsage_(0)
+      storageType_(storageType), packStore_(0),
+      minTextureUsage_(0), extraTextureUsage_(0),
+      textureFormatPolicy_(KeepSourceFormat), keepCompressedTiles_(true),
+      loadResults_(new QGeoTileLoadResults), loadGeneration_(0)
 {
     const QString basePath = baseCacheDirectory();
 
@@ -113,7 +204,146 @@ QGeoFileTileCache::QGeoFileTileCache(const QString &directory, QObject *parent)
     setMaxMemoryUsage(3 * 1024 * 1024);
     setExtraTextureUsage(6 * 1024 * 1024);
 
-    loadTiles();
+    loadPool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+
+    if (storageType_ == PackedStorage) {
+        packStore_ = new QGeoTilePackStore(directory_, this);
+        connect(packStore_, SIGNAL(compactionFinished()), this, SLOT(writePackIndex()));
+        loadPackedTiles();
+    } else {
+        loadTiles();
+    }
+}
+
+QGeoFileTileCache::StorageType QGeoFileTileCache::storageType() const
+{
+    return storageType_;
+}
+
+void QGeoFileTileCache::setTextureFormatPolicy(TextureFormatPolicy policy)
+{
+    textureFormatPolicy_ = policy;
+}
+
+QGeoFileTileCache::TextureFormatPolicy QGeoFileTileCache::textureFormatPolicy() const
+{
+    return textureFormatPolicy_;
+}
+
+void QGeoFileTileCache::setKeepCompressedTiles(bool keep)
+{
+    keepCompressedTiles_ = keep;
+}
+
+bool QGeoFileTileCache::keepCompressedTiles() const
+{
+    return keepCompressedTiles_;
+}
+
+/*
+    Returns the image the texture cache should hold for a decoded tile. With
+    PreferCompactFormat, images that use at most 256 distinct colors are
+    stored with an exact 8-bit palette and other opaque images are reduced to
+    RGB565. Images with transparency are left alone.
+*/
+QImage QGeoFileTileCache::textureImage(const QImage &image, TextureFormatPolicy policy)
+{
+    if (policy == KeepSourceFormat || image.isNull())
+        return image;
+
+    switch (image.format()) {
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+    case QImage::Format_Indexed8:
+    case QImage::Format_Grayscale8:
+    case QImage::Format_RGB16:
+        return image;
+    default:
+        break;
+    }
+
+    if (image.hasAlphaChannel())
+        return image;
+
+    const QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+    QVector<QRgb> colorTable;
+    QSet<QRgb> colors;
+    colors.reserve(256);
+    bool paletted = true;
+    for (int y = 0; paletted && y < rgb.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(rgb.constScanLine(y));
+        QRgb last = ~line[0];
+        for (int x = 0; x < rgb.width(); ++x) {
+            // runs of the same color are very common in map tiles
+            if (line[x] == last)
+                continue;
+            last = line[x];
+            if (colors.contains(last))
+                continue;
+            if (colorTable.size() == 256) {
+                paletted = false;
+                break;
+            }
+            colors.insert(last);
+            colorTable.append(last);
+        }
+    }
+
+    if (paletted)
+        return rgb.convertToFormat(QImage::Format_Indexed8, colorTable, Qt::ThresholdDither);
+    return rgb.convertToFormat(QImage::Format_RGB16);
+}
+
+void QGeoFileTileCache::loadPackedTiles()
+{
+    if (!packStore_->open()) {
+        // fall back to not persisting anything rather than scattering files
+        qWarning() << "Unable to open packed tile cache in" << directory_;
+        return;
+    }
+
+    // The index lists the tiles of each queue most recently used first. They
+    // are restored into the queue they were in, without going through insert()
+    // so that nothing is evicted before the plugin had a chance to apply its
+    // configured disk cache size.
+    const QList<QGeoTilePackStore::Entry> entries = packStore_->entries();
+    for (int q = 1; q <= 3; ++q) {
+        QList<QGeoTileSpec> specs;
+        QList<QSharedPointer<QGeoCachedTileDisk> > queue;
+        QList<int> costs;
+        // deserializeQueue() links each tile in at the front, so go backwards
+        for (int i = entries.size() - 1; i >= 0; --i) {
+            const QGeoTilePackStore::Entry &entry = entries.at(i);
+            const int entryQueue = (entry.queue >= 1 && entry.queue <= 3) ? entry.queue : 1;
+            if (entryQueue != q)
+                continue;
+            QSharedPointer<QGeoCachedTileDisk> tileDisk(new QGeoCachedTileDisk);
+            tileDisk->spec = entry.spec;
+            tileDisk->format = entry.format;
+            tileDisk->cache = this;
+            specs.append(entry.spec);
+            queue.append(tileDisk);
+            costs.append(entry.dataSize);
+        }
+        diskCache_.deserializeQueue(q, specs, queue, costs);
+    }
+}
+
+void QGeoFileTileCache::writePackIndex()
+{
+    if (!packStore_)
+        return;
+
+    QList<QPair<QGeoTileSpec, int> > order;
+    for (int i = 1; i <= 3; i++) {
+        QList<QSharedPointer<QGeoCachedTileDisk> > queue;
+        diskCache_.serializeQueue(i, queue);
+        foreach (const QSharedPointer<QGeoCachedTileDisk> &tile, queue) {
+            if (!tile.isNull())
+                order.append(qMakePair(tile->spec, i));
+        }
+    }
+    packStore_->writeIndex(order);
 }
 
 void QGeoFileTileCache::loadTiles()
@@ -172,6 +402,15 @@ void QGeoFileTileCache::loadTiles()
 
 QGeoFileTileCache::~QGeoFileTileCache()
 {
+    // jobs access the disk storage, let them finish first
+    loadPool_.waitForDone();
+
+    if (packStore_) {
+        packStore_->waitForCompaction();
+        writePackIndex();
+        return;
+    }
+
     // write disk cache queues to disk
     QDir dir(directory_);
     for (int i = 1; i<=4; i++) {
@@ -263,9 +502,15 @@ int QGeoFileTileCache::textureUsage() const
 
 void QGeoFileTileCache::clearAll()
 {
+    // anything still being loaded belongs to the old contents
+    ++loadGeneration_;
     textureCache_.clear();
     memoryCache_.clear();
     diskCache_.clear();
+    if (packStore_) {
+        packStore_->clear();
+        return;
+    }
     QDir dir(directory_);
     dir.setNameFilters(QStringList() << QLatin1String("*-*-*-*.*"));
     dir.setFilter(QDir::Files);
@@ -287,18 +532,16 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::get(const QGeoTileSpec &spec)
             handleError(spec, QLatin1String("Problem with tile image"));
             return QSharedPointer<QGeoTileTexture>(0);
         }
-        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, image);
+        QSharedPointer<QGeoTileTexture> tt = addDecodedTile(spec, textureImage(image, textureFormatPolicy_),
+                                                            tm->bytes, tm->format, false);
         if (tt)
             return tt;
     }
 
     QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
     if (td) {
-        const QString format = QFileInfo(td->filename).suffix();
-        QFile file(td->filename);
-        file.open(QIODevice::ReadOnly);
-        QByteArray bytes = file.readAll();
-        file.close();
+        QString format;
+        const QByteArray bytes = readDiskTile(td->spec, td->filename, &format);
 
         QImage image;
         if (!image.loadFromData(bytes)) {
@@ -306,8 +549,8 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::get(const QGeoTileSpec &spec)
             return QSharedPointer<QGeoTileTexture>(0);
         }
 
-        addToMemoryCache(spec, bytes, format);
-        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(td->spec, image);
+        QSharedPointer<QGeoTileTexture> tt = addDecodedTile(td->spec, textureImage(image, textureFormatPolicy_),
+                                                            bytes, format, true);
         if (tt)
             return tt;
     }
@@ -315,6 +558,125 @@ QSharedPointer<QGeoTileTexture> QGeoFileTileCache::get(const QGeoTileSpec &spec)
     return QSharedPointer<QGeoTileTexture>();
 }
 
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::getAsync(const QGeoTileSpec &spec, bool *pending)
+{
+    *pending = false;
+
+    QSharedPointer<QGeoTileTexture> tt = textureCache_.object(spec);
+    if (tt)
+        return tt;
+
+    QHash<QGeoTileSpec, PendingLoad>::iterator it = pendingLoads_.find(spec);
+    if (it != pendingLoads_.end()) {
+        ++it.value().waiters;
+        *pending = true;
+        return QSharedPointer<QGeoTileTexture>();
+    }
+
+    PendingLoad load;
+    load.cancelled = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+    load.waiters = 1;
+
+    QGeoTileLoadJob *job = 0;
+    QSharedPointer<QGeoCachedTileMemory> tm = memoryCache_.object(spec);
+    if (tm) {
+        job = new QGeoTileLoadJob(this, spec, load.cancelled);
+        job->fromMemory(tm->bytes, tm->format);
+    } else {
+        QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
+        if (td) {
+            job = new QGeoTileLoadJob(this, spec, load.cancelled);
+            job->fromDisk(td->filename);
+        }
+    }
+
+    if (!job)
+        return QSharedPointer<QGeoTileTexture>();
+
+    pendingLoads_.insert(spec, load);
+    loadPool_.start(job);
+    *pending = true;
+    return QSharedPointer<QGeoTileTexture>();
+}
+
+void QGeoFileTileCache::cancelAsync(const QGeoTileSpec &spec)
+{
+    QHash<QGeoTileSpec, PendingLoad>::iterator it = pendingLoads_.find(spec);
+    if (it == pendingLoads_.end())
+        return;
+
+    // the cache is shared between maps, keep loading while anyone still waits
+    if (--it.value().waiters > 0)
+        return;
+
+    it.value().cancelled->store(1);
+    pendingLoads_.erase(it);
+}
+
+bool QGeoFileTileCache::contains(const QGeoTileSpec &spec, QGeoTiledMappingManagerEngine::CacheAreas areas) const
+{
+    if ((areas & QGeoTiledMappingManagerEngine::DiskCache) && diskCache_.contains(spec))
+        return true;
+    if ((areas & QGeoTiledMappingManagerEngine::MemoryCache)
+            && (memoryCache_.contains(spec) || textureCache_.contains(spec)))
+        return true;
+    return false;
+}
+
+void QGeoFileTileCache::processLoadedTiles()
+{
+    QList<QGeoTileLoadResult> results;
+    {
+        QMutexLocker locker(&loadResults_->mutex);
+        results.swap(loadResults_->results);
+    }
+
+    foreach (const QGeoTileLoadResult &result, results) {
+        // a load that was cancelled after the job had already finished
+        QHash<QGeoTileSpec, PendingLoad>::iterator pending = pendingLoads_.find(result.spec);
+        if (pending == pendingLoads_.end() || pending.value().cancelled != result.cancelled)
+            continue;
+        pendingLoads_.erase(pending);
+
+        if (result.generation != loadGeneration_) {
+            emit tileLoadFailed(result.spec);
+            continue;
+        }
+
+        if (!result.ok) {
+            handleError(result.spec, QLatin1String("Problem with tile image"));
+            // drop the unusable data so that the tile gets fetched again
+            removeBrokenTile(result.spec);
+            emit tileLoadFailed(result.spec);
+            continue;
+        }
+
+        addDecodedTile(result.spec, result.image, result.bytes, result.format, result.fromDisk);
+        emit tileLoaded(result.spec);
+    }
+}
+
+void QGeoFileTileCache::waitForPendingLoads()
+{
+    loadPool_.waitForDone();
+    processLoadedTiles();
+}
+
+void QGeoFileTileCache::removeBrokenTile(const QGeoTileSpec &spec)
+{
+    memoryCache_.remove(spec);
+
+    QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
+    if (!td)
+        return;
+    // remove() detaches the entry from the cache, so delete the data here
+    diskCache_.remove(spec);
+    if (packStore_)
+        packStore_->remove(spec);
+    else
+        QFile::remove(td->filename);
+}
+
 void QGeoFileTileCache::insert(const QGeoTileSpec &spec,
                            const QByteArray &bytes,
                            const QString &format,
@@ -323,7 +685,13 @@ void QGeoFileTileCache::insert(const QGeoTileSpec &spec,
     if (bytes.isEmpty())
         return;
 
-    if (areas & QGeoTiledMappingManagerEngine::DiskCache) {
+    if ((areas & QGeoTiledMappingManagerEngine::DiskCache) && packStore_) {
+        // the new record supersedes the old one, which must not be evicted
+        // from the store when its cache entry goes away
+        diskCache_.remove(spec);
+        if (packStore_->write(spec, bytes, format))
+            addToPackedDiskCache(spec, format, bytes.size());
+    } else if (areas & QGeoTiledMappingManagerEngine::DiskCache) {
         QString filename = tileSpecToFilename(spec, format, directory_);
         QFile file(filename);
         file.open(QIODevice::WriteOnly);
@@ -344,7 +712,10 @@ void QGeoFileTileCache::insert(const QGeoTileSpec &spec,
 
 void QGeoFileTileCache::evictFromDiskCache(QGeoCachedTileDisk *td)
 {
-    QFile::remove(td->filename);
+    if (td->cache && td->cache->packStore_)
+        td->cache->packStore_->remove(td->spec);
+    else
+        QFile::remove(td->filename);
 }
 
 void QGeoFileTileCache::evictFromMemoryCache(QGeoCachedTileMemory * /* tm  */)
@@ -364,6 +735,32 @@ QSharedPointer<QGeoCachedTileDisk> QGeoFileTileCache::addToDiskCache(const QGeoT
     return td;
 }
 
+QSharedPointer<QGeoCachedTileDisk> QGeoFileTileCache::addToPackedDiskCache(const QGeoTileSpec &spec, const QString &format, int cost)
+{
+    QSharedPointer<QGeoCachedTileDisk> td(new QGeoCachedTileDisk);
+    td->spec = spec;
+    td->format = format;
+    td->cache = this;
+
+    diskCache_.insert(spec, td, cost);
+    return td;
+}
+
+// Called from the load jobs as well, must not touch the caches
+QByteArray QGeoFileTileCache::readDiskTile(const QGeoTileSpec &spec, const QString &filename, QString *format)
+{
+    if (packStore_)
+        return packStore_->read(spec, format);
+
+    *format = QFileInfo(filename).suffix();
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QByteArray bytes = file.readAll();
+    file.close();
+    return bytes;
+}
+
 QSharedPointer<QGeoCachedTileMemory> QGeoFileTileCache::addToMemoryCache(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
 {
     QSharedPointer<QGeoCachedTileMemory> tm(new QGeoCachedTileMemory);
@@ -378,14 +775,41 @@ QSharedPointer<QGeoCachedTileMemory> QGeoFileTileCache::addToMemoryCache(const Q
     return tm;
 }
 
-QSharedPointer<QGeoTileTexture> QGeoFileTileCache::addToTextureCache(const QGeoTileSpec &spec, const QImage &image)
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::addToTextureCache(const QGeoTileSpec &spec, const QImage &image, bool *cached)
 {
     QSharedPointer<QGeoTileTexture> tt(new QGeoTileTexture);
     tt->spec = spec;
     tt->image = image;
 
-    int textureCost = image.width() * image.height() * image.depth() / 8;
-    textureCache_.insert(spec, tt, textureCost);
+    // count what the pixel data really occupies, which differs from
+    // width * height * depth for padded scanlines and compact formats
+    int textureCost = image.byteCount();
+    const bool inserted = textureCache_.insert(spec, tt, textureCost);
+    if (cached)
+        *cached = inserted;
+
+    return tt;
+}
+
+/*
+    Stores a freshly decoded tile. The compressed bytes are kept in the memory
+    cache alongside the decoded image unless keepCompressedTiles() is false, in
+    which case they are only kept while the texture cache could not take the
+    image.
+*/
+QSharedPointer<QGeoTileTexture> QGeoFileTileCache::addDecodedTile(const QGeoTileSpec &spec, const QImage &image,
+                                                                  const QByteArray &bytes, const QString &format,
+                                                                  bool fromDisk)
+{
+    bool cached = false;
+    QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, image, &cached);
+
+    if (keepCompressedTiles_ || !cached) {
+        if (fromDisk)
+            addToMemoryCache(spec, bytes, format);
+    } else if (!fromDisk) {
+        memoryCache_.remove(spec);
+    }
 
     return tt;
 }
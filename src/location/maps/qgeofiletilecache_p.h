@@ -55,6 +55,8 @@
 #include <QSet>
 #include <QMutex>
 #include <QTimer>
+#include <QThreadPool>
+#include <QAtomicInt>
 
 #include "qgeotilespec_p.h"
 #include "qgeotiledmappingmanagerengine_p.h"
@@ -69,6 +71,8 @@ class QGeoMappingManager;
 class QGeoTile;
 class QGeoCachedTileMemory;
 class QGeoFileTileCache;
+class QGeoTilePackStore;
+class QGeoTileLoadResults;
 
 class QPixmap;
 class QThread;
@@ -99,9 +103,29 @@ class Q_LOCATION_EXPORT QGeoFileTileCache : public QAbstractGeoTileCache
 {
     Q_OBJECT
 public:
+    enum StorageType {
+        FilePerTileStorage,
+        PackedStorage
+    };
+
+    enum TextureFormatPolicy {
+        KeepSourceFormat,
+        PreferCompactFormat
+    };
+
     QGeoFileTileCache(const QString &directory = QString(), QObject *parent = 0);
+    QGeoFileTileCache(const QString &directory, StorageType storageType, QObject *parent = 0);
     ~QGeoFileTileCache();
 
+    StorageType storageType() const;
+
+    void setTextureFormatPolicy(TextureFormatPolicy policy);
+    TextureFormatPolicy textureFormatPolicy() const;
+    void setKeepCompressedTiles(bool keep);
+    bool keepCompressedTiles() const;
+
+    static QImage textureImage(const QImage &image, TextureFormatPolicy policy);
+
     void setMaxDiskUsage(int diskUsage) Q_DECL_OVERRIDE;
     int maxDiskUsage() const Q_DECL_OVERRIDE;
     int diskUsage() const Q_DECL_OVERRIDE;
@@ -118,6 +142,11 @@ public:
     void clearAll() Q_DECL_OVERRIDE;
 
     QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    QSharedPointer<QGeoTileTexture> getAsync(const QGeoTileSpec &spec, bool *pending) Q_DECL_OVERRIDE;
+    void cancelAsync(const QGeoTileSpec &spec) Q_DECL_OVERRIDE;
+    bool contains(const QGeoTileSpec &spec,
+                  QGeoTiledMappingManagerEngine::CacheAreas areas = QGeoTiledMappingManagerEngine::AllCaches) const Q_DECL_OVERRIDE;
+    void waitForPendingLoads();
 
     // can be called without a specific tileCache pointer
     static void evictFromDiskCache(QGeoCachedTileDisk *td);
@@ -128,15 +157,26 @@ public:
                 const QString &format,
                 QGeoTiledMappingManagerEngine::CacheAreas areas = QGeoTiledMappingManagerEngine::AllCaches) Q_DECL_OVERRIDE;
 
+private Q_SLOTS:
+    void writePackIndex();
+    void processLoadedTiles();
+
 private:
     void printStats() Q_DECL_OVERRIDE;
     void loadTiles();
+    void loadPackedTiles();
+    QByteArray readDiskTile(const QGeoTileSpec &spec, const QString &filename, QString *format);
+    void removeBrokenTile(const QGeoTileSpec &spec);
 
     QString directory() const;
 
     QSharedPointer<QGeoCachedTileDisk> addToDiskCache(const QGeoTileSpec &spec, const QString &filename);
+    QSharedPointer<QGeoCachedTileDisk> addToPackedDiskCache(const QGeoTileSpec &spec, const QString &format, int cost);
     QSharedPointer<QGeoCachedTileMemory> addToMemoryCache(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
-    QSharedPointer<QGeoTileTexture> addToTextureCache(const QGeoTileSpec &spec, const QImage &image);
+    QSharedPointer<QGeoTileTexture> addToTextureCache(const QGeoTileSpec &spec, const QImage &image, bool *cached = 0);
+    QSharedPointer<QGeoTileTexture> addDecodedTile(const QGeoTileSpec &spec, const QImage &image,
+                                                   const QByteArray &bytes, const QString &format,
+                                                   bool fromDisk);
 
     static QString tileSpecToFilename(const QGeoTileSpec &spec, const QString &format, const QString &directory);
     static QGeoTileSpec filenameToTileSpec(const QString &filename);
@@ -146,9 +186,26 @@ private:
     QCache3Q<QGeoTileSpec, QGeoTileTexture > textureCache_;
 
     QString directory_;
+    StorageType storageType_;
+    QGeoTilePackStore *packStore_;
 
     int minTextureUsage_;
     int extraTextureUsage_;
+    TextureFormatPolicy textureFormatPolicy_;
+    bool keepCompressedTiles_;
+
+    struct PendingLoad
+    {
+        QSharedPointer<QAtomicInt> cancelled; // shared with the load job
+        int waiters;
+    };
+
+    QThreadPool loadPool_;
+    QHash<QGeoTileSpec, PendingLoad> pendingLoads_;
+    QSharedPointer<QGeoTileLoadResults> loadResults_;
+    int loadGeneration_;
+
+    friend class QGeoTileLoadJob;
 };
 
 QT_END_NAMESPACE
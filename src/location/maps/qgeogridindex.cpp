@@ -0,0 +1,310 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeogridindex_p.h"
+
+#include <QtCore/qnumeric.h>
+
+#include <algorithm>
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// rectangles covering more cells than this go to the list of large ones
+const qint64 MAX_ITEM_CELLS = 64;
+
+// cell coordinates are clamped to this, far beyond any sensible use
+const double MAX_CELL = 1 << 30;
+
+int cellCoordinate(double value, double cellSize)
+{
+    return int(qBound(-MAX_CELL, std::floor(value / cellSize), MAX_CELL));
+}
+
+bool intersects(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right()
+            && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+void removeOne(QVector<int> &ids, int id)
+{
+    const int i = ids.indexOf(id);
+    if (i < 0)
+        return;
+    ids[i] = ids.last();
+    ids.removeLast();
+}
+
+}
+
+QGeoGridIndex::QGeoGridIndex(double cellSize)
+:   cellSize_(cellSize > 0.0 ? cellSize : 1.0)
+{
+}
+
+/*!
+    \internal
+*/
+double QGeoGridIndex::cellSize() const
+{
+    return cellSize_;
+}
+
+/*!
+    \internal
+
+    Changes the size of the grid cells to \a cellSize and sorts the
+    rectangles into the new cells.
+*/
+void QGeoGridIndex::setCellSize(double cellSize)
+{
+    if (cellSize <= 0.0 || cellSize == cellSize_)
+        return;
+
+    const QHash<int, QRectF> rects = rects_;
+    clear();
+    cellSize_ = cellSize;
+    for (QHash<int, QRectF>::const_iterator it = rects.constBegin(); it != rects.constEnd(); ++it)
+        insert(it.key(), it.value());
+}
+
+/*!
+    \internal
+
+    Adds the rectangle \a rect under \a id, replacing the one it had before.
+    Rectangles with coordinates that are not finite are not indexed.
+*/
+void QGeoGridIndex::insert(int id, const QRectF &rect)
+{
+    remove(id);
+
+    const QRectF r = rect.normalized();
+    int left, top, right, bottom;
+    if (!cellRange(r, &left, &top, &right, &bottom))
+        return;
+
+    rects_.insert(id, r);
+
+    if (qint64(right - left + 1) * qint64(bottom - top + 1) > MAX_ITEM_CELLS) {
+        large_.append(id);
+        return;
+    }
+
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x)
+            cells_[cellKey(x, y)].append(id);
+    }
+}
+
+/*!
+    \internal
+
+    Removes the rectangle of \a id. Returns false if there was none.
+*/
+bool QGeoGridIndex::remove(int id)
+{
+    QHash<int, QRectF>::iterator it = rects_.find(id);
+    if (it == rects_.end())
+        return false;
+
+    const QRectF r = it.value();
+    rects_.erase(it);
+
+    int left, top, right, bottom;
+    cellRange(r, &left, &top, &right, &bottom);
+    if (qint64(right - left + 1) * qint64(bottom - top + 1) > MAX_ITEM_CELLS) {
+        removeOne(large_, id);
+        return true;
+    }
+
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            QHash<quint64, QVector<int> >::iterator cell = cells_.find(cellKey(x, y));
+            if (cell == cells_.end())
+                continue;
+            removeOne(cell.value(), id);
+            if (cell.value().isEmpty())
+                cells_.erase(cell);
+        }
+    }
+    return true;
+}
+
+/*!
+    \internal
+*/
+void QGeoGridIndex::clear()
+{
+    cells_.clear();
+    rects_.clear();
+    large_.clear();
+}
+
+/*!
+    \internal
+
+    Adds \a delta to every id from \a from on, as when rows are inserted
+    into or removed from a model the ids stand for. The rectangles stay in
+    their cells. When \a delta is negative, the ids from \a from + \a delta
+    to \a from - 1 must have been removed first.
+*/
+void QGeoGridIndex::shiftIds(int from, int delta)
+{
+    if (delta == 0 || rects_.isEmpty())
+        return;
+
+    QHash<int, QRectF> rects;
+    rects.reserve(rects_.size());
+    for (QHash<int, QRectF>::const_iterator it = rects_.constBegin(); it != rects_.constEnd(); ++it)
+        rects.insert(it.key() >= from ? it.key() + delta : it.key(), it.value());
+    rects_.swap(rects);
+
+    for (QHash<quint64, QVector<int> >::iterator cell = cells_.begin(); cell != cells_.end(); ++cell) {
+        QVector<int> &ids = cell.value();
+        for (int i = 0; i < ids.size(); ++i) {
+            if (ids.at(i) >= from)
+                ids[i] += delta;
+        }
+    }
+    for (int i = 0; i < large_.size(); ++i) {
+        if (large_.at(i) >= from)
+            large_[i] += delta;
+    }
+}
+
+/*!
+    \internal
+*/
+bool QGeoGridIndex::contains(int id) const
+{
+    return rects_.contains(id);
+}
+
+/*!
+    \internal
+*/
+QRectF QGeoGridIndex::rect(int id) const
+{
+    return rects_.value(id);
+}
+
+/*!
+    \internal
+*/
+int QGeoGridIndex::count() const
+{
+    return rects_.size();
+}
+
+/*!
+    \internal
+
+    Returns the ids of the rectangles intersecting \a rect in ascending
+    order.
+*/
+QVector<int> QGeoGridIndex::intersecting(const QRectF &rect) const
+{
+    QVector<int> ids;
+    const QRectF r = rect.normalized();
+    int left, top, right, bottom;
+    if (rects_.isEmpty() || !cellRange(r, &left, &top, &right, &bottom))
+        return ids;
+
+    const qint64 cells = qint64(right - left + 1) * qint64(bottom - top + 1);
+    if (cells > qint64(rects_.size())) {
+        // more cells to look at than rectangles to test
+        for (QHash<int, QRectF>::const_iterator it = rects_.constBegin(); it != rects_.constEnd(); ++it) {
+            if (intersects(it.value(), r))
+                ids.append(it.key());
+        }
+    } else {
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                QHash<quint64, QVector<int> >::const_iterator cell = cells_.constFind(cellKey(x, y));
+                if (cell == cells_.constEnd())
+                    continue;
+                foreach (int id, cell.value()) {
+                    if (intersects(rects_.value(id), r))
+                        ids.append(id);
+                }
+            }
+        }
+        foreach (int id, large_) {
+            if (intersects(rects_.value(id), r))
+                ids.append(id);
+        }
+    }
+
+    // rectangles spanning several cells are found more than once
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+/*!
+    \internal
+
+    Returns the ids of the rectangles containing \a point in ascending
+    order.
+*/
+QVector<int> QGeoGridIndex::containing(const QPointF &point) const
+{
+    return intersecting(QRectF(point, point));
+}
+
+bool QGeoGridIndex::cellRange(const QRectF &rect, int *left, int *top, int *right, int *bottom) const
+{
+    if (!qIsFinite(rect.left()) || !qIsFinite(rect.right())
+            || !qIsFinite(rect.top()) || !qIsFinite(rect.bottom())) {
+        return false;
+    }
+
+    *left = cellCoordinate(rect.left(), cellSize_);
+    *top = cellCoordinate(rect.top(), cellSize_);
+    *right = cellCoordinate(rect.right(), cellSize_);
+    *bottom = cellCoordinate(rect.bottom(), cellSize_);
+    return true;
+}
+
+quint64 QGeoGridIndex::cellKey(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOGRIDINDEX_P_H
+#define QGEOGRIDINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtCore/QHash>
+#include <QtCore/QRectF>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    A uniform grid over rectangles identified by integers, for finding the
+    ones near a point or a region without testing all of them.
+
+    Every rectangle is listed in the square cells it overlaps. Rectangles
+    that would cover too many cells are kept in a separate list that every
+    query checks. Points are rectangles of zero size, and rectangles touching
+    at an edge count as intersecting.
+*/
+class Q_LOCATION_EXPORT QGeoGridIndex
+{
+public:
+    explicit QGeoGridIndex(double cellSize = 1.0);
+
+    double cellSize() const;
+    void setCellSize(double cellSize);
+
+    void insert(int id, const QRectF &rect);
+    bool remove(int id);
+    void clear();
+    void shiftIds(int from, int delta);
+
+    bool contains(int id) const;
+    QRectF rect(int id) const;
+    int count() const;
+
+    QVector<int> intersecting(const QRectF &rect) const;
+    QVector<int> containing(const QPointF &point) const;
+
+private:
+    bool cellRange(const QRectF &rect, int *left, int *top, int *right, int *bottom) const;
+    static quint64 cellKey(int x, int y);
+
+    QHash<quint64, QVector<int> > cells_;
+    QHash<int, QRectF> rects_;
+    QVector<int> large_;
+    double cellSize_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOGRIDINDEX_P_H
@@ -128,6 +128,17 @@ QGeoCameraCapabilities QGeoMap::cameraCapabilities()
         return QGeoCameraCapabilities();
 }
 
+/*
+    Returns the transform from mercator space to item positions for the
+    current camera, or an invalid transform when the map cannot express its
+    projection that way. Callers then have to fall back to
+    coordinateToItemPosition().
+*/
+QGeoMercatorTransform QGeoMap::mercatorTransform() const
+{
+    return QGeoMercatorTransform();
+}
+
 void QGeoMap::prefetchData()
 {
 
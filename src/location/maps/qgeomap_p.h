@@ -49,6 +49,7 @@
 
 #include "qgeocameradata_p.h"
 #include "qgeomaptype_p.h"
+#include "qgeomercatortransform_p.h"
 #include <QtCore/QObject>
 #include <QtPositioning/private/qdoublevector2d_p.h>
 
@@ -83,6 +84,7 @@ public:
 
     virtual QGeoCoordinate itemPositionToCoordinate(const QDoubleVector2D &pos, bool clipToViewport = true) const = 0;
     virtual QDoubleVector2D coordinateToItemPosition(const QGeoCoordinate &coordinate, bool clipToViewport = true) const = 0;
+    virtual QGeoMercatorTransform mercatorTransform() const;
     virtual void prefetchData();
     virtual void clearData();
 
@@ -40,12 +40,19 @@
 #include "qgeotilespec_p.h"
 #include <QtPositioning/private/qdoublevector3d_p.h>
 #include <QtCore/private/qobject_p.h>
-#include <QtQuick/QSGSimpleTextureNode>
+#include "qgeotileatlas_p.h"
+#include <QtQuick/QSGGeometryNode>
+#include <QtQuick/QSGTextureMaterial>
 #include <QtQuick/QQuickWindow>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
 #include <cmath>
 
 QT_BEGIN_NAMESPACE
 
+// how many zoom levels up a missing tile looks for a cached ancestor
+static const int FALLBACK_LEVELS = 4;
+
 class QGeoMapScenePrivate : public QObjectPrivate
 {
     Q_DECLARE_PUBLIC(QGeoMapScene)
@@ -76,6 +83,8 @@ public:
     int m_sideLength;
 
     QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > m_textures;
+    // cached tiles of other zoom levels standing in for visible tiles without a texture
+    QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > m_fallbackTextures;
 
     // tilesToGrid transform
     int m_minTileX; // the minimum tile index, i.e. 0 to sideLength which is 1<< zoomLevel
@@ -168,6 +177,32 @@ void QGeoMapScene::addTile(const QGeoTileSpec &spec, QSharedPointer<QGeoTileText
     d->addTile(spec, texture);
 }
 
+void QGeoMapScene::setFallbackTiles(const QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > &tiles)
+{
+    Q_D(QGeoMapScene);
+    d->m_fallbackTextures = tiles;
+}
+
+/*
+    Returns the tiles that can be drawn in place of \a spec while it has no
+    texture, best first: the nearest FALLBACK_LEVELS ancestors,
+    drawn scaled up from the matching sub-rectangle, followed by the four
+    children of the next zoom level.
+*/
+QList<QGeoTileSpec> QGeoMapScene::fallbackCandidates(const QGeoTileSpec &spec)
+{
+    QList<QGeoTileSpec> candidates;
+    for (int dz = 1; dz <= FALLBACK_LEVELS && dz <= spec.zoom(); ++dz) {
+        candidates << QGeoTileSpec(spec.plugin(), spec.mapId(), spec.zoom() - dz,
+                                   spec.x() >> dz, spec.y() >> dz, spec.version());
+    }
+    for (int i = 0; i < 4; ++i) {
+        candidates << QGeoTileSpec(spec.plugin(), spec.mapId(), spec.zoom() + 1,
+                                   spec.x() * 2 + (i & 1), spec.y() * 2 + (i >> 1), spec.version());
+    }
+    return candidates;
+}
+
 QDoubleVector2D QGeoMapScene::itemPositionToMercator(const QDoubleVector2D &pos) const
 {
     Q_D(const QGeoMapScene);
@@ -180,6 +215,21 @@ QDoubleVector2D QGeoMapScene::mercatorToItemPosition(const QDoubleVector2D &merc
     return d->mercatorToItemPosition(mercator);
 }
 
+QGeoMercatorTransform QGeoMapScene::mercatorTransform() const
+{
+    Q_D(const QGeoMapScene);
+    if (d->m_sideLength == 0 || d->m_mercatorWidth <= 0.0 || d->m_mercatorHeight <= 0.0)
+        return QGeoMercatorTransform();
+
+    // mercatorToItemPosition() with the wrapping reduced to "closest copy of the world"
+    return QGeoMercatorTransform(d->m_mercatorCenterX / d->m_sideLength,
+                                 d->m_screenWidth * d->m_sideLength / d->m_mercatorWidth,
+                                 d->m_screenOffsetX + 0.5 * d->m_screenWidth,
+                                 d->m_screenHeight * d->m_sideLength / d->m_mercatorHeight,
+                                 d->m_screenOffsetY
+                                    + d->m_screenHeight * (0.5 - d->m_mercatorCenterY / d->m_mercatorHeight));
+}
+
 bool QGeoMapScene::verticalLock() const
 {
     Q_D(const QGeoMapScene);
@@ -550,27 +600,67 @@ void QGeoMapScenePrivate::setupCamera()
     m_projectionMatrix.frustum(-halfWidth, halfWidth, -halfHeight, halfHeight, nearPlane, farPlane);
 }
 
+// All tiles of one atlas page, drawn with a single geometry node
+class QGeoMapTilePageNode : public QSGGeometryNode
+{
+public:
+    explicit QGeoMapTilePageNode(QSGTexture *texture)
+        : geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0)
+    {
+        geometry.setDrawingMode(GL_TRIANGLES);
+        setGeometry(&geometry);
+        material.setTexture(texture);
+        opaqueMaterial.setTexture(texture);
+        setMaterial(&material);
+        setOpaqueMaterial(&opaqueMaterial);
+    }
+
+    void setFiltering(QSGTexture::Filtering filtering)
+    {
+        if (material.filtering() == filtering)
+            return;
+        material.setFiltering(filtering);
+        opaqueMaterial.setFiltering(filtering);
+        markDirty(DirtyMaterial);
+    }
+
+    // the page only needs blending once a translucent tile was uploaded to it
+    void updateBlending()
+    {
+        const bool blending = material.texture()->hasAlphaChannel();
+        if (bool(material.flags() & QSGMaterial::Blending) == blending)
+            return;
+        material.setFlag(QSGMaterial::Blending, blending);
+        markDirty(DirtyMaterial);
+    }
+
+    QSGGeometry geometry;
+    QSGTextureMaterial material;
+    QSGOpaqueTextureMaterial opaqueMaterial;
+};
+
 class QGeoMapTileContainerNode : public QSGTransformNode
 {
 public:
-    void addChild(const QGeoTileSpec &spec, QSGSimpleTextureNode *node)
+    void clearPages()
     {
-        tiles.insert(spec, node);
-        appendChildNode(node);
+        qDeleteAll(pages);
+        pages.clear();
     }
-    QHash<QGeoTileSpec, QSGSimpleTextureNode *> tiles;
+
+    QVector<QGeoMapTilePageNode *> pages;
 };
 
 class QGeoMapRootNode : public QSGClipNode
 {
 public:
     QGeoMapRootNode()
-        : isTextureLinear(false)
-        , geometry(QSGGeometry::defaultAttributes_Point2D(), 4)
+        : geometry(QSGGeometry::defaultAttributes_Point2D(), 4)
         , root(new QSGTransformNode())
         , tiles(new QGeoMapTileContainerNode())
         , wrapLeft(new QGeoMapTileContainerNode())
         , wrapRight(new QGeoMapTileContainerNode())
+        , atlas(0)
     {
         setIsRectangular(true);
         setGeometry(&geometry);
@@ -582,7 +672,11 @@ public:
 
     ~QGeoMapRootNode()
     {
-        qDeleteAll(textures);
+        tiles->clearPages();
+        wrapLeft->clearPages();
+        wrapRight->clearPages();
+        qDeleteAll(pages);
+        delete atlas;
     }
 
     void setClipRect(const QRect &rect)
@@ -595,10 +689,12 @@ public:
         }
     }
 
+    void updateAtlas(QGeoMapScenePrivate *d);
+    void addToAtlas(const QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > &textures);
+    void addQuad(const QSGGeometry::TexturedPoint2D *tile, const QRectF &part,
+                 const QGeoTileAtlasLayout::Slot &slot, const QRectF &texturePart);
     void updateTiles(QGeoMapTileContainerNode *root, QGeoMapScenePrivate *d, double camAdjust);
 
-    bool isTextureLinear;
-
     QSGGeometry geometry;
     QRect clipRect;
 
@@ -608,7 +704,15 @@ public:
     QGeoMapTileContainerNode *wrapLeft;     // When zoomed out, the tiles that wrap around on the left.
     QGeoMapTileContainerNode *wrapRight;    // When zoomed out, the tiles that wrap around on the right
 
-    QHash<QGeoTileSpec, QSGTexture *> textures;
+    QGeoTileAtlasLayout *atlas;
+    QVector<QGeoTileAtlasTexture *> pages;
+
+    struct TileQuad
+    {
+        int page;
+        QSGGeometry::TexturedPoint2D v[4];
+    };
+    QVector<TileQuad> quads;                // scratch, keeps its capacity between frames
 };
 
 static bool qgeomapscene_isTileInViewport(const QSGGeometry::TexturedPoint2D *tp, const QMatrix4x4 &matrix) {
@@ -623,6 +727,84 @@ static QVector3D toVector3D(const QDoubleVector3D& in)
     return QVector3D(in.x(), in.y(), in.z());
 }
 
+/*
+    Keeps the atlas in step with the visible tiles: tiles that left the scene
+    give up their slot and newly textured tiles are queued for upload into a
+    free one. Only the sub-rectangles of arriving tiles are ever uploaded.
+*/
+void QGeoMapRootNode::updateAtlas(QGeoMapScenePrivate *d)
+{
+    if (atlas && atlas->tileSize() != d->m_tileSize) {
+        tiles->clearPages();
+        wrapLeft->clearPages();
+        wrapRight->clearPages();
+        qDeleteAll(pages);
+        pages.clear();
+        delete atlas;
+        atlas = 0;
+    }
+
+    if (!atlas) {
+        GLint maxTextureSize = 2048;
+        if (QOpenGLContext *context = QOpenGLContext::currentContext())
+            context->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+        atlas = new QGeoTileAtlasLayout(qMin(2048, int(maxTextureSize)), d->m_tileSize);
+    }
+
+    foreach (const QGeoTileSpec &spec, atlas->tiles()) {
+        if (!d->m_visibleTiles.contains(spec) && !d->m_fallbackTextures.contains(spec))
+            atlas->remove(spec);
+    }
+
+    addToAtlas(d->m_textures);
+    addToAtlas(d->m_fallbackTextures);
+}
+
+void QGeoMapRootNode::addToAtlas(const QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > &textures)
+{
+    typedef QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> >::const_iterator iter;
+    for (iter it = textures.constBegin(); it != textures.constEnd(); ++it) {
+        if (!it.value() || it.value()->image.isNull() || atlas->contains(it.key()))
+            continue;
+
+        QGeoTileAtlasLayout::Slot slot = atlas->insert(it.key());
+        while (pages.size() < atlas->pageCount())
+            pages.append(new QGeoTileAtlasTexture(atlas->pageSize()));
+        pages.at(slot.page)->setTile(atlas->pixelRect(slot), it.value()->image);
+    }
+}
+
+/*
+    Queues the quad covering \a part of the tile whose vertices are \a tile,
+    textured with \a texturePart of the atlas slot. Parts are in the 0..1
+    range of the tile, y pointing down.
+*/
+void QGeoMapRootNode::addQuad(const QSGGeometry::TexturedPoint2D *tile, const QRectF &part,
+                              const QGeoTileAtlasLayout::Slot &slot, const QRectF &texturePart)
+{
+    TileQuad quad;
+    quad.page = slot.page;
+
+    // see QGeoMapScenePrivate::buildGeometry() for the vertex order
+    const double x1 = tile[0].x + part.left() * (tile[3].x - tile[0].x);
+    const double x2 = tile[0].x + part.right() * (tile[3].x - tile[0].x);
+    const double y1 = tile[0].y + part.top() * (tile[3].y - tile[0].y);
+    const double y2 = tile[0].y + part.bottom() * (tile[3].y - tile[0].y);
+
+    // map onto the atlas slot
+    const QRectF rect = atlas->textureRect(slot);
+    const double tx1 = rect.x() + texturePart.left() * rect.width();
+    const double tx2 = rect.x() + texturePart.right() * rect.width();
+    const double ty1 = rect.y() + texturePart.top() * rect.height();
+    const double ty2 = rect.y() + texturePart.bottom() * rect.height();
+
+    quad.v[0].set(x1, y1, tx1, ty1);
+    quad.v[1].set(x1, y2, tx1, ty2);
+    quad.v[2].set(x2, y1, tx2, ty1);
+    quad.v[3].set(x2, y2, tx2, ty2);
+    quads.append(quad);
+}
+
 void QGeoMapRootNode::updateTiles(QGeoMapTileContainerNode *root,
                                   QGeoMapScenePrivate *d,
                                   double camAdjust)
@@ -636,67 +818,89 @@ void QGeoMapRootNode::updateTiles(QGeoMapTileContainerNode *root,
     cameraMatrix.lookAt(toVector3D(eye), toVector3D(center), toVector3D(d->m_cameraUp));
     root->setMatrix(d->m_projectionMatrix * cameraMatrix);
 
-    QSet<QGeoTileSpec> tilesInSG = QSet<QGeoTileSpec>::fromList(root->tiles.keys());
-    QSet<QGeoTileSpec> toRemove = tilesInSG - d->m_visibleTiles;
-    QSet<QGeoTileSpec> toAdd = d->m_visibleTiles - tilesInSG;
-
-    foreach (const QGeoTileSpec &s, toRemove)
-        delete root->tiles.take(s);
-
-    for (QHash<QGeoTileSpec, QSGSimpleTextureNode *>::iterator it = root->tiles.begin();
-         it != root->tiles.end(); ) {
-        QSGGeometry visualGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4);
-        QSGGeometry::TexturedPoint2D *v = visualGeometry.vertexDataAsTexturedPoint2D();
-        bool ok = d->buildGeometry(it.key(), v) && qgeomapscene_isTileInViewport(v, root->matrix());
-        QSGSimpleTextureNode *node = it.value();
-        QSGNode::DirtyState dirtyBits = 0;
-
-        // Check and handle changes to vertex data.
-        if (ok && memcmp(node->geometry()->vertexData(), v, 4 * sizeof(QSGGeometry::TexturedPoint2D)) != 0) {
-            if (v[0].x == v[3].x || v[0].y == v[3].y) { // top-left == bottom-right => invalid => remove
-                ok = false;
-            } else {
-                memcpy(node->geometry()->vertexData(), v, 4 * sizeof(QSGGeometry::TexturedPoint2D));
-                dirtyBits |= QSGNode::DirtyGeometry;
-            }
+    quads.resize(0);
+
+    const QRectF wholeTile(0, 0, 1, 1);
+    QSGGeometry::TexturedPoint2D v[4];
+
+    foreach (const QGeoTileSpec &spec, d->m_visibleTiles) {
+        if (!d->buildGeometry(spec, v) || !qgeomapscene_isTileInViewport(v, root->matrix()))
+            continue;
+        if (v[0].x == v[3].x || v[0].y == v[3].y) // top-left == bottom-right => invalid
+            continue;
+
+        QGeoTileAtlasLayout::Slot slot = atlas->slot(spec);
+        if (slot.isValid()) {
+            addQuad(v, wholeTile, slot, wholeTile);
+            continue;
         }
 
-        if (!ok) {
-            it = root->tiles.erase(it);
-            delete node;
-        } else {
-            if (isTextureLinear != d->m_linearScaling) {
-                node->setFiltering(d->m_linearScaling ? QSGTexture::Linear : QSGTexture::Nearest);
-                dirtyBits |= QSGNode::DirtyMaterial;
+        if (d->m_fallbackTextures.isEmpty())
+            continue;
+
+        // No texture yet, draw the best cached tile of another zoom level instead
+        foreach (const QGeoTileSpec &fallback, QGeoMapScene::fallbackCandidates(spec)) {
+            slot = atlas->slot(fallback);
+            if (!slot.isValid())
+                continue;
+
+            const int dz = spec.zoom() - fallback.zoom();
+            if (dz > 0) {
+                // an ancestor: the part of it covering this tile, scaled up
+                const double size = 1.0 / (1 << dz);
+                const QRectF part(size * (spec.x() - (fallback.x() << dz)),
+                                  size * (spec.y() - (fallback.y() << dz)),
+                                  size, size);
+                addQuad(v, wholeTile, slot, part);
+                break;
             }
-            if (dirtyBits != 0)
-                node->markDirty(dirtyBits);
-            it++;
+
+            // a child: a whole texture covering a quarter of this tile
+            const QRectF part(0.5 * (fallback.x() - spec.x() * 2),
+                              0.5 * (fallback.y() - spec.y() * 2),
+                              0.5, 0.5);
+            addQuad(v, part, slot, wholeTile);
         }
     }
 
-    foreach (const QGeoTileSpec &s, toAdd) {
-        QGeoTileTexture *tileTexture = d->m_textures.value(s).data();
-        if (!tileTexture || tileTexture->image.isNull())
-            continue;
-        QSGSimpleTextureNode *tileNode = new QSGSimpleTextureNode();
-        // note: setTexture will update coordinates so do it here, before we buildGeometry
-        tileNode->setTexture(textures.value(s));
-        Q_ASSERT(tileNode->geometry());
-        Q_ASSERT(tileNode->geometry()->attributes() == QSGGeometry::defaultAttributes_TexturedPoint2D().attributes);
-        Q_ASSERT(tileNode->geometry()->vertexCount() == 4);
-        if (d->buildGeometry(s, tileNode->geometry()->vertexDataAsTexturedPoint2D())
-                && qgeomapscene_isTileInViewport(tileNode->geometry()->vertexDataAsTexturedPoint2D(), root->matrix())) {
-            tileNode->setFiltering(d->m_linearScaling ? QSGTexture::Linear : QSGTexture::Nearest);
-            root->addChild(s, tileNode);
-        } else {
-            delete tileNode;
+    QVector<int> quadsPerPage(pages.size(), 0);
+    for (int i = 0; i < quads.size(); ++i)
+        ++quadsPerPage[quads.at(i).page];
+
+    while (root->pages.size() < pages.size()) {
+        QGeoMapTilePageNode *node = new QGeoMapTilePageNode(pages.at(root->pages.size()));
+        root->pages.append(node);
+        root->appendChildNode(node);
+    }
+
+    const QSGTexture::Filtering filtering = d->m_linearScaling ? QSGTexture::Linear : QSGTexture::Nearest;
+    for (int page = 0; page < root->pages.size(); ++page) {
+        QGeoMapTilePageNode *node = root->pages.at(page);
+        node->geometry.allocate(6 * quadsPerPage.at(page));
+
+        QSGGeometry::TexturedPoint2D *vertices = node->geometry.vertexDataAsTexturedPoint2D();
+        for (int i = 0; i < quads.size(); ++i) {
+            const TileQuad &quad = quads.at(i);
+            if (quad.page != page)
+                continue;
+            // the quad was a triangle strip, as two triangles
+            *vertices++ = quad.v[0];
+            *vertices++ = quad.v[1];
+            *vertices++ = quad.v[2];
+            *vertices++ = quad.v[2];
+            *vertices++ = quad.v[1];
+            *vertices++ = quad.v[3];
         }
+
+        node->setFiltering(filtering);
+        node->updateBlending();
+        node->markDirty(QSGNode::DirtyGeometry);
     }
 }
 
 QSGNode *QGeoMapScene::updateSceneGraph(QSGNode *oldNode, QQuickWindow *window)
 {
+    Q_UNUSED(window);
     Q_D(QGeoMapScene);
     float w = d->m_screenSize.width();
     float h = d->m_screenSize.height();
@@ -717,26 +921,13 @@ QSGNode *QGeoMapScene::updateSceneGraph(QSGNode *oldNode, QQuickWindow *window)
     itemSpaceMatrix.scale(1, -1);
     mapRoot->root->setMatrix(itemSpaceMatrix);
 
-    QSet<QGeoTileSpec> textures = QSet<QGeoTileSpec>::fromList(mapRoot->textures.keys());
-    QSet<QGeoTileSpec> toRemove = textures - d->m_visibleTiles;
-    QSet<QGeoTileSpec> toAdd = d->m_visibleTiles - textures;
-
-    foreach (const QGeoTileSpec &spec, toRemove)
-        mapRoot->textures.take(spec)->deleteLater();
-    foreach (const QGeoTileSpec &spec, toAdd) {
-        QGeoTileTexture *tileTexture = d->m_textures.value(spec).data();
-        if (!tileTexture || tileTexture->image.isNull())
-            continue;
-        mapRoot->textures.insert(spec, window->createTextureFromImage(tileTexture->image));
-    }
+    mapRoot->updateAtlas(d);
 
     double sideLength = d->m_scaleFactor * d->m_tileSize * d->m_sideLength;
     mapRoot->updateTiles(mapRoot->tiles, d, 0);
     mapRoot->updateTiles(mapRoot->wrapLeft, d, +sideLength);
     mapRoot->updateTiles(mapRoot->wrapRight, d, -sideLength);
 
-    mapRoot->isTextureLinear = d->m_linearScaling;
-
     return mapRoot;
 }
 
@@ -48,7 +48,10 @@
 //
 
 #include <QObject>
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
 #include <QtLocation/qlocationglobal.h>
+#include "qgeomercatortransform_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -78,9 +81,12 @@ public:
     void setUseVerticalLock(bool lock);
 
     void addTile(const QGeoTileSpec &spec, QSharedPointer<QGeoTileTexture> texture);
+    void setFallbackTiles(const QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > &tiles);
+    static QList<QGeoTileSpec> fallbackCandidates(const QGeoTileSpec &spec);
 
     QDoubleVector2D itemPositionToMercator(const QDoubleVector2D &pos) const;
     QDoubleVector2D mercatorToItemPosition(const QDoubleVector2D &mercator) const;
+    QGeoMercatorTransform mercatorTransform() const;
 
     QSGNode *updateSceneGraph(QSGNode *oldNode, QQuickWindow *window);
 
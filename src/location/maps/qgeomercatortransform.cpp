@@ -0,0 +1,95 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeomercatortransform_p.h"
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Constructs an invalid transform, for maps that cannot describe their
+    projection this way.
+*/
+QGeoMercatorTransform::QGeoMercatorTransform()
+:   centerX_(0.0),
+    scaleX_(0.0),
+    offsetX_(0.0),
+    scaleY_(0.0),
+    offsetY_(0.0),
+    valid_(false)
+{
+}
+
+QGeoMercatorTransform::QGeoMercatorTransform(double centerX, double scaleX, double offsetX,
+                                             double scaleY, double offsetY)
+:   centerX_(centerX),
+    scaleX_(scaleX),
+    offsetX_(offsetX),
+    scaleY_(scaleY),
+    offsetY_(offsetY),
+    valid_(true)
+{
+}
+
+QDoubleVector2D QGeoMercatorTransform::map(const QDoubleVector2D &mercator) const
+{
+    double dx = mercator.x() - centerX_;
+    dx -= std::floor(dx + 0.5);
+    return QDoubleVector2D(offsetX_ + scaleX_ * dx, offsetY_ + scaleY_ * mercator.y());
+}
+
+/*
+    Maps \a count points stored as x, y pairs in \a mercator to item
+    positions in \a positions, which may be the same array. The loop has no
+    branches so that the compiler can vectorize it.
+*/
+void QGeoMercatorTransform::map(const double *mercator, double *positions, int count) const
+{
+    const double centerX = centerX_;
+    const double scaleX = scaleX_;
+    const double offsetX = offsetX_;
+    const double scaleY = scaleY_;
+    const double offsetY = offsetY_;
+
+    for (int i = 0; i < 2 * count; i += 2) {
+        double dx = mercator[i] - centerX;
+        dx -= std::floor(dx + 0.5);
+        positions[i] = offsetX + scaleX * dx;
+        positions[i + 1] = offsetY + scaleY * mercator[i + 1];
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOMERCATORTRANSFORM_P_H
+#define QGEOMERCATORTRANSFORM_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    The mapping from normalized web mercator coordinates (0 to 1, y pointing
+    south) to item positions for the current camera of a map:
+
+        x = offsetX + scaleX * wrap(mercatorX - centerX)
+        y = offsetY + scaleY * mercatorY
+
+    where wrap() picks the copy of the world closest to the center, the same
+    as QGeoMap::coordinateToItemPosition() does. Map items keep their paths in
+    mercator space and project them with one pass over the vertices instead
+    of going through the map for every coordinate.
+*/
+class Q_LOCATION_EXPORT QGeoMercatorTransform
+{
+public:
+    QGeoMercatorTransform();
+    QGeoMercatorTransform(double centerX, double scaleX, double offsetX,
+                          double scaleY, double offsetY);
+
+    bool isValid() const { return valid_; }
+
+    double centerX() const { return centerX_; }
+    double scaleX() const { return scaleX_; }
+    double offsetX() const { return offsetX_; }
+    double scaleY() const { return scaleY_; }
+    double offsetY() const { return offsetY_; }
+
+    QDoubleVector2D map(const QDoubleVector2D &mercator) const;
+    void map(const double *mercator, double *positions, int count) const;
+
+private:
+    double centerX_;
+    double scaleX_;
+    double offsetX_;
+    double scaleY_;
+    double offsetY_;
+    bool valid_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOMERCATORTRANSFORM_P_H
@@ -0,0 +1,202 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeopathsimplifier_p.h"
+
+#include <QtCore/qnumeric.h>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// a span of the path whose inner vertices are not split yet
+struct Span
+{
+    int first;
+    int last;
+    int parent;
+    bool left;
+};
+
+// squared distance of (px, py) to the segment from (ax, ay) to (bx, by)
+double segmentDistance(double px, double py, double ax, double ay, double bx, double by)
+{
+    const double dx = bx - ax;
+    const double dy = by - ay;
+    const double length = dx * dx + dy * dy;
+    double t = length > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / length : 0.0;
+    t = qBound(0.0, t, 1.0);
+    const double ex = ax + t * dx - px;
+    const double ey = ay + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+}
+
+QGeoPathSimplifier::QGeoPathSimplifier()
+:   root_(-1)
+{
+}
+
+/*!
+    \internal
+
+    Builds the simplification of the \a count points in \a points, which
+    holds x, y pairs. The points are not kept.
+*/
+void QGeoPathSimplifier::build(const double *points, int count)
+{
+    clear();
+    if (count <= 0)
+        return;
+
+    tolerances_.fill(0.0, count);
+    left_.fill(-1, count);
+    right_.fill(-1, count);
+
+    // the ends are part of every simplification
+    tolerances_[0] = qInf();
+    tolerances_[count - 1] = qInf();
+
+    double *tolerances = tolerances_.data();
+    QVector<Span> stack;
+    if (count > 2) {
+        Span span = { 0, count - 1, -1, false };
+        stack.append(span);
+    }
+
+    while (!stack.isEmpty()) {
+        const Span span = stack.takeLast();
+
+        const double ax = points[2 * span.first];
+        const double ay = points[2 * span.first + 1];
+        const double bx = points[2 * span.last];
+        const double by = points[2 * span.last + 1];
+        int split = span.first + 1;
+        double distance = -1.0;
+        for (int i = span.first + 1; i < span.last; ++i) {
+            const double d = segmentDistance(points[2 * i], points[2 * i + 1], ax, ay, bx, by);
+            if (d > distance) {
+                distance = d;
+                split = i;
+            }
+        }
+
+        double tolerance = std::sqrt(distance);
+        if (span.parent < 0) {
+            root_ = split;
+        } else {
+            tolerance = qMin(tolerance, tolerances[span.parent]);
+            if (span.left)
+                left_[span.parent] = split;
+            else
+                right_[span.parent] = split;
+        }
+        tolerances[split] = tolerance;
+
+        if (split - span.first > 1) {
+            Span before = { span.first, split, split, true };
+            stack.append(before);
+        }
+        if (span.last - split > 1) {
+            Span after = { split, span.last, split, false };
+            stack.append(after);
+        }
+    }
+}
+
+/*!
+    \internal
+*/
+void QGeoPathSimplifier::clear()
+{
+    tolerances_.clear();
+    left_.clear();
+    right_.clear();
+    root_ = -1;
+}
+
+/*!
+    \internal
+
+    Returns the largest tolerance at which the vertex at \a index is kept.
+    It is infinite for the first and the last vertex.
+*/
+double QGeoPathSimplifier::tolerance(int index) const
+{
+    return tolerances_.at(index);
+}
+
+/*!
+    \internal
+
+    Replaces \a indices with the vertices, in path order, that the
+    simplification with the given \a tolerance keeps. A tolerance of 0 keeps
+    every vertex.
+*/
+void QGeoPathSimplifier::select(double tolerance, QVector<int> *indices) const
+{
+    indices->clear();
+    const int count = tolerances_.size();
+    if (count == 0)
+        return;
+
+    indices->append(0);
+
+    // in order walk of the split tree; since no vertex has a larger
+    // tolerance than its parent, a dropped vertex ends its subtree
+    const double *tolerances = tolerances_.constData();
+    QVector<int> stack;
+    int node = root_;
+    for (;;) {
+        while (node >= 0 && tolerances[node] >= tolerance) {
+            stack.append(node);
+            node = left_.at(node);
+        }
+        if (stack.isEmpty())
+            break;
+        node = stack.takeLast();
+        indices->append(node);
+        node = right_.at(node);
+    }
+
+    if (count > 1)
+        indices->append(count - 1);
+}
+
+QT_END_NAMESPACE
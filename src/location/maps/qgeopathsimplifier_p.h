@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOPATHSIMPLIFIER_P_H
+#define QGEOPATHSIMPLIFIER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Precomputed Douglas-Peucker simplification of a path at every tolerance.
+
+    build() runs the algorithm once down to the last vertex and keeps, for
+    every vertex, the largest tolerance at which it is still part of the
+    simplified path, clamped so that it never exceeds the one of the vertex
+    that split its span. select() then walks only the kept part of that
+    split tree, so picking the vertices for a tolerance costs time in the
+    size of the output rather than of the path.
+*/
+class Q_LOCATION_EXPORT QGeoPathSimplifier
+{
+public:
+    QGeoPathSimplifier();
+
+    void build(const double *points, int count);
+    void clear();
+
+    inline int count() const { return tolerances_.size(); }
+    double tolerance(int index) const;
+
+    void select(double tolerance, QVector<int> *indices) const;
+
+private:
+    QVector<double> tolerances_;
+    QVector<int> left_;     // vertex splitting the span before a vertex, or -1
+    QVector<int> right_;    // vertex splitting the span after a vertex, or -1
+    int root_;
+};
+
+Q_DECLARE_TYPEINFO(QGeoPathSimplifier, Q_MOVABLE_TYPE);
+
+QT_END_NAMESPACE
+
+#endif // QGEOPATHSIMPLIFIER_P_H
@@ -0,0 +1,508 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeopolygonclipper_p.h"
+
+#include <QtCore/QtGlobal>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// how far from the border a point must be to count as inside or outside
+const double BORDER_EPSILON = 1e-9;
+
+typedef QGeoPolygonClipper::Ring Ring;
+
+/*
+    A stretch of a ring that lies inside the rectangle. It starts and ends on
+    the border; entry and exit are those points as positions along the
+    border.
+*/
+struct Chain
+{
+    Ring points;
+    double entry;
+    double exit;
+    bool used;
+};
+
+/*
+    The border of the clip rectangle as a closed path that starts in the top
+    left corner and runs in the direction of positive orientation: right
+    along the top edge, down the right edge and back along the bottom and
+    left edges.
+*/
+class Border
+{
+public:
+    explicit Border(const QRectF &rect)
+    :   left_(rect.left()), top_(rect.top()), right_(rect.right()), bottom_(rect.bottom()),
+        width_(rect.width()), height_(rect.height()), perimeter_(2.0 * (width_ + height_))
+    {
+    }
+
+    bool isInside(double x, double y) const
+    {
+        return left_ + BORDER_EPSILON < x && x < right_ - BORDER_EPSILON
+                && top_ + BORDER_EPSILON < y && y < bottom_ - BORDER_EPSILON;
+    }
+
+    bool isOutside(double x, double y) const
+    {
+        return x < left_ - BORDER_EPSILON || right_ + BORDER_EPSILON < x
+                || y < top_ - BORDER_EPSILON || bottom_ + BORDER_EPSILON < y;
+    }
+
+    // position along the border of a point that lies on it
+    double position(double x, double y) const
+    {
+        const double dTop = qAbs(y - top_);
+        const double dRight = qAbs(x - right_);
+        const double dBottom = qAbs(y - bottom_);
+        const double dLeft = qAbs(x - left_);
+        const double nearest = qMin(qMin(dTop, dRight), qMin(dBottom, dLeft));
+
+        if (nearest == dTop)
+            return qBound(0.0, x - left_, width_);
+        if (nearest == dRight)
+            return width_ + qBound(0.0, y - top_, height_);
+        if (nearest == dBottom)
+            return width_ + height_ + qBound(0.0, right_ - x, width_);
+        return distance(0.0, 2.0 * width_ + height_ + qBound(0.0, bottom_ - y, height_));
+    }
+
+    // distance when walking along the border from one position to another
+    double distance(double from, double to) const
+    {
+        double d = to - from;
+        if (d < 0.0)
+            d += perimeter_;
+        if (d >= perimeter_)
+            d -= perimeter_;
+        return d;
+    }
+
+    // appends the corners passed when walking from one position to another
+    void appendCorners(double from, double to, Ring *ring) const
+    {
+        const double corners[4][3] = {
+            { 0.0, left_, top_ },
+            { width_, right_, top_ },
+            { width_ + height_, right_, bottom_ },
+            { 2.0 * width_ + height_, left_, bottom_ }
+        };
+        const double span = distance(from, to);
+
+        // corners come in border order, so the passed ones are a rotation of
+        // the array starting at the first corner after "from"
+        int first = 0;
+        while (first < 4 && corners[first][0] <= from)
+            ++first;
+
+        for (int i = 0; i < 4; ++i) {
+            const double *corner = corners[(first + i) % 4];
+            const double d = distance(from, corner[0]);
+            if (d <= 0.0 || span <= d)
+                break;
+            *ring << corner[1] << corner[2];
+        }
+    }
+
+    Ring ring() const
+    {
+        Ring r;
+        r << left_ << top_ << right_ << top_ << right_ << bottom_ << left_ << bottom_;
+        return r;
+    }
+
+private:
+    double left_;
+    double top_;
+    double right_;
+    double bottom_;
+    double width_;
+    double height_;
+    double perimeter_;
+};
+
+// Liang-Barsky: the parameter range of the segment p -> q inside rect
+bool clipSegment(const double *p, const double *q, const QRectF &rect, double *t0, double *t1)
+{
+    const double dx = q[0] - p[0];
+    const double dy = q[1] - p[1];
+    const double denominators[4] = { -dx, dx, -dy, dy };
+    const double numerators[4] = { p[0] - rect.left(), rect.right() - p[0],
+                                   p[1] - rect.top(), rect.bottom() - p[1] };
+    *t0 = 0.0;
+    *t1 = 1.0;
+
+    for (int i = 0; i < 4; ++i) {
+        if (denominators[i] == 0.0) {
+            if (numerators[i] < 0.0)
+                return false;
+            continue;
+        }
+        const double t = numerators[i] / denominators[i];
+        if (denominators[i] < 0.0) {
+            if (t > *t1)
+                return false;
+            if (t > *t0)
+                *t0 = t;
+        } else {
+            if (t < *t0)
+                return false;
+            if (t < *t1)
+                *t1 = t;
+        }
+    }
+    return true;
+}
+
+/*
+    Finishes a chain. Chains that only run along the border, or only touch it,
+    enclose nothing and are dropped: walking the border between the
+    neighbouring chains covers them.
+*/
+void finishChain(Chain &chain, const Border &border, QVector<Chain> &chains)
+{
+    const double *points = chain.points.constData();
+    const int count = chain.points.size() / 2;
+
+    for (int i = 1; i < count; ++i) {
+        const double mx = 0.5 * (points[2 * i - 2] + points[2 * i]);
+        const double my = 0.5 * (points[2 * i - 1] + points[2 * i + 1]);
+        if (border.isInside(mx, my)) {
+            chain.exit = border.position(points[2 * count - 2], points[2 * count - 1]);
+            chain.used = false;
+            chains.append(chain);
+            return;
+        }
+    }
+}
+
+// drops repeated points, which the triangulator cannot handle
+void removeDuplicates(Ring &ring)
+{
+    int count = 0;
+    double *points = ring.data();
+    for (int i = 0; i < ring.size(); i += 2) {
+        if (count > 0
+                && qAbs(points[i] - points[2 * count - 2]) <= BORDER_EPSILON
+                && qAbs(points[i + 1] - points[2 * count - 1]) <= BORDER_EPSILON) {
+            continue;
+        }
+        points[2 * count] = points[i];
+        points[2 * count + 1] = points[i + 1];
+        ++count;
+    }
+
+    while (count > 1
+           && qAbs(points[0] - points[2 * count - 2]) <= BORDER_EPSILON
+           && qAbs(points[1] - points[2 * count - 1]) <= BORDER_EPSILON) {
+        --count;
+    }
+    ring.resize(2 * count);
+}
+
+} // namespace
+
+/*
+    Returns the part of the polygon given by \a rings that lies inside
+    \a rect. A single convex ring is clipped with Sutherland-Hodgman; anything
+    else is split at the border into chains that are joined again by walking
+    the border, which keeps concave pieces and holes apart.
+*/
+QVector<QGeoPolygonClipper::Ring> QGeoPolygonClipper::clip(const QVector<Ring> &rings,
+                                                           const QRectF &rect)
+{
+    QVector<Ring> result;
+    if (rect.isEmpty())
+        return result;
+
+    if (rings.size() == 1 && isConvex(rings.first())) {
+        Ring clipped = clipConvex(rings.first(), rect);
+        removeDuplicates(clipped);
+        if (clipped.size() >= 6)
+            result.append(clipped);
+        return result;
+    }
+
+    const Border border(rect);
+    QVector<Chain> chains;
+    int winding = 0;
+
+    foreach (const Ring &ring, rings) {
+        const int count = ring.size() / 2;
+        if (count < 3)
+            continue;
+
+        const double *points = ring.constData();
+        double minX = points[0];
+        double maxX = points[0];
+        double minY = points[1];
+        double maxY = points[1];
+        for (int i = 1; i < count; ++i) {
+            minX = qMin(minX, points[2 * i]);
+            maxX = qMax(maxX, points[2 * i]);
+            minY = qMin(minY, points[2 * i + 1]);
+            maxY = qMax(maxY, points[2 * i + 1]);
+        }
+
+        if (maxX < rect.left() || rect.right() < minX || maxY < rect.top() || rect.bottom() < minY)
+            continue;
+
+        // start the walk on a point outside so that no chain wraps around
+        int start = -1;
+        for (int i = 0; i < count && start < 0; ++i) {
+            if (border.isOutside(points[2 * i], points[2 * i + 1]))
+                start = i;
+        }
+        if (start < 0) {
+            result.append(ring);
+            continue;
+        }
+
+        const int chainsBefore = chains.size();
+        Chain chain;
+        bool open = false;
+
+        for (int e = 0; e < count; ++e) {
+            const double *p = points + 2 * ((start + e) % count);
+            const double *q = points + 2 * ((start + e + 1) % count);
+            double t0;
+            double t1;
+
+            if (!clipSegment(p, q, rect, &t0, &t1)) {
+                if (open) {
+                    finishChain(chain, border, chains);
+                    open = false;
+                }
+                continue;
+            }
+
+            if (!open) {
+                const double x = p[0] + t0 * (q[0] - p[0]);
+                const double y = p[1] + t0 * (q[1] - p[1]);
+                chain.points.clear();
+                chain.points << x << y;
+                chain.entry = border.position(x, y);
+                open = true;
+            }
+
+            if (t1 < 1.0) {
+                chain.points << p[0] + t1 * (q[0] - p[0]) << p[1] + t1 * (q[1] - p[1]);
+                finishChain(chain, border, chains);
+                open = false;
+            } else {
+                chain.points << q[0] << q[1];
+            }
+        }
+
+        // rings that never enter the rectangle either contain all of it or
+        // none of it
+        if (chains.size() == chainsBefore) {
+            const QPointF center = rect.center();
+            if (contains(ring, center.x(), center.y()))
+                winding += signedArea(ring) > 0.0 ? 1 : -1;
+        }
+    }
+
+    if (chains.isEmpty()) {
+        if (winding > 0)
+            result.prepend(border.ring());
+        return result;
+    }
+
+    // leaving the polygon at a chain's exit, the border is inside the
+    // polygon up to the next entry in the direction of positive orientation
+    for (int i = 0; i < chains.size(); ++i) {
+        if (chains.at(i).used)
+            continue;
+
+        Ring ring;
+        int current = i;
+        forever {
+            Chain &chain = chains[current];
+            chain.used = true;
+            ring += chain.points;
+
+            int next = -1;
+            double nearest = 0.0;
+            for (int j = 0; j < chains.size(); ++j) {
+                if (chains.at(j).used && j != i)
+                    continue;
+                const double d = border.distance(chain.exit, chains.at(j).entry);
+                if (next < 0 || d < nearest) {
+                    next = j;
+                    nearest = d;
+                }
+            }
+
+            border.appendCorners(chain.exit, chains.at(next).entry, &ring);
+            if (next == i)
+                break;
+            current = next;
+        }
+
+        removeDuplicates(ring);
+        if (ring.size() >= 6)
+            result.append(ring);
+    }
+
+    return result;
+}
+
+/*
+    Orients \a rings for clip(): rings nested inside an even number of other
+    rings become outer rings with a positive signed area, the others holes
+    with a negative one.
+*/
+void QGeoPolygonClipper::orient(QVector<Ring> &rings)
+{
+    for (int i = 0; i < rings.size(); ++i) {
+        if (rings.at(i).size() < 6)
+            continue;
+
+        int depth = 0;
+        for (int j = 0; j < rings.size(); ++j) {
+            if (j != i && contains(rings.at(j), rings.at(i).at(0), rings.at(i).at(1)))
+                ++depth;
+        }
+
+        const bool hole = depth % 2;
+        if ((signedArea(rings.at(i)) < 0.0) != hole) {
+            Ring &ring = rings[i];
+            const int count = ring.size() / 2;
+            for (int k = 0; k < count / 2; ++k) {
+                qSwap(ring[2 * k], ring[2 * (count - 1 - k)]);
+                qSwap(ring[2 * k + 1], ring[2 * (count - 1 - k) + 1]);
+            }
+        }
+    }
+}
+
+double QGeoPolygonClipper::signedArea(const Ring &ring)
+{
+    const double *points = ring.constData();
+    const int count = ring.size() / 2;
+    double area = 0.0;
+    for (int i = 0, j = count - 1; i < count; j = i++)
+        area += points[2 * j] * points[2 * i + 1] - points[2 * i] * points[2 * j + 1];
+    return 0.5 * area;
+}
+
+bool QGeoPolygonClipper::contains(const Ring &ring, double x, double y)
+{
+    const double *points = ring.constData();
+    const int count = ring.size() / 2;
+    bool inside = false;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        const double xi = points[2 * i];
+        const double yi = points[2 * i + 1];
+        const double xj = points[2 * j];
+        const double yj = points[2 * j + 1];
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi)
+            inside = !inside;
+    }
+    return inside;
+}
+
+bool QGeoPolygonClipper::isConvex(const Ring &ring)
+{
+    const double *points = ring.constData();
+    const int count = ring.size() / 2;
+    if (count < 3)
+        return false;
+
+    int sign = 0;
+    for (int i = 0; i < count; ++i) {
+        const double *a = points + 2 * i;
+        const double *b = points + 2 * ((i + 1) % count);
+        const double *c = points + 2 * ((i + 2) % count);
+        const double cross = (b[0] - a[0]) * (c[1] - b[1]) - (b[1] - a[1]) * (c[0] - b[0]);
+        if (cross == 0.0)
+            continue;
+        const int s = cross > 0.0 ? 1 : -1;
+        if (sign != 0 && s != sign)
+            return false;
+        sign = s;
+    }
+    return sign != 0;
+}
+
+/*
+    Sutherland-Hodgman against the four edges of \a rect. Only exact for
+    convex input, a concave ring would come out with its separate pieces
+    joined along the border.
+*/
+QGeoPolygonClipper::Ring QGeoPolygonClipper::clipConvex(const Ring &ring, const QRectF &rect)
+{
+    Ring input = ring;
+    Ring output;
+
+    for (int edge = 0; edge < 4 && input.size() >= 6; ++edge) {
+        // edge 0 left, 1 right, 2 top, 3 bottom
+        const int axis = edge / 2;
+        const double bound = edge == 0 ? rect.left() : edge == 1 ? rect.right()
+                           : edge == 2 ? rect.top() : rect.bottom();
+        const double side = (edge % 2) ? -1.0 : 1.0;
+
+        output.clear();
+        const double *points = input.constData();
+        const int count = input.size() / 2;
+
+        for (int i = 0; i < count; ++i) {
+            const double *p = points + 2 * ((i + count - 1) % count);
+            const double *q = points + 2 * i;
+            const double dp = side * (p[axis] - bound);
+            const double dq = side * (q[axis] - bound);
+
+            if ((dp >= 0.0) != (dq >= 0.0)) {
+                const double t = dp / (dp - dq);
+                output << p[0] + t * (q[0] - p[0]) << p[1] + t * (q[1] - p[1]);
+            }
+            if (dq >= 0.0)
+                output << q[0] << q[1];
+        }
+        input.swap(output);
+    }
+
+    if (input.size() < 6)
+        input.clear();
+    return input;
+}
+
+QT_END_NAMESPACE
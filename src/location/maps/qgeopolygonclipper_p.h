@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOPOLYGONCLIPPER_P_H
+#define QGEOPOLYGONCLIPPER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtCore/QRectF>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Clips polygons to an axis aligned rectangle, such as the viewport of a
+    map, without going through QPainterPath.
+
+    A polygon is a list of rings, each a flat array of x, y pairs that is
+    implicitly closed. Rings must not cross each other or themselves, and
+    must be oriented with orient(): outer rings have a positive signed area,
+    holes a negative one. The result follows the same rules, so every ring
+    in it is a simple polygon that can be triangulated directly; pieces that
+    the rectangle separates become separate rings instead of being joined
+    along the border.
+*/
+class Q_LOCATION_EXPORT QGeoPolygonClipper
+{
+public:
+    typedef QVector<double> Ring;
+
+    static QVector<Ring> clip(const QVector<Ring> &rings, const QRectF &rect);
+
+    static void orient(QVector<Ring> &rings);
+    static double signedArea(const Ring &ring);
+    static bool contains(const Ring &ring, double x, double y);
+    static bool isConvex(const Ring &ring);
+
+private:
+    static Ring clipConvex(const Ring &ring, const QRectF &rect);
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOPOLYGONCLIPPER_P_H
@@ -0,0 +1,263 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotileatlas_p.h"
+
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+
+QT_BEGIN_NAMESPACE
+
+// Every slot is framed by this many pixels copied from the tile's own edge
+static const int AtlasGutter = 1;
+
+QGeoTileAtlasLayout::QGeoTileAtlasLayout(int pageSize, int tileSize)
+:   tileSize_(qMax(1, tileSize)),
+    columns_(qMax(1, pageSize / (qMax(1, tileSize) + 2 * AtlasGutter)))
+{
+}
+
+/*
+    Returns the edge length of a page in pixels, which is the requested page
+    size rounded down to a whole number of slots including their gutters.
+*/
+int QGeoTileAtlasLayout::pageSize() const
+{
+    return columns_ * (tileSize_ + 2 * AtlasGutter);
+}
+
+int QGeoTileAtlasLayout::tileSize() const
+{
+    return tileSize_;
+}
+
+int QGeoTileAtlasLayout::tilesPerPage() const
+{
+    return columns_ * columns_;
+}
+
+int QGeoTileAtlasLayout::pageCount() const
+{
+    return freeSlots_.size();
+}
+
+int QGeoTileAtlasLayout::count() const
+{
+    return slots_.size();
+}
+
+bool QGeoTileAtlasLayout::contains(const QGeoTileSpec &spec) const
+{
+    return slots_.contains(spec);
+}
+
+QGeoTileAtlasLayout::Slot QGeoTileAtlasLayout::slot(const QGeoTileSpec &spec) const
+{
+    return slots_.value(spec);
+}
+
+/*
+    Assigns a slot to \a spec, or returns the one it already has.
+*/
+QGeoTileAtlasLayout::Slot QGeoTileAtlasLayout::insert(const QGeoTileSpec &spec)
+{
+    QHash<QGeoTileSpec, Slot>::const_iterator it = slots_.constFind(spec);
+    if (it != slots_.constEnd())
+        return it.value();
+
+    int page = 0;
+    while (page < freeSlots_.size() && freeSlots_.at(page).isEmpty())
+        ++page;
+
+    if (page == freeSlots_.size()) {
+        // slots are handed out from the back, lowest index first
+        QVector<int> slots(tilesPerPage());
+        for (int i = 0; i < slots.size(); ++i)
+            slots[i] = slots.size() - 1 - i;
+        freeSlots_.append(slots);
+    }
+
+    QVector<int> &pageSlots = freeSlots_[page];
+    Slot slot(page, pageSlots.last());
+    pageSlots.removeLast();
+
+    slots_.insert(spec, slot);
+    return slot;
+}
+
+void QGeoTileAtlasLayout::remove(const QGeoTileSpec &spec)
+{
+    QHash<QGeoTileSpec, Slot>::iterator it = slots_.find(spec);
+    if (it == slots_.end())
+        return;
+
+    freeSlots_[it->page].append(it->index);
+    slots_.erase(it);
+}
+
+QList<QGeoTileSpec> QGeoTileAtlasLayout::tiles() const
+{
+    return slots_.keys();
+}
+
+/*
+    Returns the pixels of the tile in \a slot, not including the gutter.
+*/
+QRect QGeoTileAtlasLayout::pixelRect(const Slot &slot) const
+{
+    const int cell = tileSize_ + 2 * AtlasGutter;
+    return QRect((slot.index % columns_) * cell + AtlasGutter,
+                 (slot.index / columns_) * cell + AtlasGutter,
+                 tileSize_, tileSize_);
+}
+
+/*
+    Returns the normalized texture coordinates of the whole tile in \a slot.
+    Linear filtering at the tile's edge reads into the gutter, which repeats
+    the edge pixels, so no texels of the tile have to be given up.
+*/
+QRectF QGeoTileAtlasLayout::textureRect(const Slot &slot) const
+{
+    const double size = pageSize();
+    const QRect rect = pixelRect(slot);
+    return QRectF(rect.x() / size, rect.y() / size, rect.width() / size, rect.height() / size);
+}
+
+/*
+    Returns \a image scaled to \a tileSize pixels square, in the format the
+    atlas is uploaded in, and surrounded by a gutter that repeats its edge
+    pixels. The result covers pixelRect() grown by the gutter on every side.
+*/
+QImage QGeoTileAtlasLayout::paddedTile(const QImage &image, int tileSize)
+{
+    QImage tile = image;
+    if (tile.size() != QSize(tileSize, tileSize))
+        tile = tile.scaled(tileSize, tileSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    tile = tile.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+
+    QImage padded(tileSize + 2 * AtlasGutter, tileSize + 2 * AtlasGutter, tile.format());
+    for (int y = 0; y < padded.height(); ++y) {
+        const int sourceY = qBound(0, y - AtlasGutter, tileSize - 1);
+        const quint32 *src = reinterpret_cast<const quint32 *>(tile.constScanLine(sourceY));
+        quint32 *dst = reinterpret_cast<quint32 *>(padded.scanLine(y));
+        for (int x = 0; x < AtlasGutter; ++x) {
+            dst[x] = src[0];
+            dst[AtlasGutter + tileSize + x] = src[tileSize - 1];
+        }
+        memcpy(dst + AtlasGutter, src, tileSize * sizeof(quint32));
+    }
+    return padded;
+}
+
+QGeoTileAtlasTexture::QGeoTileAtlasTexture(int pageSize)
+:   size_(pageSize, pageSize),
+    id_(0)
+{
+}
+
+QGeoTileAtlasTexture::~QGeoTileAtlasTexture()
+{
+    if (id_ && QOpenGLContext::currentContext())
+        QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &id_);
+}
+
+int QGeoTileAtlasTexture::textureId() const
+{
+    return id_;
+}
+
+QSize QGeoTileAtlasTexture::textureSize() const
+{
+    return size_;
+}
+
+/*
+    Returns true if any tile uploaded to the page is translucent. Pages of
+    opaque tiles, such as JPEG or RGB16 ones, are then drawn without blending.
+*/
+bool QGeoTileAtlasTexture::hasAlphaChannel() const
+{
+    return !translucentTiles_.isEmpty();
+}
+
+bool QGeoTileAtlasTexture::hasMipmaps() const
+{
+    return false;
+}
+
+/*
+    Queues \a image for upload into \a rect, which is the slot's pixelRect().
+    The gutter around it is filled as well.
+*/
+void QGeoTileAtlasTexture::setTile(const QRect &rect, const QImage &image)
+{
+    pending_.append(qMakePair(rect, image));
+
+    const QPair<int, int> key(rect.x(), rect.y());
+    if (image.hasAlphaChannel())
+        translucentTiles_.insert(key);
+    else
+        translucentTiles_.remove(key);
+}
+
+void QGeoTileAtlasTexture::bind()
+{
+    QOpenGLFunctions *funcs = QOpenGLContext::currentContext()->functions();
+
+    const bool created = !id_;
+    if (created) {
+        funcs->glGenTextures(1, &id_);
+        funcs->glBindTexture(GL_TEXTURE_2D, id_);
+        funcs->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size_.width(), size_.height(), 0,
+                            GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    } else {
+        funcs->glBindTexture(GL_TEXTURE_2D, id_);
+    }
+
+    for (int i = 0; i < pending_.size(); ++i) {
+        const QRect &rect = pending_.at(i).first;
+        const QImage image = QGeoTileAtlasLayout::paddedTile(pending_.at(i).second, rect.width());
+        const int gutter = (image.width() - rect.width()) / 2;
+
+        funcs->glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x() - gutter, rect.y() - gutter,
+                               image.width(), image.height(),
+                               GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+    }
+    pending_.clear();
+
+    updateBindOptions(created);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEATLAS_P_H
+#define QGEOTILEATLAS_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QRect>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+#include <QtQuick/QSGTexture>
+
+#include "qgeotilespec_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Bookkeeping for packing equally sized tiles into atlas pages. Every page
+    is a square grid of tile slots; freed slots are reused before a new page
+    is started, and tiles go to the lowest page with room so the scene keeps
+    to as few pages, and draw calls, as possible. Each slot has a one pixel
+    gutter repeating the tile's edge, so tiles can be sampled edge to edge
+    without picking up their neighbours.
+*/
+class Q_LOCATION_EXPORT QGeoTileAtlasLayout
+{
+public:
+    struct Slot
+    {
+        Slot() : page(-1), index(-1) {}
+        Slot(int p, int i) : page(p), index(i) {}
+
+        bool isValid() const { return page >= 0; }
+
+        int page;
+        int index;
+    };
+
+    QGeoTileAtlasLayout(int pageSize, int tileSize);
+
+    int pageSize() const;
+    int tileSize() const;
+    int tilesPerPage() const;
+    int pageCount() const;
+    int count() const;
+
+    bool contains(const QGeoTileSpec &spec) const;
+    Slot slot(const QGeoTileSpec &spec) const;
+    Slot insert(const QGeoTileSpec &spec);
+    void remove(const QGeoTileSpec &spec);
+    QList<QGeoTileSpec> tiles() const;
+
+    QRect pixelRect(const Slot &slot) const;
+    QRectF textureRect(const Slot &slot) const;
+
+    static QImage paddedTile(const QImage &image, int tileSize);
+
+private:
+    int tileSize_;
+    int columns_;
+    QHash<QGeoTileSpec, Slot> slots_;
+    QVector<QVector<int> > freeSlots_;
+};
+
+/*
+    One atlas page. Tile images are queued with setTile() and copied into
+    their sub-rectangle of the texture the next time the page is bound, on the
+    render thread. Only plain OpenGL ES 2 calls are used, so software
+    rasterizers such as llvmpipe handle it as well as any GPU.
+*/
+class QGeoTileAtlasTexture : public QSGTexture
+{
+    Q_OBJECT
+
+public:
+    explicit QGeoTileAtlasTexture(int pageSize);
+    ~QGeoTileAtlasTexture();
+
+    int textureId() const Q_DECL_OVERRIDE;
+    QSize textureSize() const Q_DECL_OVERRIDE;
+    bool hasAlphaChannel() const Q_DECL_OVERRIDE;
+    bool hasMipmaps() const Q_DECL_OVERRIDE;
+    void bind() Q_DECL_OVERRIDE;
+
+    void setTile(const QRect &rect, const QImage &image);
+
+private:
+    QSize size_;
+    uint id_;
+    QVector<QPair<QRect, QImage> > pending_;
+    QSet<QPair<int, int> > translucentTiles_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEATLAS_P_H
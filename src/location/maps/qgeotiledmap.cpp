@@ -58,6 +58,12 @@ QGeoTiledMap::QGeoTiledMap(QGeoTiledMappingManagerEngine *engine, QObject *paren
 
     QObject::connect(engine,&QGeoTiledMappingManagerEngine::tileVersionChanged,
                      this,&QGeoTiledMap::handleTileVersionChanged);
+    QObject::connect(engine, &QGeoTiledMappingManagerEngine::tileFetchBacklogCleared,
+                     this, &QGeoTiledMap::handleTileFetchBacklogCleared);
+    QObject::connect(d->m_cache, &QAbstractGeoTileCache::tileLoaded,
+                     this, &QGeoTiledMap::handleTileLoaded);
+    QObject::connect(d->m_cache, &QAbstractGeoTileCache::tileLoadFailed,
+                     this, &QGeoTiledMap::handleTileLoadFailed);
 }
 
 QGeoTiledMap::~QGeoTiledMap()
@@ -66,6 +72,11 @@ QGeoTiledMap::~QGeoTiledMap()
     delete d->m_tileRequests;
     d->m_tileRequests = 0;
 
+    if (!d->m_engine.isNull()) {
+        foreach (const QGeoTileSpec &spec, d->m_fallbackLoading)
+            d->m_cache->cancelAsync(spec);
+    }
+
     if (!d->m_engine.isNull()) {
         QGeoTiledMappingManagerEngine *engine = qobject_cast<QGeoTiledMappingManagerEngine*>(d->m_engine);
         Q_ASSERT(engine);
@@ -97,6 +108,12 @@ QSGNode *QGeoTiledMap::updateSceneGraph(QSGNode *oldNode, QQuickWindow *window)
     return d->updateSceneGraph(oldNode, window);
 }
 
+int QGeoTiledMap::tilePriority(const QGeoTileSpec &spec) const
+{
+    Q_D(const QGeoTiledMap);
+    return d->m_cameraTiles->tilePriority(spec);
+}
+
 void QGeoTiledMap::prefetchData()
 {
     Q_D(QGeoTiledMap);
@@ -109,6 +126,12 @@ void QGeoTiledMap::clearData()
     d->m_cache->clearAll();
 }
 
+void QGeoTiledMap::handleTileFetchBacklogCleared()
+{
+    Q_D(QGeoTiledMap);
+    d->m_tileRequests->tileFetchBacklogCleared();
+}
+
 void QGeoTiledMap::handleTileVersionChanged()
 {
     Q_D(QGeoTiledMap);
@@ -119,6 +142,27 @@ void QGeoTiledMap::handleTileVersionChanged()
     }
 }
 
+void QGeoTiledMap::handleTileLoaded(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTiledMap);
+    // the cache is shared between maps, only react to our own requests
+    if (d->m_tileRequests && d->m_tileRequests->isLoading(spec))
+        d->m_tileRequests->tileFetched(spec);
+    if (d->m_fallbackLoading.remove(spec)) {
+        if (d->updateFallbackTiles(true))
+            update();
+    }
+}
+
+void QGeoTiledMap::handleTileLoadFailed(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTiledMap);
+    if (d->m_tileRequests)
+        d->m_tileRequests->tileLoadFailed(spec);
+    if (d->m_fallbackLoading.remove(spec))
+        d->updateFallbackTiles(true);
+}
+
 void QGeoTiledMap::evaluateCopyrights(const QSet<QGeoTileSpec> &visibleTiles)
 {
     Q_UNUSED(visibleTiles);
@@ -154,12 +198,19 @@ QDoubleVector2D QGeoTiledMap::coordinateToItemPosition(const QGeoCoordinate &coo
     return pos;
 }
 
+QGeoMercatorTransform QGeoTiledMap::mercatorTransform() const
+{
+    Q_D(const QGeoTiledMap);
+    return d->m_mapScene->mercatorTransform();
+}
+
 QGeoTiledMapPrivate::QGeoTiledMapPrivate(QGeoTiledMappingManagerEngine *engine)
     : QGeoMapPrivate(engine),
       m_cache(engine->tileCache()),
       m_cameraTiles(new QGeoCameraTiles()),
       m_mapScene(new QGeoMapScene()),
-      m_tileRequests(0)
+      m_tileRequests(0),
+      m_hasFallbacks(false)
 {
     m_cameraTiles->setMaximumZoomLevel(static_cast<int>(std::ceil(engine->cameraCapabilities().maximumZoomLevel())));
     m_cameraTiles->setTileSize(engine->tileSize().width());
@@ -181,8 +232,8 @@ QGeoTiledMapPrivate::~QGeoTiledMapPrivate()
 void QGeoTiledMapPrivate::prefetchTiles()
 {
     if (m_tileRequests)
-        m_tileRequests->requestTiles(m_cameraTiles->prefetchTiles(QGeoCameraTiles::PrefetchTwoNeighbourLayers)
-                                     - m_mapScene->texturedTiles());
+        m_tileRequests->prefetchTiles(m_cameraTiles->prefetchTiles(QGeoCameraTiles::PrefetchTwoNeighbourLayers)
+                                      - m_mapScene->texturedTiles());
 }
 
 void QGeoTiledMapPrivate::changeCameraData(const QGeoCameraData &oldCameraData)
@@ -234,10 +285,68 @@ void QGeoTiledMapPrivate::updateScene()
         m_mapScene->addTile(tex->spec, tex);
     }
 
-    if (!cachedTiles.isEmpty())
+    const bool hasFallbacks = updateFallbackTiles();
+
+    if (!cachedTiles.isEmpty() || hasFallbacks)
         q->update();
 }
 
+/*
+    Looks up cached tiles of neighbouring zoom levels to draw in place of the
+    visible tiles that have no texture yet, so that a frame is complete without
+    waiting for the network. Stand-ins that still have to be decoded are
+    loaded in the background and picked up once they arrive. Returns true if
+    any stand-in is available.
+
+    Nothing is looked up again while the same tiles are missing, unless
+    \a force is set because a stand-in finished loading. Loads that are still
+    wanted are kept, the others are cancelled.
+*/
+bool QGeoTiledMapPrivate::updateFallbackTiles(bool force)
+{
+    const QSet<QGeoTileSpec> missing = m_cameraTiles->visibleTiles() - m_mapScene->texturedTiles();
+    if (!force && missing == m_fallbackMissing)
+        return m_hasFallbacks;
+    m_fallbackMissing = missing;
+
+    QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > fallbacks;
+    QSet<QGeoTileSpec> loading;
+    QSet<QGeoTileSpec> checked;
+
+    foreach (const QGeoTileSpec &spec, missing) {
+        foreach (const QGeoTileSpec &candidate, QGeoMapScene::fallbackCandidates(spec)) {
+            const bool ancestor = candidate.zoom() < spec.zoom();
+
+            if (!checked.contains(candidate)) {
+                checked.insert(candidate);
+                if (m_fallbackLoading.contains(candidate)) {
+                    // already on its way, asking again would count us twice
+                    loading.insert(candidate);
+                } else {
+                    bool pending = false;
+                    QSharedPointer<QGeoTileTexture> tex = m_cache->getAsync(candidate, &pending);
+                    if (tex)
+                        fallbacks.insert(candidate, tex);
+                    else if (pending)
+                        loading.insert(candidate);
+                }
+            }
+
+            // the nearest ancestor wins, children are only needed without one
+            if (ancestor && (fallbacks.contains(candidate) || loading.contains(candidate)))
+                break;
+        }
+    }
+
+    foreach (const QGeoTileSpec &spec, m_fallbackLoading - loading)
+        m_cache->cancelAsync(spec);
+    m_fallbackLoading = loading;
+
+    m_mapScene->setFallbackTiles(fallbacks);
+    m_hasFallbacks = !fallbacks.isEmpty();
+    return m_hasFallbacks;
+}
+
 void QGeoTiledMapPrivate::changeActiveMapType(const QGeoMapType mapType)
 {
     m_cameraTiles->setMapType(mapType);
@@ -285,6 +394,10 @@ void QGeoTiledMapPrivate::updateTile(const QGeoTileSpec &spec)
             m_mapScene->addTile(spec, tex);
             q->update();
         }
+    } else if (m_mapScene->texturedTiles().size() < m_cameraTiles->visibleTiles().size()) {
+        // a prefetched tile of another zoom level may stand in for a missing one
+        if (updateFallbackTiles())
+            q->update();
     }
 }
 
@@ -82,9 +82,11 @@ public:
     QAbstractGeoTileCache *tileCache();
     QGeoTileRequestManager *requestManager();
     void updateTile(const QGeoTileSpec &spec);
+    int tilePriority(const QGeoTileSpec &spec) const;
 
     QGeoCoordinate itemPositionToCoordinate(const QDoubleVector2D &pos, bool clipToViewport = true) const Q_DECL_OVERRIDE;
     QDoubleVector2D coordinateToItemPosition(const QGeoCoordinate &coordinate, bool clipToViewport = true) const Q_DECL_OVERRIDE;
+    QGeoMercatorTransform mercatorTransform() const Q_DECL_OVERRIDE;
     void prefetchData() Q_DECL_OVERRIDE;
     void clearData() Q_DECL_OVERRIDE;
 
@@ -94,6 +96,9 @@ protected:
 
 private Q_SLOTS:
     void handleTileVersionChanged();
+    void handleTileFetchBacklogCleared();
+    void handleTileLoaded(const QGeoTileSpec &spec);
+    void handleTileLoadFailed(const QGeoTileSpec &spec);
 
 private:
     Q_DISABLE_COPY(QGeoTiledMap)
@@ -50,9 +50,11 @@
 #include "qgeomap_p_p.h"
 #include "qgeocameradata_p.h"
 #include "qgeomaptype_p.h"
+#include "qgeotilespec_p.h"
 #include <QtPositioning/private/qdoublevector3d_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
 #include <QtCore/QPointer>
+#include <QtCore/QSet>
 
 QT_BEGIN_NAMESPACE
 
@@ -62,7 +64,6 @@ class QAbstractGeoTileCache;
 class QGeoTiledMappingManagerEngine;
 class QGeoTiledMap;
 class QGeoTileRequestManager;
-class QGeoTileSpec;
 class QSGNode;
 class QQuickWindow;
 
@@ -90,12 +91,16 @@ protected:
 
 private:
     void updateScene();
+    bool updateFallbackTiles(bool force = false);
 
 private:
     QAbstractGeoTileCache *m_cache;
     QGeoCameraTiles *m_cameraTiles;
     QGeoMapScene *m_mapScene;
     QGeoTileRequestManager *m_tileRequests;
+    QSet<QGeoTileSpec> m_fallbackLoading;
+    QSet<QGeoTileSpec> m_fallbackMissing;   // tiles the current fallbacks stand in for
+    bool m_hasFallbacks;
     Q_DISABLE_COPY(QGeoTiledMapPrivate)
 };
 
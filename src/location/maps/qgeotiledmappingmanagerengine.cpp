@@ -43,14 +43,22 @@
 #include "qgeotilerequestmanager_p.h"
 #include "qgeofiletilecache_p.h"
 #include "qgeotilespec_p.h"
+#include "qgeotileseedjob_p.h"
 
 #include <QTimer>
 #include <QLocale>
 #include <QDir>
 #include <QStandardPaths>
 
+#include <climits>
+
 QT_BEGIN_NAMESPACE
 
+// Outstanding tiles, as a multiple of the fetcher's concurrency limit and as
+// an absolute floor, above which prefetching waits for the fetcher.
+static const int TileFetchBacklogFactor = 4;
+static const int TileFetchBacklogHighWater = 64;
+
 QGeoTiledMappingManagerEngine::QGeoTiledMappingManagerEngine(QObject *parent)
     : QGeoMappingManagerEngine(parent),
       d_ptr(new QGeoTiledMappingManagerEnginePrivate)
@@ -62,6 +70,8 @@ QGeoTiledMappingManagerEngine::QGeoTiledMappingManagerEngine(QObject *parent)
 */
 QGeoTiledMappingManagerEngine::~QGeoTiledMappingManagerEngine()
 {
+    foreach (QGeoTileSeedJob *job, d_ptr->seedJobs_)
+        job->engineDestroyed();
     delete d_ptr;
 }
 
@@ -73,6 +83,7 @@ void QGeoTiledMappingManagerEngine::setTileFetcher(QGeoTileFetcher *fetcher)
     d->fetcher_ = fetcher;
 
     qRegisterMetaType<QGeoTileSpec>();
+    qRegisterMetaType<QGeoTilePriorityHash>("QGeoTilePriorityHash");
 
     connect(d->fetcher_,
             SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)),
@@ -101,23 +112,9 @@ QGeoMap *QGeoTiledMappingManagerEngine::createMap()
 
 void QGeoTiledMappingManagerEngine::releaseMap(QGeoTiledMap *map)
 {
-    d_ptr->mapHash_.remove(map);
-
-    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > newTileHash = d_ptr->tileHash_;
-    typedef QHash<QGeoTileSpec, QSet<QGeoTiledMap *> >::const_iterator h_iter;
-    h_iter hi = d_ptr->tileHash_.constBegin();
-    h_iter hend = d_ptr->tileHash_.constEnd();
-    for (; hi != hend; ++hi) {
-        QSet<QGeoTiledMap *> maps = hi.value();
-        if (maps.contains(map)) {
-            maps.remove(map);
-            if (maps.isEmpty())
-                newTileHash.remove(hi.key());
-            else
-                newTileHash.insert(hi.key(), maps);
-        }
-    }
-    d_ptr->tileHash_ = newTileHash;
+    d_ptr->tileTable_.releaseMap(map);
+
+    updateTileFetchBacklog();
 }
 
 void QGeoTiledMappingManagerEngine::updateTileRequests(QGeoTiledMap *map,
@@ -128,112 +125,217 @@ void QGeoTiledMappingManagerEngine::updateTileRequests(QGeoTiledMap *map,
 
     typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
 
-    // add and remove tiles from tileset for this map
+    // add and remove map from the outstanding tiles, requesting a tile
+    // for its first map and cancelling it once its last map is gone
 
-    QSet<QGeoTileSpec> oldTiles = d->mapHash_.value(map);
+    QGeoTilePriorityHash reqTiles;
+    QSet<QGeoTileSpec> cancelTiles;
 
     tile_iter rem = tilesRemoved.constBegin();
     tile_iter remEnd = tilesRemoved.constEnd();
     for (; rem != remEnd; ++rem) {
-        oldTiles.remove(*rem);
+        // tiles a seed job waits for keep going
+        if (d->tileTable_.release(*rem, map) && !d->seedTiles_.contains(*rem))
+            cancelTiles.insert(*rem);
     }
 
     tile_iter add = tilesAdded.constBegin();
     tile_iter addEnd = tilesAdded.constEnd();
     for (; add != addEnd; ++add) {
-        oldTiles.insert(*add);
+        if (d->tileTable_.addRef(*add, map)) {
+            reqTiles.insert(*add, map->tilePriority(*add));
+            cancelTiles.remove(*add);
+        }
     }
 
-    d->mapHash_.insert(map, oldTiles);
+    QMetaObject::invokeMethod(d->fetcher_, "updateTileRequests",
+                              Qt::QueuedConnection,
+                              Q_ARG(QGeoTilePriorityHash, reqTiles),
+                              Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
 
-    // add and remove map from mapset for the tiles
+    updateTileFetchBacklog();
+}
 
-    QSet<QGeoTileSpec> reqTiles;
-    QSet<QGeoTileSpec> cancelTiles;
+/*
+    Moves the still queued \a tiles of \a map to the priority they have for
+    the map's current camera, so that tiles requested for an earlier view do
+    not hold up the ones now in the middle of the screen.
+*/
+void QGeoTiledMappingManagerEngine::updateTilePriorities(QGeoTiledMap *map,
+                                                         const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
 
-    rem = tilesRemoved.constBegin();
-    for (; rem != remEnd; ++rem) {
-        QSet<QGeoTiledMap *> mapSet = d->tileHash_.value(*rem);
-        mapSet.remove(map);
-        if (mapSet.isEmpty()) {
-            cancelTiles.insert(*rem);
-            d->tileHash_.remove(*rem);
-        } else {
-            d->tileHash_.insert(*rem, mapSet);
-        }
-    }
+    if (!d->fetcher_ || tiles.isEmpty())
+        return;
 
-    add = tilesAdded.constBegin();
-    for (; add != addEnd; ++add) {
-        QSet<QGeoTiledMap *> mapSet = d->tileHash_.value(*add);
-        if (mapSet.isEmpty()) {
-            reqTiles.insert(*add);
-        }
-        mapSet.insert(map);
-        d->tileHash_.insert(*add, mapSet);
+    QGeoTilePriorityHash priorities;
+    priorities.reserve(tiles.size());
+    foreach (const QGeoTileSpec &spec, tiles)
+        priorities.insert(spec, map->tilePriority(spec));
+
+    QMetaObject::invokeMethod(d->fetcher_, "updateTilePriorities",
+                              Qt::QueuedConnection,
+                              Q_ARG(QGeoTilePriorityHash, priorities));
+}
+
+/*
+    Returns true while the tile fetcher has a backlog: more tiles outstanding
+    than it can work through in a few rounds of requests. Maps hold back
+    prefetching until tileFetchBacklogCleared() is emitted.
+*/
+bool QGeoTiledMappingManagerEngine::isTileFetchBacklogged() const
+{
+    Q_D(const QGeoTiledMappingManagerEngine);
+    return d->fetchBacklogged_;
+}
+
+void QGeoTiledMappingManagerEngine::updateTileFetchBacklog()
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    if (!d->fetcher_)
+        return;
+
+    // A single view routinely asks for several times the concurrency limit,
+    // so the backlog only starts well above it. It clears once the fetcher
+    // could take everything outstanding at once, which keeps prefetching from
+    // toggling with every finished tile.
+    const int concurrent = d->fetcher_->maximumConcurrentRequests();
+    const int outstanding = d->tileTable_.size();
+    bool backlogged = d->fetchBacklogged_;
+    if (outstanding > qMax(TileFetchBacklogHighWater, TileFetchBacklogFactor * concurrent))
+        backlogged = true;
+    else if (outstanding <= concurrent)
+        backlogged = false;
+    if (backlogged == d->fetchBacklogged_)
+        return;
+
+    d->fetchBacklogged_ = backlogged;
+    if (!backlogged)
+        emit tileFetchBacklogCleared();
+}
+
+/*
+    Creates a job that downloads the tiles of \a mapType covering \a area
+    from \a minimumZoomLevel to \a maximumZoomLevel into the disk cache. The
+    job does nothing until QGeoTileSeedJob::start() is called.
+*/
+QGeoTileSeedJob *QGeoTiledMappingManagerEngine::createSeedJob(const QGeoMapType &mapType,
+                                                              const QGeoShape &area,
+                                                              int minimumZoomLevel,
+                                                              int maximumZoomLevel,
+                                                              QObject *parent)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    QGeoTileSeedJob *job = new QGeoTileSeedJob(this, mapType, area,
+                                               minimumZoomLevel, maximumZoomLevel, parent);
+    d->seedJobs_.insert(job);
+    return job;
+}
+
+void QGeoTiledMappingManagerEngine::requestSeedTiles(QGeoTileSeedJob *job, const QList<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    // behind every tile a map is waiting for
+    static const int seedPriority = INT_MAX;
+
+    QGeoTilePriorityHash reqTiles;
+    foreach (const QGeoTileSpec &spec, tiles) {
+        if (!d->tileTable_.contains(spec) && !d->seedTiles_.contains(spec))
+            reqTiles.insert(spec, seedPriority);
+        d->seedTiles_.insert(spec, job);
     }
 
-    cancelTiles -= reqTiles;
+    if (reqTiles.isEmpty())
+        return;
 
     QMetaObject::invokeMethod(d->fetcher_, "updateTileRequests",
                               Qt::QueuedConnection,
-                              Q_ARG(QSet<QGeoTileSpec>, reqTiles),
-                              Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
+                              Q_ARG(QGeoTilePriorityHash, reqTiles),
+                              Q_ARG(QSet<QGeoTileSpec>, QSet<QGeoTileSpec>()));
+}
+
+/*
+    Drops the \a tiles \a job has in flight, cancelling the ones nobody else
+    waits for.
+*/
+void QGeoTiledMappingManagerEngine::releaseSeedTiles(QGeoTileSeedJob *job, const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    QSet<QGeoTileSpec> cancelTiles;
+    foreach (const QGeoTileSpec &spec, tiles) {
+        d->seedTiles_.remove(spec, job);
+        if (!d->seedTiles_.contains(spec) && !d->tileTable_.contains(spec))
+            cancelTiles.insert(spec);
+    }
+
+    if (!cancelTiles.isEmpty() && d->fetcher_) {
+        QMetaObject::invokeMethod(d->fetcher_, "updateTileRequests",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QGeoTilePriorityHash, QGeoTilePriorityHash()),
+                                  Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
+    }
+}
+
+void QGeoTiledMappingManagerEngine::releaseSeedJob(QGeoTileSeedJob *job, const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+    releaseSeedTiles(job, tiles);
+    d->seedJobs_.remove(job);
 }
 
 void QGeoTiledMappingManagerEngine::engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
-    QSet<QGeoTiledMap *> maps = d->tileHash_.value(spec);
+    QGeoTileRequestTable::MapList maps;
+    const bool forMaps = d->tileTable_.take(spec, &maps);
+    const QList<QGeoTileSeedJob *> jobs = d->seedTiles_.values(spec);
+    d->seedTiles_.remove(spec);
 
-    typedef QSet<QGeoTiledMap *>::const_iterator map_iter;
+    // seeded tiles go straight to disk, they are not decoded
+    QGeoTiledMappingManagerEngine::CacheAreas areas = d->cacheHint_;
+    if (!jobs.isEmpty())
+        areas = forMaps ? (areas | DiskCache) : CacheAreas(DiskCache);
 
-    map_iter map = maps.constBegin();
-    map_iter mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        QSet<QGeoTileSpec> tileSet = d->mapHash_.value(*map);
-        tileSet.remove(spec);
-        if (tileSet.isEmpty())
-            d->mapHash_.remove(*map);
-        else
-            d->mapHash_.insert(*map, tileSet);
-    }
+    tileCache()->insert(spec, bytes, format, areas);
 
-    d->tileHash_.remove(spec);
-    tileCache()->insert(spec, bytes, format, d->cacheHint_);
+    for (int i = 0; i < maps.size(); ++i)
+        maps.at(i)->requestManager()->tileFetched(spec);
 
-    map = maps.constBegin();
-    mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        (*map)->requestManager()->tileFetched(spec);
+    foreach (QGeoTileSeedJob *job, jobs) {
+        // a job may be deleted by an earlier one's signals
+        if (d->seedJobs_.contains(job))
+            job->tileFinished(spec, bytes.size());
     }
+
+    updateTileFetchBacklog();
 }
 
 void QGeoTiledMappingManagerEngine::engineTileError(const QGeoTileSpec &spec, const QString &errorString)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
-    QSet<QGeoTiledMap *> maps = d->tileHash_.value(spec);
-    typedef QSet<QGeoTiledMap *>::const_iterator map_iter;
-    map_iter map = maps.constBegin();
-    map_iter mapEnd = maps.constEnd();
-    for (; map != mapEnd; ++map) {
-        QSet<QGeoTileSpec> tileSet = d->mapHash_.value(*map);
-
-        tileSet.remove(spec);
-        if (tileSet.isEmpty())
-            d->mapHash_.remove(*map);
-        else
-            d->mapHash_.insert(*map, tileSet);
-    }
-    d->tileHash_.remove(spec);
+    QGeoTileRequestTable::MapList maps;
+    d->tileTable_.take(spec, &maps);
+    const QList<QGeoTileSeedJob *> jobs = d->seedTiles_.values(spec);
+    d->seedTiles_.remove(spec);
+
+    for (int i = 0; i < maps.size(); ++i)
+        maps.at(i)->requestManager()->tileError(spec, errorString);
 
-    for (map = maps.constBegin(); map != mapEnd; ++map) {
-        (*map)->requestManager()->tileError(spec, errorString);
+    foreach (QGeoTileSeedJob *job, jobs) {
+        if (d->seedJobs_.contains(job))
+            job->tileFailed(spec);
     }
 
     emit tileError(spec, errorString);
+
+    updateTileFetchBacklog();
 }
 
 void QGeoTiledMappingManagerEngine::setTileSize(const QSize &tileSize)
@@ -299,6 +401,16 @@ QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTileTexture(co
     return d_ptr->tileCache_->get(spec);
 }
 
+QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTileTextureAsync(const QGeoTileSpec &spec, bool *pending)
+{
+    return d_ptr->tileCache_->getAsync(spec, pending);
+}
+
+void QGeoTiledMappingManagerEngine::cancelTileTextureAsync(const QGeoTileSpec &spec)
+{
+    d_ptr->tileCache_->cancelAsync(spec);
+}
+
 /*******************************************************************************
 *******************************************************************************/
 
@@ -306,7 +418,8 @@ QGeoTiledMappingManagerEnginePrivate::QGeoTiledMappingManagerEnginePrivate()
 :   m_tileVersion(-1),
     cacheHint_(QGeoTiledMappingManagerEngine::AllCaches),
     tileCache_(0),
-    fetcher_(0)
+    fetcher_(0),
+    fetchBacklogged_(false)
 {
 }
 
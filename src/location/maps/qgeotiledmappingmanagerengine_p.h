@@ -65,6 +65,8 @@ class QGeoTileTexture;
 class QGeoTileSpec;
 class QGeoTiledMap;
 class QAbstractGeoTileCache;
+class QGeoTileSeedJob;
+class QGeoShape;
 
 class Q_LOCATION_EXPORT QGeoTiledMappingManagerEngine : public QGeoMappingManagerEngine
 {
@@ -92,9 +94,17 @@ public:
     void updateTileRequests(QGeoTiledMap *map,
                             const QSet<QGeoTileSpec> &tilesAdded,
                             const QSet<QGeoTileSpec> &tilesRemoved);
+    void updateTilePriorities(QGeoTiledMap *map, const QSet<QGeoTileSpec> &tiles);
+    bool isTileFetchBacklogged() const;
+
+    QGeoTileSeedJob *createSeedJob(const QGeoMapType &mapType, const QGeoShape &area,
+                                   int minimumZoomLevel, int maximumZoomLevel,
+                                   QObject *parent = 0);
 
     QAbstractGeoTileCache *tileCache();
     QSharedPointer<QGeoTileTexture> getTileTexture(const QGeoTileSpec &spec);
+    QSharedPointer<QGeoTileTexture> getTileTextureAsync(const QGeoTileSpec &spec, bool *pending);
+    void cancelTileTextureAsync(const QGeoTileSpec &spec);
 
 
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint() const;
@@ -106,6 +116,7 @@ private Q_SLOTS:
 Q_SIGNALS:
     void tileError(const QGeoTileSpec &spec, const QString &errorString);
     void tileVersionChanged();
+    void tileFetchBacklogCleared();
 
 protected:
     void setTileFetcher(QGeoTileFetcher *fetcher);
@@ -117,10 +128,16 @@ protected:
 private:
     QGeoTiledMappingManagerEnginePrivate *d_ptr;
 
+    void updateTileFetchBacklog();
+    void requestSeedTiles(QGeoTileSeedJob *job, const QList<QGeoTileSpec> &tiles);
+    void releaseSeedTiles(QGeoTileSeedJob *job, const QSet<QGeoTileSpec> &tiles);
+    void releaseSeedJob(QGeoTileSeedJob *job, const QSet<QGeoTileSpec> &tiles);
+
     Q_DECLARE_PRIVATE(QGeoTiledMappingManagerEngine)
     Q_DISABLE_COPY(QGeoTiledMappingManagerEngine)
 
     friend class QGeoTileFetcher;
+    friend class QGeoTileSeedJob;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QGeoTiledMappingManagerEngine::CacheAreas)
@@ -53,6 +53,7 @@
 #include <QHash>
 #include <QSet>
 #include "qgeotiledmappingmanagerengine_p.h"
+#include "qgeotilerequesttable_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -60,6 +61,7 @@ class QGeoTiledMap;
 class QAbstractGeoTileCache;
 class QGeoTileSpec;
 class QGeoTileFetcher;
+class QGeoTileSeedJob;
 
 class QGeoTiledMappingManagerEnginePrivate
 {
@@ -69,11 +71,13 @@ public:
 
     QSize tileSize_;
     int m_tileVersion;
-    QHash<QGeoTiledMap *, QSet<QGeoTileSpec> > mapHash_;
-    QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > tileHash_;
+    QGeoTileRequestTable tileTable_;
+    QMultiHash<QGeoTileSpec, QGeoTileSeedJob *> seedTiles_;
+    QSet<QGeoTileSeedJob *> seedJobs_;
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint_;
     QAbstractGeoTileCache *tileCache_;
     QGeoTileFetcher *fetcher_;
+    bool fetchBacklogged_;
 
 private:
     Q_DISABLE_COPY(QGeoTiledMappingManagerEnginePrivate)
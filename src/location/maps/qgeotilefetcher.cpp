@@ -52,7 +52,7 @@ QGeoTileFetcher::QGeoTileFetcher(QObject *parent)
 
     d->enabled_ = true;
 
-    if (!d->queue_.isEmpty())
+    if (!d->queued_.isEmpty())
         d->timer_.start(0, this);
 }
 
@@ -64,6 +64,21 @@ QGeoTileFetcher::~QGeoTileFetcher()
 
 void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
                                                   const QSet<QGeoTileSpec> &tilesRemoved)
+{
+    QGeoTilePriorityHash prioritized;
+    foreach (const QGeoTileSpec &spec, tilesAdded)
+        prioritized.insert(spec, 0);
+
+    updateTileRequests(prioritized, tilesRemoved);
+}
+
+/*
+    Queues the tiles in \a tilesAdded, keyed by their priority (lower values
+    are requested first), and cancels the tiles in \a tilesRemoved. Tiles that
+    are already queued are moved to their new priority.
+*/
+void QGeoTileFetcher::updateTileRequests(const QGeoTilePriorityHash &tilesAdded,
+                                         const QSet<QGeoTileSpec> &tilesRemoved)
 {
     Q_D(QGeoTileFetcher);
 
@@ -71,12 +86,54 @@ void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
 
     cancelTileRequests(tilesRemoved);
 
-    d->queue_ += tilesAdded.toList();
+    typedef QGeoTilePriorityHash::const_iterator tile_iter;
+    tile_iter tile = tilesAdded.constBegin();
+    tile_iter end = tilesAdded.constEnd();
+    for (; tile != end; ++tile) {
+        if (d->invmap_.contains(tile.key())) {
+            // still downloading after an earlier cancel, take it back
+            d->cancelled_.remove(tile.key());
+            continue;
+        }
+        d->enqueue(tile.key(), tileHost(tile.key()), tile.value());
+    }
 
-    if (d->enabled_ && !d->queue_.isEmpty() && !d->timer_.isActive())
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
         d->timer_.start(0, this);
 }
 
+/*
+    Moves the queued tiles in \a tiles to their new priority. Tiles that are
+    not queued, because they are on the wire or no longer wanted, are ignored,
+    and tiles whose priority did not change keep their place in line.
+*/
+void QGeoTileFetcher::updateTilePriorities(const QGeoTilePriorityHash &tiles)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+
+    typedef QGeoTilePriorityHash::const_iterator tile_iter;
+    tile_iter tile = tiles.constBegin();
+    tile_iter end = tiles.constEnd();
+    for (; tile != end; ++tile) {
+        QHash<QGeoTileSpec, QGeoTileFetcherPrivate::QueueEntry>::const_iterator queued =
+                d->queued_.constFind(tile.key());
+        if (queued == d->queued_.constEnd())
+            continue;
+        if (int(queued->key >> 32) == qMax(0, tile.value()))
+            continue;
+        const QString host = queued->host;
+        d->enqueue(tile.key(), host, tile.value());
+    }
+}
+
+/*
+    Drops the tiles in \a tiles from the queue. Requests that are already on
+    the wire are not aborted, as that would tear down a keep-alive connection
+    the next tile could have reused; they are left to finish, still occupying
+    their slot, and their data only goes to the cache.
+*/
 void QGeoTileFetcher::cancelTileRequests(const QSet<QGeoTileSpec> &tiles)
 {
     Q_D(QGeoTileFetcher);
@@ -85,47 +142,51 @@ void QGeoTileFetcher::cancelTileRequests(const QSet<QGeoTileSpec> &tiles)
     tile_iter tile = tiles.constBegin();
     tile_iter end = tiles.constEnd();
     for (; tile != end; ++tile) {
-        QGeoTiledMapReply *reply = d->invmap_.value(*tile, 0);
-        if (reply) {
-            d->invmap_.remove(*tile);
-            reply->abort();
-            if (reply->isFinished())
-                reply->deleteLater();
-        }
-        d->queue_.removeAll(*tile);
+        if (d->dequeue(*tile))
+            ++d->cancelledCount_;
+        else if (d->invmap_.contains(*tile))
+            d->cancelled_.insert(*tile);
     }
 }
 
+/*
+    Hands queued tiles to the backend in priority order until the queue is
+    drained, the concurrency limit is reached or every host with queued tiles
+    is at its own limit. The pass is rescheduled whenever a request finishes
+    or new tiles arrive.
+*/
 void QGeoTileFetcher::requestNextTile()
 {
     Q_D(QGeoTileFetcher);
 
     QMutexLocker ml(&d->queueMutex_);
 
-    if (!d->enabled_)
-        return;
+    d->timer_.stop();
 
-    if (d->queue_.isEmpty())
+    if (!d->enabled_)
         return;
 
-    QGeoTileSpec ts = d->queue_.takeFirst();
-
-    QGeoTiledMapReply *reply = getTileImage(ts);
-
-    if (reply->isFinished()) {
-        handleReply(reply, ts);
-    } else {
-        connect(reply,
-                SIGNAL(finished()),
-                this,
-                SLOT(finished()),
-                Qt::QueuedConnection);
-
-        d->invmap_.insert(ts, reply);
+    QGeoTileSpec ts;
+    QString host;
+    while (d->invmap_.size() < d->maxConcurrentRequests_.load() && d->takeNext(&ts, &host)) {
+        QGeoTiledMapReply *reply = getTileImage(ts);
+
+        if (reply->isFinished()) {
+            d->releaseHost(host);
+            ++d->completedCount_;
+            handleReply(reply, ts);
+        } else {
+            connect(reply,
+                    SIGNAL(finished()),
+                    this,
+                    SLOT(finished()),
+                    Qt::QueuedConnection);
+
+            d->invmap_.insert(ts, reply);
+            d->updateCounts();
+            d->replyHosts_.insert(reply, host);
+        }
     }
-
-    if (d->queue_.isEmpty())
-        d->timer_.stop();
 }
 
 void QGeoTileFetcher::finished()
@@ -140,12 +201,28 @@ void QGeoTileFetcher::finished()
 
     QGeoTileSpec spec = reply->tileSpec();
 
-    if (!d->invmap_.contains(spec)) {
+    if (d->invmap_.value(spec, 0) != reply) {
         reply->deleteLater();
         return;
     }
 
     d->invmap_.remove(spec);
+    d->updateCounts();
+    d->releaseHost(d->replyHosts_.take(reply));
+
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+
+    if (d->cancelled_.remove(spec)) {
+        ++d->cancelledCount_;
+        // nobody waits for it any more, but the bytes are worth caching
+        if (reply->error() != QGeoTiledMapReply::NoError) {
+            reply->deleteLater();
+            return;
+        }
+    } else {
+        ++d->completedCount_;
+    }
 
     handleReply(reply, spec);
 }
@@ -158,14 +235,108 @@ void QGeoTileFetcher::timerEvent(QTimerEvent *event)
         return;
     }
 
-    if (d->queue_.isEmpty()) {
-        d->timer_.stop();
-        return;
-    }
-
     requestNextTile();
 }
 
+/*
+    Sets the number of tile requests that may be in flight at once to
+    \a count. Tiles beyond the limit stay in the priority queue, where they
+    can still be reordered or cancelled cheaply, rather than piling up in the
+    network layer. Plugins should set this to what their tile servers allow.
+*/
+void QGeoTileFetcher::setMaximumConcurrentRequests(int count)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+
+    d->maxConcurrentRequests_.store(qMax(1, count));
+
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+}
+
+int QGeoTileFetcher::maximumConcurrentRequests() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->maxConcurrentRequests_.load();
+}
+
+/*
+    Sets the number of tile requests that may be in flight to any single host,
+    as reported by tileHost(), to \a count. Keeping this at or below the
+    network layer's connection limit means every request goes straight onto an
+    open keep-alive connection.
+*/
+void QGeoTileFetcher::setMaximumRequestsPerHost(int count)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+
+    d->maxRequestsPerHost_.store(qMax(1, count));
+
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+}
+
+int QGeoTileFetcher::maximumRequestsPerHost() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->maxRequestsPerHost_.load();
+}
+
+/*
+    Returns the host that \a spec will be fetched from. Tiles on the same host
+    share the per host request limit. The default implementation puts every
+    tile on one host.
+*/
+QString QGeoTileFetcher::tileHost(const QGeoTileSpec &spec) const
+{
+    Q_UNUSED(spec);
+    return QString();
+}
+
+/*
+    Returns the number of tiles waiting to be requested. This and the other
+    counters never block, so they may be read from any thread, including from
+    slots connected to tileFinished().
+*/
+int QGeoTileFetcher::queuedRequests() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->queuedCount_.load();
+}
+
+/*
+    Returns the number of tile requests currently on the wire, including
+    cancelled ones that are being left to finish.
+*/
+int QGeoTileFetcher::inFlightRequests() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->inFlightCount_.load();
+}
+
+/*
+    Returns the number of tile requests cancelled since the fetcher was created.
+*/
+qint64 QGeoTileFetcher::cancelledRequests() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->cancelledCount_.load();
+}
+
+/*
+    Returns the number of tile requests that finished, successfully or not,
+    while still wanted.
+*/
+qint64 QGeoTileFetcher::completedRequests() const
+{
+    Q_D(const QGeoTileFetcher);
+    return d->completedCount_.load();
+}
+
 void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &spec)
 {
     Q_D(QGeoTileFetcher);
@@ -188,7 +359,14 @@ void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &
 *******************************************************************************/
 
 QGeoTileFetcherPrivate::QGeoTileFetcherPrivate()
-:   enabled_(false)
+:   enabled_(false),
+    sequence_(0),
+    maxConcurrentRequests_(6),
+    maxRequestsPerHost_(6),
+    queuedCount_(0),
+    inFlightCount_(0),
+    cancelledCount_(0),
+    completedCount_(0)
 {
 }
 
@@ -196,4 +374,84 @@ QGeoTileFetcherPrivate::~QGeoTileFetcherPrivate()
 {
 }
 
+/*
+    Publishes the queue and in-flight sizes for the lock-free getters.
+    Called with queueMutex_ held whenever either changes.
+*/
+void QGeoTileFetcherPrivate::updateCounts()
+{
+    queuedCount_.store(queued_.size());
+    inFlightCount_.store(invmap_.size());
+}
+
+void QGeoTileFetcherPrivate::enqueue(const QGeoTileSpec &spec, const QString &host, int priority)
+{
+    dequeue(spec);
+
+    if (queued_.isEmpty())
+        sequence_ = 0;
+
+    QueueEntry entry;
+    entry.host = host;
+    entry.key = (quint64(quint32(qMax(0, priority))) << 32) | sequence_++;
+
+    hosts_[host].queue.insert(entry.key, spec);
+    queued_.insert(spec, entry);
+    updateCounts();
+}
+
+bool QGeoTileFetcherPrivate::dequeue(const QGeoTileSpec &spec)
+{
+    QHash<QGeoTileSpec, QueueEntry>::iterator it = queued_.find(spec);
+    if (it == queued_.end())
+        return false;
+
+    QHash<QString, HostQueue>::iterator host = hosts_.find(it->host);
+    host->queue.remove(it->key);
+    if (host->queue.isEmpty() && host->inFlight == 0)
+        hosts_.erase(host);
+
+    queued_.erase(it);
+    updateCounts();
+    return true;
+}
+
+/*
+    Picks the most urgent queued tile whose host still has a free request slot
+    and reserves that slot. There are only ever a handful of hosts, so looking
+    at the head of each host's queue is cheap.
+*/
+bool QGeoTileFetcherPrivate::takeNext(QGeoTileSpec *spec, QString *host)
+{
+    QHash<QString, HostQueue>::iterator best = hosts_.end();
+    QHash<QString, HostQueue>::iterator it = hosts_.begin();
+    for (; it != hosts_.end(); ++it) {
+        if (it->queue.isEmpty() || it->inFlight >= maxRequestsPerHost_.load())
+            continue;
+        if (best == hosts_.end() || it->queue.firstKey() < best->queue.firstKey())
+            best = it;
+    }
+
+    if (best == hosts_.end())
+        return false;
+
+    *spec = best->queue.take(best->queue.firstKey());
+    *host = best.key();
+    ++best->inFlight;
+    queued_.remove(*spec);
+    updateCounts();
+    return true;
+}
+
+void QGeoTileFetcherPrivate::releaseHost(const QString &host)
+{
+    QHash<QString, HostQueue>::iterator it = hosts_.find(host);
+    if (it == hosts_.end())
+        return;
+
+    --it->inFlight;
+    if (it->queue.isEmpty() && it->inFlight <= 0)
+        hosts_.erase(it);
+}
+
 QT_END_NAMESPACE
@@ -49,6 +49,7 @@
 //
 
 #include <QObject>
+#include <QHash>
 #include <qlocationglobal.h>
 #include "qgeomaptype_p.h"
 #include "qgeotiledmappingmanagerengine_p.h"
@@ -62,6 +63,8 @@ class QGeoTiledMappingManagerEngine;
 class QGeoTiledMapReply;
 class QGeoTileSpec;
 
+typedef QHash<QGeoTileSpec, int> QGeoTilePriorityHash;
+
 class Q_LOCATION_EXPORT QGeoTileFetcher : public QObject
 {
     Q_OBJECT
@@ -70,8 +73,18 @@ public:
     QGeoTileFetcher(QObject *parent = 0);
     virtual ~QGeoTileFetcher();
 
+    int maximumConcurrentRequests() const;
+    int maximumRequestsPerHost() const;
+
+    int queuedRequests() const;
+    int inFlightRequests() const;
+    qint64 cancelledRequests() const;
+    qint64 completedRequests() const;
+
 public Q_SLOTS:
     void updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
+    void updateTileRequests(const QGeoTilePriorityHash &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
+    void updateTilePriorities(const QGeoTilePriorityHash &tiles);
 
 private Q_SLOTS:
     void cancelTileRequests(const QSet<QGeoTileSpec> &tiles);
@@ -84,6 +97,9 @@ Q_SIGNALS:
 
 protected:
     void timerEvent(QTimerEvent *event);
+    void setMaximumConcurrentRequests(int count);
+    void setMaximumRequestsPerHost(int count);
+    virtual QString tileHost(const QGeoTileSpec &spec) const;
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint() const;
 
 private:
@@ -56,7 +56,11 @@
 #include <QMutex>
 #include <QMutexLocker>
 #include <QHash>
+#include <QSet>
+#include <QBasicTimer>
+#include <QAtomicInt>
 #include "qgeomaptype_p.h"
+#include "qgeotilespec_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -70,11 +74,44 @@ public:
     QGeoTileFetcherPrivate();
     virtual ~QGeoTileFetcherPrivate();
 
+    struct HostQueue
+    {
+        HostQueue() : inFlight(0) {}
+
+        // keyed by (priority << 32 | arrival), so equal priorities stay FIFO
+        QMap<quint64, QGeoTileSpec> queue;
+        int inFlight;
+    };
+
+    struct QueueEntry
+    {
+        QString host;
+        quint64 key;
+    };
+
     bool enabled_;
     QBasicTimer timer_;
-    QMutex queueMutex_;
-    QList<QGeoTileSpec> queue_;
+    mutable QMutex queueMutex_;
+    QHash<QString, HostQueue> hosts_;
+    QHash<QGeoTileSpec, QueueEntry> queued_;
+    quint32 sequence_;
+    // The limits and counters are atomic so that the getters need not take
+    // queueMutex_, which is held while tileFinished() is emitted.
+    QAtomicInt maxConcurrentRequests_;
+    QAtomicInt maxRequestsPerHost_;
     QHash<QGeoTileSpec, QGeoTiledMapReply *> invmap_;
+    QHash<QGeoTiledMapReply *, QString> replyHosts_;
+    QSet<QGeoTileSpec> cancelled_;
+    QAtomicInt queuedCount_;
+    QAtomicInt inFlightCount_;
+    QAtomicInteger<qint64> cancelledCount_;
+    QAtomicInteger<qint64> completedCount_;
+
+    void updateCounts();
+    void enqueue(const QGeoTileSpec &spec, const QString &host, int priority);
+    bool dequeue(const QGeoTileSpec &spec);
+    bool takeNext(QGeoTileSpec *spec, QString *host);
+    void releaseHost(const QString &host);
 
 private:
     Q_DISABLE_COPY(QGeoTileFetcherPrivate)
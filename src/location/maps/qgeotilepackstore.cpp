@@ -0,0 +1,782 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilepackstore_p.h"
+
+#include <QDir>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QSet>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// All on-disk structures are written in host byte order. A cache written on
+// a host with a different byte order fails the magic check and is rebuilt.
+const quint32 PackMagic = 0x50544751;    // "QGTP"
+const quint32 RecordMagic = 0x52544751;  // "QGTR"
+const quint32 IndexMagic = 0x49544751;   // "QGTI"
+const quint32 FormatVersion = 1;
+
+struct PackFileHeader
+{
+    quint32 magic;
+    quint32 version;
+};
+
+struct PackRecordHeader
+{
+    quint32 magic;
+    quint32 dataSize;
+    qint32 mapId;
+    qint32 zoom;
+    qint32 x;
+    qint32 y;
+    qint32 version;
+    quint16 pluginSize;
+    quint16 formatSize;
+};
+
+struct IndexFileHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint64 packSize;
+    quint32 recordCount;
+    quint32 stringCount;
+};
+
+struct IndexRecord
+{
+    quint64 offset;
+    quint32 recordSize;
+    quint32 dataSize;
+    qint32 mapId;
+    qint32 zoom;
+    qint32 x;
+    qint32 y;
+    qint32 version;
+    quint16 plugin;
+    quint16 format;
+    quint32 queue;
+    quint32 reserved;
+};
+
+bool entryOffsetLessThan(const QGeoTilePackStore::Entry &a, const QGeoTilePackStore::Entry &b)
+{
+    return a.offset < b.offset;
+}
+
+}
+
+class QGeoTilePackCompactionState
+{
+public:
+    enum Result { Running, Succeeded, Failed };
+
+    QGeoTilePackCompactionState()
+        : snapshotEnd(0), aborted(0), result(Running) {}
+
+    QString source;
+    QScopedPointer<QSaveFile> target; // replaces the pack when committed
+    quint64 snapshotEnd;
+    QVector<quint64> offsets;
+    QVector<quint32> sizes;
+    QVector<quint64> newOffsets;
+    QAtomicInt aborted;
+    /* stored with release once the worker is done with the fields above */
+    QAtomicInt result;
+};
+
+Q_DECLARE_METATYPE(QGeoTilePackCompactionState *)
+
+class QGeoTilePackCompactionJob : public QRunnable
+{
+public:
+    QGeoTilePackCompactionJob(const QSharedPointer<QGeoTilePackCompactionState> &state,
+                              QGeoTilePackStore *store)
+        : state_(state), store_(store) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QGeoTilePackCompactionState *s = state_.data();
+        QFile in(s->source);
+        QSaveFile &out = *s->target;
+        bool ok = in.open(QIODevice::ReadOnly) && out.open(QIODevice::WriteOnly);
+
+        if (ok) {
+            const PackFileHeader header = { PackMagic, FormatVersion };
+            ok = out.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+        }
+
+        s->newOffsets.reserve(s->offsets.size());
+        QByteArray buffer;
+        for (int i = 0; ok && i < s->offsets.size(); ++i) {
+            if (s->aborted.load()) {
+                ok = false;
+                break;
+            }
+            const int size = s->sizes.at(i);
+            buffer.resize(size);
+            ok = in.seek(s->offsets.at(i)) && in.read(buffer.data(), size) == size;
+            if (!ok)
+                break;
+            s->newOffsets.append(out.pos());
+            ok = out.write(buffer) == size;
+        }
+
+        /* the target stays open, finishCompaction() appends to it and commits */
+        in.close();
+        s->result.storeRelease(ok ? QGeoTilePackCompactionState::Succeeded
+                                  : QGeoTilePackCompactionState::Failed);
+
+        QMetaObject::invokeMethod(store_, "finishCompaction", Qt::QueuedConnection,
+                                  Q_ARG(QGeoTilePackCompactionState *, s));
+    }
+
+private:
+    QSharedPointer<QGeoTilePackCompactionState> state_;
+    QGeoTilePackStore *store_;
+};
+
+QGeoTilePackStore::QGeoTilePackStore(const QString &directory, QObject *parent)
+    : QObject(parent), directory_(directory), mutex_(QMutex::Recursive), deadBytes_(0),
+      compactionRatio_(0.5), compactionMinimum_(1024 * 1024)
+{
+    qRegisterMetaType<QGeoTilePackCompactionState *>();
+    compactionPool_.setMaxThreadCount(1);
+}
+
+QGeoTilePackStore::~QGeoTilePackStore()
+{
+    if (compaction_)
+        compaction_->aborted.store(1);
+    compactionPool_.waitForDone();
+    /* an uncommitted target discards its temporary file */
+    compaction_.clear();
+    close();
+}
+
+QString QGeoTilePackStore::packFileName() const
+{
+    return QDir(directory_).filePath(QStringLiteral("tiles.pack"));
+}
+
+QString QGeoTilePackStore::indexFileName() const
+{
+    return QDir(directory_).filePath(QStringLiteral("tiles.idx"));
+}
+
+bool QGeoTilePackStore::open()
+{
+    QMutexLocker locker(&mutex_);
+    if (pack_.isOpen())
+        return true;
+
+    QDir::root().mkpath(directory_);
+
+    pack_.setFileName(packFileName());
+    if (!pack_.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning() << "Unable to open tile pack file" << pack_.fileName();
+        return false;
+    }
+
+    PackFileHeader header;
+    if (pack_.size() < qint64(sizeof(header))
+            || pack_.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+            || header.magic != PackMagic || header.version != FormatVersion) {
+        // new or unreadable pack, start from scratch
+        const PackFileHeader newHeader = { PackMagic, FormatVersion };
+        pack_.resize(0);
+        pack_.seek(0);
+        pack_.write(reinterpret_cast<const char *>(&newHeader), sizeof(newHeader));
+        QFile::remove(indexFileName());
+        return true;
+    }
+
+    if (!loadIndex()) {
+        entries_.clear();
+        loadOrder_.clear();
+        deadBytes_ = 0;
+        scanPack(sizeof(PackFileHeader));
+    }
+
+    return true;
+}
+
+void QGeoTilePackStore::close()
+{
+    QMutexLocker locker(&mutex_);
+    entries_.clear();
+    loadOrder_.clear();
+    deadBytes_ = 0;
+    pack_.close();
+}
+
+bool QGeoTilePackStore::isOpen() const
+{
+    return pack_.isOpen();
+}
+
+bool QGeoTilePackStore::loadIndex()
+{
+    QFile index(indexFileName());
+    if (!index.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = index.size();
+    if (fileSize < qint64(sizeof(IndexFileHeader)))
+        return false;
+
+    const uchar *data = index.map(0, fileSize);
+    if (!data)
+        return false;
+
+    const uchar *end = data + fileSize;
+    const uchar *p = data;
+
+    IndexFileHeader header;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+
+    const qint64 packSize = pack_.size();
+    bool ok = header.magic == IndexMagic && header.version == FormatVersion
+            && qint64(header.packSize) <= packSize;
+
+    QVector<QString> strings;
+    strings.reserve(ok ? header.stringCount : 0);
+    for (quint32 i = 0; ok && i < header.stringCount; ++i) {
+        quint16 length;
+        if (end - p < qint64(sizeof(length))) {
+            ok = false;
+            break;
+        }
+        memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        if (end - p < length) {
+            ok = false;
+            break;
+        }
+        strings.append(QString::fromLatin1(reinterpret_cast<const char *>(p), length));
+        p += length;
+    }
+
+    ok = ok && (end - p) == qint64(header.recordCount) * qint64(sizeof(IndexRecord));
+
+    qint64 liveBytes = 0;
+    if (ok) {
+        entries_.reserve(header.recordCount);
+        loadOrder_.reserve(header.recordCount);
+        for (quint32 i = 0; i < header.recordCount; ++i, p += sizeof(IndexRecord)) {
+            IndexRecord record;
+            memcpy(&record, p, sizeof(record));
+            if (record.plugin >= strings.size() || record.format >= strings.size()
+                    || record.offset + record.recordSize > header.packSize
+                    || record.dataSize > record.recordSize) {
+                ok = false;
+                break;
+            }
+
+            Entry entry;
+            entry.spec = QGeoTileSpec(strings.at(record.plugin), record.mapId, record.zoom,
+                                      record.x, record.y, record.version);
+            entry.format = strings.at(record.format);
+            entry.offset = record.offset;
+            entry.recordSize = record.recordSize;
+            entry.dataSize = record.dataSize;
+            entry.queue = record.queue;
+            entries_.insert(entry.spec, entry);
+            loadOrder_.append(entry.spec);
+            liveBytes += record.recordSize;
+        }
+    }
+
+    index.unmap(const_cast<uchar *>(data));
+    index.close();
+
+    if (!ok)
+        return false;
+
+    // everything before the indexed pack size that is not referenced is dead
+    deadBytes_ = qint64(header.packSize) - qint64(sizeof(PackFileHeader)) - liveBytes;
+
+    // pick up tiles that were appended after the index was last written
+    if (qint64(header.packSize) < packSize)
+        scanPack(header.packSize);
+
+    return true;
+}
+
+void QGeoTilePackStore::scanPack(quint64 from)
+{
+    const qint64 packSize = pack_.size();
+    qint64 offset = from;
+    QByteArray names;
+
+    while (offset + qint64(sizeof(PackRecordHeader)) <= packSize) {
+        PackRecordHeader header;
+        if (!pack_.seek(offset)
+                || pack_.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+                || header.magic != RecordMagic) {
+            break;
+        }
+
+        const qint64 recordSize = qint64(sizeof(header)) + header.pluginSize
+                + header.formatSize + header.dataSize;
+        if (offset + recordSize > packSize)
+            break;
+
+        names.resize(header.pluginSize + header.formatSize);
+        if (pack_.read(names.data(), names.size()) != names.size())
+            break;
+
+        Entry entry;
+        entry.spec = QGeoTileSpec(QString::fromLatin1(names.constData(), header.pluginSize),
+                                  header.mapId, header.zoom, header.x, header.y, header.version);
+        entry.format = QString::fromLatin1(names.constData() + header.pluginSize, header.formatSize);
+        entry.offset = offset;
+        entry.recordSize = recordSize;
+        entry.dataSize = header.dataSize;
+
+        QHash<QGeoTileSpec, Entry>::const_iterator existing = entries_.constFind(entry.spec);
+        if (existing != entries_.constEnd())
+            markDead(existing.value());
+        entries_.insert(entry.spec, entry);
+        loadOrder_.append(entry.spec);
+
+        offset += recordSize;
+    }
+
+    // drop a partially written record left behind by a crash
+    if (offset < packSize)
+        pack_.resize(offset);
+}
+
+QList<QGeoTilePackStore::Entry> QGeoTilePackStore::entries() const
+{
+    QMutexLocker locker(&mutex_);
+    QList<Entry> result;
+    result.reserve(entries_.size());
+
+    QSet<QGeoTileSpec> seen;
+    seen.reserve(entries_.size());
+
+    // later duplicates in the load order supersede earlier ones
+    for (int i = loadOrder_.size() - 1; i >= 0; --i) {
+        const QGeoTileSpec &spec = loadOrder_.at(i);
+        if (seen.contains(spec))
+            continue;
+        QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constFind(spec);
+        if (it == entries_.constEnd())
+            continue;
+        seen.insert(spec);
+        result.prepend(it.value());
+    }
+
+    QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constBegin();
+    for (; it != entries_.constEnd(); ++it) {
+        if (!seen.contains(it.key()))
+            result.append(it.value());
+    }
+
+    return result;
+}
+
+bool QGeoTilePackStore::contains(const QGeoTileSpec &spec) const
+{
+    QMutexLocker locker(&mutex_);
+    return entries_.contains(spec);
+}
+
+int QGeoTilePackStore::size(const QGeoTileSpec &spec) const
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constFind(spec);
+    if (it == entries_.constEnd())
+        return 0;
+    return it.value().dataSize;
+}
+
+bool QGeoTilePackStore::write(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
+{
+    QMutexLocker locker(&mutex_);
+    if (!pack_.isOpen())
+        return false;
+
+    const QByteArray plugin = spec.plugin().toLatin1();
+    const QByteArray formatName = format.toLatin1();
+
+    PackRecordHeader header;
+    header.magic = RecordMagic;
+    header.dataSize = bytes.size();
+    header.mapId = spec.mapId();
+    header.zoom = spec.zoom();
+    header.x = spec.x();
+    header.y = spec.y();
+    header.version = spec.version();
+    header.pluginSize = plugin.size();
+    header.formatSize = formatName.size();
+
+    QByteArray record;
+    record.reserve(sizeof(header) + plugin.size() + formatName.size() + bytes.size());
+    record.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    record.append(plugin);
+    record.append(formatName);
+    record.append(bytes);
+
+    const qint64 offset = pack_.size();
+    if (!pack_.seek(offset) || pack_.write(record) != record.size()) {
+        qWarning() << "Unable to write tile to pack file" << pack_.fileName();
+        pack_.resize(offset);
+        return false;
+    }
+
+    Entry entry;
+    entry.spec = spec;
+    entry.format = format;
+    entry.offset = offset;
+    entry.recordSize = record.size();
+    entry.dataSize = bytes.size();
+
+    QHash<QGeoTileSpec, Entry>::iterator existing = entries_.find(spec);
+    if (existing != entries_.end()) {
+        markDead(existing.value());
+        existing.value() = entry;
+        maybeCompact();
+    } else {
+        entries_.insert(spec, entry);
+    }
+
+    return true;
+}
+
+QByteArray QGeoTilePackStore::read(const QGeoTileSpec &spec, QString *format)
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constFind(spec);
+    if (it == entries_.constEnd() || !pack_.isOpen())
+        return QByteArray();
+
+    const Entry &entry = it.value();
+    QByteArray bytes;
+    bytes.resize(entry.dataSize);
+    if (!pack_.seek(entry.dataOffset())
+            || pack_.read(bytes.data(), entry.dataSize) != qint64(entry.dataSize)) {
+        return QByteArray();
+    }
+
+    if (format)
+        *format = entry.format;
+    return bytes;
+}
+
+void QGeoTilePackStore::remove(const QGeoTileSpec &spec)
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::iterator it = entries_.find(spec);
+    if (it == entries_.end())
+        return;
+
+    markDead(it.value());
+    entries_.erase(it);
+    maybeCompact();
+}
+
+void QGeoTilePackStore::clear()
+{
+    QMutexLocker locker(&mutex_);
+    if (compaction_)
+        compaction_->aborted.store(1);
+    compactionPool_.waitForDone();
+    /* an uncommitted target discards its temporary file */
+    compaction_.clear();
+
+    entries_.clear();
+    loadOrder_.clear();
+    deadBytes_ = 0;
+    QFile::remove(indexFileName());
+
+    if (pack_.isOpen())
+        pack_.resize(sizeof(PackFileHeader));
+}
+
+void QGeoTilePackStore::markDead(const Entry &entry)
+{
+    deadBytes_ += entry.recordSize;
+}
+
+void QGeoTilePackStore::writeIndex(const QList<QPair<QGeoTileSpec, int> > &order)
+{
+    QMutexLocker locker(&mutex_);
+    if (!pack_.isOpen())
+        return;
+
+    QHash<QString, quint16> stringIds;
+    QByteArray strings;
+    QVector<IndexRecord> records;
+    records.reserve(entries_.size());
+    QSet<QGeoTileSpec> written;
+    written.reserve(entries_.size());
+
+    auto stringId = [&](const QString &string) -> quint16 {
+        QHash<QString, quint16>::const_iterator it = stringIds.constFind(string);
+        if (it != stringIds.constEnd())
+            return it.value();
+        const QByteArray latin1 = string.toLatin1();
+        const quint16 length = latin1.size();
+        strings.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        strings.append(latin1);
+        const quint16 id = stringIds.size();
+        stringIds.insert(string, id);
+        return id;
+    };
+
+    auto append = [&](const Entry &entry, int queue) {
+        IndexRecord record;
+        memset(&record, 0, sizeof(record));
+        record.offset = entry.offset;
+        record.recordSize = entry.recordSize;
+        record.dataSize = entry.dataSize;
+        record.mapId = entry.spec.mapId();
+        record.zoom = entry.spec.zoom();
+        record.x = entry.spec.x();
+        record.y = entry.spec.y();
+        record.version = entry.spec.version();
+        record.plugin = stringId(entry.spec.plugin());
+        record.format = stringId(entry.format);
+        record.queue = queue;
+        records.append(record);
+        written.insert(entry.spec);
+    };
+
+    for (int i = 0; i < order.size(); ++i) {
+        const QGeoTileSpec &spec = order.at(i).first;
+        QHash<QGeoTileSpec, Entry>::iterator it = entries_.find(spec);
+        if (it == entries_.end() || written.contains(spec))
+            continue;
+        it.value().queue = order.at(i).second;
+        append(it.value(), it.value().queue);
+    }
+
+    QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constBegin();
+    for (; it != entries_.constEnd(); ++it) {
+        if (!written.contains(it.key()))
+            append(it.value(), it.value().queue);
+    }
+
+    IndexFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = IndexMagic;
+    header.version = FormatVersion;
+    header.packSize = pack_.size();
+    header.recordCount = records.size();
+    header.stringCount = stringIds.size();
+
+    QSaveFile file(indexFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write tile index file" << file.fileName();
+        return;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(strings);
+    file.write(reinterpret_cast<const char *>(records.constData()),
+               records.size() * sizeof(IndexRecord));
+    if (!file.commit())
+        qWarning() << "Unable to write tile index file" << file.fileName();
+}
+
+qint64 QGeoTilePackStore::packSize() const
+{
+    QMutexLocker locker(&mutex_);
+    return pack_.isOpen() ? pack_.size() : 0;
+}
+
+qint64 QGeoTilePackStore::deadBytes() const
+{
+    QMutexLocker locker(&mutex_);
+    return deadBytes_;
+}
+
+void QGeoTilePackStore::setCompactionThreshold(qreal deadRatio, qint64 minimumDeadBytes)
+{
+    QMutexLocker locker(&mutex_);
+    compactionRatio_ = deadRatio;
+    compactionMinimum_ = minimumDeadBytes;
+    maybeCompact();
+}
+
+bool QGeoTilePackStore::isCompacting() const
+{
+    QMutexLocker locker(&mutex_);
+    return !compaction_.isNull();
+}
+
+void QGeoTilePackStore::maybeCompact()
+{
+    if (compaction_ || !pack_.isOpen())
+        return;
+    if (deadBytes_ < compactionMinimum_ || deadBytes_ < compactionRatio_ * packSize())
+        return;
+    compact();
+}
+
+void QGeoTilePackStore::compact()
+{
+    QMutexLocker locker(&mutex_);
+    if (compaction_ || !pack_.isOpen())
+        return;
+
+    QList<Entry> live = entries_.values();
+    std::sort(live.begin(), live.end(), entryOffsetLessThan);
+
+    QSharedPointer<QGeoTilePackCompactionState> state(new QGeoTilePackCompactionState);
+    state->source = packFileName();
+    state->target.reset(new QSaveFile(packFileName()));
+    state->snapshotEnd = pack_.size();
+    state->offsets.reserve(live.size());
+    state->sizes.reserve(live.size());
+    foreach (const Entry &entry, live) {
+        state->offsets.append(entry.offset);
+        state->sizes.append(entry.recordSize);
+    }
+
+    compaction_ = state;
+    compactionPool_.start(new QGeoTilePackCompactionJob(state, this));
+}
+
+void QGeoTilePackStore::waitForCompaction()
+{
+    /* the worker never takes the lock, so waiting while holding it is safe */
+    QMutexLocker locker(&mutex_);
+    compactionPool_.waitForDone();
+    if (compaction_)
+        finishCompaction(compaction_.data());
+}
+
+// The worker queues this call and waitForCompaction() makes it directly, so
+// a queued call may arrive after its compaction was finished and another one
+// started. It only acts on the current compaction once its worker is done; a
+// new compaction that reuses the address of an old one is still running.
+void QGeoTilePackStore::finishCompaction(QGeoTilePackCompactionState *job)
+{
+    QMutexLocker locker(&mutex_);
+    QSharedPointer<QGeoTilePackCompactionState> state = compaction_;
+    if (!state || state.data() != job)
+        return;
+    const int result = state->result.loadAcquire();
+    if (result == QGeoTilePackCompactionState::Running)
+        return;
+    compaction_.clear();
+
+    if (result != QGeoTilePackCompactionState::Succeeded || !pack_.isOpen())
+        return;
+
+    QHash<quint64, quint64> moved;
+    moved.reserve(state->offsets.size());
+    for (int i = 0; i < state->offsets.size(); ++i)
+        moved.insert(state->offsets.at(i), state->newOffsets.at(i));
+
+    // Records still in the old pack that the worker did not see were written
+    // while it was running, so they are copied over here. The entries keep
+    // pointing into the old pack until the new one has replaced it.
+    QSaveFile &out = *state->target;
+    QHash<QGeoTileSpec, quint64> newOffsets;
+    newOffsets.reserve(entries_.size());
+    qint64 liveBytes = 0;
+    bool ok = true;
+    QByteArray buffer;
+    QHash<QGeoTileSpec, Entry>::const_iterator it = entries_.constBegin();
+    for (; ok && it != entries_.constEnd(); ++it) {
+        const Entry &entry = it.value();
+        liveBytes += entry.recordSize;
+        QHash<quint64, quint64>::const_iterator m = moved.constFind(entry.offset);
+        if (entry.offset < state->snapshotEnd && m != moved.constEnd()) {
+            newOffsets.insert(it.key(), m.value());
+            continue;
+        }
+
+        buffer.resize(entry.recordSize);
+        ok = pack_.seek(entry.offset)
+                && pack_.read(buffer.data(), entry.recordSize) == qint64(entry.recordSize);
+        if (ok) {
+            newOffsets.insert(it.key(), out.pos());
+            ok = out.write(buffer) == buffer.size();
+        }
+    }
+    const qint64 newPackSize = out.pos();
+
+    // QSaveFile renames over the old pack, so a failure at any point leaves
+    // the old pack and the entries pointing into it untouched.
+    pack_.close();
+    if (!ok || !out.commit()) {
+        qWarning() << "Unable to replace tile pack file" << packFileName();
+        if (!pack_.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+            qWarning() << "Unable to open tile pack file" << pack_.fileName();
+            entries_.clear();
+            loadOrder_.clear();
+            deadBytes_ = 0;
+        }
+        return;
+    }
+
+    // the old index refers to offsets in the old pack
+    QFile::remove(indexFileName());
+
+    if (!pack_.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning() << "Unable to open tile pack file" << pack_.fileName();
+        entries_.clear();
+        loadOrder_.clear();
+        deadBytes_ = 0;
+        return;
+    }
+
+    QHash<QGeoTileSpec, Entry>::iterator e = entries_.begin();
+    for (; e != entries_.end(); ++e)
+        e.value().offset = newOffsets.value(e.key());
+
+    // Tiles removed while the worker was running were copied as live, they
+    // are the only dead records in the new pack.
+    loadOrder_.clear();
+    deadBytes_ = newPackSize - qint64(sizeof(PackFileHeader)) - liveBytes;
+    emit compactionFinished();
+}
+
+QT_END_NAMESPACE
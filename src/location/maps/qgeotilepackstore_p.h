@@ -0,0 +1,161 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEPACKSTORE_P_H
+#define QGEOTILEPACKSTORE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include "qgeotilespec_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QGeoTilePackCompactionState;
+
+/*
+ * Disk storage for QGeoFileTileCache that keeps all tiles in a single
+ * append-only pack file instead of one file per tile.
+ *
+ * The pack file ("tiles.pack") is a sequence of self-describing records
+ * (key + format + image bytes). The index file ("tiles.idx") is a flat
+ * array of fixed-size records that is written on shutdown and memory
+ * mapped on startup, so opening a cache of several hundred thousand tiles
+ * does not need to touch the file system per tile. Records appended after
+ * the index was last written are recovered by scanning the tail of the pack.
+ *
+ * Removing or replacing a tile only marks its record as dead; once enough
+ * dead bytes accumulate the live records are copied into a new pack file on
+ * a worker thread.
+ *
+ * read() may be called from any thread, everything else is expected to be
+ * called from the thread the store lives in.
+ */
+class Q_LOCATION_EXPORT QGeoTilePackStore : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        Entry() : offset(0), recordSize(0), dataSize(0), queue(1) {}
+
+        QGeoTileSpec spec;
+        QString format;
+        quint64 offset;     // start of the record in the pack file
+        quint32 recordSize; // header, key and data
+        quint32 dataSize;   // image bytes only
+        int queue;          // QCache3Q queue the tile was in when the index was written
+
+        quint64 dataOffset() const { return offset + recordSize - dataSize; }
+    };
+
+    explicit QGeoTilePackStore(const QString &directory, QObject *parent = 0);
+    ~QGeoTilePackStore();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    QList<Entry> entries() const;
+    bool contains(const QGeoTileSpec &spec) const;
+    int size(const QGeoTileSpec &spec) const;
+
+    bool write(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
+    QByteArray read(const QGeoTileSpec &spec, QString *format = 0);
+    void remove(const QGeoTileSpec &spec);
+    void clear();
+
+    void writeIndex(const QList<QPair<QGeoTileSpec, int> > &order);
+
+    qint64 packSize() const;
+    qint64 deadBytes() const;
+
+    void setCompactionThreshold(qreal deadRatio, qint64 minimumDeadBytes);
+    bool isCompacting() const;
+    void compact();
+    void waitForCompaction();
+
+    QString packFileName() const;
+    QString indexFileName() const;
+
+Q_SIGNALS:
+    void compactionFinished();
+
+private Q_SLOTS:
+    void finishCompaction(QGeoTilePackCompactionState *job);
+
+private:
+    bool loadIndex();
+    void scanPack(quint64 from);
+    void maybeCompact();
+    void markDead(const Entry &entry);
+
+    QString directory_;
+    mutable QMutex mutex_;
+    QFile pack_;
+    QHash<QGeoTileSpec, Entry> entries_;
+    QVector<QGeoTileSpec> loadOrder_;
+    qint64 deadBytes_;
+
+    qreal compactionRatio_;
+    qint64 compactionMinimum_;
+    QSharedPointer<QGeoTilePackCompactionState> compaction_;
+    QThreadPool compactionPool_;
+
+    Q_DISABLE_COPY(QGeoTilePackStore)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEPACKSTORE_P_H
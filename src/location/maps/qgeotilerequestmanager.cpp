@@ -59,8 +59,11 @@ public:
     QHash<QGeoTileSpec, int> m_retries;
     QHash<QGeoTileSpec, QSharedPointer<RetryFuture> > m_futures;
     QSet<QGeoTileSpec> m_requested;
+    QSet<QGeoTileSpec> m_loading;
+    bool m_prefetchDeferred;
 
     void tileFetched(const QGeoTileSpec &spec);
+    void tileLoadFailed(const QGeoTileSpec &spec);
 };
 
 QGeoTileRequestManager::QGeoTileRequestManager(QGeoTiledMap *map, QGeoTiledMappingManagerEngine *engine)
@@ -79,11 +82,46 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManager::requestTiles(con
     return d_ptr->requestTiles(tiles);
 }
 
+/*
+    Requests \a tiles like requestTiles(), unless the engine's tile fetcher
+    still has a backlog. Prefetching then waits for the backlog to clear and
+    is recomputed for the camera at that time.
+*/
+void QGeoTileRequestManager::prefetchTiles(const QSet<QGeoTileSpec> &tiles)
+{
+    if (!d_ptr->m_engine.isNull() && d_ptr->m_engine->isTileFetchBacklogged()) {
+        d_ptr->m_prefetchDeferred = true;
+        return;
+    }
+
+    d_ptr->m_prefetchDeferred = false;
+    d_ptr->requestTiles(tiles);
+}
+
+void QGeoTileRequestManager::tileFetchBacklogCleared()
+{
+    if (!d_ptr->m_prefetchDeferred)
+        return;
+
+    d_ptr->m_prefetchDeferred = false;
+    d_ptr->m_map->prefetchData();
+}
+
 void QGeoTileRequestManager::tileFetched(const QGeoTileSpec &spec)
 {
     d_ptr->tileFetched(spec);
 }
 
+void QGeoTileRequestManager::tileLoadFailed(const QGeoTileSpec &spec)
+{
+    d_ptr->tileLoadFailed(spec);
+}
+
+bool QGeoTileRequestManager::isLoading(const QGeoTileSpec &spec) const
+{
+    return d_ptr->m_loading.contains(spec);
+}
+
 QSharedPointer<QGeoTileTexture> QGeoTileRequestManager::tileTexture(const QGeoTileSpec &spec)
 {
     if (d_ptr->m_engine)
@@ -99,18 +137,24 @@ void QGeoTileRequestManager::tileError(const QGeoTileSpec &tile, const QString &
 
 QGeoTileRequestManagerPrivate::QGeoTileRequestManagerPrivate(QGeoTiledMap *map,QGeoTiledMappingManagerEngine *engine)
     : m_map(map),
-      m_engine(engine)
+      m_engine(engine),
+      m_prefetchDeferred(false)
 {
 }
 
 QGeoTileRequestManagerPrivate::~QGeoTileRequestManagerPrivate()
 {
+    if (!m_engine.isNull()) {
+        foreach (const QGeoTileSpec &tile, m_loading)
+            m_engine->cancelTileTextureAsync(tile);
+    }
 }
 
 QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTiles(const QSet<QGeoTileSpec> &tiles)
 {
     QSet<QGeoTileSpec> cancelTiles = m_requested - tiles;
-    QSet<QGeoTileSpec> requestTiles = tiles - m_requested;
+    QSet<QGeoTileSpec> cancelLoads = m_loading - tiles;
+    QSet<QGeoTileSpec> requestTiles = tiles - m_requested - m_loading;
     QSet<QGeoTileSpec> cached;
 //    int tileSize = tiles.size();
 //    int newTiles = requestTiles.size();
@@ -119,16 +163,30 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTi
 
     QList<QSharedPointer<QGeoTileTexture> > cachedTex;
 
+    // tiles that left the view are no longer worth decoding
+    if (!m_engine.isNull()) {
+        iter i = cancelLoads.constBegin();
+        iter end = cancelLoads.constEnd();
+        for (; i != end; ++i)
+            m_engine->cancelTileTextureAsync(*i);
+    }
+    m_loading -= cancelLoads;
+
     // remove tiles in cache from request tiles
     if (!m_engine.isNull()) {
         iter i = requestTiles.constBegin();
         iter end = requestTiles.constEnd();
         for (; i != end; ++i) {
             QGeoTileSpec tile = *i;
-            QSharedPointer<QGeoTileTexture> tex = m_engine->getTileTexture(tile);
+            bool pending = false;
+            QSharedPointer<QGeoTileTexture> tex = m_engine->getTileTextureAsync(tile, &pending);
             if (tex) {
                 cachedTex << tex;
                 cached.insert(tile);
+            } else if (pending) {
+                // delivered through tileFetched() once decoded
+                m_loading.insert(tile);
+                cached.insert(tile);
             }
         }
     }
@@ -136,6 +194,11 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTi
     requestTiles -= cached;
 
     m_requested -= cancelTiles;
+
+    // the camera moved, so tiles asked for earlier may now be more or less urgent
+    if (!m_engine.isNull())
+        m_engine->updateTilePriorities(m_map, m_requested);
+
     m_requested += requestTiles;
 
 //    qDebug() << "required # tiles: " << tileSize << ", new tiles: " << newTiles << ", total server requests: " << requested_.size();
@@ -163,10 +226,26 @@ void QGeoTileRequestManagerPrivate::tileFetched(const QGeoTileSpec &spec)
 {
     m_map->updateTile(spec);
     m_requested.remove(spec);
+    m_loading.remove(spec);
     m_retries.remove(spec);
     m_futures.remove(spec);
 }
 
+void QGeoTileRequestManagerPrivate::tileLoadFailed(const QGeoTileSpec &spec)
+{
+    if (!m_loading.contains(spec))
+        return;
+    m_loading.remove(spec);
+
+    // the cached copy was unusable, go to the network instead
+    if (!m_engine.isNull()) {
+        QSet<QGeoTileSpec> requestTiles;
+        requestTiles.insert(spec);
+        m_requested.insert(spec);
+        m_engine->updateTileRequests(m_map, requestTiles, QSet<QGeoTileSpec>());
+    }
+}
+
 // Represents a tile that needs to be retried after a certain period of time
 class RetryFuture : public QObject
 {
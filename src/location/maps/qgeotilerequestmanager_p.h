@@ -65,9 +65,13 @@ public:
     ~QGeoTileRequestManager();
 
     QList<QSharedPointer<QGeoTileTexture> > requestTiles(const QSet<QGeoTileSpec> &tiles);
+    void prefetchTiles(const QSet<QGeoTileSpec> &tiles);
+    void tileFetchBacklogCleared();
 
     void tileError(const QGeoTileSpec &tile, const QString &errorString);
     void tileFetched(const QGeoTileSpec &spec);
+    void tileLoadFailed(const QGeoTileSpec &spec);
+    bool isLoading(const QGeoTileSpec &spec) const;
     QSharedPointer<QGeoTileTexture> tileTexture(const QGeoTileSpec &spec);
 
 private:
@@ -0,0 +1,260 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilerequesttable_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QGeoTileRequestTable::QGeoTileRequestTable()
+:   size_(0)
+{
+}
+
+/*
+    Returns the number of tiles in the table.
+*/
+int QGeoTileRequestTable::size() const
+{
+    return size_;
+}
+
+bool QGeoTileRequestTable::isEmpty() const
+{
+    return size_ == 0;
+}
+
+int QGeoTileRequestTable::capacity() const
+{
+    return entries_.size();
+}
+
+bool QGeoTileRequestTable::contains(const QGeoTileSpec &spec) const
+{
+    return find(spec, tileHash(spec)) != -1;
+}
+
+/*
+    Returns the number of maps waiting for \a spec, 0 if it is not in the
+    table.
+*/
+int QGeoTileRequestTable::refCount(const QGeoTileSpec &spec) const
+{
+    int index = find(spec, tileHash(spec));
+    return index == -1 ? 0 : entries_.at(index).maps.size();
+}
+
+/*
+    Adds \a map to the maps waiting for \a spec. Returns true if \a spec was
+    not in the table before, meaning it has to be requested.
+*/
+bool QGeoTileRequestTable::addRef(const QGeoTileSpec &spec, QGeoTiledMap *map)
+{
+    // keep the load factor below 3/4
+    if ((size_ + 1) * 4 > entries_.size() * 3)
+        rehash(qMax(16, entries_.size() * 2));
+
+    const uint hash = tileHash(spec);
+    const int mask = entries_.size() - 1;
+    int index = hash & mask;
+    for (;;) {
+        Entry &entry = entries_[index];
+        if (entry.isEmpty()) {
+            entry.spec = spec;
+            entry.hash = hash;
+            entry.maps.append(map);
+            ++size_;
+            return true;
+        }
+        if (entry.hash == hash && entry.spec == spec) {
+            if (!entry.maps.contains(map))
+                entry.maps.append(map);
+            return false;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+/*
+    Removes \a map from the maps waiting for \a spec. Returns true if that
+    was the last one, in which case the tile is dropped from the table and
+    its request can be cancelled.
+*/
+bool QGeoTileRequestTable::release(const QGeoTileSpec &spec, QGeoTiledMap *map)
+{
+    int index = find(spec, tileHash(spec));
+    if (index == -1)
+        return false;
+
+    MapList &maps = entries_[index].maps;
+    int i = maps.indexOf(map);
+    if (i == -1)
+        return false;
+    maps.remove(i);
+
+    if (!maps.isEmpty())
+        return false;
+
+    erase(index);
+    return true;
+}
+
+/*
+    Drops \a spec from the table, storing the maps that were waiting for it
+    in \a maps. Returns false if \a spec was not in the table.
+*/
+bool QGeoTileRequestTable::take(const QGeoTileSpec &spec, MapList *maps)
+{
+    int index = find(spec, tileHash(spec));
+    if (index == -1)
+        return false;
+
+    *maps = entries_.at(index).maps;
+    erase(index);
+    return true;
+}
+
+/*
+    Removes \a map from every tile, dropping the tiles no other map waits
+    for.
+*/
+void QGeoTileRequestTable::releaseMap(QGeoTiledMap *map)
+{
+    bool dropped = false;
+    for (int index = 0; index < entries_.size(); ++index) {
+        MapList &maps = entries_[index].maps;
+        int i = maps.indexOf(map);
+        if (i == -1)
+            continue;
+        maps.remove(i);
+        dropped |= maps.isEmpty();
+    }
+
+    // emptied entries break the probe sequences, rebuild once
+    if (dropped)
+        rehash(entries_.size());
+}
+
+void QGeoTileRequestTable::clear()
+{
+    entries_.clear();
+    size_ = 0;
+}
+
+/*
+    qHash(QGeoTileSpec) folds every field into 5 bits, which makes adjacent
+    tiles collide in a power of two table. Mix the fields instead.
+*/
+uint QGeoTileRequestTable::tileHash(const QGeoTileSpec &spec)
+{
+    uint h = qHash(spec.plugin()) ^ (uint(spec.mapId()) << 16) ^ uint(spec.version());
+    h = h * 31 + uint(spec.zoom());
+    h = h * 0x9e3779b1U + uint(spec.x());
+    h = h * 0x9e3779b1U + uint(spec.y());
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+int QGeoTileRequestTable::find(const QGeoTileSpec &spec, uint hash) const
+{
+    if (entries_.isEmpty())
+        return -1;
+
+    const int mask = entries_.size() - 1;
+    int index = hash & mask;
+    for (;;) {
+        const Entry &entry = entries_.at(index);
+        if (entry.isEmpty())
+            return -1;
+        if (entry.hash == hash && entry.spec == spec)
+            return index;
+        index = (index + 1) & mask;
+    }
+}
+
+/*
+    Removes the entry at \a index, shifting later entries of the same probe
+    sequence back so that lookups never need tombstones.
+*/
+void QGeoTileRequestTable::erase(int index)
+{
+    const int mask = entries_.size() - 1;
+    int hole = index;
+    int next = index;
+    for (;;) {
+        next = (next + 1) & mask;
+        const Entry &entry = entries_.at(next);
+        if (entry.isEmpty())
+            break;
+
+        // leave the entry alone if its home slot lies cyclically in (hole, next]
+        const int home = entry.hash & mask;
+        if (hole <= next ? (hole < home && home <= next) : (hole < home || home <= next))
+            continue;
+
+        entries_[hole] = entry;
+        hole = next;
+    }
+
+    entries_[hole] = Entry();
+    --size_;
+}
+
+void QGeoTileRequestTable::rehash(int capacity)
+{
+    QVector<Entry> old;
+    old.swap(entries_);
+    entries_.resize(capacity);
+    size_ = 0;
+
+    const int mask = capacity - 1;
+    for (int i = 0; i < old.size(); ++i) {
+        const Entry &entry = old.at(i);
+        if (entry.isEmpty())
+            continue;
+
+        int index = entry.hash & mask;
+        while (!entries_.at(index).isEmpty())
+            index = (index + 1) & mask;
+        entries_[index] = entry;
+        ++size_;
+    }
+}
+
+QT_END_NAMESPACE
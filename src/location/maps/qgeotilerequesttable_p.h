@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEREQUESTTABLE_P_H
+#define QGEOTILEREQUESTTABLE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtCore/QVarLengthArray>
+#include <QtCore/QVector>
+
+#include "qgeotilespec_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QGeoTiledMap;
+
+/*
+    The tiles a tiled mapping engine has outstanding, each with the maps
+    waiting for it. The number of maps is the tile's reference count: a
+    tile is requested when its first map adds it and cancelled when its
+    last map lets go.
+
+    This is a flat open-addressing table with linear probing, so entries
+    are updated in place. The maps of an entry are kept inline; only tiles
+    shared by many maps spill to the heap.
+*/
+class Q_LOCATION_EXPORT QGeoTileRequestTable
+{
+public:
+    typedef QVarLengthArray<QGeoTiledMap *, 4> MapList;
+
+    QGeoTileRequestTable();
+
+    int size() const;
+    bool isEmpty() const;
+    int capacity() const;
+
+    bool contains(const QGeoTileSpec &spec) const;
+    int refCount(const QGeoTileSpec &spec) const;
+
+    bool addRef(const QGeoTileSpec &spec, QGeoTiledMap *map);
+    bool release(const QGeoTileSpec &spec, QGeoTiledMap *map);
+    bool take(const QGeoTileSpec &spec, MapList *maps);
+    void releaseMap(QGeoTiledMap *map);
+    void clear();
+
+private:
+    struct Entry
+    {
+        Entry() : hash(0) {}
+
+        bool isEmpty() const { return maps.isEmpty(); }
+
+        QGeoTileSpec spec;
+        uint hash;
+        MapList maps;
+    };
+
+    static uint tileHash(const QGeoTileSpec &spec);
+    int find(const QGeoTileSpec &spec, uint hash) const;
+    void erase(int index);
+    void rehash(int capacity);
+
+    QVector<Entry> entries_;
+    int size_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEREQUESTTABLE_P_H
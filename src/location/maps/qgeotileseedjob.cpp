@@ -0,0 +1,663 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotileseedjob_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
+#include "qabstractgeotilecache_p.h"
+#include "qgeotilespec_p.h"
+
+#include <QtPositioning/QGeoCircle>
+#include <QtPositioning/QGeoRectangle>
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/qmath.h>
+
+#include <cmath>
+#include <climits>
+
+QT_BEGIN_NAMESPACE
+
+// same as QGeoCoordinate, in meters
+static const double EARTH_MEAN_RADIUS = 6371007.2;
+// web mercator does not reach the poles
+static const double MERCATOR_MAX_LATITUDE = 85.05112878;
+// what a tile is assumed to take on disk before any has been fetched
+static const int SEED_TILE_SIZE_ESTIMATE = 8 * 1024;
+
+class QGeoTileSeedJobPrivate
+{
+public:
+    QGeoTileSeedJobPrivate();
+
+    bool setArea(const QGeoShape &area);
+    void zoomBounds(int zoom, int *minX, int *maxX, int *minY, int *maxY) const;
+    bool rowColumns(int zoom, int y, int *first, int *last) const;
+    qint64 tileCount(int zoom) const;
+    void resetCursor();
+    void startZoomLevel();
+    bool startRow();
+    bool nextTile(QGeoTileSpec *spec);
+
+    qint64 projectedBytes() const;
+    bool checkCapacity(QGeoTileSeedJob *q);
+    void requestTiles(QGeoTileSeedJob *q);
+    void setState(QGeoTileSeedJob *q, QGeoTileSeedJob::State state);
+    void fail(QGeoTileSeedJob *q, const QString &error);
+    void checkFinished(QGeoTileSeedJob *q);
+
+    QPointer<QGeoTiledMappingManagerEngine> engine;
+    QString plugin;
+    QGeoMapType mapType;
+    int version;
+
+    QGeoShape area;
+    int minZoom;
+    int maxZoom;
+
+    // the area's bounding box; west > east when it crosses the dateline
+    double north;
+    double south;
+    double west;
+    double east;
+    bool isCircle;
+    QGeoCoordinate circleCenter;
+    double circleRadius;
+
+    // position of the tile walk; rowMaxX may reach past the dateline
+    int zoom;
+    int x;
+    int y;
+    int minX;
+    int maxX;
+    int minY;
+    int maxY;
+    int rowMinX;
+    int rowMaxX;
+
+    int maxConcurrentRequests;
+    QGeoTileSeedJob::State state;
+    QString errorString;
+    QSet<QGeoTileSpec> inFlight;
+
+    int total;
+    int completed;
+    int skipped;
+    int failed;
+    qint64 fetchedBytes;
+};
+
+QGeoTileSeedJobPrivate::QGeoTileSeedJobPrivate()
+:   version(-1),
+    minZoom(0),
+    maxZoom(-1),
+    north(0.0),
+    south(0.0),
+    west(0.0),
+    east(0.0),
+    isCircle(false),
+    circleRadius(0.0),
+    zoom(0),
+    x(0),
+    y(0),
+    minX(0),
+    maxX(-1),
+    minY(0),
+    maxY(-1),
+    rowMinX(0),
+    rowMaxX(-1),
+    maxConcurrentRequests(4),
+    state(QGeoTileSeedJob::Idle),
+    total(0),
+    completed(0),
+    skipped(0),
+    failed(0),
+    fetchedBytes(0)
+{
+}
+
+/*
+    Works out the bounding box of \a shape. Returns false for shapes that
+    cannot be seeded.
+*/
+bool QGeoTileSeedJobPrivate::setArea(const QGeoShape &shape)
+{
+    area = shape;
+    if (!shape.isValid())
+        return false;
+
+    if (shape.type() == QGeoShape::RectangleType) {
+        QGeoRectangle rect(shape);
+        north = rect.topLeft().latitude();
+        south = rect.bottomRight().latitude();
+        west = rect.topLeft().longitude();
+        east = rect.bottomRight().longitude();
+        isCircle = false;
+        return true;
+    }
+
+    if (shape.type() == QGeoShape::CircleType) {
+        QGeoCircle circle(shape);
+        circleCenter = circle.center();
+        circleRadius = circle.radius();
+        isCircle = true;
+
+        // the columns of a circle are worked out row by row in rowColumns()
+        const double angle = circleRadius / EARTH_MEAN_RADIUS;
+        north = qMin(circleCenter.latitude() + qRadiansToDegrees(angle), 90.0);
+        south = qMax(circleCenter.latitude() - qRadiansToDegrees(angle), -90.0);
+        west = -180.0;
+        east = 180.0;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+    Returns the range of tiles covering the bounding box of the area at
+    \a zoom. Across the dateline \a maxX is larger than the last column.
+*/
+void QGeoTileSeedJobPrivate::zoomBounds(int zoom, int *minX, int *maxX, int *minY, int *maxY) const
+{
+    const int side = 1 << zoom;
+    const QDoubleVector2D topLeft = QGeoProjection::coordToMercator(
+                QGeoCoordinate(qMin(north, MERCATOR_MAX_LATITUDE), west));
+    const QDoubleVector2D bottomRight = QGeoProjection::coordToMercator(
+                QGeoCoordinate(qMax(south, -MERCATOR_MAX_LATITUDE), east));
+
+    *minX = qBound(0, int(std::floor(topLeft.x() * side)), side - 1);
+    *maxX = qBound(0, int(std::floor(bottomRight.x() * side)), side - 1);
+    *minY = qBound(0, int(std::floor(topLeft.y() * side)), side - 1);
+    *maxY = qBound(0, int(std::floor(bottomRight.y() * side)), side - 1);
+
+    // across the dateline the columns wrap around
+    if (west > east)
+        *maxX += side;
+}
+
+/*
+    Returns the columns of row \a y at \a zoom that touch the area, or false
+    if none does. \a first may be negative and \a last past the last column
+    when the row crosses the dateline; callers wrap them.
+*/
+bool QGeoTileSeedJobPrivate::rowColumns(int zoom, int y, int *first, int *last) const
+{
+    const int side = 1 << zoom;
+    if (!isCircle) {
+        *first = minX;
+        *last = maxX;
+        return true;
+    }
+
+    const double angle = circleRadius / EARTH_MEAN_RADIUS;
+    const double centerLatitude = qDegreesToRadians(circleCenter.latitude());
+    const double tileNorth = qDegreesToRadians(QGeoProjection::mercatorToCoord(
+                                                   QDoubleVector2D(0.0, double(y) / side)).latitude());
+    const double tileSouth = qDegreesToRadians(QGeoProjection::mercatorToCoord(
+                                                   QDoubleVector2D(0.0, double(y + 1) / side)).latitude());
+    if (tileSouth > centerLatitude + angle || tileNorth < centerLatitude - angle)
+        return false;
+
+    // A circle around a pole, or wider than a hemisphere, covers whole rows.
+    // Otherwise its half width at latitude p is acos(c(p)) with
+    //   c(p) = (cos(angle) - sin(center) sin(p)) / (cos(center) cos(p)),
+    // and c is smallest at the row's edges or where sin(p) = sin(center) / cos(angle).
+    const double cosCenter = qCos(centerLatitude);
+    const double sinCenter = qSin(centerLatitude);
+    const double cosAngle = qCos(angle);
+    double minC = -1.0;
+    if (cosCenter > 1e-12 && cosAngle > 0.0) {
+        minC = qMin((cosAngle - sinCenter * qSin(tileNorth)) / (cosCenter * qCos(tileNorth)),
+                    (cosAngle - sinCenter * qSin(tileSouth)) / (cosCenter * qCos(tileSouth)));
+        const double sinWidest = sinCenter / cosAngle;
+        if (sinWidest > qSin(tileSouth) && sinWidest < qSin(tileNorth)) {
+            const double cosWidest = qSqrt(1.0 - sinWidest * sinWidest);
+            minC = qMin(minC, (cosAngle - sinCenter * sinWidest) / (cosCenter * cosWidest));
+        }
+    }
+
+    if (minC <= -1.0) {
+        *first = 0;
+        *last = side - 1;
+        return true;
+    }
+
+    const double span = qRadiansToDegrees(qAcos(qMin(minC, 1.0)));
+    const double longitude = circleCenter.longitude();
+    *first = int(std::floor((longitude - span + 180.0) / 360.0 * side));
+    *last = int(std::floor((longitude + span + 180.0) / 360.0 * side));
+    if (*last - *first + 1 >= side) {
+        *first = 0;
+        *last = side - 1;
+    }
+    return true;
+}
+
+/*
+    Returns the number of tiles of the area at \a zoom, without visiting
+    them: a product for rectangles, a sum over the rows for circles.
+*/
+qint64 QGeoTileSeedJobPrivate::tileCount(int zoom) const
+{
+    int zoomMinX, zoomMaxX, zoomMinY, zoomMaxY;
+    zoomBounds(zoom, &zoomMinX, &zoomMaxX, &zoomMinY, &zoomMaxY);
+    if (!isCircle)
+        return qint64(zoomMaxX - zoomMinX + 1) * (zoomMaxY - zoomMinY + 1);
+
+    qint64 count = 0;
+    for (int row = zoomMinY; row <= zoomMaxY; ++row) {
+        int first, last;
+        if (rowColumns(zoom, row, &first, &last))
+            count += last - first + 1;
+    }
+    return count;
+}
+
+void QGeoTileSeedJobPrivate::resetCursor()
+{
+    zoom = minZoom;
+    startZoomLevel();
+}
+
+void QGeoTileSeedJobPrivate::startZoomLevel()
+{
+    if (zoom > maxZoom)
+        return;
+
+    zoomBounds(zoom, &minX, &maxX, &minY, &maxY);
+    y = minY;
+    startRow();
+}
+
+bool QGeoTileSeedJobPrivate::startRow()
+{
+    if (!rowColumns(zoom, y, &rowMinX, &rowMaxX)) {
+        rowMinX = 0;
+        rowMaxX = -1;
+    }
+    x = rowMinX;
+    return rowMaxX >= rowMinX;
+}
+
+/*
+    Advances the walk over the tiles of the area, zoom level by zoom level
+    and row by row. Returns false once all tiles have been visited.
+*/
+bool QGeoTileSeedJobPrivate::nextTile(QGeoTileSpec *spec)
+{
+    while (zoom <= maxZoom) {
+        if (y > maxY) {
+            ++zoom;
+            startZoomLevel();
+            continue;
+        }
+        if (x > rowMaxX) {
+            ++y;
+            if (y <= maxY)
+                startRow();
+            continue;
+        }
+
+        const int tileX = x++ & ((1 << zoom) - 1);
+        *spec = QGeoTileSpec(plugin, mapType.mapId(), zoom, tileX, y, version);
+        return true;
+    }
+    return false;
+}
+
+/*
+    Returns how much of the disk cache the job will take once all of its
+    tiles are seeded, at the average size of the tiles fetched so far, or
+    the estimate before any has been fetched.
+*/
+qint64 QGeoTileSeedJobPrivate::projectedBytes() const
+{
+    const int fetched = completed - skipped;
+    if (fetched <= 0)
+        return qint64(total) * SEED_TILE_SIZE_ESTIMATE;
+    return qint64(double(fetchedBytes) / fetched * total);
+}
+
+/*
+    The disk cache evicts the least recently used tiles once it is full, so a
+    job larger than the cache would throw away its own first tiles. Fails the
+    job as soon as its projected size no longer fits, long before the cache
+    is full.
+*/
+bool QGeoTileSeedJobPrivate::checkCapacity(QGeoTileSeedJob *q)
+{
+    QAbstractGeoTileCache *cache = engine.isNull() ? 0 : engine->tileCache();
+    const qint64 capacity = cache ? cache->maxDiskUsage() : 0;
+    if (capacity <= 0)
+        return true;
+
+    if (projectedBytes() <= capacity)
+        return true;
+
+    fail(q, QStringLiteral("The %1 tiles of the area do not fit into the disk cache of %2 bytes")
+            .arg(total).arg(capacity));
+    return false;
+}
+
+/*
+    Tops up the tiles in flight to the concurrency limit. Tiles already on
+    disk are counted as skipped without fetching them again.
+*/
+void QGeoTileSeedJobPrivate::requestTiles(QGeoTileSeedJob *q)
+{
+    if (state != QGeoTileSeedJob::Running || engine.isNull())
+        return;
+
+    if (!checkCapacity(q))
+        return;
+
+    QAbstractGeoTileCache *cache = engine->tileCache();
+    const int done = completed + failed;
+
+    QList<QGeoTileSpec> tiles;
+    QGeoTileSpec spec;
+    while (inFlight.size() < maxConcurrentRequests && nextTile(&spec)) {
+        if (cache && cache->contains(spec, QGeoTiledMappingManagerEngine::DiskCache)) {
+            ++completed;
+            ++skipped;
+            continue;
+        }
+        inFlight.insert(spec);
+        tiles.append(spec);
+    }
+
+    if (!tiles.isEmpty())
+        engine->requestSeedTiles(q, tiles);
+
+    if (completed + failed != done)
+        emit q->progress(completed + failed, total);
+
+    checkFinished(q);
+}
+
+void QGeoTileSeedJobPrivate::setState(QGeoTileSeedJob *q, QGeoTileSeedJob::State newState)
+{
+    if (state == newState)
+        return;
+    state = newState;
+    emit q->stateChanged(state);
+}
+
+void QGeoTileSeedJobPrivate::fail(QGeoTileSeedJob *q, const QString &error)
+{
+    if (!engine.isNull())
+        engine->releaseSeedTiles(q, inFlight);
+    inFlight.clear();
+    errorString = error;
+    setState(q, QGeoTileSeedJob::Failed);
+}
+
+void QGeoTileSeedJobPrivate::checkFinished(QGeoTileSeedJob *q)
+{
+    if (state != QGeoTileSeedJob::Running || !inFlight.isEmpty() || zoom <= maxZoom)
+        return;
+
+    setState(q, QGeoTileSeedJob::Finished);
+    emit q->finished();
+}
+
+/*!
+    \class QGeoTileSeedJob
+    \inmodule QtLocation
+    \internal
+
+    Downloads all tiles of an area over a range of zoom levels into the disk
+    cache, so that maps keep working without a network connection. Jobs are
+    created with QGeoTiledMappingManagerEngine::createSeedJob().
+
+    Tiles go through the engine's tile fetcher at the lowest priority and at
+    most maximumConcurrentRequests() at a time, so that maps on screen are
+    served first. Downloaded tiles are written to disk without being decoded.
+    A job that does not fit into the disk cache fails rather than have the
+    cache evict the tiles it seeded first.
+*/
+
+QGeoTileSeedJob::QGeoTileSeedJob(QGeoTiledMappingManagerEngine *engine, const QGeoMapType &mapType,
+                                 const QGeoShape &area, int minimumZoomLevel, int maximumZoomLevel,
+                                 QObject *parent)
+    : QObject(parent),
+      d_ptr(new QGeoTileSeedJobPrivate)
+{
+    Q_D(QGeoTileSeedJob);
+    d->engine = engine;
+    d->plugin = engine->managerName() + QLatin1Char('_') + QString::number(engine->managerVersion());
+    d->version = engine->tileVersion();
+    d->mapType = mapType;
+    d->minZoom = qMax(0, minimumZoomLevel);
+    d->maxZoom = maximumZoomLevel;
+
+    if (!d->setArea(area)) {
+        qWarning("QGeoTileSeedJob: cannot seed the tiles of an invalid or unsupported shape");
+        d->maxZoom = -1;
+    }
+
+    // count the tiles up front so progress can be reported as a fraction,
+    // the walk itself only advances as tiles are requested
+    qint64 total = 0;
+    for (int zoom = d->minZoom; zoom <= d->maxZoom && total < INT_MAX; ++zoom)
+        total += d->tileCount(zoom);
+    d->total = int(qMin(total, qint64(INT_MAX)));
+    d->resetCursor();
+}
+
+QGeoTileSeedJob::~QGeoTileSeedJob()
+{
+    Q_D(QGeoTileSeedJob);
+    if (!d->engine.isNull())
+        d->engine->releaseSeedJob(this, d->inFlight);
+    delete d_ptr;
+}
+
+QGeoMapType QGeoTileSeedJob::mapType() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->mapType;
+}
+
+QGeoShape QGeoTileSeedJob::area() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->area;
+}
+
+int QGeoTileSeedJob::minimumZoomLevel() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->minZoom;
+}
+
+int QGeoTileSeedJob::maximumZoomLevel() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->maxZoom;
+}
+
+/*
+    Sets the number of tiles the job has in flight at once to \a count, 4 by
+    default. Lower values leave more of the fetcher to maps on screen.
+*/
+void QGeoTileSeedJob::setMaximumConcurrentRequests(int count)
+{
+    Q_D(QGeoTileSeedJob);
+    d->maxConcurrentRequests = qMax(1, count);
+    d->requestTiles(this);
+}
+
+int QGeoTileSeedJob::maximumConcurrentRequests() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->maxConcurrentRequests;
+}
+
+QGeoTileSeedJob::State QGeoTileSeedJob::state() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->state;
+}
+
+/*
+    Returns why the job failed, or an empty string unless state() is Failed.
+*/
+QString QGeoTileSeedJob::errorString() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->errorString;
+}
+
+int QGeoTileSeedJob::totalTiles() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->total;
+}
+
+/*
+    Returns the number of tiles that are in the disk cache, including the
+    ones that were there before the job started.
+*/
+int QGeoTileSeedJob::completedTiles() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->completed;
+}
+
+/*
+    Returns the number of tiles that were already cached and not fetched.
+*/
+int QGeoTileSeedJob::skippedTiles() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->skipped;
+}
+
+int QGeoTileSeedJob::failedTiles() const
+{
+    Q_D(const QGeoTileSeedJob);
+    return d->failed;
+}
+
+void QGeoTileSeedJob::start()
+{
+    Q_D(QGeoTileSeedJob);
+    if (d->state != Idle)
+        return;
+
+    if (d->engine.isNull()) {
+        d->setState(this, Cancelled);
+        return;
+    }
+
+    d->setState(this, Running);
+    d->requestTiles(this);
+}
+
+/*
+    Stops requesting tiles. Tiles already in flight still complete.
+*/
+void QGeoTileSeedJob::pause()
+{
+    Q_D(QGeoTileSeedJob);
+    if (d->state == Running)
+        d->setState(this, Paused);
+}
+
+void QGeoTileSeedJob::resume()
+{
+    Q_D(QGeoTileSeedJob);
+    if (d->state != Paused)
+        return;
+
+    d->setState(this, Running);
+    d->requestTiles(this);
+}
+
+void QGeoTileSeedJob::cancel()
+{
+    Q_D(QGeoTileSeedJob);
+    if (d->state == Finished || d->state == Cancelled || d->state == Failed)
+        return;
+
+    if (!d->engine.isNull())
+        d->engine->releaseSeedTiles(this, d->inFlight);
+    d->inFlight.clear();
+    d->setState(this, Cancelled);
+}
+
+void QGeoTileSeedJob::tileFinished(const QGeoTileSpec &spec, int bytes)
+{
+    Q_D(QGeoTileSeedJob);
+    if (!d->inFlight.remove(spec))
+        return;
+
+    ++d->completed;
+    d->fetchedBytes += bytes;
+    emit progress(d->completed + d->failed, d->total);
+
+    if (!d->checkCapacity(this))
+        return;
+
+    d->requestTiles(this);
+    d->checkFinished(this);
+}
+
+void QGeoTileSeedJob::tileFailed(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTileSeedJob);
+    if (!d->inFlight.remove(spec))
+        return;
+
+    ++d->failed;
+    emit progress(d->completed + d->failed, d->total);
+
+    d->requestTiles(this);
+    d->checkFinished(this);
+}
+
+void QGeoTileSeedJob::engineDestroyed()
+{
+    Q_D(QGeoTileSeedJob);
+    d->engine = 0;
+    d->inFlight.clear();
+    if (d->state != Finished && d->state != Failed)
+        d->setState(this, Cancelled);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILESEEDJOB_P_H
+#define QGEOTILESEEDJOB_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QObject>
+#include <QtLocation/qlocationglobal.h>
+#include <QtPositioning/QGeoShape>
+
+#include "qgeomaptype_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QGeoTiledMappingManagerEngine;
+class QGeoTileSeedJobPrivate;
+class QGeoTileSpec;
+
+class Q_LOCATION_EXPORT QGeoTileSeedJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Idle,
+        Running,
+        Paused,
+        Finished,
+        Cancelled,
+        Failed
+    };
+
+    ~QGeoTileSeedJob();
+
+    QGeoMapType mapType() const;
+    QGeoShape area() const;
+    int minimumZoomLevel() const;
+    int maximumZoomLevel() const;
+
+    void setMaximumConcurrentRequests(int count);
+    int maximumConcurrentRequests() const;
+
+    State state() const;
+    QString errorString() const;
+    int totalTiles() const;
+    int completedTiles() const;
+    int skippedTiles() const;
+    int failedTiles() const;
+
+public Q_SLOTS:
+    void start();
+    void pause();
+    void resume();
+    void cancel();
+
+Q_SIGNALS:
+    void progress(int done, int total);
+    void stateChanged(QGeoTileSeedJob::State state);
+    void finished();
+
+private:
+    QGeoTileSeedJob(QGeoTiledMappingManagerEngine *engine, const QGeoMapType &mapType,
+                    const QGeoShape &area, int minimumZoomLevel, int maximumZoomLevel,
+                    QObject *parent);
+
+    void tileFinished(const QGeoTileSpec &spec, int bytes);
+    void tileFailed(const QGeoTileSpec &spec);
+    void engineDestroyed();
+
+    QGeoTileSeedJobPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QGeoTileSeedJob)
+    Q_DISABLE_COPY(QGeoTileSeedJob)
+
+    friend class QGeoTiledMappingManagerEngine;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILESEEDJOB_P_H
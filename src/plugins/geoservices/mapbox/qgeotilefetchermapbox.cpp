@@ -85,6 +85,7 @@ QGeoTiledMapReply *QGeoTileFetcherMapbox::getTileImage(const QGeoTileSpec &spec)
 {
     QNetworkRequest request;
     request.setRawHeader("User-Agent", m_userAgent);
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
 
     request.setUrl(QUrl(QStringLiteral("http://api.tiles.mapbox.com/v4/") +
                         m_mapId + QLatin1Char('/') +
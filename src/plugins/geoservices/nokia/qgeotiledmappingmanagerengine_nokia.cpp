@@ -108,7 +108,11 @@ QGeoTiledMappingManagerEngineNokia::QGeoTiledMappingManagerEngineNokia(
         m_cacheDirectory = QAbstractGeoTileCache::baseCacheDirectory() + QLatin1String("here");
     }
 
-    QAbstractGeoTileCache *tileCache = new QGeoFileTileCache(m_cacheDirectory);
+    QGeoFileTileCache::StorageType storageType = QGeoFileTileCache::FilePerTileStorage;
+    if (parameters.value(QStringLiteral("here.mapping.cache.storage")).toString() == QLatin1String("pack"))
+        storageType = QGeoFileTileCache::PackedStorage;
+
+    QGeoFileTileCache *tileCache = new QGeoFileTileCache(m_cacheDirectory, storageType);
     setTileCache(tileCache);
 
     if (parameters.contains(QStringLiteral("here.mapping.cache.disk.size"))) {
@@ -132,6 +136,12 @@ QGeoTiledMappingManagerEngineNokia::QGeoTiledMappingManagerEngineNokia(
           tileCache->setExtraTextureUsage(cacheSize);
     }
 
+    if (parameters.value(QStringLiteral("here.mapping.cache.texture.format")).toString() == QLatin1String("compact"))
+        tileCache->setTextureFormatPolicy(QGeoFileTileCache::PreferCompactFormat);
+
+    if (parameters.contains(QStringLiteral("here.mapping.cache.memory.keepcompressed")))
+        tileCache->setKeepCompressedTiles(parameters.value(QStringLiteral("here.mapping.cache.memory.keepcompressed")).toBool());
+
     populateMapSchemes();
     loadMapVersion();
     QMetaObject::invokeMethod(fetcher, "fetchCopyrightsData", Qt::QueuedConnection);
@@ -85,6 +85,11 @@ QGeoTileFetcherNokia::QGeoTileFetcherNokia(const QVariantMap &parameters,
 
     m_applicationId = parameters.value(QStringLiteral("here.app_id")).toString();
     m_token = parameters.value(QStringLiteral("here.token")).toString();
+
+    // tiles are spread over four randomly picked subdomains, each allowing
+    // six connections, so the pool is treated as a single host
+    setMaximumConcurrentRequests(24);
+    setMaximumRequestsPerHost(24);
 }
 
 QGeoTileFetcherNokia::~QGeoTileFetcherNokia()
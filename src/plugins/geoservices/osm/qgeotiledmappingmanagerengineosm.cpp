@@ -44,6 +44,7 @@
 #include <QtLocation/private/qgeocameracapabilities_p.h>
 #include <QtLocation/private/qgeomaptype_p.h>
 #include <QtLocation/private/qgeotiledmap_p.h>
+#include <QtLocation/private/qgeofiletilecache_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -84,6 +85,22 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
 
     setTileFetcher(tileFetcher);
 
+    QGeoFileTileCache::StorageType storageType = QGeoFileTileCache::FilePerTileStorage;
+    if (parameters.value(QStringLiteral("osm.mapping.cache.storage")).toString() == QLatin1String("pack"))
+        storageType = QGeoFileTileCache::PackedStorage;
+
+    // managerName() is not yet set, we have to hardcode the plugin name below
+    const QString cacheDirectory = QAbstractGeoTileCache::baseCacheDirectory() + QLatin1String("osm");
+    QGeoFileTileCache *tileCache = new QGeoFileTileCache(cacheDirectory, storageType);
+
+    if (parameters.value(QStringLiteral("osm.mapping.cache.texture.format")).toString() == QLatin1String("compact"))
+        tileCache->setTextureFormatPolicy(QGeoFileTileCache::PreferCompactFormat);
+
+    if (parameters.contains(QStringLiteral("osm.mapping.cache.memory.keepcompressed")))
+        tileCache->setKeepCompressedTiles(parameters.value(QStringLiteral("osm.mapping.cache.memory.keepcompressed")).toBool());
+
+    setTileCache(tileCache);
+
     *error = QGeoServiceProvider::NoError;
     errorString->clear();
 }
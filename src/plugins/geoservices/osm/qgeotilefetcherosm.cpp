@@ -60,54 +60,77 @@ void QGeoTileFetcherOsm::setUserAgent(const QByteArray &userAgent)
 void QGeoTileFetcherOsm::setUrlPrefix(const QString &urlPrefix)
 {
     m_urlPrefix = urlPrefix;
+    m_tileHosts.clear();
 }
 
 QGeoTiledMapReply *QGeoTileFetcherOsm::getTileImage(const QGeoTileSpec &spec)
 {
     QNetworkRequest request;
     request.setRawHeader("User-Agent", m_userAgent);
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    request.setUrl(tileUrl(spec));
 
-    QString urlPrefix;
-    QString suffix = QStringLiteral(".png");
+    QNetworkReply *reply = m_networkManager->get(request);
 
-    switch (spec.mapId()) {
+    return new QGeoMapReplyOsm(reply, spec);
+}
+
+/*
+    The host only depends on the map id, so it is looked up once per map type
+    rather than building the tile's URL both here and in getTileImage().
+*/
+QString QGeoTileFetcherOsm::tileHost(const QGeoTileSpec &spec) const
+{
+    QHash<int, QString>::const_iterator it = m_tileHosts.constFind(spec.mapId());
+    if (it != m_tileHosts.constEnd())
+        return it.value();
+
+    const QString host = QUrl(urlPrefix(spec.mapId())).host();
+    m_tileHosts.insert(spec.mapId(), host);
+    return host;
+}
+
+QString QGeoTileFetcherOsm::urlPrefix(int mapId, QString *suffix) const
+{
+    if (suffix)
+        *suffix = QStringLiteral(".png");
+
+    switch (mapId) {
     case 1:
-        urlPrefix = QStringLiteral("http://otile1.mqcdn.com/tiles/1.0.0/map/");
-        suffix = QStringLiteral(".jpg");
-        break;
+        if (suffix)
+            *suffix = QStringLiteral(".jpg");
+        return QStringLiteral("http://otile1.mqcdn.com/tiles/1.0.0/map/");
     case 2:
-        urlPrefix = QStringLiteral("http://otile1.mqcdn.com/tiles/1.0.0/sat/");
-        suffix = QStringLiteral(".jpg");
-        break;
+        if (suffix)
+            *suffix = QStringLiteral(".jpg");
+        return QStringLiteral("http://otile1.mqcdn.com/tiles/1.0.0/sat/");
     case 3:
-        urlPrefix = QStringLiteral("http://a.tile.thunderforest.com/cycle/");
-        break;
+        return QStringLiteral("http://a.tile.thunderforest.com/cycle/");
     case 4:
-        urlPrefix = QStringLiteral("http://a.tile.thunderforest.com/transport/");
-        break;
+        return QStringLiteral("http://a.tile.thunderforest.com/transport/");
     case 5:
-        urlPrefix = QStringLiteral("http://a.tile.thunderforest.com/transport-dark/");
-        break;
+        return QStringLiteral("http://a.tile.thunderforest.com/transport-dark/");
     case 6:
-        urlPrefix = QStringLiteral("http://a.tile.thunderforest.com/landscape/");
-        break;
+        return QStringLiteral("http://a.tile.thunderforest.com/landscape/");
     case 7:
-        urlPrefix = QStringLiteral("http://a.tile.thunderforest.com/outdoors/");
-        break;
+        return QStringLiteral("http://a.tile.thunderforest.com/outdoors/");
     case 8:
-        urlPrefix = m_urlPrefix;
-        break;
+        return m_urlPrefix;
     default:
-        qWarning("Unknown map id %d\n", spec.mapId());
+        return QString();
     }
+}
 
-    request.setUrl(QUrl(urlPrefix + QString::number(spec.zoom()) + QLatin1Char('/') +
-                        QString::number(spec.x()) + QLatin1Char('/') +
-                        QString::number(spec.y()) + suffix));
-
-    QNetworkReply *reply = m_networkManager->get(request);
+QUrl QGeoTileFetcherOsm::tileUrl(const QGeoTileSpec &spec) const
+{
+    QString suffix;
+    const QString prefix = urlPrefix(spec.mapId(), &suffix);
+    if (prefix.isEmpty() && spec.mapId() != 8)
+        qWarning("Unknown map id %d\n", spec.mapId());
 
-    return new QGeoMapReplyOsm(reply, spec);
+    return QUrl(prefix + QString::number(spec.zoom()) + QLatin1Char('/') +
+                QString::number(spec.x()) + QLatin1Char('/') +
+                QString::number(spec.y()) + suffix);
 }
 
 QT_END_NAMESPACE
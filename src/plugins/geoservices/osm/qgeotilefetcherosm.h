@@ -41,11 +41,13 @@
 #define QGEOTILEFETCHEROSM_H
 
 #include <QtLocation/private/qgeotilefetcher_p.h>
+#include <QtCore/QHash>
 
 QT_BEGIN_NAMESPACE
 
 class QGeoTiledMappingManagerEngine;
 class QNetworkAccessManager;
+class QUrl;
 
 class QGeoTileFetcherOsm : public QGeoTileFetcher
 {
@@ -57,12 +59,18 @@ public:
     void setUserAgent(const QByteArray &userAgent);
     void setUrlPrefix(const QString &urlPrefix);
 
+protected:
+    QString tileHost(const QGeoTileSpec &spec) const Q_DECL_OVERRIDE;
+
 private:
     QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec);
+    QString urlPrefix(int mapId, QString *suffix = 0) const;
+    QUrl tileUrl(const QGeoTileSpec &spec) const;
 
     QNetworkAccessManager *m_networkManager;
     QByteArray m_userAgent;
     QString m_urlPrefix;
+    mutable QHash<int, QString> m_tileHosts;
 };
 
 QT_END_NAMESPACE
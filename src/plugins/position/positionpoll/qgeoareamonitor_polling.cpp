@@ -46,11 +46,27 @@
 #include <QtCore/qtimer.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qmutex.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qvector.h>
+
+#include <algorithm>
+#include <cmath>
 
 #define UPDATE_INTERVAL_5S  5000
 
-typedef QHash<QString, QGeoAreaMonitorInfo> MonitorTable;
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// side of a grid cell in degrees, about a kilometer at the equator
+static const double GRID_CELL_SIZE = 0.01;
+static const int GRID_COLUMNS = 36000;
+static const int GRID_ROWS = 18000;
+
+// areas spanning more cells than this are tested for every position
+static const int MAX_GRID_CELLS = 1024;
 
+static const double EARTH_MEAN_RADIUS = 6371.0072 * 1000.0;
 
 static QMetaMethod areaEnteredSignal()
 {
@@ -70,11 +86,189 @@ static QMetaMethod monitorExpiredSignal()
     return signal;
 }
 
+static int gridColumn(double longitude)
+{
+    return qBound(0, int(std::floor((longitude + 180.0) / GRID_CELL_SIZE)), GRID_COLUMNS - 1);
+}
+
+static int gridRow(double latitude)
+{
+    return qBound(0, int(std::floor((latitude + 90.0) / GRID_CELL_SIZE)), GRID_ROWS - 1);
+}
+
+/*
+ *  A uniform grid over latitude and longitude holding the bounding box of
+ *  every monitored area. Monitors are identified by their slot, so all
+ *  bookkeeping lives in arrays indexed by it.
+ */
+class AreaMonitorGrid
+{
+public:
+    AreaMonitorGrid() {}
+
+    void insert(int slot, const QGeoShape &area)
+    {
+        remove(slot);
+        if (slot >= entries.size())
+            entries.resize(slot + 1);
+
+        Entry &entry = entries[slot];
+        entry.used = true;
+        if (!bounds(area, &entry)) {
+            entry.large = true;
+        } else {
+            const int columns = entry.wraps ? GRID_COLUMNS - entry.left + entry.right + 1
+                                            : entry.right - entry.left + 1;
+            entry.large = qint64(columns) * (entry.top - entry.bottom + 1) > MAX_GRID_CELLS;
+        }
+
+        if (entry.large) {
+            large.append(slot);
+            return;
+        }
+        for (int row = entry.bottom; row <= entry.top; ++row) {
+            if (entry.wraps) {
+                for (int column = entry.left; column < GRID_COLUMNS; ++column)
+                    cells[cellKey(column, row)].append(slot);
+                for (int column = 0; column <= entry.right; ++column)
+                    cells[cellKey(column, row)].append(slot);
+            } else {
+                for (int column = entry.left; column <= entry.right; ++column)
+                    cells[cellKey(column, row)].append(slot);
+            }
+        }
+    }
+
+    void remove(int slot)
+    {
+        if (slot >= entries.size() || !entries.at(slot).used)
+            return;
+
+        Entry &entry = entries[slot];
+        entry.used = false;
+        if (entry.large) {
+            large.removeOne(slot);
+            return;
+        }
+        for (int row = entry.bottom; row <= entry.top; ++row) {
+            if (entry.wraps) {
+                for (int column = entry.left; column < GRID_COLUMNS; ++column)
+                    removeFromCell(cellKey(column, row), slot);
+                for (int column = 0; column <= entry.right; ++column)
+                    removeFromCell(cellKey(column, row), slot);
+            } else {
+                for (int column = entry.left; column <= entry.right; ++column)
+                    removeFromCell(cellKey(column, row), slot);
+            }
+        }
+    }
+
+    // appends the slots whose area may contain coordinate, each once
+    void candidates(const QGeoCoordinate &coordinate, QVector<int> *slots) const
+    {
+        if (!coordinate.isValid())
+            return;
+        const QHash<quint64, QVector<int> >::const_iterator it
+                = cells.constFind(cellKey(gridColumn(coordinate.longitude()),
+                                          gridRow(coordinate.latitude())));
+        if (it != cells.constEnd())
+            *slots += it.value();
+        *slots += large;
+    }
+
+private:
+    struct Entry
+    {
+        Entry() : left(0), right(0), bottom(0), top(0), wraps(false), large(false), used(false) {}
+
+        int left;
+        int right;
+        int bottom;
+        int top;
+        bool wraps;     // crosses the 180th meridian, left > right
+        bool large;
+        bool used;
+    };
+
+    static quint64 cellKey(int column, int row)
+    {
+        return quint64(row) * GRID_COLUMNS + column;
+    }
+
+    void removeFromCell(quint64 key, int slot)
+    {
+        QHash<quint64, QVector<int> >::iterator it = cells.find(key);
+        if (it == cells.end())
+            return;
+        it.value().removeOne(slot);
+        if (it.value().isEmpty())
+            cells.erase(it);
+    }
+
+    // the grid cells around area; false when they cannot be told
+    static bool bounds(const QGeoShape &area, Entry *entry)
+    {
+        double top;
+        double bottom;
+        double left;
+        double right;
+        if (area.type() == QGeoShape::RectangleType) {
+            const QGeoRectangle rectangle(area);
+            top = rectangle.topLeft().latitude();
+            bottom = rectangle.bottomRight().latitude();
+            left = rectangle.topLeft().longitude();
+            right = rectangle.bottomRight().longitude();
+        } else if (area.type() == QGeoShape::CircleType) {
+            const QGeoCircle circle(area);
+            const QGeoCoordinate center = circle.center();
+            // widened a little for the fuzzy compare in QGeoCircle::contains()
+            const double ratio = circle.radius() * (1.0 + 1e-6) / EARTH_MEAN_RADIUS;
+            const double latitudeSpan = ratio * 180.0 / M_PI;
+            top = center.latitude() + latitudeSpan;
+            bottom = center.latitude() - latitudeSpan;
+            if (top >= 90.0 || bottom <= -90.0 || ratio >= M_PI / 2) {
+                // around a pole the circle takes every longitude
+                left = -180.0;
+                right = 180.0;
+            } else {
+                const double cosLatitude = std::cos(center.latitude() * M_PI / 180.0);
+                const double longitudeSpan
+                        = std::asin(qMin(1.0, std::sin(ratio) / cosLatitude)) * 180.0 / M_PI;
+                left = center.longitude() - longitudeSpan;
+                right = center.longitude() + longitudeSpan;
+                if (left < -180.0)
+                    left += 360.0;
+                if (right > 180.0)
+                    right -= 360.0;
+            }
+        } else {
+            return false;
+        }
+
+        // QGeoRectangle::contains() takes any longitude at a pole it touches
+        if (top >= 90.0 || bottom <= -90.0) {
+            left = -180.0;
+            right = 180.0;
+        }
+
+        entry->top = gridRow(top);
+        entry->bottom = gridRow(bottom);
+        entry->left = gridColumn(left);
+        entry->right = gridColumn(right);
+        entry->wraps = left > right;
+        return true;
+    }
+
+    QVector<Entry> entries;
+    QHash<quint64, QVector<int> > cells;
+    QVector<int> large;
+};
+
 class QGeoAreaMonitorPollingPrivate : public QObject
 {
     Q_OBJECT
 public:
-    QGeoAreaMonitorPollingPrivate() : source(0), mutex(QMutex::Recursive)
+    QGeoAreaMonitorPollingPrivate() : source(0), mutex(QMutex::Recursive), scan(0)
     {
         nextExpiryTimer = new QTimer(this);
         nextExpiryTimer->setSingleShot(true);
@@ -86,8 +280,8 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
-        singleShotTrigger.remove(monitor.identifier());
+        const int slot = insertMonitor(monitor);
+        singleShotTrigger[slot] = -1;
 
         checkStartStop();
         setupNextExpiryTimeout();
@@ -97,8 +291,8 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
-        singleShotTrigger.insert(monitor.identifier(), signalId);
+        const int slot = insertMonitor(monitor);
+        singleShotTrigger[slot] = signalId;
 
         checkStartStop();
         setupNextExpiryTimeout();
@@ -108,7 +302,12 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        QGeoAreaMonitorInfo mon = activeMonitorAreas.take(monitor.identifier());
+        const int slot = slotForIdentifier.value(monitor.identifier(), -1);
+        if (slot < 0)
+            return QGeoAreaMonitorInfo();
+
+        QGeoAreaMonitorInfo mon = monitors.at(slot);
+        removeMonitor(slot);
 
         checkStartStop();
         setupNextExpiryTimeout();
@@ -173,11 +372,15 @@ public:
         return source;
     }
 
-    MonitorTable activeMonitors() const
+    QList<QGeoAreaMonitorInfo> activeMonitors() const
     {
         QMutexLocker locker(&mutex);
 
-        return activeMonitorAreas;
+        QList<QGeoAreaMonitorInfo> result;
+        result.reserve(slotForIdentifier.size());
+        foreach (int slot, slotForIdentifier)
+            result.append(monitors.at(slot));
+        return result;
     }
 
     void checkStartStop()
@@ -192,7 +395,7 @@ public:
             }
         }
 
-        if (signalsConnected && !activeMonitorAreas.isEmpty()) {
+        if (signalsConnected && !slotForIdentifier.isEmpty()) {
             if (source)
                 source->startUpdates();
             else
@@ -205,42 +408,69 @@ public:
     }
 
 private:
-    void setupNextExpiryTimeout()
+    //inserts or updates monitor and returns its slot
+    int insertMonitor(const QGeoAreaMonitorInfo &monitor)
     {
-        nextExpiryTimer->stop();
-        activeExpiry.first = QDateTime();
-        activeExpiry.second = QString();
-
-        foreach (const QGeoAreaMonitorInfo &info, activeMonitors()) {
-            if (info.expiration().isValid()) {
-                if (!activeExpiry.first.isValid()) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                    continue;
-                }
-                if (info.expiration() < activeExpiry.first) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                }
+        int slot = slotForIdentifier.value(monitor.identifier(), -1);
+        if (slot < 0) {
+            if (!freeSlots.isEmpty()) {
+                slot = freeSlots.takeLast();
+            } else {
+                slot = monitors.size();
+                monitors.append(QGeoAreaMonitorInfo());
+                singleShotTrigger.append(-1);
+                insideArea.append(false);
+                lastScan.append(0);
             }
+            slotForIdentifier.insert(monitor.identifier(), slot);
+        } else if (monitors.at(slot).expiration().isValid()) {
+            expiries.remove(monitors.at(slot).expiration(), slot);
         }
 
-        if (activeExpiry.first.isValid())
-            nextExpiryTimer->start(QDateTime::currentDateTime().msecsTo(activeExpiry.first));
+        monitors[slot] = monitor;
+        index.insert(slot, monitor.area());
+        if (monitor.expiration().isValid())
+            expiries.insert(monitor.expiration(), slot);
+        return slot;
+    }
+
+    //forgets the monitor in slot, including whether it was entered
+    void removeMonitor(int slot)
+    {
+        const QGeoAreaMonitorInfo &monitor = monitors.at(slot);
+        slotForIdentifier.remove(monitor.identifier());
+        if (monitor.expiration().isValid())
+            expiries.remove(monitor.expiration(), slot);
+        index.remove(slot);
+        if (insideArea.at(slot))
+            insideSlots.removeOne(slot);
+
+        monitors[slot] = QGeoAreaMonitorInfo();
+        singleShotTrigger[slot] = -1;
+        insideArea[slot] = false;
+        freeSlots.append(slot);
+    }
+
+    void setupNextExpiryTimeout()
+    {
+        nextExpiryTimer->stop();
+
+        if (!expiries.isEmpty())
+            nextExpiryTimer->start(QDateTime::currentDateTime().msecsTo(expiries.firstKey()));
     }
 
 
     //returns true if areaEntered should be emitted
-    bool processInsideArea(const QString &monitorIdent)
+    bool processInsideArea(int slot)
     {
-        if (!insideArea.contains(monitorIdent)) {
-            if (singleShotTrigger.value(monitorIdent, -1) == areaEnteredSignal().methodIndex()) {
+        if (!insideArea.at(slot)) {
+            if (singleShotTrigger.at(slot) == areaEnteredSignal().methodIndex()) {
                 //this is the finishing singleshot event
-                singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                removeMonitor(slot);
                 setupNextExpiryTimeout();
             } else {
-                insideArea.insert(monitorIdent);
+                insideArea[slot] = true;
+                insideSlots.append(slot);
             }
             return true;
         }
@@ -249,16 +479,16 @@ private:
     }
 
     //returns true if areaExited should be emitted
-    bool processOutsideArea(const QString &monitorIdent)
+    bool processOutsideArea(int slot)
     {
-        if (insideArea.contains(monitorIdent)) {
-            if (singleShotTrigger.value(monitorIdent, -1) == areaExitedSignal().methodIndex()) {
+        if (insideArea.at(slot)) {
+            if (singleShotTrigger.at(slot) == areaExitedSignal().methodIndex()) {
                 //this is the finishing singleShot event
-                singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                removeMonitor(slot);
                 setupNextExpiryTimeout();
             } else {
-                insideArea.remove(monitorIdent);
+                insideArea[slot] = false;
+                insideSlots.removeOne(slot);
             }
             return true;
         }
@@ -279,37 +509,76 @@ private Q_SLOTS:
          * Don't block timer firing even if monitorExpiredSignal is not connected.
          * This allows us to continue to remove the existing monitors as they expire.
          **/
-        const QGeoAreaMonitorInfo info = activeMonitorAreas.take(activeExpiry.second);
-        setupNextExpiryTimeout();
+        QGeoAreaMonitorInfo info;
+        {
+            QMutexLocker locker(&mutex);
+            if (expiries.isEmpty())
+                return;
+            const int slot = expiries.constBegin().value();
+            info = monitors.at(slot);
+            removeMonitor(slot);
+            setupNextExpiryTimeout();
+        }
         emit timeout(info);
 
     }
 
     void positionUpdated(const QGeoPositionInfo &info)
     {
-        foreach (const QGeoAreaMonitorInfo &monInfo, activeMonitors()) {
-            const QString identifier = monInfo.identifier();
-            if (monInfo.area().contains(info.coordinate())) {
-                if (processInsideArea(identifier))
-                    emit areaEventDetected(monInfo, info, true);
-            } else {
-                if (processOutsideArea(identifier))
-                    emit areaEventDetected(monInfo, info, false);
+        const QGeoCoordinate coordinate = info.coordinate();
+        QVector<QPair<QGeoAreaMonitorInfo, bool> > events;
+        {
+            QMutexLocker locker(&mutex);
+
+            // only monitors whose bounds hold the position can be entered,
+            // and only entered ones can be exited
+            ++scan;
+            QVector<int> slots;
+            index.candidates(coordinate, &slots);
+            foreach (int slot, slots)
+                lastScan[slot] = scan;
+            foreach (int slot, insideSlots) {
+                if (lastScan.at(slot) != scan)
+                    slots.append(slot);
+            }
+            std::sort(slots.begin(), slots.end());
+
+            foreach (int slot, slots) {
+                const QGeoAreaMonitorInfo monInfo = monitors.at(slot);
+                if (monInfo.area().contains(coordinate)) {
+                    if (processInsideArea(slot))
+                        events.append(qMakePair(monInfo, true));
+                } else {
+                    if (processOutsideArea(slot))
+                        events.append(qMakePair(monInfo, false));
+                }
             }
         }
+
+        // emitted unlocked, receivers may start or stop monitors
+        for (int i = 0; i < events.size(); ++i)
+            emit areaEventDetected(events.at(i).first, info, events.at(i).second);
     }
 
 private:
-    QPair<QDateTime, QString> activeExpiry;
-    QHash<QString, int> singleShotTrigger;
+    // per monitor state, indexed by a slot that is reused once the
+    // monitor stops or expires
+    QVector<QGeoAreaMonitorInfo> monitors;
+    QVector<int> singleShotTrigger;     // signal index, -1 if not single shot
+    QVector<bool> insideArea;
+    QVector<quint32> lastScan;          // scan in which the slot was last a candidate
+    QVector<int> freeSlots;
+    QHash<QString, int> slotForIdentifier;
+
+    QVector<int> insideSlots;
+    AreaMonitorGrid index;
+    QMultiMap<QDateTime, int> expiries;
     QTimer* nextExpiryTimer;
-    QSet<QString> insideArea;
-
-    MonitorTable activeMonitorAreas;
 
     QGeoPositionInfoSource* source;
     QList<QGeoAreaMonitorPolling*> registeredClients;
     mutable QMutex mutex;
+    quint32 scan;
 };
 
 Q_GLOBAL_STATIC(QGeoAreaMonitorPollingPrivate, pollingPrivate)
@@ -415,7 +684,7 @@ bool QGeoAreaMonitorPolling::stopMonitoring(const QGeoAreaMonitorInfo &monitor)
 
 QList<QGeoAreaMonitorInfo> QGeoAreaMonitorPolling::activeMonitors() const
 {
-    return d->activeMonitors().values();
+    return d->activeMonitors();
 }
 
 QList<QGeoAreaMonitorInfo> QGeoAreaMonitorPolling::activeMonitors(const QGeoShape &region) const
@@ -424,7 +693,7 @@ QList<QGeoAreaMonitorInfo> QGeoAreaMonitorPolling::activeMonitors(const QGeoShap
     if (region.isEmpty())
         return results;
 
-    const MonitorTable list = d->activeMonitors();
+    const QList<QGeoAreaMonitorInfo> list = d->activeMonitors();
     foreach (const QGeoAreaMonitorInfo &monitor, list) {
         if (region.contains(monitor.area().center()))
             results.append(monitor);
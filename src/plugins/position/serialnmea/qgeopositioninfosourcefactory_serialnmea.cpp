@@ -39,60 +39,119 @@
 
 #include "qgeopositioninfosourcefactory_serialnmea.h"
 #include <QtPositioning/qnmeapositioninfosource.h>
+#include <QtPositioning/private/qnmeapositioninfosource_p.h>
+#include <QtPositioning/private/qnmeasatelliteinfosource_p.h>
 #include <QtSerialPort/qserialport.h>
 #include <QtSerialPort/qserialportinfo.h>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qthread.h>
+#include <QHash>
 #include <QSet>
 
 Q_LOGGING_CATEGORY(lcSerial, "qt.positioning.serialnmea")
 
-class NmeaSource : public QNmeaPositionInfoSource
+static QString nmeaPortName()
+{
+    QByteArray requestedPort = qgetenv("QT_NMEA_SERIAL_PORT");
+    if (!requestedPort.isEmpty())
+        return QString::fromUtf8(requestedPort);
+
+    const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    qCDebug(lcSerial) << "Found" << ports.count() << "serial ports";
+    if (ports.isEmpty()) {
+        qWarning("serialnmea: No serial ports found");
+        return QString();
+    }
+
+    // Try to find a well-known device.
+    QSet<int> supportedDevices;
+    supportedDevices << 0x67b; // GlobalSat (BU-353S4 and probably others)
+    supportedDevices << 0xe8d; // Qstarz MTK II
+    foreach (const QSerialPortInfo& port, ports) {
+        if (port.hasVendorIdentifier() && supportedDevices.contains(port.vendorIdentifier()))
+            return port.portName();
+    }
+
+    qWarning("serialnmea: No known GPS device found. Specify the COM port via QT_NMEA_SERIAL_PORT.");
+    return QString();
+}
+
+/*
+    Reads one serial port for all sources of the plugin. The port is opened
+    by the first source and closed with the last one; in between every
+    sentence is parsed once by the reader's own QNmeaPositionInfoSource,
+    which hands the fixes on to the sources the application uses. All
+    sources of a port have to live in the same thread; sources created for
+    it in another thread are refused.
+*/
+class NmeaReader
 {
 public:
-    NmeaSource(QObject *parent);
-    bool isValid() const { return !m_port.isNull(); }
+    static QSharedPointer<NmeaReader> open(const QString &portName);
+    ~NmeaReader();
+
+    QNmeaPositionInfoSource *source() const { return m_source.data(); }
 
 private:
+    explicit NmeaReader(const QString &portName);
+
+    QString m_portName;
     QScopedPointer<QSerialPort> m_port;
+    QScopedPointer<QNmeaPositionInfoSource> m_source;
 };
 
-NmeaSource::NmeaSource(QObject *parent)
-    : QNmeaPositionInfoSource(RealTimeMode, parent),
-      m_port(new QSerialPort)
+// a reader and the thread that opened it; only that thread may take a
+// strong reference, so the reader is never destroyed in another one
+struct NmeaReaderEntry
 {
-    QByteArray requestedPort = qgetenv("QT_NMEA_SERIAL_PORT");
-    if (requestedPort.isEmpty()) {
-        const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
-        qCDebug(lcSerial) << "Found" << ports.count() << "serial ports";
-        if (ports.isEmpty()) {
-            qWarning("serialnmea: No serial ports found");
-            m_port.reset();
-            return;
-        }
+    NmeaReaderEntry() : thread(0) {}
+    QWeakPointer<NmeaReader> reader;
+    QThread *thread;
+};
 
-        // Try to find a well-known device.
-        QSet<int> supportedDevices;
-        supportedDevices << 0x67b; // GlobalSat (BU-353S4 and probably others)
-        supportedDevices << 0xe8d; // Qstarz MTK II
-        QString portName;
-        foreach (const QSerialPortInfo& port, ports) {
-            if (port.hasVendorIdentifier() && supportedDevices.contains(port.vendorIdentifier())) {
-                portName = port.portName();
-                break;
-            }
-        }
+// the open readers by port name; sources may be created in any thread
+struct NmeaReaderHash
+{
+    QMutex mutex;
+    QHash<QString, NmeaReaderEntry> readers;
+};
+Q_GLOBAL_STATIC(NmeaReaderHash, nmeaReaders)
 
-        if (portName.isEmpty()) {
-            qWarning("serialnmea: No known GPS device found. Specify the COM port via QT_NMEA_SERIAL_PORT.");
-            m_port.reset();
-            return;
+QSharedPointer<NmeaReader> NmeaReader::open(const QString &portName)
+{
+    // declared before the locker, so that a reader dropped on the way out
+    // is destroyed after the mutex is released
+    QSharedPointer<NmeaReader> reader;
+    QMutexLocker locker(&nmeaReaders()->mutex);
+
+    const NmeaReaderEntry entry = nmeaReaders()->readers.value(portName);
+    if (!entry.reader.isNull()) {
+        if (entry.thread != QThread::currentThread()) {
+            qWarning("serialnmea: %s is already in use by another thread", qPrintable(portName));
+            return QSharedPointer<NmeaReader>();
         }
-
-        m_port->setPortName(portName);
-    } else {
-        m_port->setPortName(QString::fromUtf8(requestedPort));
+        reader = entry.reader.toStrongRef();
+        if (reader)
+            return reader;
     }
 
+    reader = QSharedPointer<NmeaReader>(new NmeaReader(portName));
+    if (!reader->m_port)
+        return QSharedPointer<NmeaReader>();
+
+    NmeaReaderEntry &newEntry = nmeaReaders()->readers[portName];
+    newEntry.reader = reader;
+    newEntry.thread = QThread::currentThread();
+    return reader;
+}
+
+NmeaReader::NmeaReader(const QString &portName)
+    : m_portName(portName),
+      m_port(new QSerialPort)
+{
+    m_port->setPortName(portName);
     m_port->setBaudRate(4800);
 
     qCDebug(lcSerial) << "Opening serial port" << m_port->portName();
@@ -103,11 +162,63 @@ NmeaSource::NmeaSource(QObject *parent)
         return;
     }
 
-    setDevice(m_port.data());
+    m_source.reset(new QNmeaPositionInfoSource(QNmeaPositionInfoSource::RealTimeMode));
+    m_source->setDevice(m_port.data());
 
     qCDebug(lcSerial) << "Opened successfully";
 }
 
+NmeaReader::~NmeaReader()
+{
+    // the source goes first, it reads the port
+    m_source.reset();
+    if (nmeaReaders.exists() && m_port) {
+        qCDebug(lcSerial) << "Closing serial port" << m_portName;
+        m_port->close();
+        QMutexLocker locker(&nmeaReaders()->mutex);
+        // another thread may have opened the port again in the meantime
+        if (nmeaReaders()->readers.value(m_portName).reader.isNull())
+            nmeaReaders()->readers.remove(m_portName);
+    }
+}
+
+class NmeaSource : public QNmeaPositionInfoSource
+{
+public:
+    NmeaSource(QObject *parent);
+    bool isValid() const { return !m_reader.isNull(); }
+
+private:
+    QSharedPointer<NmeaReader> m_reader;
+};
+
+NmeaSource::NmeaSource(QObject *parent)
+    : QNmeaPositionInfoSource(RealTimeMode, parent)
+{
+    const QString portName = nmeaPortName();
+    if (portName.isEmpty())
+        return;
+
+    m_reader = NmeaReader::open(portName);
+    if (m_reader)
+        QNmeaPositionInfoSourcePrivate::get(this)->setUpstreamSource(m_reader->source());
+}
+
+class NmeaSatelliteSource : public QNmeaSatelliteInfoSource
+{
+public:
+    NmeaSatelliteSource(const QSharedPointer<NmeaReader> &reader, QObject *parent);
+
+private:
+    QSharedPointer<NmeaReader> m_reader;
+};
+
+NmeaSatelliteSource::NmeaSatelliteSource(const QSharedPointer<NmeaReader> &reader, QObject *parent)
+    : QNmeaSatelliteInfoSource(reader->source(), parent),
+      m_reader(reader)
+{
+}
+
 QGeoPositionInfoSource *QGeoPositionInfoSourceFactorySerialNmea::positionInfoSource(QObject *parent)
 {
     QScopedPointer<NmeaSource> src(new NmeaSource(parent));
@@ -116,8 +227,12 @@ QGeoPositionInfoSource *QGeoPositionInfoSourceFactorySerialNmea::positionInfoSou
 
 QGeoSatelliteInfoSource *QGeoPositionInfoSourceFactorySerialNmea::satelliteInfoSource(QObject *parent)
 {
-    Q_UNUSED(parent);
-    return Q_NULLPTR;
+    const QString portName = nmeaPortName();
+    if (portName.isEmpty())
+        return Q_NULLPTR;
+
+    QSharedPointer<NmeaReader> reader = NmeaReader::open(portName);
+    return reader ? new NmeaSatelliteSource(reader, parent) : Q_NULLPTR;
 }
 
 QGeoAreaMonitorSource *QGeoPositionInfoSourceFactorySerialNmea::areaMonitor(QObject *parent)
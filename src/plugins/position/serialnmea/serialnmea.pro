@@ -1,5 +1,5 @@
 TARGET = qtposition_serialnmea
-QT = core positioning serialport
+QT = core positioning-private serialport
 
 PLUGIN_TYPE = position
 PLUGIN_CLASS_NAME = QGeoPositionInfoSourceFactorySerialNmea
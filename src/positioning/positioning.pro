@@ -40,6 +40,7 @@ PRIVATE_HEADERS += \
                     qgeolocation_p.h \
                     qlocationutils_p.h \
                     qnmeapositioninfosource_p.h \
+                    qnmeasatelliteinfosource_p.h \
                     qgeocoordinate_p.h \
                     qgeopositioninfosource_p.h \
                     qdeclarativegeoaddress_p.h \
@@ -65,6 +66,7 @@ SOURCES += \
             qgeosatelliteinfosource.cpp \
             qlocationutils.cpp \
             qnmeapositioninfosource.cpp \
+            qnmeasatelliteinfosource.cpp \
             qgeopositioninfosourcefactory.cpp \
             qdeclarativegeoaddress.cpp \
             qdeclarativegeolocation.cpp \
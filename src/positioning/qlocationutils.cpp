@@ -42,7 +42,6 @@
 #include "qgeopositioninfo.h"
 
 #include <QTime>
-#include <QList>
 #include <QByteArray>
 #include <QDebug>
 
@@ -50,6 +49,159 @@
 
 QT_BEGIN_NAMESPACE
 
+namespace {
+
+/*
+    A view of one comma separated field of an NMEA sentence. It points into
+    the caller's buffer and is only valid as long as that buffer is.
+*/
+struct QNmeaField
+{
+    const char *data;
+    int size;
+
+    bool isEmpty() const { return size == 0; }
+    char operator[](int i) const { return data[i]; }
+};
+
+/*
+    Splits an NMEA sentence at its commas without copying it. Fields past
+    MaxFields are dropped; none of the sentences parsed here use them.
+*/
+class QNmeaSentence
+{
+public:
+    enum { MaxFields = 24 };
+
+    QNmeaSentence(const char *data, int size)
+        : m_count(0)
+    {
+        int start = 0;
+        for (int i = 0; i <= size && m_count < MaxFields; ++i) {
+            if (i == size || data[i] == ',') {
+                m_fields[m_count].data = data + start;
+                m_fields[m_count].size = i - start;
+                ++m_count;
+                start = i + 1;
+            }
+        }
+    }
+
+    int count() const { return m_count; }
+    const QNmeaField &operator[](int i) const { return m_fields[i]; }
+
+private:
+    QNmeaField m_fields[MaxFields];
+    int m_count;
+};
+
+}
+
+static const double qlocationutils_powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool qlocationutils_isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static int qlocationutils_hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/*
+    Parses a plain decimal number such as "49.4" or "-0.7". Both the
+    mantissa and the power of ten are exact doubles, so the division rounds
+    the same way strtod() does. Anything else (exponents, whitespace, very
+    long mantissas) goes through QByteArray::toDouble().
+*/
+static bool qlocationutils_parseDouble(const char *data, int size, double *value)
+{
+    int i = 0;
+    bool negative = false;
+    if (i < size && (data[i] == '-' || data[i] == '+')) {
+        negative = (data[i] == '-');
+        ++i;
+    }
+
+    quint64 mantissa = 0;
+    int digits = 0;
+    int decimals = 0;
+    bool seenDot = false;
+    for (; i < size; ++i) {
+        const char c = data[i];
+        if (qlocationutils_isDigit(c)) {
+            mantissa = mantissa * 10 + (c - '0');
+            ++digits;
+            if (seenDot)
+                ++decimals;
+        } else if (c == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            break;
+        }
+    }
+
+    if (i == size && digits > 0 && digits <= 15) {
+        double result = double(mantissa) / qlocationutils_powersOfTen[decimals];
+        *value = negative ? -result : result;
+        return true;
+    }
+
+    bool ok = false;
+    double result = QByteArray::fromRawData(data, size).toDouble(&ok);
+    if (ok)
+        *value = result;
+    return ok;
+}
+
+/*
+    Parses a decimal integer, falling back to QByteArray::toInt() for
+    anything but a short run of digits.
+*/
+static bool qlocationutils_parseInt(const char *data, int size, int *value)
+{
+    if (size > 0 && size <= 9) {
+        int result = 0;
+        int i = 0;
+        for (; i < size && qlocationutils_isDigit(data[i]); ++i)
+            result = result * 10 + (data[i] - '0');
+        if (i == size) {
+            *value = result;
+            return true;
+        }
+    }
+
+    bool ok = false;
+    int result = QByteArray::fromRawData(data, size).toInt(&ok);
+    if (ok)
+        *value = result;
+    return ok;
+}
+
+static inline int qlocationutils_twoDigits(const char *data)
+{
+    return (data[0] - '0') * 10 + (data[1] - '0');
+}
+
+static bool qlocationutils_allDigits(const char *data, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        if (!qlocationutils_isDigit(data[i]))
+            return false;
+    }
+    return true;
+}
+
 // converts e.g. 15306.0235 from NMEA sentence to 153.100392
 static double qlocationutils_nmeaDegreesToDecimal(double nmeaDegrees)
 {
@@ -58,42 +210,116 @@ static double qlocationutils_nmeaDegreesToDecimal(double nmeaDegrees)
     return deg + (min / 60.0);
 }
 
+/*
+    Converts an NMEA "dddmm.mmmm" field to decimal degrees. The field is
+    parsed exactly as QByteArray::toDouble() would and then goes through the
+    same conversion as before, so the results are bit for bit the same.
+*/
+static bool qlocationutils_parseNmeaDegrees(const char *data, int size, double *degrees)
+{
+    double value;
+    if (!qlocationutils_parseDouble(data, size, &value))
+        return false;
+    *degrees = qlocationutils_nmeaDegreesToDecimal(value);
+    return true;
+}
+
+static bool qlocationutils_getNmeaTime(const QNmeaField &field, QTime *time)
+{
+    int dotIndex = -1;
+    for (int i = 0; i < field.size; ++i) {
+        if (field[i] == '.') {
+            dotIndex = i;
+            break;
+        }
+    }
+
+    // Same as QTime::fromString(..., "hhmmss"): exactly six digits.
+    const int hmsSize = dotIndex < 0 ? field.size : dotIndex;
+    if (hmsSize != 6 || !qlocationutils_allDigits(field.data, 6))
+        return false;
+
+    const int h = qlocationutils_twoDigits(field.data);
+    const int m = qlocationutils_twoDigits(field.data + 2);
+    const int s = qlocationutils_twoDigits(field.data + 4);
+    if (!QTime::isValid(h, m, s))
+        return false;
+
+    QTime tempTime(h, m, s);
+    if (dotIndex >= 0) {
+        int msecs = 0;
+        const int midLen = qMin(3, field.size - dotIndex - 1);
+        if (qlocationutils_parseInt(field.data + dotIndex + 1, midLen, &msecs) && msecs >= 0)
+            tempTime = tempTime.addMSecs(msecs);
+    }
+
+    *time = tempTime;
+    return true;
+}
+
+static bool qlocationutils_getNmeaLatLong(const QNmeaField &latField, char latDirection,
+                                          const QNmeaField &lngField, char lngDirection,
+                                          double *lat, double *lng)
+{
+    if ((latDirection != 'N' && latDirection != 'S')
+            || (lngDirection != 'E' && lngDirection != 'W')) {
+        return false;
+    }
+
+    double tempLat;
+    double tempLng;
+    if (qlocationutils_parseNmeaDegrees(latField.data, latField.size, &tempLat)
+            && qlocationutils_parseNmeaDegrees(lngField.data, lngField.size, &tempLng)) {
+        if (latDirection == 'S')
+            tempLat *= -1;
+        if (lngDirection == 'W')
+            tempLng *= -1;
+
+        if (QLocationUtils::isValidLat(tempLat) && QLocationUtils::isValidLong(tempLng)) {
+            *lat = tempLat;
+            *lng = tempLng;
+            return true;
+        }
+    }
+    return false;
+}
+
 static void qlocationutils_readGga(const char *data, int size, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    QNmeaSentence parts(data, size);
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
-        *hasFix = parts[6].toInt() > 0;
+    if (hasFix && parts.count() > 6 && !parts[6].isEmpty()) {
+        int quality = 0;
+        qlocationutils_parseInt(parts[6].data, parts[6].size, &quality);
+        *hasFix = quality > 0;
+    }
 
-    if (parts.count() > 1 && parts[1].count() > 0) {
+    if (parts.count() > 1 && !parts[1].isEmpty()) {
         QTime time;
-        if (QLocationUtils::getNmeaTime(parts[1], &time))
+        if (qlocationutils_getNmeaTime(parts[1], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 5 && parts[3].count() == 1 && parts[5].count() == 1) {
+    if (parts.count() > 5 && parts[3].size == 1 && parts[5].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[2], parts[3][0], parts[4], parts[5][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[2], parts[3][0], parts[4], parts[5][0], &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
     if (parts.count() > 8 && !parts[8].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[8].toDouble(&hasHdop);
-        if (hasHdop)
+        double hdop;
+        if (qlocationutils_parseDouble(parts[8].data, parts[8].size, &hdop))
             info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
     }
 
-    if (parts.count() > 9 && parts[9].count() > 0) {
-        bool hasAlt = false;
-        double alt = parts[9].toDouble(&hasAlt);
-        if (hasAlt)
+    if (parts.count() > 9 && !parts[9].isEmpty()) {
+        double alt;
+        if (qlocationutils_parseDouble(parts[9].data, parts[9].size, &alt))
             coord.setAltitude(alt);
     }
 
@@ -104,45 +330,45 @@ static void qlocationutils_readGga(const char *data, int size, QGeoPositionInfo
 static void qlocationutils_readGsa(const char *data, int size, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QList<QByteArray> parts = QByteArray::fromRawData(data, size).split(',');
+    QNmeaSentence parts(data, size);
 
-    if (hasFix && parts.count() > 2 && !parts[2].isEmpty())
-        *hasFix = parts[2].toInt() > 0;
+    if (hasFix && parts.count() > 2 && !parts[2].isEmpty()) {
+        int mode = 0;
+        qlocationutils_parseInt(parts[2].data, parts[2].size, &mode);
+        *hasFix = mode > 0;
+    }
 
     if (parts.count() > 16 && !parts[16].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[16].toDouble(&hasHdop);
-        if (hasHdop)
+        double hdop;
+        if (qlocationutils_parseDouble(parts[16].data, parts[16].size, &hdop))
             info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
     }
 
     if (parts.count() > 17 && !parts[17].isEmpty()) {
-        bool hasVdop = false;
-        double vdop = parts[17].toDouble(&hasVdop);
-        if (hasVdop)
+        double vdop;
+        if (qlocationutils_parseDouble(parts[17].data, parts[17].size, &vdop))
             info->setAttribute(QGeoPositionInfo::VerticalAccuracy, 2 * vdop * uere);
     }
 }
 
 static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    QNmeaSentence parts(data, size);
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
+    if (hasFix && parts.count() > 6 && !parts[6].isEmpty())
         *hasFix = (parts[6][0] == 'A');
 
-    if (parts.count() > 5 && parts[5].count() > 0) {
+    if (parts.count() > 5 && !parts[5].isEmpty()) {
         QTime time;
-        if (QLocationUtils::getNmeaTime(parts[5], &time))
+        if (qlocationutils_getNmeaTime(parts[5], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 4 && parts[2].count() == 1 && parts[4].count() == 1) {
+    if (parts.count() > 4 && parts[2].size == 1 && parts[4].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[1], parts[2][0], parts[3], parts[4][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[1], parts[2][0], parts[3], parts[4][0], &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
@@ -154,51 +380,48 @@ static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo
 
 static void qlocationutils_readRmc(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    QNmeaSentence parts(data, size);
     QGeoCoordinate coord;
     QDate date;
     QTime time;
 
-    if (hasFix && parts.count() > 2 && parts[2].count() > 0)
+    if (hasFix && parts.count() > 2 && !parts[2].isEmpty())
         *hasFix = (parts[2][0] == 'A');
 
-    if (parts.count() > 9 && parts[9].count() == 6) {
-        date = QDate::fromString(QString::fromLatin1(parts[9]), QStringLiteral("ddMMyy"));
-        if (date.isValid())
-            date = date.addYears(100);     // otherwise starts from 1900
-        else
-            date = QDate();
+    if (parts.count() > 9 && parts[9].size == 6 && qlocationutils_allDigits(parts[9].data, 6)) {
+        const int day = qlocationutils_twoDigits(parts[9].data);
+        const int month = qlocationutils_twoDigits(parts[9].data + 2);
+        const int year = qlocationutils_twoDigits(parts[9].data + 4);
+        // A two-digit year is taken as 19yy and then moved on a century, so
+        // validate against 19yy first (e.g. 29 February 1900 does not exist).
+        if (QDate::isValid(1900 + year, month, day))
+            date.setDate(2000 + year, month, day);
     }
 
-    if (parts.count() > 1 && parts[1].count() > 0)
-        QLocationUtils::getNmeaTime(parts[1], &time);
+    if (parts.count() > 1 && !parts[1].isEmpty())
+        qlocationutils_getNmeaTime(parts[1], &time);
 
-    if (parts.count() > 6 && parts[4].count() == 1 && parts[6].count() == 1) {
+    if (parts.count() > 6 && parts[4].size == 1 && parts[6].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[3], parts[4][0], parts[5], parts[6][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[3], parts[4][0], parts[5], parts[6][0], &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 7 && !parts[7].isEmpty()) {
+        if (qlocationutils_parseDouble(parts[7].data, parts[7].size, &value))
             info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value * 1.852 / 3.6));    // knots -> m/s
     }
-    if (parts.count() > 8 && parts[8].count() > 0) {
-        value = parts[8].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 8 && !parts[8].isEmpty()) {
+        if (qlocationutils_parseDouble(parts[8].data, parts[8].size, &value))
             info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
     }
-    if (parts.count() > 11 && parts[11].count() == 1
+    if (parts.count() > 11 && parts[11].size == 1
             && (parts[11][0] == 'E' || parts[11][0] == 'W')) {
-        value = parts[10].toDouble(&parsed);
-        if (parsed) {
+        if (qlocationutils_parseDouble(parts[10].data, parts[10].size, &value)) {
             if (parts[11][0] == 'W')
                 value *= -1;
             info->setAttribute(QGeoPositionInfo::MagneticVariation, qreal(value));
@@ -216,19 +439,15 @@ static void qlocationutils_readVtg(const char *data, int size, QGeoPositionInfo
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    QNmeaSentence parts(data, size);
 
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 1 && parts[1].count() > 0) {
-        value = parts[1].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 1 && !parts[1].isEmpty()) {
+        if (qlocationutils_parseDouble(parts[1].data, parts[1].size, &value))
             info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
     }
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 7 && !parts[7].isEmpty()) {
+        if (qlocationutils_parseDouble(parts[7].data, parts[7].size, &value))
             info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value / 3.6));    // km/h -> m/s
     }
 }
@@ -238,19 +457,21 @@ static void qlocationutils_readZda(const char *data, int size, QGeoPositionInfo
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    QNmeaSentence parts(data, size);
     QDate date;
     QTime time;
 
-    if (parts.count() > 1 && parts[1].count() > 0)
-        QLocationUtils::getNmeaTime(parts[1], &time);
-
-    if (parts.count() > 4 && parts[2].count() > 0 && parts[3].count() > 0
-            && parts[4].count() == 4) {     // must be full 4-digit year
-        int day = parts[2].toUInt();
-        int month = parts[3].toUInt();
-        int year = parts[4].toUInt();
+    if (parts.count() > 1 && !parts[1].isEmpty())
+        qlocationutils_getNmeaTime(parts[1], &time);
+
+    if (parts.count() > 4 && !parts[2].isEmpty() && !parts[3].isEmpty()
+            && parts[4].size == 4) {     // must be full 4-digit year
+        int day = 0;
+        int month = 0;
+        int year = 0;
+        qlocationutils_parseInt(parts[2].data, parts[2].size, &day);
+        qlocationutils_parseInt(parts[3].data, parts[3].size, &month);
+        qlocationutils_parseInt(parts[4].data, parts[4].size, &year);
         if (day > 0 && month > 0 && year > 0)
             date.setDate(year, month, day);
     }
@@ -334,69 +555,108 @@ bool QLocationUtils::hasValidNmeaChecksum(const char *data, int size)
     int result = 0;
     for (int i = 1; i < asteriskIndex; ++i)
         result ^= data[i];
-    /*
-        char calc[CSUM_LEN + 1];
-        ::snprintf(calc, CSUM_LEN + 1, "%02x", result);
-        return ::strncmp(calc, &data[asteriskIndex+1], 2) == 0;
-        */
 
-    QByteArray checkSumBytes(&data[asteriskIndex + 1], 2);
-    bool ok = false;
-    int checksum = checkSumBytes.toInt(&ok,16);
-    return ok && checksum == result;
+    const int high = qlocationutils_hexValue(data[asteriskIndex + 1]);
+    const int low = qlocationutils_hexValue(data[asteriskIndex + 2]);
+    return high >= 0 && low >= 0 && (high << 4 | low) == result;
 }
 
 bool QLocationUtils::getNmeaTime(const QByteArray &bytes, QTime *time)
 {
-    int dotIndex = bytes.indexOf('.');
-    QTime tempTime;
-
-    if (dotIndex < 0) {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.constData()),
-                                     QStringLiteral("hhmmss"));
-    } else {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.mid(0, dotIndex)),
-                                     QStringLiteral("hhmmss"));
-        bool hasMsecs = false;
-        int midLen = qMin(3, bytes.size() - dotIndex - 1);
-        int msecs = bytes.mid(dotIndex + 1, midLen).toUInt(&hasMsecs);
-        if (hasMsecs)
-            tempTime = tempTime.addMSecs(msecs);
+    QNmeaField field = { bytes.constData(), bytes.size() };
+    return qlocationutils_getNmeaTime(field, time);
+}
+
+bool QLocationUtils::getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lng)
+{
+    QNmeaField latField = { latString.constData(), latString.size() };
+    QNmeaField lngField = { lngString.constData(), lngString.size() };
+    return qlocationutils_getNmeaLatLong(latField, latDirection, lngField, lngDirection, lat, lng);
+}
+
+/*
+    Checks that \a data is a "$--xxx" sentence of the given \a type with a
+    valid checksum, and returns its size without the checksum.
+*/
+static int qlocationutils_sentenceSize(const char *data, int size, const char *type)
+{
+    if (size < 6 || data[0] != '$' || data[3] != type[0] || data[4] != type[1]
+            || data[5] != type[2] || !QLocationUtils::hasValidNmeaChecksum(data, size)) {
+        return -1;
     }
 
-    if (tempTime.isValid()) {
-        *time = tempTime;
-        return true;
+    for (int i = 0; i < size; ++i) {
+        if (data[i] == '*')
+            return i;
     }
-    return false;
+    return size;
 }
 
-bool QLocationUtils::getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lng)
+static int qlocationutils_optionalInt(const QNmeaSentence &parts, int index)
 {
-    if ((latDirection != 'N' && latDirection != 'S')
-            || (lngDirection != 'E' && lngDirection != 'W')) {
+    int value = -1;
+    if (index < parts.count() && !parts[index].isEmpty()
+            && !qlocationutils_parseInt(parts[index].data, parts[index].size, &value)) {
+        value = -1;
+    }
+    return value;
+}
+
+bool QLocationUtils::getSatellitesInViewFromNmea(const char *data, int size,
+                                                 NmeaSatellitesInView *satellites)
+{
+    size = qlocationutils_sentenceSize(data, size, "GSV");
+    if (size < 0)
+        return false;
+
+    QNmeaSentence parts(data, size);
+    if (parts.count() < 4)
+        return false;
+
+    satellites->talker[0] = data[1];
+    satellites->talker[1] = data[2];
+    satellites->sentenceCount = qlocationutils_optionalInt(parts, 1);
+    satellites->sentenceNumber = qlocationutils_optionalInt(parts, 2);
+    satellites->satellitesInView = qlocationutils_optionalInt(parts, 3);
+    satellites->count = 0;
+    if (satellites->sentenceCount < 1 || satellites->sentenceNumber < 1
+            || satellites->sentenceNumber > satellites->sentenceCount) {
         return false;
     }
 
-    bool hasLat = false;
-    bool hasLong = false;
-    double tempLat = latString.toDouble(&hasLat);
-    double tempLng = lngString.toDouble(&hasLong);
-    if (hasLat && hasLong) {
-        tempLat = qlocationutils_nmeaDegreesToDecimal(tempLat);
-        if (latDirection == 'S')
-            tempLat *= -1;
-        tempLng = qlocationutils_nmeaDegreesToDecimal(tempLng);
-        if (lngDirection == 'W')
-            tempLng *= -1;
+    // Four fields per satellite; NMEA 4.1 appends a single signal ID field.
+    for (int i = 4; i + 3 < parts.count() && satellites->count < 4; i += 4) {
+        const int identifier = qlocationutils_optionalInt(parts, i);
+        if (identifier <= 0)
+            continue;
+
+        NmeaSatellite &satellite = satellites->satellites[satellites->count++];
+        satellite.identifier = identifier;
+        satellite.elevation = qlocationutils_optionalInt(parts, i + 1);
+        satellite.azimuth = qlocationutils_optionalInt(parts, i + 2);
+        satellite.signalStrength = qlocationutils_optionalInt(parts, i + 3);
+    }
+    return true;
+}
 
-        if (isValidLat(tempLat) && isValidLong(tempLng)) {
-            *lat = tempLat;
-            *lng = tempLng;
-            return true;
-        }
+bool QLocationUtils::getSatellitesInUseFromNmea(const char *data, int size,
+                                                NmeaSatellitesInUse *satellites)
+{
+    size = qlocationutils_sentenceSize(data, size, "GSA");
+    if (size < 0)
+        return false;
+
+    QNmeaSentence parts(data, size);
+
+    satellites->talker[0] = data[1];
+    satellites->talker[1] = data[2];
+    satellites->count = 0;
+    for (int i = 3; i < 15 && i < parts.count(); ++i) {
+        const int identifier = qlocationutils_optionalInt(parts, i);
+        if (identifier > 0)
+            satellites->identifiers[satellites->count++] = identifier;
     }
-    return false;
+    return true;
 }
 
 QT_END_NAMESPACE
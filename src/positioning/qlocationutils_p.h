@@ -111,6 +111,57 @@ public:
         lat-long values. Fails if lat or long fail isValidLat() or isValidLong().
     */
     Q_AUTOTEST_EXPORT static bool getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lon);
+
+    /*
+        One satellite of a GSV sentence. Fields missing from the sentence
+        are -1.
+    */
+    struct NmeaSatellite
+    {
+        int identifier;
+        int elevation;
+        int azimuth;
+        int signalStrength;
+    };
+
+    /*
+        One part of a GSV group: the talker ("GP", "GL", ...), which part
+        of how many this is, and the up to four satellites it lists.
+    */
+    struct NmeaSatellitesInView
+    {
+        char talker[2];
+        int sentenceCount;
+        int sentenceNumber;
+        int satellitesInView;
+        int count;
+        NmeaSatellite satellites[4];
+    };
+
+    /*
+        The identifiers of the satellites used for the fix, from a GSA
+        sentence.
+    */
+    struct NmeaSatellitesInUse
+    {
+        char talker[2];
+        int count;
+        int identifiers[12];
+    };
+
+    /*
+        Reads a GSV sentence with a valid checksum into \a satellites without
+        allocating. Returns false for any other sentence.
+    */
+    Q_AUTOTEST_EXPORT static bool getSatellitesInViewFromNmea(const char *data, int size,
+                                                              NmeaSatellitesInView *satellites);
+
+    /*
+        Reads a GSA sentence with a valid checksum into \a satellites without
+        allocating. Returns false for any other sentence.
+    */
+    Q_AUTOTEST_EXPORT static bool getSatellitesInUseFromNmea(const char *data, int size,
+                                                             NmeaSatellitesInUse *satellites);
 };
 
 QT_END_NAMESPACE
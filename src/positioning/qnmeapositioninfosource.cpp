@@ -39,14 +39,18 @@
 **
 ****************************************************************************/
 #include "qnmeapositioninfosource_p.h"
+#include "qnmeasatelliteinfosource_p.h"
 #include "qlocationutils_p.h"
 
 #include <QIODevice>
+#include <QFileDevice>
 #include <QBasicTimer>
 #include <QTimerEvent>
 #include <QTimer>
 #include <QtCore/QtNumeric>
 
+#include <string.h>
+
 
 QT_BEGIN_NAMESPACE
 
@@ -193,6 +197,155 @@ void QNmeaSimulatedReader::processNextSentence()
 }
 
 
+//============================================================
+
+// Bytes of a file mapped, or read from any other device, per chunk.
+static const int BATCH_CHUNK_SIZE = 16 * 1024 * 1024;
+static const int BATCH_READ_SIZE = 1024 * 1024;
+// Positions collected before positionsUpdated() is emitted.
+static const int BATCH_MAX_UPDATES = 4096;
+// Longer lines cannot be NMEA sentences; buffered partial lines are dropped.
+static const int BATCH_MAX_LINE = 4096;
+
+QNmeaBatchReader::QNmeaBatchReader(QNmeaPositionInfoSourcePrivate *sourcePrivate)
+        : QNmeaReader(sourcePrivate),
+        m_bufferedSize(0),
+        m_chunkTimerId(-1),
+        m_mapFailed(false)
+{
+}
+
+QNmeaBatchReader::~QNmeaBatchReader()
+{
+    if (m_chunkTimerId > 0)
+        killTimer(m_chunkTimerId);
+}
+
+void QNmeaBatchReader::readAvailableData()
+{
+    if (m_chunkTimerId > 0)     // the next chunk is already scheduled
+        return;
+
+    processChunk();
+}
+
+void QNmeaBatchReader::timerEvent(QTimerEvent *event)
+{
+    killTimer(event->timerId());
+    m_chunkTimerId = -1;
+    processChunk();
+}
+
+/*
+    Processes one chunk of the log and, if there is more, schedules the
+    next one from the event loop so that the application can still stop
+    updates or close the device in between.
+*/
+void QNmeaBatchReader::processChunk()
+{
+    QIODevice *device = m_proxy->m_device;
+    if (!device || !device->isOpen() || !m_proxy->wantsUpdates())
+        return;
+
+    QFileDevice *file = qobject_cast<QFileDevice *>(device);
+    if (!file || file->isSequential() || m_bufferedSize > 0 || m_mapFailed
+            || !processMappedChunk(file)) {
+        processBufferedChunk(device);
+    }
+
+    flushUpdates();
+
+    if (m_proxy->m_device && m_proxy->m_device->bytesAvailable() > 0 && m_proxy->wantsUpdates())
+        m_chunkTimerId = startTimer(0);
+}
+
+bool QNmeaBatchReader::processMappedChunk(QFileDevice *file)
+{
+    const qint64 offset = file->pos();
+    const qint64 remaining = file->size() - offset;
+    if (remaining <= 0)
+        return true;
+
+    const int size = int(qMin<qint64>(remaining, BATCH_CHUNK_SIZE));
+    uchar *data = file->map(offset, size);
+    if (!data) {
+        m_mapFailed = true;
+        return false;
+    }
+
+    int consumed = processLines(reinterpret_cast<const char *>(data), size, size == remaining);
+    if (consumed == 0 && m_proxy->wantsUpdates())
+        consumed = size;    // no line break in a whole chunk, this is not NMEA
+    file->unmap(data);
+    file->seek(offset + consumed);
+    return true;
+}
+
+void QNmeaBatchReader::processBufferedChunk(QIODevice *device)
+{
+    if (m_buffer.size() < m_bufferedSize + BATCH_READ_SIZE)
+        m_buffer.resize(m_bufferedSize + BATCH_READ_SIZE);
+
+    const qint64 read = device->read(m_buffer.data() + m_bufferedSize, BATCH_READ_SIZE);
+    if (read <= 0)
+        return;
+
+    const int size = m_bufferedSize + int(read);
+    const bool atEnd = !device->isSequential() && device->atEnd();
+    const int consumed = processLines(m_buffer.constData(), size, atEnd);
+
+    // Unless updates were stopped part way, what is left is one partial line.
+    m_bufferedSize = size - consumed;
+    if (m_bufferedSize > BATCH_MAX_LINE && m_proxy->wantsUpdates())
+        m_bufferedSize = 0;
+    else if (m_bufferedSize > 0)
+        ::memmove(m_buffer.data(), m_buffer.constData() + consumed, m_bufferedSize);
+}
+
+/*
+    Parses the complete lines in \a data, and the trailing partial line too
+    if \a atEnd is true. Returns the number of bytes consumed, which stops
+    short of the end when updates were stopped from a slot.
+*/
+int QNmeaBatchReader::processLines(const char *data, int size, bool atEnd)
+{
+    int start = 0;
+    while (start < size) {
+        const char *newline = static_cast<const char *>(::memchr(data + start, '\n', size - start));
+        if (!newline && !atEnd)
+            break;
+
+        const int end = newline ? int(newline - data) + 1 : size;
+        QGeoPositionInfo update;
+        bool hasFix = false;
+        if (m_proxy->parsePosInfoFromNmeaData(data + start, end - start, &update, &hasFix)) {
+            m_proxy->mergeUpdate(&update);
+            if (hasFix && update.isValid())
+                m_updates.append(update);
+        }
+        start = end;
+
+        if (m_updates.size() >= BATCH_MAX_UPDATES) {
+            flushUpdates();
+            if (!m_proxy->wantsUpdates())
+                break;
+        }
+    }
+    return start;
+}
+
+void QNmeaBatchReader::flushUpdates()
+{
+    if (m_updates.isEmpty())
+        return;
+
+    QList<QGeoPositionInfo> updates;
+    updates.swap(m_updates);
+    m_updates.reserve(updates.size());
+    m_proxy->notifyNewUpdates(updates);
+}
+
+
 //============================================================
 
 
@@ -217,6 +370,8 @@ QNmeaPositionInfoSourcePrivate::QNmeaPositionInfoSourcePrivate(QNmeaPositionInfo
 
 QNmeaPositionInfoSourcePrivate::~QNmeaPositionInfoSourcePrivate()
 {
+    if (m_upstream)
+        m_upstream->d->m_downstream.removeOne(this);
     delete m_nmeaReader;
     delete m_updateTimer;
 }
@@ -257,11 +412,16 @@ bool QNmeaPositionInfoSourcePrivate::initialize()
     if (m_nmeaReader)
         return true;
 
+    if (m_upstream)
+        return m_upstream->d->startReading();
+
     if (!openSourceDevice())
         return false;
 
     if (m_updateMode == QNmeaPositionInfoSource::RealTimeMode)
         m_nmeaReader = new QNmeaRealTimeReader(this);
+    else if (m_updateMode == QNmeaPositionInfoSource::BatchMode)
+        m_nmeaReader = new QNmeaBatchReader(this);
     else
         m_nmeaReader = new QNmeaSimulatedReader(this);
 
@@ -270,8 +430,13 @@ bool QNmeaPositionInfoSourcePrivate::initialize()
 
 void QNmeaPositionInfoSourcePrivate::prepareSourceDevice()
 {
+    // sources fed by an upstream source have no device of their own
+    if (!m_nmeaReader)
+        return;
+
     // some data may already be available
-    if (m_updateMode == QNmeaPositionInfoSource::SimulationMode) {
+    if (m_updateMode == QNmeaPositionInfoSource::SimulationMode
+            || m_updateMode == QNmeaPositionInfoSource::BatchMode) {
         if (m_nmeaReader && m_device->bytesAvailable())
             m_nmeaReader->readAvailableData();
     }
@@ -285,9 +450,54 @@ void QNmeaPositionInfoSourcePrivate::prepareSourceDevice()
 bool QNmeaPositionInfoSourcePrivate::parsePosInfoFromNmeaData(const char *data, int size,
         QGeoPositionInfo *posInfo, bool *hasFix)
 {
+    // every sentence read passes here, satellite sources take theirs first
+    foreach (QNmeaSatelliteInfoSource *satelliteSource, m_satelliteSources)
+        satelliteSource->parseNmeaSentence(data, size);
+
     return m_source->parsePosInfoFromNmeaData(data, size, posInfo, hasFix);
 }
 
+void QNmeaPositionInfoSourcePrivate::addSatelliteSource(QNmeaSatelliteInfoSource *source)
+{
+    m_satelliteSources.append(source);
+}
+
+void QNmeaPositionInfoSourcePrivate::removeSatelliteSource(QNmeaSatelliteInfoSource *source)
+{
+    m_satelliteSources.removeOne(source);
+}
+
+/*
+    Makes this source take its positions from \a upstream instead of reading
+    a device. \a upstream parses every sentence once and hands each fix on,
+    to be delivered according to this source's own update interval and
+    requests.
+*/
+void QNmeaPositionInfoSourcePrivate::setUpstreamSource(QNmeaPositionInfoSource *upstream)
+{
+    if (m_upstream)
+        m_upstream->d->m_downstream.removeOne(this);
+
+    m_upstream = upstream;
+    if (m_upstream) {
+        m_upstream->d->m_downstream.append(this);
+        m_lastUpdate = m_upstream->d->m_lastUpdate;
+    }
+}
+
+/*
+    Starts reading the device for satellite and downstream sources without
+    delivering positions.
+*/
+bool QNmeaPositionInfoSourcePrivate::startReading()
+{
+    if (!initialize())
+        return false;
+
+    prepareSourceDevice();
+    return true;
+}
+
 void QNmeaPositionInfoSourcePrivate::startUpdates()
 {
     if (m_invokedStart)
@@ -301,7 +511,7 @@ void QNmeaPositionInfoSourcePrivate::startUpdates()
     if (!initialized)
         return;
 
-    if (m_updateMode == QNmeaPositionInfoSource::RealTimeMode) {
+    if (m_updateMode == QNmeaPositionInfoSource::RealTimeMode && m_nmeaReader) {
         // skip over any buffered data - we only want the newest data
         if (m_device->bytesAvailable()) {
             if (m_device->isSequential())
@@ -314,7 +524,8 @@ void QNmeaPositionInfoSourcePrivate::startUpdates()
     if (m_updateTimer)
         m_updateTimer->stop();
 
-    if (m_source->updateInterval() > 0) {
+    // batches are delivered as fast as they are read, timestamps are ignored
+    if (m_source->updateInterval() > 0 && m_updateMode != QNmeaPositionInfoSource::BatchMode) {
         if (!m_updateTimer)
             m_updateTimer = new QBasicTimer;
         m_updateTimer->start(m_source->updateInterval(), this);
@@ -366,11 +577,13 @@ void QNmeaPositionInfoSourcePrivate::updateRequestTimeout()
     emit m_source->updateTimeout();
 }
 
-void QNmeaPositionInfoSourcePrivate::notifyNewUpdate(QGeoPositionInfo *update, bool hasFix)
+/*
+    Completes \a update with what earlier sentences reported: the date for
+    sentences that only carry a time, and the accuracy for sentences that
+    do not report it.
+*/
+void QNmeaPositionInfoSourcePrivate::mergeUpdate(QGeoPositionInfo *update)
 {
-    // include <QDebug> before uncommenting
-    //qDebug() << "QNmeaPositionInfoSourcePrivate::notifyNewUpdate()" << update->timestamp() << hasFix << m_invokedStart << (m_requestTimer && m_requestTimer->isActive());
-
     QDate date = update->timestamp().date();
     if (date.isValid()) {
         m_currentDate = date;
@@ -391,6 +604,14 @@ void QNmeaPositionInfoSourcePrivate::notifyNewUpdate(QGeoPositionInfo *update, b
         m_verticalAccuracy = update->attribute(QGeoPositionInfo::VerticalAccuracy);
     else if (!qIsNaN(m_verticalAccuracy))
         update->setAttribute(QGeoPositionInfo::VerticalAccuracy, m_verticalAccuracy);
+}
+
+void QNmeaPositionInfoSourcePrivate::notifyNewUpdate(QGeoPositionInfo *update, bool hasFix)
+{
+    // include <QDebug> before uncommenting
+    //qDebug() << "QNmeaPositionInfoSourcePrivate::notifyNewUpdate()" << update->timestamp() << hasFix << m_invokedStart << (m_requestTimer && m_requestTimer->isActive());
+
+    mergeUpdate(update);
 
     if (hasFix && update->isValid()) {
         if (m_requestTimer && m_requestTimer->isActive()) {
@@ -409,7 +630,52 @@ void QNmeaPositionInfoSourcePrivate::notifyNewUpdate(QGeoPositionInfo *update, b
             }
         }
         m_lastUpdate = *update;
+
+        foreach (QNmeaPositionInfoSourcePrivate *downstream, m_downstream) {
+            QGeoPositionInfo downstreamUpdate(*update);
+            downstream->notifyNewUpdate(&downstreamUpdate, hasFix);
+        }
+    }
+}
+
+/*
+    Delivers positions read in BatchMode, which have already been completed
+    with mergeUpdate() and all have a fix. A pending requestUpdate() is
+    answered with the first of them.
+*/
+void QNmeaPositionInfoSourcePrivate::notifyNewUpdates(const QList<QGeoPositionInfo> &updates)
+{
+    if (m_requestTimer && m_requestTimer->isActive()) {
+        m_requestTimer->stop();
+        emitUpdated(updates.first());
+    }
+
+    m_lastUpdate = updates.last();
+    if (m_invokedStart) {
+        emit m_source->positionsUpdated(updates);
+        // positionsUpdated() may have stopped updates
+        if (m_invokedStart)
+            emitUpdated(updates.last());
+    }
+
+    foreach (QNmeaPositionInfoSourcePrivate *downstream, m_downstream)
+        downstream->notifyNewUpdates(updates);
+}
+
+bool QNmeaPositionInfoSourcePrivate::wantsUpdates() const
+{
+    if (m_invokedStart || (m_requestTimer && m_requestTimer->isActive()))
+        return true;
+
+    foreach (QNmeaSatelliteInfoSource *satelliteSource, m_satelliteSources) {
+        if (satelliteSource->wantsUpdates())
+            return true;
     }
+    foreach (QNmeaPositionInfoSourcePrivate *downstream, m_downstream) {
+        if (downstream->wantsUpdates())
+            return true;
+    }
+    return false;
 }
 
 void QNmeaPositionInfoSourcePrivate::timerEvent(QTimerEvent *)
@@ -455,10 +721,11 @@ void QNmeaPositionInfoSourcePrivate::emitUpdated(const QGeoPositionInfo &update)
     data and uses it to provide positional data in the form of
     QGeoPositionInfo objects.
 
-    A QNmeaPositionInfoSource instance operates in either \l {RealTimeMode} or
-    \l {SimulationMode}. These modes allow NMEA data to be read from either a
-    live source of positional data, or replayed for simulation purposes from
-    previously recorded NMEA data.
+    A QNmeaPositionInfoSource instance operates in \l {RealTimeMode},
+    \l {SimulationMode} or \l {BatchMode}. These modes allow NMEA data to be
+    read from either a live source of positional data, replayed for simulation
+    purposes from previously recorded NMEA data, or processed from a recording
+    as fast as possible.
 
     The source of NMEA data is set with setDevice().
 
@@ -481,6 +748,19 @@ void QNmeaPositionInfoSourcePrivate::emitUpdated(const QGeoPositionInfo &update)
 
     \value RealTimeMode Positional data is read and distributed from the data source as it becomes available. Use this mode if you are using a live source of positional data (for example, a GPS hardware device).
     \value SimulationMode The data and time information in the NMEA source data is used to provide positional updates at the rate at which the data was originally recorded. Use this mode if the data source contains previously recorded NMEA data and you want to replay the data for simulation purposes.
+    \value BatchMode The data source is read in large chunks, memory-mapped if it is a file, and its timestamps are ignored. Positions are delivered in batches through positionsUpdated() as fast as they can be parsed, and the update interval has no effect. Use this mode to process recorded NMEA data offline, for example in regression tests. This value was introduced in Qt 5.7.
+*/
+
+/*!
+    \fn void QNmeaPositionInfoSource::positionsUpdated(const QList<QGeoPositionInfo> &updates)
+    \since 5.7
+
+    This signal is emitted in \l {BatchMode} with the \a updates read from
+    the next part of the data source, in the order in which they were
+    recorded. As in the other modes, the date and the accuracy reported by
+    earlier sentences are carried over to sentences which lack them.
+
+    positionUpdated() follows each batch with its last position.
 */
 
 
@@ -52,7 +52,8 @@ class Q_POSITIONING_EXPORT QNmeaPositionInfoSource : public QGeoPositionInfoSour
 public:
     enum UpdateMode {
         RealTimeMode = 1,
-        SimulationMode
+        SimulationMode,
+        BatchMode
     };
 
     explicit QNmeaPositionInfoSource(UpdateMode updateMode, QObject *parent = 0);
@@ -79,6 +80,9 @@ public Q_SLOTS:
     void stopUpdates();
     void requestUpdate(int timeout = 0);
 
+Q_SIGNALS:
+    void positionsUpdated(const QList<QGeoPositionInfo> &updates);
+
 protected:
     virtual bool parsePosInfoFromNmeaData(const char *data,
                                           int size,
@@ -88,6 +92,7 @@ protected:
 private:
     Q_DISABLE_COPY(QNmeaPositionInfoSource)
     friend class QNmeaPositionInfoSourcePrivate;
+    friend class QNmeaSatelliteInfoSource;
     QNmeaPositionInfoSourcePrivate *d;
     void setError(QGeoPositionInfoSource::Error positionError);
 };
@@ -50,6 +50,7 @@
 // We mean it.
 //
 
+#include "qpositioningglobal_p.h"
 #include "qnmeapositioninfosource.h"
 #include "qgeopositioninfo.h"
 
@@ -62,8 +63,10 @@ QT_BEGIN_NAMESPACE
 class QBasicTimer;
 class QTimerEvent;
 class QTimer;
+class QFileDevice;
 
 class QNmeaReader;
+class QNmeaSatelliteInfoSource;
 struct QPendingGeoPositionInfo
 {
     QGeoPositionInfo info;
@@ -71,13 +74,17 @@ struct QPendingGeoPositionInfo
 };
 
 
-class QNmeaPositionInfoSourcePrivate : public QObject
+class Q_POSITIONING_PRIVATE_EXPORT QNmeaPositionInfoSourcePrivate : public QObject
 {
     Q_OBJECT
 public:
     QNmeaPositionInfoSourcePrivate(QNmeaPositionInfoSource *parent, QNmeaPositionInfoSource::UpdateMode updateMode);
     ~QNmeaPositionInfoSourcePrivate();
 
+    static QNmeaPositionInfoSourcePrivate *get(QNmeaPositionInfoSource *source) { return source->d; }
+
+    void setUpstreamSource(QNmeaPositionInfoSource *upstream);
+
     void startUpdates();
     void stopUpdates();
     void requestUpdate(int msec);
@@ -87,7 +94,14 @@ public:
                                   QGeoPositionInfo *posInfo,
                                   bool *hasFix);
 
+    void mergeUpdate(QGeoPositionInfo *update);
     void notifyNewUpdate(QGeoPositionInfo *update, bool fixStatus);
+    void notifyNewUpdates(const QList<QGeoPositionInfo> &updates);
+    bool wantsUpdates() const;
+
+    void addSatelliteSource(QNmeaSatelliteInfoSource *source);
+    void removeSatelliteSource(QNmeaSatelliteInfoSource *source);
+    bool startReading();
 
     QNmeaPositionInfoSource::UpdateMode m_updateMode;
     QPointer<QIODevice> m_device;
@@ -124,6 +138,9 @@ private:
     bool m_noUpdateLastInterval;
     bool m_updateTimeoutSent;
     bool m_connectedReadyRead;
+    QList<QNmeaSatelliteInfoSource *> m_satelliteSources;
+    QPointer<QNmeaPositionInfoSource> m_upstream;
+    QList<QNmeaPositionInfoSourcePrivate *> m_downstream;
 };
 
 
@@ -172,6 +189,32 @@ private:
     bool m_hasValidDateTime;
 };
 
+
+class QNmeaBatchReader : public QObject, public QNmeaReader
+{
+    Q_OBJECT
+public:
+    explicit QNmeaBatchReader(QNmeaPositionInfoSourcePrivate *sourcePrivate);
+    ~QNmeaBatchReader();
+    virtual void readAvailableData();
+
+protected:
+    virtual void timerEvent(QTimerEvent *event);
+
+private:
+    void processChunk();
+    bool processMappedChunk(QFileDevice *file);
+    void processBufferedChunk(QIODevice *device);
+    int processLines(const char *data, int size, bool atEnd);
+    void flushUpdates();
+
+    QList<QGeoPositionInfo> m_updates;
+    QByteArray m_buffer;
+    int m_bufferedSize;
+    int m_chunkTimerId;
+    bool m_mapFailed;
+};
+
 QT_END_NAMESPACE
 
 #endif
@@ -0,0 +1,399 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 Jolla Ltd.
+** Contact: Aaron McCarthy <aaron.mccarthy@jollamobile.com>
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtPositioning module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+#include "qnmeasatelliteinfosource_p.h"
+#include "qnmeapositioninfosource_p.h"
+
+#include <QtCore/QTimer>
+#include <QtCore/QTimerEvent>
+
+QT_BEGIN_NAMESPACE
+
+static QGeoSatelliteInfo::SatelliteSystem qnmeasatellite_system(const char *talker, int identifier)
+{
+    if (talker[0] == 'G' && talker[1] == 'P')
+        return QGeoSatelliteInfo::GPS;
+    if (talker[0] == 'G' && talker[1] == 'L')
+        return QGeoSatelliteInfo::GLONASS;
+
+    // combined talkers such as "GN" number GLONASS satellites from 65
+    if (identifier >= 1 && identifier <= 32)
+        return QGeoSatelliteInfo::GPS;
+    if (identifier >= 65 && identifier <= 96)
+        return QGeoSatelliteInfo::GLONASS;
+    return QGeoSatelliteInfo::Undefined;
+}
+
+static QGeoSatelliteInfo qnmeasatellite_info(QGeoSatelliteInfo::SatelliteSystem system,
+                                             const QLocationUtils::NmeaSatellite &satellite)
+{
+    QGeoSatelliteInfo info;
+    info.setSatelliteSystem(system);
+    info.setSatelliteIdentifier(satellite.identifier);
+    info.setSignalStrength(satellite.signalStrength);
+    if (satellite.elevation >= 0)
+        info.setAttribute(QGeoSatelliteInfo::Elevation, satellite.elevation);
+    if (satellite.azimuth >= 0)
+        info.setAttribute(QGeoSatelliteInfo::Azimuth, satellite.azimuth);
+    return info;
+}
+
+/*!
+    \class QNmeaSatelliteInfoSource
+    \inmodule QtPositioning
+    \internal
+
+    \brief The QNmeaSatelliteInfoSource class provides satellite information
+    from the NMEA data read by a QNmeaPositionInfoSource.
+
+    The source does not read the device itself. The position source passes
+    it every sentence it reads, so a stream is read and split into fields
+    only once. Satellites in view are taken from GSV sentences, kept per
+    talker and reported once all parts of a group have arrived. Satellites
+    in use are taken from the GSA sentences of the current fix; receivers
+    tracking several systems send one GSA per system in a row.
+
+    Assembling the groups does not allocate; the lists are only built when
+    a group or a fix is complete.
+*/
+
+/*!
+    Constructs a satellite source that reports the satellites described by
+    the NMEA data of \a positionSource, with the given \a parent.
+*/
+QNmeaSatelliteInfoSource::QNmeaSatelliteInfoSource(QNmeaPositionInfoSource *positionSource,
+                                                   QObject *parent)
+    : QGeoSatelliteInfoSource(parent),
+      m_positionSource(positionSource),
+      m_talkerCount(0),
+      m_inUseCount(0),
+      m_lastWasInUse(false),
+      m_inViewPending(false),
+      m_inUsePending(false),
+      m_requestTimer(0),
+      m_running(false),
+      m_error(QGeoSatelliteInfoSource::NoError)
+{
+    if (m_positionSource)
+        m_positionSource->d->addSatelliteSource(this);
+}
+
+QNmeaSatelliteInfoSource::~QNmeaSatelliteInfoSource()
+{
+    if (m_positionSource)
+        m_positionSource->d->removeSatelliteSource(this);
+}
+
+/*!
+    Returns the position source whose data this source reports on.
+*/
+QNmeaPositionInfoSource *QNmeaSatelliteInfoSource::positionSource() const
+{
+    return m_positionSource;
+}
+
+void QNmeaSatelliteInfoSource::setUpdateInterval(int msec)
+{
+    int interval = msec;
+    if (interval != 0)
+        interval = qMax(msec, minimumUpdateInterval());
+    QGeoSatelliteInfoSource::setUpdateInterval(interval);
+
+    if (m_running) {
+        if (interval > 0)
+            m_updateTimer.start(interval, this);
+        else
+            m_updateTimer.stop();
+    }
+}
+
+int QNmeaSatelliteInfoSource::minimumUpdateInterval() const
+{
+    return 100;
+}
+
+QGeoSatelliteInfoSource::Error QNmeaSatelliteInfoSource::error() const
+{
+    return m_error;
+}
+
+void QNmeaSatelliteInfoSource::startUpdates()
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    if (updateInterval() > 0)
+        m_updateTimer.start(updateInterval(), this);
+
+    if (!startReading())
+        stopUpdates();
+}
+
+void QNmeaSatelliteInfoSource::stopUpdates()
+{
+    m_running = false;
+    m_updateTimer.stop();
+    m_inViewPending = false;
+    m_inUsePending = false;
+}
+
+void QNmeaSatelliteInfoSource::requestUpdate(int timeout)
+{
+    if (m_requestTimer && m_requestTimer->isActive())
+        return;
+
+    if (timeout == 0)
+        timeout = 60000 * 5;
+    if (timeout < minimumUpdateInterval()) {
+        emit requestTimeout();
+        return;
+    }
+
+    if (!m_requestTimer) {
+        m_requestTimer = new QTimer(this);
+        m_requestTimer->setSingleShot(true);
+        connect(m_requestTimer, SIGNAL(timeout()), SLOT(updateRequestTimeout()));
+    }
+
+    // started first, reading may complete a group right away
+    m_requestTimer->start(timeout);
+    if (!startReading() && m_requestTimer->isActive()) {
+        m_requestTimer->stop();
+        emit requestTimeout();
+    }
+}
+
+void QNmeaSatelliteInfoSource::updateRequestTimeout()
+{
+    emit requestTimeout();
+}
+
+bool QNmeaSatelliteInfoSource::wantsUpdates() const
+{
+    return m_running || (m_requestTimer && m_requestTimer->isActive());
+}
+
+void QNmeaSatelliteInfoSource::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_updateTimer.timerId())
+        emitPendingUpdates();
+    else
+        QGeoSatelliteInfoSource::timerEvent(event);
+}
+
+bool QNmeaSatelliteInfoSource::startReading()
+{
+    if (!m_positionSource) {
+        setError(QGeoSatelliteInfoSource::ClosedError);
+        return false;
+    }
+    if (!m_positionSource->d->startReading()) {
+        setError(QGeoSatelliteInfoSource::AccessError);
+        return false;
+    }
+    return true;
+}
+
+void QNmeaSatelliteInfoSource::setError(QGeoSatelliteInfoSource::Error error)
+{
+    m_error = error;
+    emit QGeoSatelliteInfoSource::error(error);
+}
+
+/*!
+    Takes the satellite information from the NMEA sentence of \a size bytes
+    at \a data. Sentences other than GSV and GSA only end a run of GSA
+    sentences.
+*/
+void QNmeaSatelliteInfoSource::parseNmeaSentence(const char *data, int size)
+{
+    const bool isSatellites = size >= 6 && data[3] == 'G' && data[4] == 'S';
+    if (isSatellites && data[5] == 'A') {
+        QLocationUtils::NmeaSatellitesInUse sentence;
+        if (QLocationUtils::getSatellitesInUseFromNmea(data, size, &sentence)) {
+            addSatellitesInUse(sentence);
+            m_lastWasInUse = true;
+            return;
+        }
+    }
+
+    // a fix has one GSA per satellite system, so the satellites in use are
+    // only complete once a sentence of another kind ends the run
+    if (m_lastWasInUse) {
+        m_lastWasInUse = false;
+        satellitesInUseChanged();
+    }
+
+    if (isSatellites && data[5] == 'V') {
+        QLocationUtils::NmeaSatellitesInView sentence;
+        if (QLocationUtils::getSatellitesInViewFromNmea(data, size, &sentence))
+            addSatellitesInView(sentence);
+    }
+}
+
+QNmeaSatelliteInfoSource::TalkerGroup *QNmeaSatelliteInfoSource::talkerGroup(const char *talker)
+{
+    for (int i = 0; i < m_talkerCount; ++i) {
+        if (m_talkers[i].talker[0] == talker[0] && m_talkers[i].talker[1] == talker[1])
+            return &m_talkers[i];
+    }
+
+    if (m_talkerCount == MaxTalkers)
+        return 0;
+
+    TalkerGroup *group = &m_talkers[m_talkerCount++];
+    group->talker[0] = talker[0];
+    group->talker[1] = talker[1];
+    group->sentenceCount = 0;
+    group->nextSentence = 0;
+    group->pendingCount = 0;
+    group->count = 0;
+    return group;
+}
+
+void QNmeaSatelliteInfoSource::addSatellitesInView(const QLocationUtils::NmeaSatellitesInView &sentence)
+{
+    TalkerGroup *group = talkerGroup(sentence.talker);
+    if (!group)
+        return;
+
+    if (sentence.sentenceNumber == 1) {
+        group->sentenceCount = sentence.sentenceCount;
+        group->nextSentence = 1;
+        group->pendingCount = 0;
+    }
+
+    if (sentence.sentenceNumber != group->nextSentence
+            || sentence.sentenceCount != group->sentenceCount) {
+        // a part is missing, wait for the start of the next group
+        group->nextSentence = 0;
+        return;
+    }
+
+    for (int i = 0; i < sentence.count && group->pendingCount < MaxSatellitesPerTalker; ++i)
+        group->pending[group->pendingCount++] = sentence.satellites[i];
+    ++group->nextSentence;
+
+    if (sentence.sentenceNumber == sentence.sentenceCount) {
+        for (int i = 0; i < group->pendingCount; ++i)
+            group->satellites[i] = group->pending[i];
+        group->count = group->pendingCount;
+        group->nextSentence = 0;
+        satellitesInViewChanged();
+    }
+}
+
+void QNmeaSatelliteInfoSource::addSatellitesInUse(const QLocationUtils::NmeaSatellitesInUse &sentence)
+{
+    // the first GSA of a fix replaces the satellites of the previous one
+    if (!m_lastWasInUse)
+        m_inUseCount = 0;
+
+    for (int i = 0; i < sentence.count && m_inUseCount < MaxSatellitesInUse; ++i) {
+        SatelliteInUse &satellite = m_inUse[m_inUseCount++];
+        satellite.identifier = sentence.identifiers[i];
+        satellite.system = qnmeasatellite_system(sentence.talker, satellite.identifier);
+    }
+}
+
+void QNmeaSatelliteInfoSource::satellitesInViewChanged()
+{
+    m_satellitesInView.clear();
+    for (int i = 0; i < m_talkerCount; ++i) {
+        const TalkerGroup &group = m_talkers[i];
+        for (int j = 0; j < group.count; ++j) {
+            const QLocationUtils::NmeaSatellite &satellite = group.satellites[j];
+            m_satellitesInView.append(qnmeasatellite_info(
+                    qnmeasatellite_system(group.talker, satellite.identifier), satellite));
+        }
+    }
+    m_inViewPending = true;
+
+    if (m_requestTimer && m_requestTimer->isActive()) {
+        m_requestTimer->stop();
+        emit satellitesInViewUpdated(m_satellitesInView);
+        emit satellitesInUseUpdated(m_satellitesInUse);
+        if (!m_running) {
+            m_inViewPending = false;
+            m_inUsePending = false;
+        }
+        return;
+    }
+
+    if (m_running && !m_updateTimer.isActive())
+        emitPendingUpdates();
+}
+
+void QNmeaSatelliteInfoSource::satellitesInUseChanged()
+{
+    m_satellitesInUse.clear();
+    for (int i = 0; i < m_inUseCount; ++i) {
+        const SatelliteInUse &inUse = m_inUse[i];
+        QGeoSatelliteInfo info;
+        info.setSatelliteSystem(inUse.system);
+        info.setSatelliteIdentifier(inUse.identifier);
+
+        // complete it from the satellites in view if possible
+        foreach (const QGeoSatelliteInfo &inView, m_satellitesInView) {
+            if (inView.satelliteIdentifier() == inUse.identifier
+                    && inView.satelliteSystem() == inUse.system) {
+                info = inView;
+                break;
+            }
+        }
+        m_satellitesInUse.append(info);
+    }
+    m_inUsePending = true;
+
+    if (m_running && !m_updateTimer.isActive())
+        emitPendingUpdates();
+}
+
+void QNmeaSatelliteInfoSource::emitPendingUpdates()
+{
+    if (m_inViewPending) {
+        m_inViewPending = false;
+        emit satellitesInViewUpdated(m_satellitesInView);
+    }
+    if (m_inUsePending) {
+        m_inUsePending = false;
+        emit satellitesInUseUpdated(m_satellitesInUse);
+    }
+}
+
+#include "moc_qnmeasatelliteinfosource_p.cpp"
+
+QT_END_NAMESPACE
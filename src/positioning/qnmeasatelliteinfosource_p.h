@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the QtPositioning module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl-3.0.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or (at your option) the GNU General
+** Public license version 3 or any later version approved by the KDE Free
+** Qt Foundation. The licenses are as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL2 and LICENSE.GPL3
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-2.0.html and
+** https://www.gnu.org/licenses/gpl-3.0.html.
+**
+#ifndef QNMEASATELLITEINFOSOURCE_P_H
+#define QNMEASATELLITEINFOSOURCE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qpositioningglobal_p.h"
+#include "qgeosatelliteinfosource.h"
+#include "qlocationutils_p.h"
+
+#include <QtCore/QBasicTimer>
+#include <QtCore/QPointer>
+
+QT_BEGIN_NAMESPACE
+
+class QTimer;
+class QNmeaPositionInfoSource;
+
+class Q_POSITIONING_PRIVATE_EXPORT QNmeaSatelliteInfoSource : public QGeoSatelliteInfoSource
+{
+    Q_OBJECT
+public:
+    explicit QNmeaSatelliteInfoSource(QNmeaPositionInfoSource *positionSource, QObject *parent = 0);
+    ~QNmeaSatelliteInfoSource();
+
+    QNmeaPositionInfoSource *positionSource() const;
+
+    void setUpdateInterval(int msec) Q_DECL_OVERRIDE;
+    int minimumUpdateInterval() const Q_DECL_OVERRIDE;
+    Error error() const Q_DECL_OVERRIDE;
+
+    void parseNmeaSentence(const char *data, int size);
+    bool wantsUpdates() const;
+
+public Q_SLOTS:
+    void startUpdates() Q_DECL_OVERRIDE;
+    void stopUpdates() Q_DECL_OVERRIDE;
+    void requestUpdate(int timeout = 0) Q_DECL_OVERRIDE;
+
+protected:
+    void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
+
+private Q_SLOTS:
+    void updateRequestTimeout();
+
+private:
+    enum {
+        MaxTalkers = 8,
+        MaxSatellitesPerTalker = 36,
+        MaxSatellitesInUse = 48
+    };
+
+    struct TalkerGroup
+    {
+        char talker[2];
+        int sentenceCount;
+        int nextSentence;
+        int pendingCount;
+        int count;
+        QLocationUtils::NmeaSatellite pending[MaxSatellitesPerTalker];
+        QLocationUtils::NmeaSatellite satellites[MaxSatellitesPerTalker];
+    };
+
+    struct SatelliteInUse
+    {
+        QGeoSatelliteInfo::SatelliteSystem system;
+        int identifier;
+    };
+
+    bool startReading();
+    TalkerGroup *talkerGroup(const char *talker);
+    void addSatellitesInView(const QLocationUtils::NmeaSatellitesInView &sentence);
+    void addSatellitesInUse(const QLocationUtils::NmeaSatellitesInUse &sentence);
+    void satellitesInViewChanged();
+    void satellitesInUseChanged();
+    void emitPendingUpdates();
+    void setError(QGeoSatelliteInfoSource::Error error);
+
+    QPointer<QNmeaPositionInfoSource> m_positionSource;
+    TalkerGroup m_talkers[MaxTalkers];
+    int m_talkerCount;
+    SatelliteInUse m_inUse[MaxSatellitesInUse];
+    int m_inUseCount;
+    bool m_lastWasInUse;
+
+    QList<QGeoSatelliteInfo> m_satellitesInView;
+    QList<QGeoSatelliteInfo> m_satellitesInUse;
+    bool m_inViewPending;
+    bool m_inUsePending;
+
+    QBasicTimer m_updateTimer;
+    QTimer *m_requestTimer;
+    bool m_running;
+    QGeoSatelliteInfoSource::Error m_error;
+};
+
+QT_END_NAMESPACE
+
+#endif
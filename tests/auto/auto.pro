@@ -55,7 +55,13 @@ qtHaveModule(location) {
            qgeomapcontroller \
            maptype \
            nokia_services \
-           qgeocameratiles
+           qgeocameratiles \
+           qgeofiletilecache \
+           qgeotilefetcher \
+           qgeotileseedjob \
+           qgeopolygonclipper \
+           qgeopathsimplifier \
+           qgeogridindex
 
     qtHaveModule(quick) {
         SUBDIRS += declarative_core \
@@ -80,4 +86,8 @@ SUBDIRS += \
            qgeopositioninfosource \
            qgeosatelliteinfo \
            qgeosatelliteinfosource \
-           qnmeapositioninfosource
+           qnmeapositioninfosource \
+           qnmeasatelliteinfosource
+
+# uses a pseudo terminal in place of a serial GPS receiver
+unix:qtHaveModule(serialport): SUBDIRS += serialnmea
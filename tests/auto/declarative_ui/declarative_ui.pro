@@ -10,7 +10,7 @@ CONFIG -= app_bundle
 
 QT += location quick
 
-OTHER_FILES = *.qml
+OTHER_FILES = *.qml *.png
 TESTDATA = $$OTHER_FILES
 
 
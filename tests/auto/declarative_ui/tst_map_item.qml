@@ -106,6 +106,12 @@ Item {
         }
     }
 
+    MapCircle {
+        id: extMapCircleGeometry
+        color: 'red'
+        border.width: 0
+    }
+
     Map {
         id: map;
         x: 20; y: 20; width: 200; height: 200
@@ -558,6 +564,68 @@ Item {
             compare (preMapQuickItemSourceItemChanged.count, 1)
         }
 
+        // samples the map every few pixels, leaving out a band around the rim,
+        // and checks that the circle covers exactly the points within its radius
+        function verifyCircleGeometry(circle) {
+            verify(waitForRendering(map))
+            var image = grabImage(map)
+            var inside = 0
+            var outside = 0
+            for (var x = 2; x < map.width; x += 4) {
+                for (var y = 2; y < map.height; y += 4) {
+                    var coordinate = map.toCoordinate(Qt.point(x + 0.5, y + 0.5), false)
+                    var distance = circle.center.distanceTo(coordinate) / circle.radius
+                    if (Math.abs(distance - 1) < 0.05)
+                        continue
+                    var red = image.red(x, y) === 255 && image.green(x, y) === 0
+                            && image.blue(x, y) === 0
+                    if (distance < 1) {
+                        verify(red, "not covered at " + x + "," + y)
+                        ++inside
+                    } else {
+                        verify(!red, "covered at " + x + "," + y)
+                        ++outside
+                    }
+                }
+            }
+            verify(inside > 0)
+            verify(outside > 0)
+        }
+
+        function test_ad_circle_geometry() {
+            map.clearMapItems()
+            map.addMapItem(extMapCircleGeometry)
+
+            // covering the north pole, the circle fills the top of the map
+            // at every longitude
+            map.zoomLevel = 1
+            map.center = QtPositioning.coordinate(60, 90)
+            extMapCircleGeometry.center = QtPositioning.coordinate(85, 0)
+            extMapCircleGeometry.radius = 1500000
+            verifyCircleGeometry(extMapCircleGeometry)
+            verify(map.fromCoordinate(QtPositioning.coordinate(85, 0), false).x < 0)
+
+            // crossing the dateline
+            map.zoomLevel = 4
+            map.center = QtPositioning.coordinate(20, 180)
+            extMapCircleGeometry.center = QtPositioning.coordinate(20, 179)
+            extMapCircleGeometry.radius = 600000
+            verifyCircleGeometry(extMapCircleGeometry)
+            extMapCircleGeometry.center = QtPositioning.coordinate(20, -179)
+            verifyCircleGeometry(extMapCircleGeometry)
+
+            // a few metres at the highest zoom level are still a round shape
+            map.zoomLevel = 20
+            map.center = QtPositioning.coordinate(20, 20)
+            extMapCircleGeometry.center = QtPositioning.coordinate(20, 20)
+            extMapCircleGeometry.radius = 5
+            verifyCircleGeometry(extMapCircleGeometry)
+            extMapCircleGeometry.radius = 1
+            verifyCircleGeometry(extMapCircleGeometry)
+
+            map.removeMapItem(extMapCircleGeometry)
+        }
+
         function clear_data() {
             preMapRectClicked.clear()
             preMapCircleClicked.clear()
@@ -68,6 +68,44 @@ Item {
 
     property variant polyCoordinate: QtPositioning.coordinate(15, 6)
 
+    // a U open to the north, its notch between longitudes 17 and 23
+    MapPolygon {
+        id: extMapPolygonConcave
+        color: 'red'
+        border.width: 0
+        path: [
+            { latitude: 28, longitude: 12 },
+            { latitude: 12, longitude: 12 },
+            { latitude: 12, longitude: 28 },
+            { latitude: 28, longitude: 28 },
+            { latitude: 28, longitude: 23 },
+            { latitude: 17, longitude: 23 },
+            { latitude: 17, longitude: 17 },
+            { latitude: 28, longitude: 17 }
+        ]
+    }
+
+    MapPolygon {
+        id: extMapPolygonNarrowNotch
+        color: 'red'
+        border.width: 0
+    }
+
+    // polygons with enough vertices to be triangulated on a worker thread
+    MapPolygon {
+        id: extMapPolygonLarge
+        color: 'red'
+        border.width: 0
+    }
+
+    Component {
+        id: largePolygonComponent
+        MapPolygon {
+            color: 'red'
+            border.width: 0
+        }
+    }
+
     MapPolygon {
         id: extMapPolygon0
         color: 'darkgrey'
@@ -88,6 +126,11 @@ Item {
         SignalSpy {id: extMapPolylinePathChanged; target: parent; signalName: "pathChanged"}
     }
 
+    MapPolyline {
+        id: extMapPolylineJoins
+        line.color: 'red'
+    }
+
     MapRectangle {
         id: extMapRectDateline
         color: 'darkcyan'
@@ -347,6 +390,145 @@ Item {
             verify(extMapPolygon.path.length == 0)
         }
 
+        function isRed(image, x, y) {
+            return image.red(x, y) === 255 && image.green(x, y) === 0 && image.blue(x, y) === 0
+        }
+
+        function isPolygonColor(image, coordinate) {
+            var point = map.fromCoordinate(coordinate)
+            return isRed(image, Math.floor(point.x), Math.floor(point.y))
+        }
+
+        function setPixelPath(item, points) {
+            var path = []
+            for (var i = 0; i < points.length; ++i)
+                path.push(map.toCoordinate(points[i], false))
+            item.path = path
+        }
+
+        function verifyConcavePolygon(notchBottom) {
+            var image = grabImage(map)
+            verify(isPolygonColor(image, QtPositioning.coordinate(24, 14.5)))
+            verify(isPolygonColor(image, QtPositioning.coordinate(24, 25.5)))
+            verify(isPolygonColor(image, QtPositioning.coordinate(14.5, 20)))
+            verify(isPolygonColor(image, QtPositioning.coordinate(notchBottom - 1, 20)))
+            verify(!isPolygonColor(image, QtPositioning.coordinate(notchBottom + 1, 20)))
+            verify(!isPolygonColor(image, QtPositioning.coordinate(27, 20)))
+        }
+
+        function test_polygon_cached_triangulation() {
+            map.clearMapItems()
+            map.center = mapDefaultCenter
+            map.addMapItem(extMapPolygonConcave)
+            verify(waitForRendering(map))
+            verifyConcavePolygon(17)
+
+            // panning and zooming only transform the cached triangles
+            map.center = QtPositioning.coordinate(22, 18)
+            verify(waitForRendering(map))
+            verifyConcavePolygon(17)
+            map.zoomLevel = 3.5
+            verify(waitForRendering(map))
+            verifyConcavePolygon(17)
+
+            // a new path is triangulated again
+            var path = extMapPolygonConcave.path
+            path[5].latitude = 22
+            path[6].latitude = 22
+            extMapPolygonConcave.path = path
+            verify(waitForRendering(map))
+            verifyConcavePolygon(22)
+
+            map.removeMapItem(extMapPolygonConcave)
+            map.zoomLevel = 3
+            map.center = mapDefaultCenter
+        }
+
+        function test_polygon_high_zoom() {
+            map.clearMapItems()
+            map.center = mapDefaultCenter
+            map.zoomLevel = 20
+
+            // a square with a notch 1.5 pixels wide, close to the 16 pixels
+            // of a cached triangulation unit at this zoom level
+            var points = [Qt.point(60, 60), Qt.point(100, 60), Qt.point(100, 120),
+                          Qt.point(101.5, 120), Qt.point(101.5, 60), Qt.point(140, 60),
+                          Qt.point(140, 140), Qt.point(60, 140)]
+            setPixelPath(extMapPolygonNarrowNotch, points)
+            map.addMapItem(extMapPolygonNarrowNotch)
+            verify(waitForRendering(map))
+
+            var image = grabImage(map)
+            verify(isPolygonColor(image, map.toCoordinate(Qt.point(80.5, 100.5), false)))
+            verify(isPolygonColor(image, map.toCoordinate(Qt.point(120.5, 100.5), false)))
+            verify(!isPolygonColor(image, map.toCoordinate(Qt.point(100.5, 100.5), false)))
+
+            map.removeMapItem(extMapPolygonNarrowNotch)
+            map.zoomLevel = 3
+        }
+
+        // a rectangle in pixels with a zigzag of 600 teeth along its top edge,
+        // all of which survive the level of detail
+        function combPoints(left, right, top, bottom) {
+            var points = [Qt.point(left, bottom), Qt.point(right, bottom)]
+            var teeth = 600
+            for (var i = 0; i <= 2 * teeth; ++i)
+                points.push(Qt.point(right - i * (right - left) / (2 * teeth), top - (i % 2) * 8))
+            return points
+        }
+
+        // polls the map until the pixel at x, y is red, then keeps watching
+        // for a while that no other triangulation turns staleX, staleY red
+        function waitForPolygon(x, y, staleX, staleY) {
+            var image
+            for (var i = 0; i < 100; ++i) {
+                image = grabImage(map)
+                if (isRed(image, x, y))
+                    break
+                wait(20)
+            }
+            verify(isRed(image, x, y), "triangulation not drawn")
+            for (i = 0; i < 10; ++i) {
+                verify(!isRed(image, staleX, staleY), "stale triangulation drawn")
+                verify(isRed(image, x, y))
+                wait(20)
+                image = grabImage(map)
+            }
+        }
+
+        function test_polygon_background_triangulation() {
+            map.clearMapItems()
+            map.center = mapDefaultCenter
+            map.zoomLevel = 3
+            var left = combPoints(20, 90, 60, 140)
+            var right = combPoints(110, 180, 60, 140)
+
+            setPixelPath(extMapPolygonLarge, left)
+            map.addMapItem(extMapPolygonLarge)
+            waitForPolygon(55, 100, 145, 100)
+
+            // the task started for a path is cancelled by the next path,
+            // and its result never shows up
+            setPixelPath(extMapPolygonLarge, right)
+            verify(waitForRendering(map))
+            setPixelPath(extMapPolygonLarge, left)
+            verify(waitForRendering(map))
+            setPixelPath(extMapPolygonLarge, right)
+            waitForPolygon(145, 100, 55, 100)
+
+            // a polygon going away while its triangulation runs leaves
+            // nothing behind to notify
+            var polygon = largePolygonComponent.createObject(page)
+            setPixelPath(polygon, left)
+            map.addMapItem(polygon)
+            verify(waitForRendering(map))
+            map.removeMapItem(polygon)
+            polygon.destroy()
+            waitForPolygon(145, 100, 55, 100)
+
+            map.removeMapItem(extMapPolygonLarge)
+        }
+
         function test_polyline() {
             map.clearMapItems()
             clear_data()
@@ -406,6 +588,34 @@ Item {
      (0,240) ---------------------------------------------------- (600,240)
 
      */
+        function test_polyline_joins() {
+            map.clearMapItems()
+            map.center = mapDefaultCenter
+            map.addMapItem(extMapPolylineJoins)
+
+            // a right angle gets a bevel: its corner is cut off diagonally
+            extMapPolylineJoins.line.width = 10
+            setPixelPath(extMapPolylineJoins, [Qt.point(40, 60), Qt.point(100, 60), Qt.point(100, 120)])
+            verify(waitForRendering(map))
+            var image = grabImage(map)
+            verify(isRed(image, 70, 57))
+            verify(isRed(image, 103, 90))
+            verify(isRed(image, 101, 58))
+            verify(!isRed(image, 103, 56))
+
+            // a hairpin keeps its full width on the way back
+            extMapPolylineJoins.line.width = 6
+            setPixelPath(extMapPolylineJoins, [Qt.point(40, 100), Qt.point(160, 100), Qt.point(40, 112)])
+            verify(waitForRendering(map))
+            image = grabImage(map)
+            verify(isRed(image, 100, 100))
+            verify(isRed(image, 100, 106))
+            verify(isRed(image, 130, 103))
+            verify(isRed(image, 70, 109))
+
+            map.removeMapItem(extMapPolylineJoins)
+        }
+
         function test_yz_dateline() {
             map.clearMapItems()
             clear_data()
@@ -0,0 +1,210 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+import QtQuick 2.0
+import QtTest 1.0
+import QtPositioning 5.5
+import QtLocation 5.7
+
+Item {
+    id: page
+    x: 0; y: 0;
+    width: 240
+    height: 240
+    Plugin { id: testPlugin; name : "qmlgeo.test.plugin"; allowExperimental: true }
+
+    property variant mapDefaultCenter: QtPositioning.coordinate(20, 20)
+
+    MapRectangle {
+        id: lowerRect
+        color: 'darkcyan'
+        topLeft { latitude: 24; longitude: 16 }
+        bottomRight { latitude: 16; longitude: 24 }
+    }
+
+    MapRectangle {
+        id: upperRect
+        color: 'darkmagenta'
+        topLeft { latitude: 22; longitude: 18 }
+        bottomRight { latitude: 12; longitude: 28 }
+    }
+
+    MapPolyline {
+        id: diagonalPolyline
+        line.width: 3
+    }
+
+    MapRectangle {
+        id: datelineRect
+        color: 'darkcyan'
+        topLeft { latitude: 25; longitude: 175 }
+        bottomRight { latitude: 15; longitude: -175 }
+    }
+
+    MapCircle {
+        id: datelineCircle
+        color: 'darkmagenta'
+        center { latitude: 10; longitude: 180 }
+        radius: 200000
+    }
+
+    Map {
+        id: map
+        x: 20; y: 20; width: 200; height: 200
+        zoomLevel: 3
+        center: mapDefaultCenter
+        plugin: testPlugin
+    }
+
+    TestCase {
+        name: "MapItemsAt"
+        when: windowShown
+
+        function verifyItems(items, expected) {
+            compare(items.length, expected.length)
+            for (var i = 0; i < expected.length; ++i)
+                verify(items[i] === expected[i], "unexpected item at " + i)
+        }
+
+        function itemsAt(coordinate) {
+            return map.itemsAt(map.fromCoordinate(coordinate, false))
+        }
+
+        function reset() {
+            map.clearMapItems()
+            map.center = mapDefaultCenter
+            map.zoomLevel = 3
+            lowerRect.z = 0
+            upperRect.z = 0
+            lowerRect.visible = true
+        }
+
+        function test_overlapping_items() {
+            reset()
+            map.addMapItem(lowerRect)
+            map.addMapItem(upperRect)
+            verify(waitForRendering(map))
+
+            // with the same z the item added later is on top
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 20)), [upperRect, lowerRect])
+            verifyItems(itemsAt(QtPositioning.coordinate(23, 17)), [lowerRect])
+            verifyItems(itemsAt(QtPositioning.coordinate(14, 26)), [upperRect])
+            verifyItems(itemsAt(QtPositioning.coordinate(30, 5)), [])
+
+            var center = map.fromCoordinate(QtPositioning.coordinate(20, 20), false)
+            verifyItems(map.itemsIn(Qt.rect(center.x - 2, center.y - 2, 4, 4)), [upperRect, lowerRect])
+            verifyItems(map.itemsIn(Qt.rect(0, 0, map.width, map.height)), [upperRect, lowerRect])
+            verifyItems(map.itemsIn(Qt.rect(0, 0, 4, 4)), [])
+        }
+
+        function test_z_order() {
+            reset()
+            map.addMapItem(lowerRect)
+            map.addMapItem(upperRect)
+            verify(waitForRendering(map))
+
+            lowerRect.z = 1
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 20)), [lowerRect, upperRect])
+            var center = map.fromCoordinate(QtPositioning.coordinate(20, 20), false)
+            verifyItems(map.itemsIn(Qt.rect(center.x - 2, center.y - 2, 4, 4)), [lowerRect, upperRect])
+
+            upperRect.z = 2
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 20)), [upperRect, lowerRect])
+        }
+
+        function test_shape() {
+            reset()
+            var path = [map.toCoordinate(Qt.point(20, 20), false),
+                        map.toCoordinate(Qt.point(80, 80), false)]
+            diagonalPolyline.path = path
+            map.addMapItem(diagonalPolyline)
+            verify(waitForRendering(map))
+
+            // itemsAt tests the stroke, itemsIn only the bounds
+            verifyItems(map.itemsAt(Qt.point(50, 50)), [diagonalPolyline])
+            verifyItems(map.itemsAt(Qt.point(70, 30)), [])
+            verifyItems(map.itemsIn(Qt.rect(69, 29, 2, 2)), [diagonalPolyline])
+        }
+
+        function test_moving_items() {
+            reset()
+            map.addMapItem(lowerRect)
+            verify(waitForRendering(map))
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 20)), [lowerRect])
+
+            // a new position is picked up by the next lookup
+            lowerRect.topLeft = QtPositioning.coordinate(34, 6)
+            lowerRect.bottomRight = QtPositioning.coordinate(28, 12)
+            verify(waitForRendering(map))
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 20)), [])
+            verifyItems(itemsAt(QtPositioning.coordinate(31, 9)), [lowerRect])
+
+            // items move with the map
+            var before = map.fromCoordinate(QtPositioning.coordinate(31, 9), false)
+            map.pan(-30, -20)
+            verify(waitForRendering(map))
+            var after = map.fromCoordinate(QtPositioning.coordinate(31, 9), false)
+            verify(Math.abs(after.x - before.x) > 10)
+            verifyItems(map.itemsAt(after), [lowerRect])
+            verifyItems(map.itemsAt(before), [])
+
+            // hidden and removed items are not found
+            lowerRect.visible = false
+            verifyItems(map.itemsAt(after), [])
+            lowerRect.visible = true
+            verifyItems(map.itemsAt(after), [lowerRect])
+            map.removeMapItem(lowerRect)
+            verifyItems(map.itemsAt(after), [])
+            verifyItems(map.itemsIn(Qt.rect(0, 0, map.width, map.height)), [])
+
+            lowerRect.topLeft = QtPositioning.coordinate(24, 16)
+            lowerRect.bottomRight = QtPositioning.coordinate(16, 24)
+        }
+
+        function test_dateline() {
+            reset()
+            map.center = QtPositioning.coordinate(15, 180)
+            map.addMapItem(datelineRect)
+            map.addMapItem(datelineCircle)
+            verify(waitForRendering(map))
+
+            // both halves of the items are found, either side of the dateline
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 177)), [datelineRect])
+            verifyItems(itemsAt(QtPositioning.coordinate(20, -177)), [datelineRect])
+            verifyItems(itemsAt(QtPositioning.coordinate(10, 179)), [datelineCircle])
+            verifyItems(itemsAt(QtPositioning.coordinate(10, -179)), [datelineCircle])
+            verifyItems(itemsAt(QtPositioning.coordinate(20, 170)), [])
+            verifyItems(itemsAt(QtPositioning.coordinate(20, -170)), [])
+
+            var west = map.fromCoordinate(QtPositioning.coordinate(20, 177), false)
+            var east = map.fromCoordinate(QtPositioning.coordinate(20, -177), false)
+            verify(west.x < east.x)
+            verifyItems(map.itemsIn(Qt.rect(west.x, west.y, east.x - west.x, 1)), [datelineRect])
+        }
+    }
+}
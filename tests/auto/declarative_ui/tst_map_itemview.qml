@@ -257,9 +257,124 @@ Item {
         }
     }
 
+    // rows of the virtualized view keep their position in an object, the
+    // way places of a PlaceSearchModel do
+    Component {
+        id: locationComponent
+        QtObject { property variant coordinate }
+    }
+
+    ListModel { id: virtualizedModel }
+
+    Map {
+        id: mapForVirtualization
+
+        property int mapItemsLength: mapItems.length
+
+        width: 100
+        height: 100
+        center: QtPositioning.coordinate(0, 0)
+        plugin: testPlugin
+        zoomLevel: 6
+
+        MapItemView {
+            id: virtualizedView
+            virtualized: true
+            cacheBuffer: 0
+            coordinateRole: "location"
+            delegate: Component {
+                MapCircle {
+                    property int row: index
+                    property variant rowLabel: model.label
+                    radius: 1000
+                    center: location.coordinate
+                }
+            }
+        }
+    }
+
     TestCase {
         name: "MapItem"
         when: windowShown
+
+        function appendRow(latitude, longitude, label) {
+            var row = { location: locationComponent.createObject(masterItem,
+                            { coordinate: QtPositioning.coordinate(latitude, longitude) }) }
+            if (label !== undefined)
+                row.label = label
+            virtualizedModel.append(row)
+        }
+
+        function insertRow(index, latitude, longitude) {
+            virtualizedModel.insert(index, { location: locationComponent.createObject(masterItem,
+                            { coordinate: QtPositioning.coordinate(latitude, longitude) }) })
+        }
+
+        function itemRows() {
+            var rows = []
+            for (var i = 0; i < mapForVirtualization.mapItems.length; ++i)
+                rows.push(mapForVirtualization.mapItems[i].row)
+            rows.sort(function(a, b) { return a - b })
+            return rows
+        }
+
+        function test_virtualized() {
+            appendRow(0.1, 0.1, "near")
+            appendRow(-0.1, -0.1, "near")
+            appendRow(40, 100)
+            appendRow(40.1, 100.1)
+            appendRow(NaN, NaN)             // no coordinate, always has an item
+            appendRow(-40, -100)
+            virtualizedView.model = virtualizedModel
+
+            // only rows in view get items
+            tryCompare(mapForVirtualization, "mapItemsLength", 3)
+            compare(itemRows(), [0, 1, 4])
+            var nearItems = []
+            for (var i = 0; i < mapForVirtualization.mapItems.length; ++i) {
+                var item = mapForVirtualization.mapItems[i]
+                if (item.row !== 4) {
+                    compare(item.rowLabel, "near")
+                    nearItems.push(item)
+                }
+            }
+
+            // panning hands the items of rows that left over to the ones
+            // that came into view, without anything left from their old rows
+            mapForVirtualization.center = QtPositioning.coordinate(40, 100)
+            tryCompare(mapForVirtualization, "mapItemsLength", 3)
+            compare(itemRows(), [2, 3, 4])
+            for (i = 0; i < mapForVirtualization.mapItems.length; ++i) {
+                item = mapForVirtualization.mapItems[i]
+                if (item.row === 4)
+                    continue
+                verify(nearItems.indexOf(item) >= 0)
+                compare(item.rowLabel, undefined)
+                var coordinate = virtualizedModel.get(item.row).location.coordinate
+                compare(item.center.latitude, coordinate.latitude)
+                compare(item.center.longitude, coordinate.longitude)
+            }
+
+            // inserted rows move the rows after them along
+            insertRow(0, 40.05, 100.05)
+            tryCompare(mapForVirtualization, "mapItemsLength", 4)
+            compare(itemRows(), [0, 3, 4, 5])
+
+            virtualizedModel.remove(3)
+            tryCompare(mapForVirtualization, "mapItemsLength", 3)
+            compare(itemRows(), [0, 3, 4])
+
+            // rows out of view cost no item
+            insertRow(1, -40.1, -100.1)
+            wait(50)
+            compare(mapForVirtualization.mapItemsLength, 3)
+            compare(itemRows(), [0, 4, 5])
+
+            mapForVirtualization.center = QtPositioning.coordinate(-40, -100)
+            tryCompare(mapForVirtualization, "mapItemsLength", 3)
+            compare(itemRows(), [1, 5, 6])
+        }
+
         function clear_data() {
             mapItemSpy.clear()
         }
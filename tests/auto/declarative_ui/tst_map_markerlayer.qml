@@ -0,0 +1,225 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+import QtQuick 2.0
+import QtTest 1.0
+import QtPositioning 5.5
+import QtLocation 5.7
+
+Item {
+    id: page
+    x: 0; y: 0;
+    width: 240
+    height: 240
+    Plugin { id: testPlugin; name : "qmlgeo.test.plugin"; allowExperimental: true }
+
+    property variant mapDefaultCenter: QtPositioning.coordinate(20, 20)
+
+    Map {
+        id: map
+        x: 20; y: 20; width: 200; height: 200
+        zoomLevel: 3
+        center: mapDefaultCenter
+        plugin: testPlugin
+
+        MapMarkerLayer {
+            id: dotLayer
+            symbolSize: Qt.size(10, 10)
+            SignalSpy { id: dotLayerClicked; target: parent; signalName: "clicked" }
+            SignalSpy { id: dotLayerCoordinatesChanged; target: parent; signalName: "coordinatesChanged" }
+        }
+    }
+
+    // markersymbols.png has a red cell and a blue cell, 8 by 8 pixels each
+    MapMarkerLayer {
+        id: atlasLayer
+        source: "markersymbols.png"
+        symbolSize: Qt.size(8, 8)
+    }
+
+    TestCase {
+        name: "MapMarkerLayer"
+        when: windowShown
+
+        function pixelCoordinates(points) {
+            var coordinates = []
+            for (var i = 0; i < points.length; ++i)
+                coordinates.push(map.toCoordinate(points[i], false))
+            return coordinates
+        }
+
+        function markersIn(layer, rect) {
+            var markers = layer.markersIn(rect)
+            var result = []
+            for (var i = 0; i < markers.length; ++i)
+                result.push(markers[i])
+            return result
+        }
+
+        function isRed(image, x, y) {
+            return image.red(x, y) === 255 && image.green(x, y) === 0 && image.blue(x, y) === 0
+        }
+
+        function isBlue(image, x, y) {
+            return image.red(x, y) === 0 && image.green(x, y) === 0 && image.blue(x, y) === 255
+        }
+
+        function isGray(image, x, y) {
+            return image.red(x, y) === image.green(x, y) && image.green(x, y) === image.blue(x, y)
+        }
+
+        function test_aa_add_markers() { // aa to run before the layer has markers
+            dotLayerCoordinatesChanged.clear()
+            compare(dotLayer.count, 0)
+            compare(dotLayer.markerAt(Qt.point(100, 100)), -1)
+
+            dotLayer.coordinates = pixelCoordinates([Qt.point(60, 60), Qt.point(140, 140)])
+            compare(dotLayerCoordinatesChanged.count, 1)
+            compare(dotLayer.count, 2)
+            compare(dotLayer.anchorPoint, Qt.point(5, 5))
+            verify(waitForRendering(map))
+
+            compare(dotLayer.markerAt(Qt.point(60, 60)), 0)
+            compare(dotLayer.markerAt(Qt.point(140, 140)), 1)
+            compare(dotLayer.markerAt(Qt.point(100, 100)), -1)
+            compare(markersIn(dotLayer, Qt.rect(0, 0, 200, 200)), [0, 1])
+
+            var image = grabImage(map)
+            verify(isRed(image, 60, 60))
+            verify(isRed(image, 140, 140))
+            verify(isGray(image, 100, 100))
+
+            // the same coordinates again change nothing
+            dotLayer.coordinates = dotLayer.coordinates
+            compare(dotLayerCoordinatesChanged.count, 1)
+        }
+
+        function test_hit_testing() {
+            // the third marker overlaps the second one and is on top of it
+            dotLayer.coordinates = pixelCoordinates([Qt.point(60, 60), Qt.point(100, 100),
+                                                     Qt.point(106, 100)])
+            verify(waitForRendering(map))
+
+            compare(dotLayer.markerAt(Qt.point(97, 100)), 1)
+            compare(dotLayer.markerAt(Qt.point(103, 100)), 2)
+            compare(dotLayer.markerAt(Qt.point(109, 100)), 2)
+            compare(dotLayer.markerAt(Qt.point(113, 100)), -1)
+            compare(markersIn(dotLayer, Qt.rect(90, 90, 20, 20)), [1, 2])
+            compare(markersIn(dotLayer, Qt.rect(50, 50, 8, 8)), [0])
+            compare(markersIn(dotLayer, Qt.rect(0, 0, 20, 20)), [])
+
+            dotLayerClicked.clear()
+            mouseClick(map, 60, 60)
+            compare(dotLayerClicked.count, 1)
+            compare(dotLayerClicked.signalArguments[0][0], 0)
+            mouseClick(map, 103, 100)
+            compare(dotLayerClicked.count, 2)
+            compare(dotLayerClicked.signalArguments[1][0], 2)
+
+            // clicks that miss every marker are left to the map
+            mouseClick(map, 20, 20)
+            compare(dotLayerClicked.count, 2)
+            verify(!dotLayer.contains(Qt.point(20, 20)))
+            verify(dotLayer.contains(Qt.point(60, 60)))
+        }
+
+        function test_viewport_changes() {
+            map.center = mapDefaultCenter
+            map.zoomLevel = 3
+            var coordinates = pixelCoordinates([Qt.point(60, 60), Qt.point(100, 100)])
+            dotLayer.coordinates = coordinates
+            verify(waitForRendering(map))
+            compare(dotLayer.markerAt(Qt.point(60, 60)), 0)
+
+            // panning moves the markers with the map
+            map.pan(30, 20)
+            verify(waitForRendering(map))
+            var point = map.fromCoordinate(coordinates[0], false)
+            verify(Math.abs(point.x - 60) > 10)
+            compare(dotLayer.markerAt(point), 0)
+            compare(dotLayer.markerAt(Qt.point(60, 60)), -1)
+
+            // zooming moves them too but keeps their size on screen
+            map.center = coordinates[1]
+            map.zoomLevel = 5
+            verify(waitForRendering(map))
+            compare(dotLayer.markerAt(Qt.point(100, 100)), 1)
+            compare(dotLayer.markerAt(Qt.point(106, 100)), -1)
+            point = map.fromCoordinate(coordinates[0], false)
+            verify(point.x < 0 && point.y < 0)
+            // markers off screen cannot be hit
+            compare(markersIn(dotLayer, Qt.rect(0, 0, 200, 200)), [1])
+
+            // a single marker moves without replacing the others
+            dotLayerCoordinatesChanged.clear()
+            dotLayer.setCoordinate(0, map.toCoordinate(Qt.point(40, 150), false))
+            compare(dotLayerCoordinatesChanged.count, 1)
+            verify(waitForRendering(map))
+            compare(dotLayer.markerAt(Qt.point(40, 150)), 0)
+            compare(markersIn(dotLayer, Qt.rect(0, 0, 200, 200)), [0, 1])
+
+            map.center = mapDefaultCenter
+            map.zoomLevel = 3
+        }
+
+        function test_atlas_cells() {
+            dotLayer.coordinates = []
+            map.center = mapDefaultCenter
+            map.zoomLevel = 3
+
+            // a red and a blue marker next to each other, off whole pixels
+            atlasLayer.coordinates = pixelCoordinates([Qt.point(60.5, 60.5), Qt.point(68.5, 60.5)])
+            atlasLayer.symbols = [0, 1]
+            map.addMapItem(atlasLayer)
+            verify(waitForRendering(map))
+
+            compare(atlasLayer.markerAt(Qt.point(60, 60)), 0)
+            compare(atlasLayer.markerAt(Qt.point(69, 60)), 1)
+
+            // the symbols are drawn as they are, without any of the
+            // neighbouring cell bleeding into their edges
+            var image = grabImage(map)
+            var red = 0
+            var blue = 0
+            for (var x = 50; x < 80; ++x) {
+                for (var y = 52; y < 70; ++y) {
+                    if (isRed(image, x, y))
+                        ++red
+                    else if (isBlue(image, x, y))
+                        ++blue
+                    else
+                        verify(isGray(image, x, y), "blended pixel at " + x + "," + y)
+                }
+            }
+            compare(red, 64)
+            compare(blue, 64)
+
+            map.removeMapItem(atlasLayer)
+        }
+    }
+}
@@ -208,6 +208,92 @@ private slots:
         QCOMPARE(tiles3, tiles3_check);
     }
 
+    void tilesPriority()
+    {
+        QGeoCameraData camera;
+        camera.setZoomLevel(4.0);
+        camera.setCenter(QGeoCoordinate(0.0, 0.0));
+
+        QGeoCameraTiles ct;
+        ct.setMaximumZoomLevel(8);
+        ct.setTileSize(16);
+        ct.setCameraData(camera);
+        ct.setScreenSize(QSize(64, 64));
+
+        // the camera looks at the corner shared by tiles (7,7), (8,7), (7,8) and (8,8)
+        int centre = ct.tilePriority(QGeoTileSpec("", 0, 4, 8, 8));
+        QCOMPARE(ct.tilePriority(QGeoTileSpec("", 0, 4, 7, 7)), centre);
+        QVERIFY(centre < ct.tilePriority(QGeoTileSpec("", 0, 4, 9, 8)));
+        QVERIFY(ct.tilePriority(QGeoTileSpec("", 0, 4, 9, 8)) < ct.tilePriority(QGeoTileSpec("", 0, 4, 10, 8)));
+
+        // every tile of the camera's layer ranks ahead of the neighbouring layers
+        int farthest = ct.tilePriority(QGeoTileSpec("", 0, 4, 0, 0));
+        QVERIFY(farthest < ct.tilePriority(QGeoTileSpec("", 0, 5, 16, 16)));
+        QVERIFY(farthest < ct.tilePriority(QGeoTileSpec("", 0, 3, 4, 4)));
+
+        // wrapping across the dateline counts as near
+        camera.setCenter(QGeoCoordinate(0.0, -170.0));
+        ct.setCameraData(camera);
+        QVERIFY(ct.tilePriority(QGeoTileSpec("", 0, 4, 15, 8)) < ct.tilePriority(QGeoTileSpec("", 0, 4, 2, 8)));
+    }
+
+    void tilesIncremental()
+    {
+        QGeoCameraData camera;
+        camera.setZoomLevel(4.5);
+        camera.setCenter(QGeoCoordinate(10.0, 170.0));
+
+        QGeoCameraTiles ct;
+        ct.setMaximumZoomLevel(8);
+        ct.setTileSize(16);
+        ct.setScreenSize(QSize(64, 48));
+        ct.setPluginString("pluginA");
+
+        // pan across the dateline, tilt, then zoom; every step must match a
+        // set computed from scratch
+        for (int step = 0; step < 60; ++step) {
+            QGeoCoordinate center = camera.center();
+            if (step < 30) {
+                center.setLongitude(center.longitude() + 1.7);
+                center.setLatitude(center.latitude() - 0.9);
+                camera.setCenter(center);
+            } else if (step < 45) {
+                camera.setTilt((step - 30) * 3.0);
+            } else {
+                camera.setZoomLevel(camera.zoomLevel() + 0.2);
+            }
+            ct.setCameraData(camera);
+
+            QGeoCameraTiles fresh;
+            fresh.setMaximumZoomLevel(8);
+            fresh.setTileSize(16);
+            fresh.setScreenSize(QSize(64, 48));
+            fresh.setPluginString("pluginA");
+            fresh.setCameraData(camera);
+
+            QCOMPARE(ct.visibleTiles(), fresh.visibleTiles());
+        }
+    }
+
+    void tilesPrefetchKeepsVisible()
+    {
+        QGeoCameraData camera;
+        camera.setZoomLevel(4.0);
+        camera.setCenter(QGeoCoordinate(0.0, 0.0));
+
+        QGeoCameraTiles ct;
+        ct.setMaximumZoomLevel(8);
+        ct.setTileSize(16);
+        ct.setCameraData(camera);
+        ct.setScreenSize(QSize(32, 32));
+
+        QSet<QGeoTileSpec> visible = ct.visibleTiles();
+        QSet<QGeoTileSpec> prefetch = ct.prefetchTiles(QGeoCameraTiles::PrefetchTwoNeighbourLayers);
+
+        QVERIFY(prefetch.contains(visible));
+        QCOMPARE(ct.visibleTiles(), visible);
+    }
+
     void tilesPositions()
     {
         QFETCH(double, mercatorX);
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeofiletilecache
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeofiletilecache.cpp
+
+QT += location testlib
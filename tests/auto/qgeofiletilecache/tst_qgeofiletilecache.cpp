@@ -0,0 +1,382 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtCore/QBuffer>
+
+#include "qgeofiletilecache_p.h"
+#include "qgeotilepackstore_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoFileTileCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void packStoreRoundTrip();
+    void packStoreRecoversUnindexedTail();
+    void packStoreCompaction();
+    void packStoreCompactionAfterWait();
+    void packedCacheReload();
+    void asyncGet();
+    void asyncCancel();
+    void compactTextures();
+    void dropCompressedCopy();
+
+private:
+    static QByteArray tileBytes(const QColor &color);
+};
+
+QByteArray tst_QGeoFileTileCache::tileBytes(const QColor &color)
+{
+    QImage image(256, 256, QImage::Format_RGB32);
+    image.fill(color);
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return bytes;
+}
+
+void tst_QGeoFileTileCache::packStoreRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec a(QStringLiteral("test"), 1, 3, 4, 5);
+    const QGeoTileSpec b(QStringLiteral("test"), 1, 3, 4, 6, 7);
+
+    {
+        QGeoTilePackStore store(dir.path());
+        QVERIFY(store.open());
+        QVERIFY(store.write(a, QByteArray("first"), QStringLiteral("png")));
+        QVERIFY(store.write(b, QByteArray("second"), QStringLiteral("jpg")));
+        QVERIFY(store.write(a, QByteArray("replaced"), QStringLiteral("png")));
+        QVERIFY(store.deadBytes() > 0);
+        store.writeIndex(QList<QPair<QGeoTileSpec, int> >() << qMakePair(b, 2) << qMakePair(a, 1));
+    }
+
+    QGeoTilePackStore store(dir.path());
+    QVERIFY(store.open());
+    QCOMPARE(store.entries().size(), 2);
+    QCOMPARE(store.entries().first().spec, b);
+    QCOMPARE(store.entries().first().queue, 2);
+
+    QString format;
+    QCOMPARE(store.read(a, &format), QByteArray("replaced"));
+    QCOMPARE(format, QStringLiteral("png"));
+    QCOMPARE(store.read(b, &format), QByteArray("second"));
+    QCOMPARE(format, QStringLiteral("jpg"));
+    QCOMPARE(store.size(b), 6);
+
+    store.remove(a);
+    QVERIFY(!store.contains(a));
+    QVERIFY(store.read(a).isEmpty());
+
+    store.clear();
+    QVERIFY(store.entries().isEmpty());
+    QVERIFY(!QFile::exists(store.indexFileName()));
+}
+
+void tst_QGeoFileTileCache::packStoreRecoversUnindexedTail()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec a(QStringLiteral("test"), 1, 3, 4, 5);
+    const QGeoTileSpec b(QStringLiteral("test"), 1, 3, 4, 6);
+
+    {
+        QGeoTilePackStore store(dir.path());
+        QVERIFY(store.open());
+        QVERIFY(store.write(a, QByteArray("indexed"), QStringLiteral("png")));
+        store.writeIndex(QList<QPair<QGeoTileSpec, int> >());
+        // written after the index, as if the application crashed
+        QVERIFY(store.write(b, QByteArray("unindexed"), QStringLiteral("png")));
+    }
+
+    // simulate a torn write at the end of the pack
+    {
+        QFile pack(QDir(dir.path()).filePath(QStringLiteral("tiles.pack")));
+        QVERIFY(pack.open(QIODevice::Append));
+        pack.write("garbage");
+    }
+
+    QGeoTilePackStore store(dir.path());
+    QVERIFY(store.open());
+    QCOMPARE(store.read(a), QByteArray("indexed"));
+    QCOMPARE(store.read(b), QByteArray("unindexed"));
+    QCOMPARE(store.entries().size(), 2);
+}
+
+void tst_QGeoFileTileCache::packStoreCompaction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QGeoTilePackStore store(dir.path());
+    QVERIFY(store.open());
+    store.setCompactionThreshold(2.0, 0); // only compact on request
+
+    const QByteArray payload(1024, 'x');
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(store.write(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i), payload, QStringLiteral("png")));
+    for (int i = 0; i < 100; i += 2)
+        store.remove(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i));
+
+    const qint64 sizeBefore = store.packSize();
+    QSignalSpy spy(&store, SIGNAL(compactionFinished()));
+    store.compact();
+    QVERIFY(store.isCompacting());
+
+    // writes while the worker is copying end up in the new pack as well
+    QVERIFY(store.write(QGeoTileSpec(QStringLiteral("test"), 1, 11, 0, 0), QByteArray("late"), QStringLiteral("png")));
+    // a tile removed meanwhile has already been copied and stays dead
+    const int removedSize = store.size(QGeoTileSpec(QStringLiteral("test"), 1, 10, 1, 1));
+    store.remove(QGeoTileSpec(QStringLiteral("test"), 1, 10, 1, 1));
+
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(!store.isCompacting());
+    QVERIFY(store.deadBytes() > removedSize);
+    QVERIFY(store.deadBytes() < 2 * removedSize);
+    QVERIFY(store.packSize() < sizeBefore);
+    QVERIFY(!store.contains(QGeoTileSpec(QStringLiteral("test"), 1, 10, 1, 1)));
+
+    // the compacted pack replaced the old one without leaving files behind
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files).size(), 1);
+
+    for (int i = 3; i < 100; i += 2)
+        QCOMPARE(store.read(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i)), payload);
+    QCOMPARE(store.read(QGeoTileSpec(QStringLiteral("test"), 1, 11, 0, 0)), QByteArray("late"));
+}
+
+void tst_QGeoFileTileCache::packStoreCompactionAfterWait()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QGeoTilePackStore store(dir.path());
+    QVERIFY(store.open());
+    store.setCompactionThreshold(2.0, 0); // only compact on request
+
+    const QByteArray payload(1024, 'x');
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(store.write(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i), payload, QStringLiteral("png")));
+    for (int i = 0; i < 100; i += 2)
+        store.remove(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i));
+
+    QSignalSpy spy(&store, SIGNAL(compactionFinished()));
+    store.compact();
+    store.waitForCompaction();
+    QCOMPARE(spy.count(), 1);
+
+    // the worker's queued call for the first compaction is still pending
+    // and must leave the second one alone
+    for (int i = 1; i < 100; i += 4)
+        store.remove(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i));
+    store.compact();
+    QVERIFY(store.isCompacting());
+
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(!store.isCompacting());
+    QCOMPARE(store.deadBytes(), qint64(0));
+    for (int i = 3; i < 100; i += 4)
+        QCOMPARE(store.read(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, i)), payload);
+}
+
+void tst_QGeoFileTileCache::packedCacheReload()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 2, 1, 1);
+
+    {
+        QGeoFileTileCache cache(dir.path(), QGeoFileTileCache::PackedStorage);
+        QCOMPARE(cache.storageType(), QGeoFileTileCache::PackedStorage);
+        cache.insert(spec, tileBytes(Qt::red), QStringLiteral("png"));
+        QVERIFY(cache.diskUsage() > 0);
+    }
+
+    // no per tile files are created
+    QCOMPARE(QDir(dir.path()).entryList(QStringList() << QStringLiteral("*-*-*-*.*"), QDir::Files).size(), 0);
+
+    QGeoFileTileCache cache(dir.path(), QGeoFileTileCache::PackedStorage);
+    QVERIFY(cache.diskUsage() > 0);
+    QSharedPointer<QGeoTileTexture> texture = cache.get(spec);
+    QVERIFY(!texture.isNull());
+    QCOMPARE(texture->image.size(), QSize(256, 256));
+    QCOMPARE(QColor(texture->image.pixel(10, 10)), QColor(Qt::red));
+
+    cache.clearAll();
+    QCOMPARE(cache.diskUsage(), 0);
+    QVERIFY(cache.get(spec).isNull());
+}
+
+void tst_QGeoFileTileCache::asyncGet()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec good(QStringLiteral("test"), 1, 2, 1, 1);
+    const QGeoTileSpec broken(QStringLiteral("test"), 1, 2, 1, 2);
+    const QGeoTileSpec missing(QStringLiteral("test"), 1, 2, 1, 3);
+
+    QGeoFileTileCache cache(dir.path());
+    cache.insert(good, tileBytes(Qt::blue), QStringLiteral("png"), QGeoTiledMappingManagerEngine::DiskCache);
+    cache.insert(broken, QByteArray("not an image"), QStringLiteral("png"));
+
+    QSignalSpy loaded(&cache, SIGNAL(tileLoaded(QGeoTileSpec)));
+    QSignalSpy failed(&cache, SIGNAL(tileLoadFailed(QGeoTileSpec)));
+
+    bool pending = true;
+    QVERIFY(cache.getAsync(missing, &pending).isNull());
+    QVERIFY(!pending);
+
+    QVERIFY(cache.getAsync(good, &pending).isNull());
+    QVERIFY(pending);
+    // a second lookup does not schedule the tile twice
+    QVERIFY(cache.getAsync(good, &pending).isNull());
+    QVERIFY(pending);
+    QVERIFY(cache.getAsync(broken, &pending).isNull());
+    QVERIFY(pending);
+
+    QTRY_COMPARE(loaded.count() + failed.count(), 2);
+    QCOMPARE(loaded.count(), 1);
+    QCOMPARE(loaded.first().first().value<QGeoTileSpec>(), good);
+    QCOMPARE(failed.count(), 1);
+    QCOMPARE(failed.first().first().value<QGeoTileSpec>(), broken);
+
+    QSharedPointer<QGeoTileTexture> texture = cache.getAsync(good, &pending);
+    QVERIFY(!texture.isNull());
+    QVERIFY(!pending);
+    QCOMPARE(QColor(texture->image.pixel(10, 10)), QColor(Qt::blue));
+
+    // the unusable tile was dropped so it gets fetched again
+    QVERIFY(cache.getAsync(broken, &pending).isNull());
+    QVERIFY(!pending);
+}
+
+void tst_QGeoFileTileCache::asyncCancel()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec shared(QStringLiteral("test"), 1, 2, 1, 1);
+    const QGeoTileSpec dropped(QStringLiteral("test"), 1, 2, 1, 2);
+
+    QGeoFileTileCache cache(dir.path());
+    cache.insert(shared, tileBytes(Qt::blue), QStringLiteral("png"), QGeoTiledMappingManagerEngine::DiskCache);
+    cache.insert(dropped, tileBytes(Qt::red), QStringLiteral("png"), QGeoTiledMappingManagerEngine::DiskCache);
+
+    QSignalSpy loaded(&cache, SIGNAL(tileLoaded(QGeoTileSpec)));
+    QSignalSpy failed(&cache, SIGNAL(tileLoadFailed(QGeoTileSpec)));
+
+    // two maps wait for the shared tile, only one of them loses interest
+    bool pending = false;
+    QVERIFY(cache.getAsync(shared, &pending).isNull());
+    QVERIFY(pending);
+    QVERIFY(cache.getAsync(shared, &pending).isNull());
+    QVERIFY(pending);
+    cache.cancelAsync(shared);
+
+    QVERIFY(cache.getAsync(dropped, &pending).isNull());
+    QVERIFY(pending);
+    cache.cancelAsync(dropped);
+
+    cache.waitForPendingLoads();
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(loaded.count(), 1);
+    QCOMPARE(loaded.first().first().value<QGeoTileSpec>(), shared);
+
+    // a cancelled tile can be asked for again
+    QVERIFY(cache.getAsync(dropped, &pending).isNull());
+    QVERIFY(pending);
+    QTRY_COMPARE(loaded.count(), 2);
+    QCOMPARE(loaded.last().first().value<QGeoTileSpec>(), dropped);
+}
+
+void tst_QGeoFileTileCache::compactTextures()
+{
+    QImage flat(256, 256, QImage::Format_RGB32);
+    flat.fill(Qt::green);
+    QImage compact = QGeoFileTileCache::textureImage(flat, QGeoFileTileCache::PreferCompactFormat);
+    QCOMPARE(compact.format(), QImage::Format_Indexed8);
+    QCOMPARE(compact.pixel(3, 3), flat.pixel(3, 3));
+
+    QImage gradient(256, 256, QImage::Format_RGB32);
+    for (int y = 0; y < gradient.height(); ++y)
+        for (int x = 0; x < gradient.width(); ++x)
+            gradient.setPixel(x, y, qRgb(x, y, 0));
+    QCOMPARE(QGeoFileTileCache::textureImage(gradient, QGeoFileTileCache::PreferCompactFormat).format(),
+             QImage::Format_RGB16);
+    QCOMPARE(QGeoFileTileCache::textureImage(gradient, QGeoFileTileCache::KeepSourceFormat).format(),
+             QImage::Format_RGB32);
+
+    QImage transparent(256, 256, QImage::Format_ARGB32);
+    transparent.fill(Qt::transparent);
+    QCOMPARE(QGeoFileTileCache::textureImage(transparent, QGeoFileTileCache::PreferCompactFormat).format(),
+             QImage::Format_ARGB32);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoFileTileCache cache(dir.path());
+    cache.setTextureFormatPolicy(QGeoFileTileCache::PreferCompactFormat);
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 2, 1, 1);
+    cache.insert(spec, tileBytes(Qt::red), QStringLiteral("png"));
+    QSharedPointer<QGeoTileTexture> texture = cache.get(spec);
+    QVERIFY(!texture.isNull());
+    QCOMPARE(texture->image.format(), QImage::Format_Indexed8);
+    // the texture cache is charged for the real size of the pixel data
+    QCOMPARE(cache.textureUsage(), texture->image.byteCount());
+}
+
+void tst_QGeoFileTileCache::dropCompressedCopy()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QGeoTileSpec spec(QStringLiteral("test"), 1, 2, 1, 1);
+    QGeoFileTileCache cache(dir.path());
+    QVERIFY(cache.keepCompressedTiles());
+    cache.setKeepCompressedTiles(false);
+
+    cache.insert(spec, tileBytes(Qt::red), QStringLiteral("png"));
+    QVERIFY(cache.memoryUsage() > 0);
+    QVERIFY(!cache.get(spec).isNull());
+    QCOMPARE(cache.memoryUsage(), 0);
+    QVERIFY(cache.textureUsage() > 0);
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoFileTileCache)
+
+#include "tst_qgeofiletilecache.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeogridindex
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeogridindex.cpp
+
+QT += location testlib
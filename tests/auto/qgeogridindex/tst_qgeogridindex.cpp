@@ -0,0 +1,188 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgeogridindex_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoGridIndex : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void points();
+    void rects();
+    void replaceAndRemove();
+    void largeRects();
+    void cellSize();
+    void shiftIds();
+    void randomized();
+};
+
+void tst_QGeoGridIndex::points()
+{
+    QGeoGridIndex index(10.0);
+    index.insert(1, QRectF(5, 5, 0, 0));
+    index.insert(2, QRectF(15, 5, 0, 0));
+    index.insert(3, QRectF(-5, -5, 0, 0));
+    QCOMPARE(index.count(), 3);
+
+    QCOMPARE(index.intersecting(QRectF(0, 0, 20, 10)), QVector<int>() << 1 << 2);
+    QCOMPARE(index.intersecting(QRectF(-10, -10, 20, 20)), QVector<int>() << 1 << 3);
+    QCOMPARE(index.containing(QPointF(15, 5)), QVector<int>() << 2);
+    QVERIFY(index.containing(QPointF(16, 5)).isEmpty());
+
+    // edges count
+    QCOMPARE(index.intersecting(QRectF(15, 5, 10, 10)), QVector<int>() << 2);
+}
+
+void tst_QGeoGridIndex::rects()
+{
+    QGeoGridIndex index(10.0);
+    index.insert(1, QRectF(0, 0, 25, 25));
+    index.insert(2, QRectF(30, 30, 5, 5));
+
+    QCOMPARE(index.containing(QPointF(24, 1)), QVector<int>() << 1);
+    QCOMPARE(index.intersecting(QRectF(20, 20, 20, 20)), QVector<int>() << 1 << 2);
+    QVERIFY(index.intersecting(QRectF(26, 0, 3, 40)).isEmpty());
+
+    // given with a negative size
+    index.insert(3, QRectF(50, 50, -10, -10));
+    QCOMPARE(index.containing(QPointF(45, 45)), QVector<int>() << 3);
+}
+
+void tst_QGeoGridIndex::replaceAndRemove()
+{
+    QGeoGridIndex index(10.0);
+    index.insert(1, QRectF(0, 0, 5, 5));
+    index.insert(1, QRectF(100, 100, 5, 5));
+    QCOMPARE(index.count(), 1);
+    QVERIFY(index.containing(QPointF(1, 1)).isEmpty());
+    QCOMPARE(index.containing(QPointF(101, 101)), QVector<int>() << 1);
+    QCOMPARE(index.rect(1), QRectF(100, 100, 5, 5));
+
+    QVERIFY(index.remove(1));
+    QVERIFY(!index.remove(1));
+    QVERIFY(!index.contains(1));
+    QVERIFY(index.containing(QPointF(101, 101)).isEmpty());
+
+    index.insert(2, QRectF(qQNaN(), 0, 1, 1));
+    QVERIFY(!index.contains(2));
+}
+
+void tst_QGeoGridIndex::largeRects()
+{
+    QGeoGridIndex index(1.0);
+    index.insert(1, QRectF(0, 0, 1000, 1000));
+    index.insert(2, QRectF(2, 2, 0, 0));
+
+    QCOMPARE(index.containing(QPointF(2, 2)), QVector<int>() << 1 << 2);
+    QCOMPARE(index.containing(QPointF(500, 500)), QVector<int>() << 1);
+    QVERIFY(index.containing(QPointF(1001, 500)).isEmpty());
+
+    QVERIFY(index.remove(1));
+    QCOMPARE(index.containing(QPointF(2, 2)), QVector<int>() << 2);
+}
+
+void tst_QGeoGridIndex::cellSize()
+{
+    QGeoGridIndex index(1.0);
+    index.insert(1, QRectF(0.5, 0.5, 0, 0));
+    index.insert(2, QRectF(3.5, 3.5, 1, 1));
+
+    index.setCellSize(100.0);
+    QCOMPARE(index.cellSize(), 100.0);
+    QCOMPARE(index.count(), 2);
+    QCOMPARE(index.intersecting(QRectF(0, 0, 4, 4)), QVector<int>() << 1 << 2);
+    QCOMPARE(index.containing(QPointF(4, 4)), QVector<int>() << 2);
+}
+
+void tst_QGeoGridIndex::shiftIds()
+{
+    QGeoGridIndex index(10.0);
+    index.insert(0, QRectF(5, 5, 0, 0));
+    index.insert(1, QRectF(15, 5, 0, 0));
+    index.insert(2, QRectF(0, 0, 1000, 1000));
+    index.insert(3, QRectF(25, 5, 0, 0));
+
+    // two rows inserted before row 1
+    index.shiftIds(1, 2);
+    QCOMPARE(index.count(), 4);
+    QCOMPARE(index.containing(QPointF(5, 5)), QVector<int>() << 0 << 4);
+    QCOMPARE(index.containing(QPointF(15, 5)), QVector<int>() << 3 << 4);
+    QCOMPARE(index.containing(QPointF(25, 5)), QVector<int>() << 4 << 5);
+    QCOMPARE(index.rect(5), QRectF(25, 5, 0, 0));
+    QVERIFY(!index.contains(1));
+
+    // row 3 removed
+    QVERIFY(index.remove(3));
+    index.shiftIds(4, -1);
+    QCOMPARE(index.intersecting(QRectF(0, 0, 30, 10)), QVector<int>() << 0 << 3 << 4);
+    QCOMPARE(index.containing(QPointF(25, 5)), QVector<int>() << 3 << 4);
+    QVERIFY(index.remove(4));
+    QCOMPARE(index.containing(QPointF(25, 5)), QVector<int>() << 3);
+}
+
+void tst_QGeoGridIndex::randomized()
+{
+    // compare to testing every rectangle
+    qsrand(42);
+    QGeoGridIndex index(16.0);
+    QHash<int, QRectF> rects;
+    for (int i = 0; i < 2000; ++i) {
+        const int id = qrand() % 500;
+        if (qrand() % 4 == 0) {
+            QCOMPARE(index.remove(id), rects.remove(id) > 0);
+            continue;
+        }
+        const QRectF r(qrand() % 1000, qrand() % 1000, qrand() % 60, qrand() % 60);
+        index.insert(id, r);
+        rects.insert(id, r);
+    }
+    QCOMPARE(index.count(), rects.size());
+
+    for (int i = 0; i < 200; ++i) {
+        const QRectF query(qrand() % 1000, qrand() % 1000, qrand() % 200, qrand() % 200);
+        QVector<int> expected;
+        for (QHash<int, QRectF>::const_iterator it = rects.constBegin(); it != rects.constEnd(); ++it) {
+            const QRectF r = it.value();
+            if (r.left() <= query.right() && query.left() <= r.right()
+                    && r.top() <= query.bottom() && query.top() <= r.bottom()) {
+                expected.append(it.key());
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        QCOMPARE(index.intersecting(query), expected);
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoGridIndex)
+
+#include "tst_qgeogridindex.moc"
@@ -5,4 +5,4 @@ INCLUDEPATH += ../../../src/location/maps
 
 SOURCES += tst_qgeomapscene.cpp
 
-QT += location positioning-private testlib
+QT += location positioning-private quick testlib
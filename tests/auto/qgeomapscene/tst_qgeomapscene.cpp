@@ -33,6 +33,7 @@
 #include "qgeocameratiles_p.h"
 #include "qgeocameradata_p.h"
 #include "qabstractgeotilecache_p.h"
+#include "qgeotileatlas_p.h"
 
 #include <QtPositioning/private/qgeoprojection_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
@@ -41,6 +42,8 @@
 
 #include <QList>
 #include <QPair>
+#include <QColor>
+#include <QtQuick/QSGGeometryNode>
 #include <QDebug>
 
 #include <cmath>
@@ -269,6 +272,16 @@ class tst_QGeoMapScene : public QObject
         screenCameraPositions(name, zoom, tileSize, screenWidth, screenHeight);
     }
 
+    private:
+        static void collectGeometryNodes(QSGNode *node, QList<QSGGeometryNode *> *nodes)
+        {
+            if (node->type() == QSGNode::GeometryNode
+                    && static_cast<QSGGeometryNode *>(node)->geometry()->vertexCount() > 0)
+                nodes->append(static_cast<QSGGeometryNode *>(node));
+            for (QSGNode *child = node->firstChild(); child; child = child->nextSibling())
+                collectGeometryNodes(child, nodes);
+        }
+
     private slots:
 
        void useVerticalLock(){
@@ -302,6 +315,157 @@ class tst_QGeoMapScene : public QObject
             QVERIFY(!mapScene2.verticalLock());
         }
 
+        void atlasLayout(){
+            // a 110px page holds a 3x3 grid of 32px tiles with 1px gutters
+            QGeoTileAtlasLayout atlas(110, 32);
+            QCOMPARE(atlas.pageSize(), 102);
+            QCOMPARE(atlas.tilesPerPage(), 9);
+            QCOMPARE(atlas.pageCount(), 0);
+
+            QList<QGeoTileSpec> specs;
+            for (int i = 0; i < 10; ++i)
+                specs << QGeoTileSpec("test", 1, 4, i, 0);
+
+            for (int i = 0; i < 9; ++i) {
+                QGeoTileAtlasLayout::Slot slot = atlas.insert(specs.at(i));
+                QCOMPARE(slot.page, 0);
+                QCOMPARE(slot.index, i);
+            }
+            QCOMPARE(atlas.pageCount(), 1);
+            QCOMPARE(atlas.pixelRect(atlas.slot(specs.at(4))), QRect(35, 35, 32, 32));
+
+            // inserting twice keeps the slot
+            QCOMPARE(atlas.insert(specs.at(4)).index, 4);
+            QCOMPARE(atlas.count(), 9);
+
+            // a full page starts a new one
+            QGeoTileAtlasLayout::Slot slot = atlas.insert(specs.at(9));
+            QCOMPARE(slot.page, 1);
+            QCOMPARE(slot.index, 0);
+            QCOMPARE(atlas.pageCount(), 2);
+
+            // freed slots on the first page are reused before the second page fills
+            atlas.remove(specs.at(2));
+            QVERIFY(!atlas.contains(specs.at(2)));
+            QVERIFY(!atlas.slot(specs.at(2)).isValid());
+            slot = atlas.insert(QGeoTileSpec("test", 1, 4, 0, 1));
+            QCOMPARE(slot.page, 0);
+            QCOMPARE(slot.index, 2);
+
+            // texture coordinates cover all texels of the tile, the gutter is outside
+            QRectF rect = atlas.textureRect(slot);
+            QVERIFY(qFuzzyCompare(rect.left(), 69.0 / 102.0));
+            QVERIFY(qFuzzyCompare(rect.right(), 101.0 / 102.0));
+            QVERIFY(qFuzzyCompare(rect.top(), 1.0 / 102.0));
+            QVERIFY(qFuzzyCompare(rect.bottom(), 33.0 / 102.0));
+        }
+
+        void atlasGutter(){
+            QImage tile(4, 4, QImage::Format_RGB32);
+            for (int y = 0; y < 4; ++y)
+                for (int x = 0; x < 4; ++x)
+                    tile.setPixel(x, y, qRgb(x * 60, y * 60, 0));
+
+            QImage padded = QGeoTileAtlasLayout::paddedTile(tile, 4);
+            QCOMPARE(padded.size(), QSize(6, 6));
+
+            // the tile itself is untouched
+            for (int y = 0; y < 4; ++y)
+                for (int x = 0; x < 4; ++x)
+                    QCOMPARE(QColor(padded.pixel(x + 1, y + 1)), QColor(tile.pixel(x, y)));
+
+            // edges and corners repeat the outermost texels of the tile
+            for (int i = 0; i < 4; ++i) {
+                QCOMPARE(QColor(padded.pixel(0, i + 1)), QColor(tile.pixel(0, i)));
+                QCOMPARE(QColor(padded.pixel(5, i + 1)), QColor(tile.pixel(3, i)));
+                QCOMPARE(QColor(padded.pixel(i + 1, 0)), QColor(tile.pixel(i, 0)));
+                QCOMPARE(QColor(padded.pixel(i + 1, 5)), QColor(tile.pixel(i, 3)));
+            }
+            QCOMPARE(QColor(padded.pixel(0, 0)), QColor(tile.pixel(0, 0)));
+            QCOMPARE(QColor(padded.pixel(5, 5)), QColor(tile.pixel(3, 3)));
+
+            // tiles of another size are scaled to the slot
+            QCOMPARE(QGeoTileAtlasLayout::paddedTile(tile, 8).size(), QSize(10, 10));
+        }
+
+        void fallbackParentDrawn(){
+            QGeoCameraData camera;
+            camera.setZoomLevel(2.0);
+            camera.setCenter(QGeoCoordinate(0.0, 0.0));
+
+            QGeoCameraTiles ct;
+            ct.setMaximumZoomLevel(8);
+            ct.setTileSize(256);
+            ct.setCameraData(camera);
+            ct.setScreenSize(QSize(512, 512));
+
+            QGeoMapScene mapScene;
+            mapScene.setTileSize(256);
+            mapScene.setScreenSize(QSize(512, 512));
+            mapScene.setCameraData(camera);
+            mapScene.setVisibleTiles(ct.visibleTiles());
+            QVERIFY(!ct.visibleTiles().isEmpty());
+
+            // none of the visible tiles has arrived, only their parents are cached
+            QImage image(256, 256, QImage::Format_RGB32);
+            image.fill(Qt::red);
+            QHash<QGeoTileSpec, QSharedPointer<QGeoTileTexture> > fallbacks;
+            foreach (const QGeoTileSpec &spec, ct.visibleTiles()) {
+                const QGeoTileSpec parent = QGeoMapScene::fallbackCandidates(spec).first();
+                QCOMPARE(parent.zoom(), spec.zoom() - 1);
+                QSharedPointer<QGeoTileTexture> texture(new QGeoTileTexture);
+                texture->spec = parent;
+                texture->image = image;
+                fallbacks.insert(parent, texture);
+            }
+            mapScene.setFallbackTiles(fallbacks);
+            QVERIFY(mapScene.texturedTiles().isEmpty());
+
+            QScopedPointer<QSGNode> root(mapScene.updateSceneGraph(0, 0));
+            QVERIFY(root);
+
+            QList<QSGGeometryNode *> nodes;
+            collectGeometryNodes(root.data(), &nodes);
+
+            // each quad shows one quarter of its parent's atlas slot
+            QGeoTileAtlasLayout layout(2048, 256);
+            const double quarter = layout.textureRect(QGeoTileAtlasLayout::Slot(0, 0)).width() / 2.0;
+            int quads = 0;
+            foreach (QSGGeometryNode *node, nodes) {
+                const QSGGeometry *geometry = node->geometry();
+                const QSGGeometry::TexturedPoint2D *v = geometry->vertexDataAsTexturedPoint2D();
+                for (int i = 0; i + 6 <= geometry->vertexCount(); i += 6, ++quads) {
+                    double minTx = v[i].tx, maxTx = v[i].tx;
+                    for (int j = 1; j < 6; ++j) {
+                        minTx = qMin(minTx, double(v[i + j].tx));
+                        maxTx = qMax(maxTx, double(v[i + j].tx));
+                    }
+                    QVERIFY(qAbs((maxTx - minTx) - quarter) < 1e-5);
+                }
+            }
+            QVERIFY(quads > 0);
+        }
+
+        void fallbackCandidates(){
+            QGeoTileSpec spec("test", 1, 5, 13, 6, 2);
+            QList<QGeoTileSpec> candidates = QGeoMapScene::fallbackCandidates(spec);
+
+            // nearest ancestors first, then the four children
+            QCOMPARE(candidates.size(), 8);
+            QCOMPARE(candidates.at(0), QGeoTileSpec("test", 1, 4, 6, 3, 2));
+            QCOMPARE(candidates.at(1), QGeoTileSpec("test", 1, 3, 3, 1, 2));
+            QCOMPARE(candidates.at(3), QGeoTileSpec("test", 1, 1, 0, 0, 2));
+            QCOMPARE(candidates.at(4), QGeoTileSpec("test", 1, 6, 26, 12, 2));
+            QCOMPARE(candidates.at(5), QGeoTileSpec("test", 1, 6, 27, 12, 2));
+            QCOMPARE(candidates.at(6), QGeoTileSpec("test", 1, 6, 26, 13, 2));
+            QCOMPARE(candidates.at(7), QGeoTileSpec("test", 1, 6, 27, 13, 2));
+
+            // there is nothing above zoom level 0
+            candidates = QGeoMapScene::fallbackCandidates(QGeoTileSpec("test", 1, 1, 1, 0));
+            QCOMPARE(candidates.size(), 5);
+            QCOMPARE(candidates.first(), QGeoTileSpec("test", 1, 0, 0, 0));
+        }
+
         void screenToMercatorPositions(){
             QFETCH(double, screenX);
             QFETCH(double, screenY);
@@ -381,6 +545,46 @@ class tst_QGeoMapScene : public QObject
             populateScreenMercatorData();
         }
 
+        void mercatorTransform(){
+            QFETCH(double, screenX);
+            QFETCH(double, screenY);
+            QFETCH(double, cameraCenterX);
+            QFETCH(double, cameraCenterY);
+            QFETCH(double, zoom);
+            QFETCH(int, tileSize);
+            QFETCH(int, screenWidth);
+            QFETCH(int, screenHeight);
+            QFETCH(double, mercatorX);
+            QFETCH(double, mercatorY);
+
+            QGeoCameraData camera;
+            camera.setZoomLevel(zoom);
+            camera.setCenter(QGeoProjection::mercatorToCoord(QDoubleVector2D(cameraCenterX, cameraCenterY)));
+
+            QGeoMapScene mapGeometry;
+            mapGeometry.setTileSize(tileSize);
+            mapGeometry.setScreenSize(QSize(screenWidth,screenHeight));
+            mapGeometry.setCameraData(camera);
+
+            QGeoMercatorTransform transform = mapGeometry.mercatorTransform();
+            QVERIFY(transform.isValid());
+
+            double mercator[2] = { mercatorX, mercatorY };
+            double position[2];
+            transform.map(mercator, position, 1);
+
+            QVERIFY(qAbs(position[0] - screenX) < 1e-6);
+            QVERIFY(qAbs(position[1] - screenY) < 1e-6);
+
+            QDoubleVector2D point = transform.map(QDoubleVector2D(mercatorX, mercatorY));
+            QCOMPARE(point.x(), position[0]);
+            QCOMPARE(point.y(), position[1]);
+        }
+
+        void mercatorTransform_data(){
+            populateScreenMercatorData();
+        }
+
 };
 
 QTEST_GUILESS_MAIN(tst_QGeoMapScene)
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeopathsimplifier
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeopathsimplifier.cpp
+
+QT += location testlib
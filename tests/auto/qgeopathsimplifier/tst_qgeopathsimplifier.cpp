@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgeopathsimplifier_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoPathSimplifier : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void shortPaths();
+    void zigzag_data();
+    void zigzag();
+    void collinear();
+    void nested();
+};
+
+static QVector<int> select(const QVector<double> &points, double tolerance)
+{
+    QGeoPathSimplifier simplifier;
+    simplifier.build(points.constData(), points.size() / 2);
+    QVector<int> indices;
+    simplifier.select(tolerance, &indices);
+    return indices;
+}
+
+void tst_QGeoPathSimplifier::shortPaths()
+{
+    QGeoPathSimplifier simplifier;
+    QVector<int> indices;
+    simplifier.select(1.0, &indices);
+    QVERIFY(indices.isEmpty());
+
+    QVector<double> points;
+    points << 0 << 0;
+    QCOMPARE(select(points, 1.0), QVector<int>() << 0);
+
+    points << 5 << 5;
+    QCOMPARE(select(points, 100.0), QVector<int>() << 0 << 1);
+
+    simplifier.build(points.constData(), 2);
+    QCOMPARE(simplifier.count(), 2);
+    QCOMPARE(simplifier.tolerance(0), qInf());
+    QCOMPARE(simplifier.tolerance(1), qInf());
+}
+
+void tst_QGeoPathSimplifier::zigzag_data()
+{
+    QTest::addColumn<double>("tolerance");
+    QTest::addColumn<QVector<int> >("expected");
+
+    QTest::newRow("all") << 0.0 << (QVector<int>() << 0 << 1 << 2 << 3 << 4);
+    QTest::newRow("small") << 0.5 << (QVector<int>() << 0 << 1 << 2 << 3 << 4);
+    QTest::newRow("medium") << 1.0 << (QVector<int>() << 0 << 1 << 3 << 4);
+    QTest::newRow("large") << 3.0 << (QVector<int>() << 0 << 3 << 4);
+    QTest::newRow("huge") << 10.0 << (QVector<int>() << 0 << 4);
+}
+
+void tst_QGeoPathSimplifier::zigzag()
+{
+    QFETCH(double, tolerance);
+    QFETCH(QVector<int>, expected);
+
+    // a peak of 4 with a dent below the line before it
+    QVector<double> points;
+    points << 0 << 0 << 2 << -2 << 4 << 0 << 6 << 4 << 8 << 0;
+
+    QCOMPARE(select(points, tolerance), expected);
+}
+
+void tst_QGeoPathSimplifier::collinear()
+{
+    QVector<double> points;
+    for (int i = 0; i < 10; ++i)
+        points << i << 2 * i;
+
+    QCOMPARE(select(points, 0.001), QVector<int>() << 0 << 9);
+    QCOMPARE(select(points, 0.0).size(), 10);
+}
+
+void tst_QGeoPathSimplifier::nested()
+{
+    // a vertex is never kept at a tolerance at which the vertex that split
+    // its span is dropped, even if it deviates more from its own span
+    QVector<double> points;
+    points << 0 << 0 << 10 << 0 << 1 << -5 << 4 << 5 << 10 << 0;
+
+    QGeoPathSimplifier simplifier;
+    simplifier.build(points.constData(), 5);
+    QCOMPARE(simplifier.tolerance(2), 5.0);
+    QCOMPARE(simplifier.tolerance(1), 5.0);
+    QVERIFY(simplifier.tolerance(3) <= 5.0);
+
+    QCOMPARE(select(points, 6.0), QVector<int>() << 0 << 4);
+    QCOMPARE(select(points, 5.0).size(), 5);
+
+    // every tolerance gives a subset of the one below
+    QVector<int> previous = select(points, 0.0);
+    for (double tolerance = 0.5; tolerance < 12.0; tolerance += 0.5) {
+        const QVector<int> indices = select(points, tolerance);
+        foreach (int index, indices)
+            QVERIFY(previous.contains(index));
+        previous = indices;
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoPathSimplifier)
+
+#include "tst_qgeopathsimplifier.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeopolygonclipper
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeopolygonclipper.cpp
+
+QT += location testlib
@@ -0,0 +1,187 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgeopolygonclipper_p.h"
+
+QT_USE_NAMESPACE
+
+typedef QGeoPolygonClipper::Ring Ring;
+
+class tst_QGeoPolygonClipper : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void orient();
+    void convex_data();
+    void convex();
+    void concaveSplit();
+    void holeInside();
+    void holeAcrossBorder();
+    void containsRect();
+    void outside();
+};
+
+static Ring ring(const QList<double> &values)
+{
+    Ring r;
+    foreach (double v, values)
+        r << v;
+    return r;
+}
+
+static double totalArea(const QVector<Ring> &rings)
+{
+    double area = 0.0;
+    foreach (const Ring &r, rings)
+        area += QGeoPolygonClipper::signedArea(r);
+    return area;
+}
+
+void tst_QGeoPolygonClipper::orient()
+{
+    // both given clockwise in the signed area sense
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << 0 << 0 << 0 << 10 << 10 << 10 << 10 << 0)
+          << ring(QList<double>() << 2 << 2 << 2 << 4 << 4 << 4 << 4 << 2);
+    QVERIFY(QGeoPolygonClipper::signedArea(rings.at(0)) < 0.0);
+
+    QGeoPolygonClipper::orient(rings);
+    QCOMPARE(QGeoPolygonClipper::signedArea(rings.at(0)), 100.0);
+    QCOMPARE(QGeoPolygonClipper::signedArea(rings.at(1)), -4.0);
+}
+
+void tst_QGeoPolygonClipper::convex_data()
+{
+    QTest::addColumn<Ring>("polygon");
+    QTest::addColumn<double>("area");
+
+    QTest::newRow("inside") << ring(QList<double>() << 2 << 2 << 8 << 2 << 8 << 8 << 2 << 8) << 36.0;
+    QTest::newRow("overlapping") << ring(QList<double>() << 5 << 5 << 15 << 5 << 15 << 15 << 5 << 15) << 25.0;
+    QTest::newRow("covering") << ring(QList<double>() << -5 << -5 << 15 << -5 << 15 << 15 << -5 << 15) << 100.0;
+    QTest::newRow("triangle") << ring(QList<double>() << 0 << 0 << 16 << 0 << 0 << 16) << 92.0;
+    QTest::newRow("outside") << ring(QList<double>() << 20 << 20 << 30 << 20 << 30 << 30) << 0.0;
+}
+
+void tst_QGeoPolygonClipper::convex()
+{
+    QFETCH(Ring, polygon);
+    QFETCH(double, area);
+
+    QVector<Ring> rings;
+    rings << polygon;
+    QGeoPolygonClipper::orient(rings);
+    QVERIFY(QGeoPolygonClipper::isConvex(rings.first()));
+
+    QVector<Ring> clipped = QGeoPolygonClipper::clip(rings, QRectF(0, 0, 10, 10));
+    QCOMPARE(clipped.size(), area > 0.0 ? 1 : 0);
+    QVERIFY(qAbs(totalArea(clipped) - area) < 1e-9);
+}
+
+void tst_QGeoPolygonClipper::concaveSplit()
+{
+    // a U whose legs stick out of the bottom of the rectangle: the bottom
+    // edge must not join the two legs
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << 0 << 0 << 30 << 0 << 30 << 30 << 20 << 30
+                                  << 20 << 10 << 10 << 10 << 10 << 30 << 0 << 30);
+    QGeoPolygonClipper::orient(rings);
+    QVERIFY(!QGeoPolygonClipper::isConvex(rings.first()));
+
+    QVector<Ring> clipped = QGeoPolygonClipper::clip(rings, QRectF(-5, 20, 40, 20));
+    QCOMPARE(clipped.size(), 2);
+    foreach (const Ring &r, clipped) {
+        QCOMPARE(r.size(), 8);
+        QCOMPARE(QGeoPolygonClipper::signedArea(r), 100.0);
+    }
+}
+
+void tst_QGeoPolygonClipper::holeInside()
+{
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << -10 << 4 << 20 << 4 << 20 << 6 << -10 << 6)
+          << ring(QList<double>() << -10 << -10 << 20 << -10 << 20 << 20 << -10 << 20)
+          << ring(QList<double>() << 2 << 2 << 8 << 2 << 8 << 3 << 2 << 3);
+    QGeoPolygonClipper::orient(rings);
+
+    // a strip across the rectangle and a small hole, both inside the outer ring
+    QVERIFY(QGeoPolygonClipper::signedArea(rings.at(0)) < 0.0);
+    QVERIFY(QGeoPolygonClipper::signedArea(rings.at(2)) < 0.0);
+
+    QVector<Ring> clipped = QGeoPolygonClipper::clip(rings, QRectF(0, 0, 10, 10));
+    QVERIFY(qAbs(totalArea(clipped) - (100.0 - 20.0 - 6.0)) < 1e-9);
+
+    int holes = 0;
+    foreach (const Ring &r, clipped) {
+        if (QGeoPolygonClipper::signedArea(r) < 0.0)
+            ++holes;
+    }
+    QCOMPARE(holes, 1);
+}
+
+void tst_QGeoPolygonClipper::holeAcrossBorder()
+{
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << 0 << 0 << 10 << 0 << 10 << 10 << 0 << 10)
+          << ring(QList<double>() << 4 << 4 << 6 << 4 << 6 << 6 << 4 << 6);
+    QGeoPolygonClipper::orient(rings);
+
+    // the hole reaches the border of the clip rectangle and becomes a notch
+    // in the outer ring
+    QVector<Ring> clipped = QGeoPolygonClipper::clip(rings, QRectF(5, 0, 10, 10));
+    QCOMPARE(clipped.size(), 1);
+    QCOMPARE(QGeoPolygonClipper::signedArea(clipped.first()), 50.0 - 2.0);
+}
+
+void tst_QGeoPolygonClipper::containsRect()
+{
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << -100 << -100 << 100 << -100 << 0 << 0 << 100 << 100 << -100 << 100);
+    QGeoPolygonClipper::orient(rings);
+
+    QVector<Ring> clipped = QGeoPolygonClipper::clip(rings, QRectF(-50, -10, 20, 20));
+    QCOMPARE(clipped.size(), 1);
+    QCOMPARE(QGeoPolygonClipper::signedArea(clipped.first()), 400.0);
+}
+
+void tst_QGeoPolygonClipper::outside()
+{
+    // concave, around the rectangle without containing it
+    QVector<Ring> rings;
+    rings << ring(QList<double>() << -10 << -10 << 20 << -10 << 20 << 20 << 15 << 20
+                                  << 15 << -5 << -5 << -5 << -5 << 20 << -10 << 20);
+    QGeoPolygonClipper::orient(rings);
+
+    QVERIFY(QGeoPolygonClipper::clip(rings, QRectF(0, 0, 10, 10)).isEmpty());
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoPolygonClipper)
+
+#include "tst_qgeopolygonclipper.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotilefetcher
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeotilefetcher.cpp
+
+QT += location network testlib
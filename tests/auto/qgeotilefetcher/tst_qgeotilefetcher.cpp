@@ -0,0 +1,413 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtCore/QPointer>
+
+#include "qgeotilefetcher_p.h"
+#include "qgeotiledmapreply_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+// Minimal HTTP/1.1 tile server. Requests are answered straight away, or held
+// until release() when holdResponses is set, so tests can look at what is in
+// flight.
+class TileServerStub : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    TileServerStub() : holdResponses(false), connections(0) {}
+
+    struct Request
+    {
+        QPointer<QTcpSocket> socket;
+        QByteArray host;
+        QByteArray path;
+    };
+
+    bool holdResponses;
+    int connections;
+    QList<Request> pending;
+    QList<QByteArray> paths;
+    QHash<QByteArray, int> maxPendingPerHost;
+
+    int pendingFor(const QByteArray &host) const
+    {
+        int count = 0;
+        foreach (const Request &request, pending) {
+            if (request.host == host)
+                ++count;
+        }
+        return count;
+    }
+
+    void release()
+    {
+        QList<Request> requests = pending;
+        pending.clear();
+        foreach (const Request &request, requests)
+            respond(request);
+    }
+
+protected:
+    void incomingConnection(qintptr handle) Q_DECL_OVERRIDE
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(handle);
+        ++connections;
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+
+private Q_SLOTS:
+    void readRequests()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &buffer = buffers_[socket];
+        buffer += socket->readAll();
+
+        int end;
+        while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+            QList<QByteArray> lines = buffer.left(end).split('\n');
+            buffer.remove(0, end + 4);
+
+            Request request;
+            request.socket = socket;
+            request.path = lines.first().split(' ').value(1);
+            foreach (const QByteArray &line, lines) {
+                if (line.toLower().startsWith("host:"))
+                    request.host = line.mid(5).trimmed();
+            }
+            paths << request.path;
+
+            if (holdResponses) {
+                pending << request;
+                maxPendingPerHost[request.host] = qMax(maxPendingPerHost.value(request.host),
+                                                       pendingFor(request.host));
+            } else {
+                respond(request);
+            }
+        }
+    }
+
+private:
+    void respond(const Request &request)
+    {
+        if (!request.socket)
+            return;
+
+        QByteArray body = request.path;
+        request.socket->write("HTTP/1.1 200 OK\r\n"
+                              "Content-Type: image/png\r\n"
+                              "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                              "\r\n" + body);
+    }
+
+    QHash<QTcpSocket *, QByteArray> buffers_;
+};
+
+class StubTileReply : public QGeoTiledMapReply
+{
+    Q_OBJECT
+
+public:
+    StubTileReply(QNetworkReply *reply, const QGeoTileSpec &spec, QObject *parent = 0)
+        : QGeoTiledMapReply(spec, parent), m_reply(reply)
+    {
+        connect(m_reply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
+    }
+
+    ~StubTileReply()
+    {
+        if (m_reply)
+            m_reply->deleteLater();
+    }
+
+    void abort() Q_DECL_OVERRIDE
+    {
+        if (m_reply)
+            m_reply->abort();
+    }
+
+private Q_SLOTS:
+    void networkReplyFinished()
+    {
+        if (m_reply->error() != QNetworkReply::NoError) {
+            setError(QGeoTiledMapReply::CommunicationError, m_reply->errorString());
+        } else {
+            setMapImageData(m_reply->readAll());
+            setMapImageFormat(QStringLiteral("png"));
+        }
+        setFinished(true);
+    }
+
+private:
+    QPointer<QNetworkReply> m_reply;
+};
+
+// Map id 1 is served from 127.0.0.1 and map id 2 from localhost, which the
+// network layer treats as two hosts even though both reach the same stub.
+class StubTileFetcher : public QGeoTileFetcher
+{
+    Q_OBJECT
+
+public:
+    StubTileFetcher(quint16 port, int maxRequests, int maxPerHost)
+        : m_networkManager(new QNetworkAccessManager(this)), m_port(port)
+    {
+        setMaximumConcurrentRequests(maxRequests);
+        setMaximumRequestsPerHost(maxPerHost);
+    }
+
+protected:
+    QString tileHost(const QGeoTileSpec &spec) const Q_DECL_OVERRIDE
+    {
+        return spec.mapId() == 2 ? QStringLiteral("localhost") : QStringLiteral("127.0.0.1");
+    }
+
+private:
+    QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec) Q_DECL_OVERRIDE
+    {
+        QUrl url;
+        url.setScheme(QStringLiteral("http"));
+        url.setHost(tileHost(spec));
+        url.setPort(m_port);
+        url.setPath(QLatin1Char('/') + QString::number(spec.zoom()) + QLatin1Char('/') +
+                    QString::number(spec.x()) + QLatin1Char('/') + QString::number(spec.y()));
+
+        QNetworkRequest request(url);
+        request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+        return new StubTileReply(m_networkManager->get(request), spec);
+    }
+
+    QNetworkAccessManager *m_networkManager;
+    quint16 m_port;
+};
+
+class tst_QGeoTileFetcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void priorityOrder();
+    void updatePriorities();
+    void perHostLimit();
+    void keepAlive();
+    void cancelInFlight();
+    void countersFromSlot();
+
+private:
+    static QGeoTileSpec tile(int mapId, int x);
+
+    TileServerStub *server_;
+};
+
+QGeoTileSpec tst_QGeoTileFetcher::tile(int mapId, int x)
+{
+    return QGeoTileSpec(QStringLiteral("stub"), mapId, 10, x, 0);
+}
+
+void tst_QGeoTileFetcher::init()
+{
+    qRegisterMetaType<QGeoTileSpec>();
+
+    server_ = new TileServerStub;
+    QVERIFY(server_->listen(QHostAddress::Any));
+}
+
+void tst_QGeoTileFetcher::cleanup()
+{
+    delete server_;
+    server_ = 0;
+}
+
+void tst_QGeoTileFetcher::priorityOrder()
+{
+    StubTileFetcher fetcher(server_->serverPort(), 1, 1);
+    QSignalSpy finished(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+
+    QGeoTilePriorityHash tiles;
+    tiles.insert(tile(1, 5), 500);
+    tiles.insert(tile(1, 1), 100);
+    tiles.insert(tile(1, 3), 300);
+    tiles.insert(tile(1, 4), 300);
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+
+    // re-prioritising a queued tile moves it in the queue
+    QGeoTilePriorityHash bump;
+    bump.insert(tile(1, 4), 200);
+    fetcher.updateTileRequests(bump, QSet<QGeoTileSpec>());
+
+    QTRY_COMPARE(finished.count(), 4);
+    QCOMPARE(server_->paths, QList<QByteArray>() << "/10/1/0" << "/10/4/0" << "/10/3/0" << "/10/5/0");
+    QCOMPARE(fetcher.completedRequests(), qint64(4));
+    QCOMPARE(fetcher.queuedRequests(), 0);
+    QCOMPARE(fetcher.inFlightRequests(), 0);
+}
+
+void tst_QGeoTileFetcher::updatePriorities()
+{
+    StubTileFetcher fetcher(server_->serverPort(), 1, 1);
+    QSignalSpy finished(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+
+    QGeoTilePriorityHash tiles;
+    for (int x = 0; x < 4; ++x)
+        tiles.insert(tile(1, x), x);
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+
+    // the camera moved to the other end of the row
+    QGeoTilePriorityHash moved;
+    for (int x = 0; x < 4; ++x)
+        moved.insert(tile(1, x), 3 - x);
+    // tiles that were never requested are not picked up by a priority update
+    moved.insert(tile(1, 9), 0);
+    fetcher.updateTilePriorities(moved);
+    QCOMPARE(fetcher.queuedRequests(), 4);
+
+    QTRY_COMPARE(finished.count(), 4);
+    QCOMPARE(server_->paths, QList<QByteArray>() << "/10/3/0" << "/10/2/0" << "/10/1/0" << "/10/0/0");
+    QCOMPARE(fetcher.queuedRequests(), 0);
+}
+
+void tst_QGeoTileFetcher::perHostLimit()
+{
+    server_->holdResponses = true;
+
+    StubTileFetcher fetcher(server_->serverPort(), 3, 2);
+    QSignalSpy finished(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+
+    QGeoTilePriorityHash tiles;
+    for (int x = 0; x < 6; ++x) {
+        tiles.insert(tile(1, x), x);
+        tiles.insert(tile(2, x), 10 + x);
+    }
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+
+    // two on the more urgent host, the third slot goes to the other one
+    QTRY_COMPARE(server_->pending.size(), 3);
+    QCOMPARE(fetcher.inFlightRequests(), 3);
+    QCOMPARE(fetcher.queuedRequests(), 9);
+    QCOMPARE(server_->pendingFor(QByteArrayLiteral("127.0.0.1:") + QByteArray::number(server_->serverPort())), 2);
+
+    for (int i = 0; i < 250 && finished.count() < 12; ++i) {
+        server_->release();
+        QTest::qWait(20);
+    }
+
+    QCOMPARE(finished.count(), 12);
+    QCOMPARE(fetcher.completedRequests(), qint64(12));
+    foreach (int count, server_->maxPendingPerHost)
+        QVERIFY(count <= 2);
+}
+
+void tst_QGeoTileFetcher::keepAlive()
+{
+    StubTileFetcher fetcher(server_->serverPort(), 2, 2);
+    QSignalSpy finished(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+
+    QGeoTilePriorityHash tiles;
+    for (int x = 0; x < 20; ++x)
+        tiles.insert(tile(1, x), x);
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+
+    QTRY_COMPARE(finished.count(), 20);
+
+    // requests beyond the cap queue in the fetcher, so the connections opened
+    // for the first ones are reused for everything else
+    QVERIFY(server_->connections <= 2);
+}
+
+void tst_QGeoTileFetcher::cancelInFlight()
+{
+    server_->holdResponses = true;
+
+    StubTileFetcher fetcher(server_->serverPort(), 2, 2);
+    QSignalSpy finished(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+
+    QGeoTilePriorityHash tiles;
+    QSet<QGeoTileSpec> all;
+    for (int x = 0; x < 5; ++x) {
+        tiles.insert(tile(1, x), x);
+        all.insert(tile(1, x));
+    }
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+    QTRY_COMPARE(server_->pending.size(), 2);
+
+    fetcher.updateTileRequests(QGeoTilePriorityHash(), all);
+
+    // queued tiles are dropped at once, requests on the wire are left to finish
+    QCOMPARE(fetcher.queuedRequests(), 0);
+    QCOMPARE(fetcher.inFlightRequests(), 2);
+    QCOMPARE(fetcher.cancelledRequests(), qint64(3));
+
+    server_->release();
+
+    QTRY_COMPARE(fetcher.inFlightRequests(), 0);
+    QCOMPARE(fetcher.cancelledRequests(), qint64(5));
+    QCOMPARE(fetcher.completedRequests(), qint64(0));
+    QVERIFY(server_->connections <= 2);
+    QCOMPARE(server_->paths.size(), 2);
+
+    // the data still arrives so the engine can cache it
+    QTRY_COMPARE(finished.count(), 2);
+}
+
+void tst_QGeoTileFetcher::countersFromSlot()
+{
+    StubTileFetcher fetcher(server_->serverPort(), 1, 1);
+
+    // tileFinished() is emitted with the queue locked, the getters must not block
+    QList<int> queued;
+    connect(&fetcher, &QGeoTileFetcher::tileFinished, this, [&]() {
+        queued << fetcher.queuedRequests();
+        QCOMPARE(fetcher.inFlightRequests(), 0);
+        QCOMPARE(fetcher.maximumConcurrentRequests(), 1);
+    });
+
+    QGeoTilePriorityHash tiles;
+    for (int x = 0; x < 3; ++x)
+        tiles.insert(tile(1, x), x);
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+
+    QTRY_COMPARE(queued.size(), 3);
+    QCOMPARE(queued, QList<int>() << 2 << 1 << 0);
+    QCOMPARE(fetcher.completedRequests(), qint64(3));
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoTileFetcher)
+
+#include "tst_qgeotilefetcher.moc"
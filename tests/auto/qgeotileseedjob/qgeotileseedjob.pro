@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotileseedjob
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeotileseedjob.cpp
+
+QT += location positioning network testlib
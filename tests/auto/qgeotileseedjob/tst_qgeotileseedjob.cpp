@@ -0,0 +1,441 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTemporaryDir>
+#include <QtPositioning/QGeoCircle>
+#include <QtPositioning/QGeoRectangle>
+
+#include "qgeotileseedjob_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
+#include "qgeotilefetcher_p.h"
+#include "qgeotiledmapreply_p.h"
+#include "qgeofiletilecache_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+// Minimal HTTP/1.1 tile server answering every request with its path padded
+// by padding bytes, or holding the answers until release() when holdResponses
+// is set.
+class TileServerStub : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    TileServerStub() : holdResponses(false), padding(0) {}
+
+    bool holdResponses;
+    int padding;
+    QList<QPointer<QTcpSocket> > pendingSockets;
+    QList<QByteArray> pendingPaths;
+    QList<QByteArray> paths;
+
+    void release()
+    {
+        for (int i = 0; i < pendingSockets.size(); ++i)
+            respond(pendingSockets.at(i), pendingPaths.at(i) + QByteArray(padding, 'x'));
+        pendingSockets.clear();
+        pendingPaths.clear();
+    }
+
+protected:
+    void incomingConnection(qintptr handle) Q_DECL_OVERRIDE
+    {
+        QTcpSocket *socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(handle);
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+
+private Q_SLOTS:
+    void readRequests()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &buffer = buffers_[socket];
+        buffer += socket->readAll();
+
+        int end;
+        while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+            QByteArray path = buffer.left(end).split(' ').value(1);
+            buffer.remove(0, end + 4);
+            paths << path;
+
+            if (holdResponses) {
+                pendingSockets << socket;
+                pendingPaths << path;
+            } else {
+                respond(socket, path + QByteArray(padding, 'x'));
+            }
+        }
+    }
+
+private:
+    static void respond(QTcpSocket *socket, const QByteArray &body)
+    {
+        if (!socket)
+            return;
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: image/png\r\n"
+                      "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                      "\r\n" + body);
+    }
+
+    QHash<QTcpSocket *, QByteArray> buffers_;
+};
+
+class StubTileReply : public QGeoTiledMapReply
+{
+    Q_OBJECT
+
+public:
+    StubTileReply(QNetworkReply *reply, const QGeoTileSpec &spec, QObject *parent = 0)
+        : QGeoTiledMapReply(spec, parent), m_reply(reply)
+    {
+        connect(m_reply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
+    }
+
+    ~StubTileReply()
+    {
+        if (m_reply)
+            m_reply->deleteLater();
+    }
+
+    void abort() Q_DECL_OVERRIDE
+    {
+        if (m_reply)
+            m_reply->abort();
+    }
+
+private Q_SLOTS:
+    void networkReplyFinished()
+    {
+        if (m_reply->error() != QNetworkReply::NoError) {
+            setError(QGeoTiledMapReply::CommunicationError, m_reply->errorString());
+        } else {
+            setMapImageData(m_reply->readAll());
+            setMapImageFormat(QStringLiteral("png"));
+        }
+        setFinished(true);
+    }
+
+private:
+    QPointer<QNetworkReply> m_reply;
+};
+
+class StubTileFetcher : public QGeoTileFetcher
+{
+    Q_OBJECT
+
+public:
+    StubTileFetcher(quint16 port, QObject *parent)
+        : QGeoTileFetcher(parent), m_networkManager(new QNetworkAccessManager(this)), m_port(port)
+    {
+    }
+
+private:
+    QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec) Q_DECL_OVERRIDE
+    {
+        QUrl url;
+        url.setScheme(QStringLiteral("http"));
+        url.setHost(QStringLiteral("127.0.0.1"));
+        url.setPort(m_port);
+        url.setPath(QLatin1Char('/') + QString::number(spec.zoom()) + QLatin1Char('/') +
+                    QString::number(spec.x()) + QLatin1Char('/') + QString::number(spec.y()));
+        return new StubTileReply(m_networkManager->get(QNetworkRequest(url)), spec);
+    }
+
+    QNetworkAccessManager *m_networkManager;
+    quint16 m_port;
+};
+
+class StubMappingEngine : public QGeoTiledMappingManagerEngine
+{
+    Q_OBJECT
+
+public:
+    StubMappingEngine(quint16 port, const QString &cacheDirectory)
+    {
+        setTileSize(QSize(256, 256));
+        setTileCache(new QGeoFileTileCache(cacheDirectory));
+        setTileFetcher(new StubTileFetcher(port, this));
+    }
+
+    QGeoTileSpec tile(int zoom, int x, int y)
+    {
+        return QGeoTileSpec(managerName() + QLatin1Char('_') + QString::number(managerVersion()),
+                            mapType().mapId(), zoom, x, y, tileVersion());
+    }
+
+    static QGeoMapType mapType()
+    {
+        return QGeoMapType(QGeoMapType::StreetMap, QStringLiteral("street"),
+                           QStringLiteral("stub"), false, false, 1);
+    }
+};
+
+class tst_QGeoTileSeedJob : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void seedRectangle();
+    void skipCached();
+    void pauseResume();
+    void circleAcrossDateline();
+    void circleCount();
+    void countWithoutWalking();
+    void tooLargeForCache();
+    void outgrowsCache();
+    void largerTilesThatFit();
+    void invalidArea();
+
+private:
+    TileServerStub *server_;
+    QTemporaryDir *cacheDir_;
+    StubMappingEngine *engine_;
+};
+
+void tst_QGeoTileSeedJob::init()
+{
+    qRegisterMetaType<QGeoTileSpec>();
+
+    server_ = new TileServerStub;
+    QVERIFY(server_->listen(QHostAddress::LocalHost));
+    cacheDir_ = new QTemporaryDir;
+    QVERIFY(cacheDir_->isValid());
+    engine_ = new StubMappingEngine(server_->serverPort(), cacheDir_->path());
+}
+
+void tst_QGeoTileSeedJob::cleanup()
+{
+    delete engine_;
+    engine_ = 0;
+    delete cacheDir_;
+    cacheDir_ = 0;
+    delete server_;
+    server_ = 0;
+}
+
+void tst_QGeoTileSeedJob::seedRectangle()
+{
+    // 1 tile at zoom 0, then the 2x2 tiles around the origin at zooms 1 and 2
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 2));
+    QCOMPARE(job->state(), QGeoTileSeedJob::Idle);
+    QCOMPARE(job->totalTiles(), 9);
+
+    QSignalSpy progress(job.data(), SIGNAL(progress(int,int)));
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QCOMPARE(job->state(), QGeoTileSeedJob::Running);
+
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(job->state(), QGeoTileSeedJob::Finished);
+    QCOMPARE(job->completedTiles(), 9);
+    QCOMPARE(job->skippedTiles(), 0);
+    QCOMPARE(job->failedTiles(), 0);
+    QCOMPARE(server_->paths.size(), 9);
+    QCOMPARE(progress.last().at(0).toInt(), 9);
+    QCOMPARE(progress.last().at(1).toInt(), 9);
+
+    // written to disk, but not decoded into memory
+    QAbstractGeoTileCache *cache = engine_->tileCache();
+    QVERIFY(cache->contains(engine_->tile(0, 0, 0), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(cache->contains(engine_->tile(1, 1, 1), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(cache->contains(engine_->tile(2, 1, 2), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(!cache->contains(engine_->tile(2, 1, 2), QGeoTiledMappingManagerEngine::MemoryCache));
+    QVERIFY(!cache->contains(engine_->tile(2, 0, 0), QGeoTiledMappingManagerEngine::DiskCache));
+}
+
+void tst_QGeoTileSeedJob::skipCached()
+{
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+
+    QScopedPointer<QGeoTileSeedJob> first(engine_->createSeedJob(StubMappingEngine::mapType(), area, 1, 1));
+    QSignalSpy firstFinished(first.data(), SIGNAL(finished()));
+    first->start();
+    QTRY_COMPARE(firstFinished.count(), 1);
+    QCOMPARE(server_->paths.size(), 4);
+
+    // the tiles of zoom level 1 are on disk now, only zoom 2 is fetched
+    QScopedPointer<QGeoTileSeedJob> second(engine_->createSeedJob(StubMappingEngine::mapType(), area, 1, 2));
+    QSignalSpy secondFinished(second.data(), SIGNAL(finished()));
+    second->start();
+    QTRY_COMPARE(secondFinished.count(), 1);
+    QCOMPARE(second->completedTiles(), 8);
+    QCOMPARE(second->skippedTiles(), 4);
+    QCOMPARE(server_->paths.size(), 8);
+}
+
+void tst_QGeoTileSeedJob::pauseResume()
+{
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 2));
+    job->setMaximumConcurrentRequests(2);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    server_->holdResponses = true;
+    job->start();
+    QTRY_COMPARE(server_->pendingPaths.size(), 2);
+
+    // tiles in flight still land while paused, but no new ones are requested
+    job->pause();
+    QCOMPARE(job->state(), QGeoTileSeedJob::Paused);
+    server_->release();
+    QTRY_COMPARE(job->completedTiles(), 2);
+    QTest::qWait(100);
+    QCOMPARE(server_->paths.size(), 2);
+
+    server_->holdResponses = false;
+    job->resume();
+    QCOMPARE(job->state(), QGeoTileSeedJob::Running);
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(job->completedTiles(), 9);
+    QCOMPARE(server_->paths.size(), 9);
+}
+
+void tst_QGeoTileSeedJob::circleAcrossDateline()
+{
+    // 100 km around a point just west of the dateline, on the equator
+    QGeoCircle area(QGeoCoordinate(0.0, 179.9), 100000.0);
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 3, 3));
+    QCOMPARE(job->totalTiles(), 4);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QTRY_COMPARE(finished.count(), 1);
+
+    QAbstractGeoTileCache *cache = engine_->tileCache();
+    QVERIFY(cache->contains(engine_->tile(3, 7, 3), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(cache->contains(engine_->tile(3, 7, 4), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(cache->contains(engine_->tile(3, 0, 3), QGeoTiledMappingManagerEngine::DiskCache));
+    QVERIFY(cache->contains(engine_->tile(3, 0, 4), QGeoTiledMappingManagerEngine::DiskCache));
+}
+
+void tst_QGeoTileSeedJob::circleCount()
+{
+    // the counted total matches the tiles the walk visits
+    QGeoCircle area(QGeoCoordinate(60.0, 10.0), 800000.0);
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 5));
+    QVERIFY(job->totalTiles() > 0);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(job->completedTiles(), job->totalTiles());
+    QCOMPARE(server_->paths.size(), job->totalTiles());
+    QCOMPARE(server_->paths.toSet().size(), job->totalTiles());
+}
+
+void tst_QGeoTileSeedJob::countWithoutWalking()
+{
+    // 4^0 + 4^1 + ... + 4^15 tiles, far too many to enumerate in the constructor
+    QGeoRectangle world(QGeoCoordinate(90.0, -180.0), QGeoCoordinate(-90.0, 180.0));
+    QElapsedTimer timer;
+    timer.start();
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), world, 0, 15));
+    QVERIFY(timer.elapsed() < 1000);
+    QCOMPARE(job->totalTiles(), 1431655765);
+}
+
+void tst_QGeoTileSeedJob::tooLargeForCache()
+{
+    // 9 tiles are estimated at more than 64 KB
+    engine_->tileCache()->setMaxDiskUsage(64 * 1024);
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 2));
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QCOMPARE(job->state(), QGeoTileSeedJob::Failed);
+    QVERIFY(!job->errorString().isEmpty());
+    QTest::qWait(100);
+    QCOMPARE(finished.count(), 0);
+    QCOMPARE(server_->paths.size(), 0);
+}
+
+void tst_QGeoTileSeedJob::outgrowsCache()
+{
+    // the estimate fits into 100 KB, the real 20 KB tiles do not
+    engine_->tileCache()->setMaxDiskUsage(100 * 1024);
+    server_->padding = 20 * 1024;
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 2));
+    job->setMaximumConcurrentRequests(1);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QTRY_COMPARE(job->state(), QGeoTileSeedJob::Failed);
+    QVERIFY(!job->errorString().isEmpty());
+    QCOMPARE(finished.count(), 0);
+    // the first real tile projects the job past the cache, before it fills
+    QCOMPARE(job->completedTiles(), 1);
+    QVERIFY(engine_->tileCache()->diskUsage() <= 100 * 1024);
+}
+
+void tst_QGeoTileSeedJob::largerTilesThatFit()
+{
+    // tiles larger than the estimate are fine while all of them fit
+    engine_->tileCache()->setMaxDiskUsage(100 * 1024);
+    server_->padding = 10 * 1024;
+    QGeoRectangle area(QGeoCoordinate(10.0, -10.0), QGeoCoordinate(-10.0, 10.0));
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), area, 0, 2));
+    job->setMaximumConcurrentRequests(1);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(job->state(), QGeoTileSeedJob::Finished);
+    QCOMPARE(job->completedTiles(), job->totalTiles());
+}
+
+void tst_QGeoTileSeedJob::invalidArea()
+{
+    QTest::ignoreMessage(QtWarningMsg, "QGeoTileSeedJob: cannot seed the tiles of an invalid or unsupported shape");
+    QScopedPointer<QGeoTileSeedJob> job(engine_->createSeedJob(StubMappingEngine::mapType(), QGeoShape(), 0, 4));
+    QCOMPARE(job->totalTiles(), 0);
+
+    QSignalSpy finished(job.data(), SIGNAL(finished()));
+    job->start();
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(job->state(), QGeoTileSeedJob::Finished);
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoTileSeedJob)
+
+#include "tst_qgeotileseedjob.moc"
@@ -3,6 +3,7 @@ SUBDIRS += \
     dummynmeapositioninfosource \
     qnmeapositioninfosource_realtime \
     qnmeapositioninfosource_simulation \
+    qnmeapositioninfosource_batch \
     qnmeapositioninfosource_realtime_generic \
     qnmeapositioninfosource_simulation_generic
 
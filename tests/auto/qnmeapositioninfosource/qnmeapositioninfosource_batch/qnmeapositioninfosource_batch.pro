@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG+=testcase
+QT += positioning testlib
+TARGET = tst_qnmeapositioninfosource_batch
+
+HEADERS += ../../utils/qlocationtestutils_p.h
+
+SOURCES += ../../utils/qlocationtestutils.cpp \
+           tst_qnmeapositioninfosource_batch.cpp
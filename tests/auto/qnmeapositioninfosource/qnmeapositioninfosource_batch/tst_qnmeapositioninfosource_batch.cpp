@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/location
+
+#include "../../utils/qlocationtestutils_p.h"
+
+#include <QtPositioning/qnmeapositioninfosource.h>
+
+#include <QTest>
+#include <QBuffer>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+
+QT_USE_NAMESPACE
+Q_DECLARE_METATYPE(QGeoPositionInfo)
+Q_DECLARE_METATYPE(QList<QGeoPositionInfo>)
+
+class BatchCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    BatchCollector() : batches(0) {}
+
+    QList<QGeoPositionInfo> updates;
+    int batches;
+
+public slots:
+    void positionsUpdated(const QList<QGeoPositionInfo> &batch)
+    {
+        updates += batch;
+        ++batches;
+    }
+};
+
+class tst_QNmeaPositionInfoSource_Batch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void startUpdates();
+    void startUpdates_data();
+
+    void requestUpdate();
+
+private:
+    QByteArray createLog(const QDateTime &start, int count) const
+    {
+        // the date only comes with the first RMC, the vertical accuracy
+        // only with the GSA
+        QByteArray log = QLocationTestUtils::createGsaSentence().toLatin1();
+        log += QLocationTestUtils::createRmcSentence(start).toLatin1();
+        for (int i = 1; i < count; ++i)
+            log += QLocationTestUtils::createGgaSentence(start.addSecs(i).time()).toLatin1();
+        return log;
+    }
+};
+
+void tst_QNmeaPositionInfoSource_Batch::initTestCase()
+{
+    qRegisterMetaType<QGeoPositionInfo>();
+    qRegisterMetaType<QList<QGeoPositionInfo> >();
+}
+
+void tst_QNmeaPositionInfoSource_Batch::startUpdates_data()
+{
+    QTest::addColumn<bool>("mapped");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("file") << true << 10;
+    QTest::newRow("file, several batches") << true << 10000;
+    QTest::newRow("buffer") << false << 10;
+    QTest::newRow("buffer, several batches") << false << 10000;
+}
+
+void tst_QNmeaPositionInfoSource_Batch::startUpdates()
+{
+    QFETCH(bool, mapped);
+    QFETCH(int, count);
+
+    const QDateTime start(QDate(2016, 3, 1), QTime(0, 0, 0), Qt::UTC);
+    const QByteArray log = createLog(start, count);
+
+    QTemporaryFile file;
+    QBuffer buffer;
+    QIODevice *device = &buffer;
+    if (mapped) {
+        QVERIFY(file.open());
+        QCOMPARE(file.write(log), qint64(log.size()));
+        QVERIFY(file.seek(0));
+        device = &file;
+    } else {
+        buffer.setData(log);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+    }
+
+    QNmeaPositionInfoSource source(QNmeaPositionInfoSource::BatchMode);
+    source.setUserEquivalentRangeError(5.1);
+    source.setDevice(device);
+    // has no effect in batch mode
+    source.setUpdateInterval(10000);
+
+    BatchCollector collector;
+    QObject::connect(&source, SIGNAL(positionsUpdated(QList<QGeoPositionInfo>)),
+                     &collector, SLOT(positionsUpdated(QList<QGeoPositionInfo>)));
+    QSignalSpy updateSpy(&source, SIGNAL(positionUpdated(QGeoPositionInfo)));
+    source.startUpdates();
+
+    QTRY_COMPARE_WITH_TIMEOUT(collector.updates.count(), count, 10000);
+    if (count > 4096)
+        QVERIFY(collector.batches > 1);
+    QCOMPARE(updateSpy.count(), collector.batches);
+
+    const QList<QGeoPositionInfo> &updates = collector.updates;
+    for (int i = 0; i < count; ++i) {
+        const QGeoPositionInfo &update = updates.at(i);
+        QCOMPARE(update.timestamp(), start.addSecs(i));
+        QVERIFY(update.hasAttribute(QGeoPositionInfo::VerticalAccuracy));
+        QVERIFY(qFuzzyCompare(update.attribute(QGeoPositionInfo::VerticalAccuracy), 40.8));
+    }
+    QCOMPARE(source.lastKnownPosition(), updates.last());
+    QCOMPARE(updateSpy.last().at(0).value<QGeoPositionInfo>(), updates.last());
+}
+
+void tst_QNmeaPositionInfoSource_Batch::requestUpdate()
+{
+    const QDateTime start(QDate(2016, 3, 1), QTime(12, 0, 0), Qt::UTC);
+    QBuffer buffer;
+    buffer.setData(createLog(start, 100));
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    QNmeaPositionInfoSource source(QNmeaPositionInfoSource::BatchMode);
+    source.setDevice(&buffer);
+
+    QSignalSpy batchSpy(&source, SIGNAL(positionsUpdated(QList<QGeoPositionInfo>)));
+    QSignalSpy updateSpy(&source, SIGNAL(positionUpdated(QGeoPositionInfo)));
+    source.requestUpdate(5000);
+
+    QTRY_COMPARE(updateSpy.count(), 1);
+    QCOMPARE(updateSpy.at(0).at(0).value<QGeoPositionInfo>().timestamp(), start);
+    QCOMPARE(batchSpy.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(tst_QNmeaPositionInfoSource_Batch)
+
+#include "tst_qnmeapositioninfosource_batch.moc"
@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qnmeasatelliteinfosource
+
+SOURCES += tst_qnmeasatelliteinfosource.cpp \
+           ../utils/qlocationtestutils.cpp
+
+HEADERS += ../utils/qlocationtestutils_p.h
+
+QT += positioning-private testlib
@@ -0,0 +1,269 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/location
+
+#include "../utils/qlocationtestutils_p.h"
+
+#include <QtPositioning/qnmeapositioninfosource.h>
+#include <QtPositioning/private/qnmeasatelliteinfosource_p.h>
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+
+QT_USE_NAMESPACE
+Q_DECLARE_METATYPE(QList<QGeoSatelliteInfo>)
+
+class tst_QNmeaSatelliteInfoSource : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void satellitesInView();
+    void satellitesInView_missingPart();
+    void satellitesInUse();
+    void satellitesInUse_multipleSystems();
+    void requestUpdate();
+    void noPositionSource();
+
+private:
+    // Writes the sentences to a log, one RMC every 100 ms before each group
+    // so that the simulated reader replays them in order.
+    bool writeLog(QTemporaryFile *file, const QList<QStringList> &groups)
+    {
+        if (!file->open())
+            return false;
+
+        QDateTime time(QDate(2016, 3, 1), QTime(12, 0, 0), Qt::UTC);
+        foreach (const QStringList &group, groups) {
+            file->write(QLocationTestUtils::createRmcSentence(time).toLatin1());
+            foreach (const QString &sentence, group)
+                file->write(QLocationTestUtils::addNmeaChecksumAndBreaks(sentence).toLatin1());
+            time = time.addMSecs(100);
+        }
+        file->write(QLocationTestUtils::createRmcSentence(time).toLatin1());
+        return file->seek(0);
+    }
+
+    QStringList gpsAndGlonass() const
+    {
+        return QStringList()
+                << QStringLiteral("$GPGSV,2,1,05,01,40,083,46,04,15,309,40,07,60,180,,09,05,045,30*")
+                << QStringLiteral("$GPGSV,2,2,05,12,75,250,42*")
+                << QStringLiteral("$GLGSV,1,1,02,65,30,120,38,70,10,200,25*");
+    }
+
+    static QGeoSatelliteInfo find(const QList<QGeoSatelliteInfo> &satellites,
+                                  QGeoSatelliteInfo::SatelliteSystem system, int identifier)
+    {
+        foreach (const QGeoSatelliteInfo &satellite, satellites) {
+            if (satellite.satelliteSystem() == system && satellite.satelliteIdentifier() == identifier)
+                return satellite;
+        }
+        return QGeoSatelliteInfo();
+    }
+};
+
+void tst_QNmeaSatelliteInfoSource::initTestCase()
+{
+    qRegisterMetaType<QList<QGeoSatelliteInfo> >();
+}
+
+void tst_QNmeaSatelliteInfoSource::satellitesInView()
+{
+    QTemporaryFile file;
+    QVERIFY(writeLog(&file, QList<QStringList>() << gpsAndGlonass()));
+
+    QNmeaPositionInfoSource positionSource(QNmeaPositionInfoSource::SimulationMode);
+    positionSource.setDevice(&file);
+    QNmeaSatelliteInfoSource source(&positionSource);
+    QCOMPARE(source.positionSource(), &positionSource);
+
+    QSignalSpy inViewSpy(&source, SIGNAL(satellitesInViewUpdated(QList<QGeoSatelliteInfo>)));
+    QSignalSpy inUseSpy(&source, SIGNAL(satellitesInUseUpdated(QList<QGeoSatelliteInfo>)));
+    source.startUpdates();
+
+    // one update per talker once its group is complete
+    QTRY_COMPARE(inViewSpy.count(), 2);
+    QCOMPARE(inUseSpy.count(), 0);
+    QCOMPARE(source.error(), QGeoSatelliteInfoSource::NoError);
+
+    QList<QGeoSatelliteInfo> satellites = inViewSpy.at(0).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 5);
+
+    satellites = inViewSpy.at(1).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 7);
+
+    QGeoSatelliteInfo satellite = find(satellites, QGeoSatelliteInfo::GPS, 1);
+    QCOMPARE(satellite.signalStrength(), 46);
+    QCOMPARE(satellite.attribute(QGeoSatelliteInfo::Elevation), qreal(40));
+    QCOMPARE(satellite.attribute(QGeoSatelliteInfo::Azimuth), qreal(83));
+
+    satellite = find(satellites, QGeoSatelliteInfo::GPS, 7);
+    QCOMPARE(satellite.satelliteIdentifier(), 7);
+    QCOMPARE(satellite.signalStrength(), -1);
+
+    satellite = find(satellites, QGeoSatelliteInfo::GPS, 12);
+    QCOMPARE(satellite.attribute(QGeoSatelliteInfo::Elevation), qreal(75));
+
+    satellite = find(satellites, QGeoSatelliteInfo::GLONASS, 70);
+    QCOMPARE(satellite.signalStrength(), 25);
+    QCOMPARE(satellite.attribute(QGeoSatelliteInfo::Azimuth), qreal(200));
+}
+
+void tst_QNmeaSatelliteInfoSource::satellitesInView_missingPart()
+{
+    QTemporaryFile file;
+    QVERIFY(writeLog(&file, QList<QStringList>()
+                     << (QStringList()
+                         << QStringLiteral("$GPGSV,2,1,05,01,40,083,46,04,15,309,40,07,60,180,,09,05,045,30*")
+                         << QStringLiteral("$GPGSV,1,1,02,03,10,010,20,05,20,020,30*"))
+                     << (QStringList()
+                         << QStringLiteral("$GPGSV,2,2,05,12,75,250,42*")
+                         << QStringLiteral("$GPGSV,1,1,01,08,30,030,40*"))));
+
+    QNmeaPositionInfoSource positionSource(QNmeaPositionInfoSource::SimulationMode);
+    positionSource.setDevice(&file);
+    QNmeaSatelliteInfoSource source(&positionSource);
+
+    QSignalSpy inViewSpy(&source, SIGNAL(satellitesInViewUpdated(QList<QGeoSatelliteInfo>)));
+    source.startUpdates();
+
+    // the first group of two is cut short and its second part arrives alone
+    QTRY_COMPARE(inViewSpy.count(), 2);
+    QTest::qWait(300);
+    QCOMPARE(inViewSpy.count(), 2);
+
+    QList<QGeoSatelliteInfo> satellites = inViewSpy.at(0).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 2);
+    QCOMPARE(satellites.at(0).satelliteIdentifier(), 3);
+
+    satellites = inViewSpy.at(1).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 1);
+    QCOMPARE(satellites.at(0).satelliteIdentifier(), 8);
+}
+
+void tst_QNmeaSatelliteInfoSource::satellitesInUse()
+{
+    QTemporaryFile file;
+    QVERIFY(writeLog(&file, QList<QStringList>()
+                     << (gpsAndGlonass()
+                         << QStringLiteral("$GNGSA,A,3,01,04,09,,,,,,,,,,1.8,1.0,1.5*")
+                         << QStringLiteral("$GNGSA,A,3,65,,,,,,,,,,,,1.8,1.0,1.5*"))
+                     << (QStringList()
+                         << QStringLiteral("$GNGSA,A,3,12,,,,,,,,,,,,2.1,1.2,1.7*"))));
+
+    QNmeaPositionInfoSource positionSource(QNmeaPositionInfoSource::SimulationMode);
+    positionSource.setDevice(&file);
+    QNmeaSatelliteInfoSource source(&positionSource);
+
+    QSignalSpy inUseSpy(&source, SIGNAL(satellitesInUseUpdated(QList<QGeoSatelliteInfo>)));
+    source.startUpdates();
+
+    // the two GSA sentences of the first fix add up, the next fix replaces them
+    QTRY_COMPARE(inUseSpy.count(), 2);
+
+    QList<QGeoSatelliteInfo> satellites = inUseSpy.at(0).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 4);
+    QCOMPARE(find(satellites, QGeoSatelliteInfo::GPS, 4).signalStrength(), 40);
+    QCOMPARE(find(satellites, QGeoSatelliteInfo::GPS, 9).signalStrength(), 30);
+    QCOMPARE(find(satellites, QGeoSatelliteInfo::GLONASS, 65).signalStrength(), 38);
+
+    satellites = inUseSpy.at(1).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 1);
+    QCOMPARE(satellites.at(0).satelliteIdentifier(), 12);
+    QCOMPARE(satellites.at(0).attribute(QGeoSatelliteInfo::Azimuth), qreal(250));
+}
+
+void tst_QNmeaSatelliteInfoSource::satellitesInUse_multipleSystems()
+{
+    QTemporaryFile file;
+    QVERIFY(writeLog(&file, QList<QStringList>()
+                     << (gpsAndGlonass()
+                         << QStringLiteral("$GPGSA,A,3,01,04,09,12,,,,,,,,,1.8,1.0,1.5*")
+                         << QStringLiteral("$GLGSA,A,3,65,70,,,,,,,,,,,1.8,1.0,1.5*"))));
+
+    QNmeaPositionInfoSource positionSource(QNmeaPositionInfoSource::SimulationMode);
+    positionSource.setDevice(&file);
+    QNmeaSatelliteInfoSource source(&positionSource);
+
+    QSignalSpy inUseSpy(&source, SIGNAL(satellitesInUseUpdated(QList<QGeoSatelliteInfo>)));
+    source.startUpdates();
+
+    // one update for the whole fix, not a GPS only one first
+    QTRY_COMPARE(inUseSpy.count(), 1);
+    QTest::qWait(300);
+    QCOMPARE(inUseSpy.count(), 1);
+
+    const QList<QGeoSatelliteInfo> satellites = inUseSpy.at(0).at(0).value<QList<QGeoSatelliteInfo> >();
+    QCOMPARE(satellites.count(), 6);
+    QCOMPARE(find(satellites, QGeoSatelliteInfo::GPS, 12).signalStrength(), 42);
+    QCOMPARE(find(satellites, QGeoSatelliteInfo::GLONASS, 70).signalStrength(), 25);
+}
+
+void tst_QNmeaSatelliteInfoSource::requestUpdate()
+{
+    QTemporaryFile file;
+    QVERIFY(writeLog(&file, QList<QStringList>() << gpsAndGlonass() << gpsAndGlonass()));
+
+    QNmeaPositionInfoSource positionSource(QNmeaPositionInfoSource::SimulationMode);
+    positionSource.setDevice(&file);
+    QNmeaSatelliteInfoSource source(&positionSource);
+
+    QSignalSpy inViewSpy(&source, SIGNAL(satellitesInViewUpdated(QList<QGeoSatelliteInfo>)));
+    QSignalSpy timeoutSpy(&source, SIGNAL(requestTimeout()));
+    source.requestUpdate(5000);
+
+    QTRY_COMPARE(inViewSpy.count(), 1);
+    QTest::qWait(300);
+    QCOMPARE(inViewSpy.count(), 1);
+    QCOMPARE(timeoutSpy.count(), 0);
+
+    source.requestUpdate(50);
+    QTRY_COMPARE(timeoutSpy.count(), 1);
+}
+
+void tst_QNmeaSatelliteInfoSource::noPositionSource()
+{
+    QNmeaPositionInfoSource *positionSource =
+            new QNmeaPositionInfoSource(QNmeaPositionInfoSource::SimulationMode);
+    QNmeaSatelliteInfoSource source(positionSource);
+    delete positionSource;
+
+    QSignalSpy errorSpy(&source, SIGNAL(error(QGeoSatelliteInfoSource::Error)));
+    source.startUpdates();
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(source.error(), QGeoSatelliteInfoSource::ClosedError);
+}
+
+QTEST_GUILESS_MAIN(tst_QNmeaSatelliteInfoSource)
+
+#include "tst_qnmeasatelliteinfosource.moc"
@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_serialnmea
+
+SOURCES += tst_serialnmea.cpp \
+           ../utils/qlocationtestutils.cpp
+
+HEADERS += ../utils/qlocationtestutils_p.h
+
+QT += positioning testlib
@@ -0,0 +1,196 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/location
+
+#include "../utils/qlocationtestutils_p.h"
+
+#include <QtPositioning/qgeopositioninfosource.h>
+#include <QtPositioning/qgeosatelliteinfosource.h>
+
+#include <QTest>
+#include <QSignalSpy>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+QT_USE_NAMESPACE
+Q_DECLARE_METATYPE(QGeoPositionInfo)
+Q_DECLARE_METATYPE(QList<QGeoSatelliteInfo>)
+
+/*
+    Stands in for a serial GPS receiver: NMEA written to the master side of
+    a pseudo terminal is read by the plugin from the slave side, which is
+    passed to it through QT_NMEA_SERIAL_PORT.
+*/
+class PseudoTerminal
+{
+public:
+    PseudoTerminal()
+        : m_master(::posix_openpt(O_RDWR | O_NOCTTY))
+    {
+        if (m_master >= 0 && (::grantpt(m_master) != 0 || ::unlockpt(m_master) != 0)) {
+            ::close(m_master);
+            m_master = -1;
+        }
+    }
+
+    ~PseudoTerminal()
+    {
+        if (m_master >= 0)
+            ::close(m_master);
+    }
+
+    bool isValid() const { return m_master >= 0; }
+    QByteArray slaveName() const { return QByteArray(::ptsname(m_master)); }
+
+    bool write(const QString &sentence)
+    {
+        const QByteArray data = sentence.toLatin1();
+        return ::write(m_master, data.constData(), data.size()) == data.size();
+    }
+
+private:
+    int m_master;
+};
+
+class tst_SerialNmea : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void sharedPort();
+    void sourceDestroyed();
+    void reopenPort();
+
+private:
+    QGeoPositionInfoSource *createPositionSource()
+    {
+        return QGeoPositionInfoSource::createSource(QStringLiteral("serialnmea"), 0);
+    }
+
+    PseudoTerminal m_terminal;
+};
+
+void tst_SerialNmea::initTestCase()
+{
+    qRegisterMetaType<QGeoPositionInfo>();
+    qRegisterMetaType<QList<QGeoSatelliteInfo> >();
+
+    if (!QGeoPositionInfoSource::availableSources().contains(QStringLiteral("serialnmea")))
+        QSKIP("The serialnmea plugin is not available");
+    if (!m_terminal.isValid())
+        QSKIP("Cannot create a pseudo terminal");
+
+    qputenv("QT_NMEA_SERIAL_PORT", m_terminal.slaveName());
+}
+
+void tst_SerialNmea::cleanupTestCase()
+{
+    qunsetenv("QT_NMEA_SERIAL_PORT");
+}
+
+void tst_SerialNmea::sharedPort()
+{
+    QScopedPointer<QGeoPositionInfoSource> first(createPositionSource());
+    QScopedPointer<QGeoPositionInfoSource> second(createPositionSource());
+    QScopedPointer<QGeoSatelliteInfoSource> satellites(
+                QGeoSatelliteInfoSource::createSource(QStringLiteral("serialnmea"), 0));
+    QVERIFY(first);
+    QVERIFY(second);     // would fail to open the port if it was not shared
+    QVERIFY(satellites);
+
+    QSignalSpy firstSpy(first.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+    QSignalSpy secondSpy(second.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+    QSignalSpy secondTimeoutSpy(second.data(), SIGNAL(updateTimeout()));
+    QSignalSpy satelliteSpy(satellites.data(), SIGNAL(satellitesInViewUpdated(QList<QGeoSatelliteInfo>)));
+
+    // each source keeps its own mode of delivery
+    first->startUpdates();
+    second->requestUpdate(5000);
+    satellites->startUpdates();
+
+    const QDateTime start = QDateTime::currentDateTime().toUTC();
+    for (int i = 0; i < 3; ++i)
+        QVERIFY(m_terminal.write(QLocationTestUtils::createRmcSentence(start.addSecs(i))));
+    QVERIFY(m_terminal.write(QLocationTestUtils::addNmeaChecksumAndBreaks(
+                                 QStringLiteral("$GPGSV,1,1,02,01,40,083,46,04,15,309,40*"))));
+
+    QTRY_COMPARE(firstSpy.count(), 3);
+    QTRY_COMPARE(satelliteSpy.count(), 1);
+    QCOMPARE(secondSpy.count(), 1);
+    QCOMPARE(secondTimeoutSpy.count(), 0);
+
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(firstSpy.at(i).at(0).value<QGeoPositionInfo>().timestamp().time().second(),
+                 start.addSecs(i).time().second());
+    }
+    QCOMPARE(secondSpy.at(0).at(0).value<QGeoPositionInfo>(),
+             firstSpy.at(0).at(0).value<QGeoPositionInfo>());
+    QCOMPARE(second->lastKnownPosition(), firstSpy.at(0).at(0).value<QGeoPositionInfo>());
+}
+
+void tst_SerialNmea::sourceDestroyed()
+{
+    QScopedPointer<QGeoPositionInfoSource> first(createPositionSource());
+    QScopedPointer<QGeoPositionInfoSource> second(createPositionSource());
+    QVERIFY(first);
+    QVERIFY(second);
+
+    QSignalSpy secondSpy(second.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+    first->startUpdates();
+    second->startUpdates();
+    first.reset();
+
+    QVERIFY(m_terminal.write(QLocationTestUtils::createRmcSentence(QDateTime::currentDateTime())));
+    QTRY_COMPARE(secondSpy.count(), 1);
+}
+
+void tst_SerialNmea::reopenPort()
+{
+    // the port is closed with the last source and opened again for the next
+    QScopedPointer<QGeoPositionInfoSource> source(createPositionSource());
+    QVERIFY(source);
+    source.reset();
+
+    source.reset(createPositionSource());
+    QVERIFY(source);
+
+    QSignalSpy spy(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+    source->startUpdates();
+    QVERIFY(m_terminal.write(QLocationTestUtils::createRmcSentence(QDateTime::currentDateTime())));
+    QTRY_COMPARE(spy.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(tst_SerialNmea)
+
+#include "tst_serialnmea.moc"
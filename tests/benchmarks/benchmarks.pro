@@ -0,0 +1,12 @@
+TEMPLATE = subdirs
+
+SUBDIRS += qgeoareamonitorpolling \
+           qlocationutils
+
+qtHaveModule(location) {
+    SUBDIRS += qgeofiletilecache \
+               qgeocameratiles \
+               qgeotilerequesttable \
+               qgeomercatortransform \
+               qgeomapscene
+}
@@ -0,0 +1,7 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeoareamonitorpolling
+
+SOURCES += tst_bench_qgeoareamonitorpolling.cpp
+
+QT += positioning testlib
@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include <QtPositioning/qgeoareamonitorsource.h>
+#include <QtPositioning/qgeopositioninfosource.h>
+#include <QtPositioning/qgeocircle.h>
+#include <QtPositioning/qgeorectangle.h>
+
+#include <cmath>
+
+QT_USE_NAMESPACE
+
+/*
+    Hands positions to the monitor as soon as replay() is called.
+*/
+class ReplayPositionSource : public QGeoPositionInfoSource
+{
+    Q_OBJECT
+public:
+    explicit ReplayPositionSource(QObject *parent = 0)
+        : QGeoPositionInfoSource(parent) {}
+
+    void replay(const QGeoPositionInfo &info) { emit positionUpdated(info); }
+
+    QGeoPositionInfo lastKnownPosition(bool = false) const Q_DECL_OVERRIDE { return QGeoPositionInfo(); }
+    PositioningMethods supportedPositioningMethods() const Q_DECL_OVERRIDE { return AllPositioningMethods; }
+    int minimumUpdateInterval() const Q_DECL_OVERRIDE { return 0; }
+    Error error() const Q_DECL_OVERRIDE { return NoError; }
+
+public Q_SLOTS:
+    void startUpdates() Q_DECL_OVERRIDE {}
+    void stopUpdates() Q_DECL_OVERRIDE {}
+    void requestUpdate(int = 0) Q_DECL_OVERRIDE {}
+};
+
+/*
+    Measures the positionpoll area monitor with many geofences in one
+    city: what each position fix costs, and what it costs to start and stop
+    all of them. Half of the fences are circles of 50 to 300 m, the other
+    half rectangles of a few hundred meters, scattered over one square
+    degree.
+*/
+class tst_bench_QGeoAreaMonitorPolling : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_bench_QGeoAreaMonitorPolling() : events(0) {}
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void positionUpdate_data();
+    void positionUpdate();
+    void startStop_data();
+    void startStop();
+
+    void areaEvent() { ++events; }
+
+private:
+    QGeoAreaMonitorSource *createMonitor(ReplayPositionSource **source);
+
+    int events;
+};
+
+static const int fixes = 100;
+
+static QList<QGeoAreaMonitorInfo> fences(int count)
+{
+    QList<QGeoAreaMonitorInfo> result;
+    result.reserve(count);
+    qsrand(1);
+    for (int i = 0; i < count; ++i) {
+        const QGeoCoordinate center(-28.0 + qrand() / double(RAND_MAX),
+                                    152.5 + qrand() / double(RAND_MAX));
+        QGeoAreaMonitorInfo info(QString::number(i));
+        if (i % 2) {
+            info.setArea(QGeoCircle(center, 50.0 + qrand() % 250));
+        } else {
+            info.setArea(QGeoRectangle(center, 0.002 + 0.00001 * (qrand() % 300),
+                                       0.002 + 0.00001 * (qrand() % 300)));
+        }
+        result.append(info);
+    }
+    return result;
+}
+
+static QList<QGeoPositionInfo> track()
+{
+    // a diagonal drive across the fenced area
+    QList<QGeoPositionInfo> result;
+    const QDateTime start = QDateTime::currentDateTime();
+    for (int i = 0; i < fixes; ++i) {
+        const double t = double(i) / fixes;
+        result.append(QGeoPositionInfo(QGeoCoordinate(-28.0 + t + 0.01 * std::sin(i * 0.3),
+                                                      152.5 + t),
+                                       start.addSecs(i)));
+    }
+    return result;
+}
+
+void tst_bench_QGeoAreaMonitorPolling::initTestCase()
+{
+    QVERIFY(QGeoAreaMonitorSource::availableSources().contains(QStringLiteral("positionpoll")));
+}
+
+void tst_bench_QGeoAreaMonitorPolling::cleanup()
+{
+    // the polling monitors share their state, start every row from scratch
+    QGeoAreaMonitorSource *monitor = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+    foreach (const QGeoAreaMonitorInfo &info, monitor->activeMonitors())
+        monitor->stopMonitoring(info);
+    delete monitor;
+}
+
+QGeoAreaMonitorSource *tst_bench_QGeoAreaMonitorPolling::createMonitor(ReplayPositionSource **source)
+{
+    QGeoAreaMonitorSource *monitor = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+    *source = new ReplayPositionSource;
+    monitor->setPositionInfoSource(*source);
+    connect(monitor, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)),
+            this, SLOT(areaEvent()));
+    connect(monitor, SIGNAL(areaExited(QGeoAreaMonitorInfo,QGeoPositionInfo)),
+            this, SLOT(areaEvent()));
+    return monitor;
+}
+
+void tst_bench_QGeoAreaMonitorPolling::positionUpdate_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("100 fences") << 100;
+    QTest::newRow("1000 fences") << 1000;
+    QTest::newRow("10000 fences") << 10000;
+}
+
+void tst_bench_QGeoAreaMonitorPolling::positionUpdate()
+{
+    QFETCH(int, count);
+
+    ReplayPositionSource *source = 0;
+    QGeoAreaMonitorSource *monitor = createMonitor(&source);
+    QVERIFY(monitor);
+
+    foreach (const QGeoAreaMonitorInfo &info, fences(count))
+        QVERIFY(monitor->startMonitoring(info));
+    QCOMPARE(monitor->activeMonitors().count(), count);
+
+    const QList<QGeoPositionInfo> positions = track();
+
+    events = 0;
+    QBENCHMARK {
+        foreach (const QGeoPositionInfo &info, positions)
+            source->replay(info);
+    }
+
+    // the track crosses fences in the denser rows
+    if (count >= 1000)
+        QVERIFY(events > 0);
+
+    delete monitor;
+}
+
+void tst_bench_QGeoAreaMonitorPolling::startStop_data()
+{
+    positionUpdate_data();
+}
+
+void tst_bench_QGeoAreaMonitorPolling::startStop()
+{
+    QFETCH(int, count);
+
+    ReplayPositionSource *source = 0;
+    QGeoAreaMonitorSource *monitor = createMonitor(&source);
+    QVERIFY(monitor);
+
+    const QList<QGeoAreaMonitorInfo> infos = fences(count);
+
+    QBENCHMARK {
+        foreach (const QGeoAreaMonitorInfo &info, infos)
+            monitor->startMonitoring(info);
+        foreach (const QGeoAreaMonitorInfo &info, infos)
+            monitor->stopMonitoring(info);
+    }
+
+    QCOMPARE(monitor->activeMonitors().count(), 0);
+
+    delete monitor;
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QGeoAreaMonitorPolling)
+
+#include "tst_bench_qgeoareamonitorpolling.moc"
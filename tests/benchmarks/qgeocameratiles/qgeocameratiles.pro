@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeocameratiles
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_bench_qgeocameratiles.cpp
+
+QT += location testlib
@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgeocameratiles_p.h"
+#include "qgeocameradata_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+/*
+    Measures QGeoCameraTiles::visibleTiles() over camera sweeps of small
+    steps, as seen while the user drags, zooms or tilts the map. The
+    "rebuild" rows recompute every step from scratch for comparison.
+*/
+class tst_bench_QGeoCameraTiles : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void sweep_data();
+    void sweep();
+};
+
+enum Sweep {
+    Pan,
+    Zoom,
+    Tilt
+};
+
+static const int stepsPerSweep = 100;
+
+static QGeoCameraData cameraAt(Sweep sweep, int step)
+{
+    QGeoCameraData camera;
+    camera.setZoomLevel(14.0);
+    camera.setCenter(QGeoCoordinate(52.5, 13.4));
+
+    switch (sweep) {
+    case Pan:
+        // a few pixels per frame at zoom 14
+        camera.setCenter(QGeoCoordinate(52.5 - step * 0.0002, 13.4 + step * 0.0003));
+        break;
+    case Zoom:
+        camera.setZoomLevel(14.0 + step * (0.9 / stepsPerSweep));
+        break;
+    case Tilt:
+        camera.setTilt(step * (45.0 / stepsPerSweep));
+        break;
+    }
+
+    return camera;
+}
+
+static void setUp(QGeoCameraTiles &tiles)
+{
+    tiles.setMaximumZoomLevel(20);
+    tiles.setTileSize(256);
+    tiles.setScreenSize(QSize(1920, 1080));
+    tiles.setPluginString(QStringLiteral("bench"));
+}
+
+void tst_bench_QGeoCameraTiles::sweep_data()
+{
+    QTest::addColumn<int>("sweep");
+    QTest::addColumn<bool>("rebuild");
+
+    QTest::newRow("pan") << int(Pan) << false;
+    QTest::newRow("pan rebuild") << int(Pan) << true;
+    QTest::newRow("zoom") << int(Zoom) << false;
+    QTest::newRow("zoom rebuild") << int(Zoom) << true;
+    QTest::newRow("tilt") << int(Tilt) << false;
+    QTest::newRow("tilt rebuild") << int(Tilt) << true;
+}
+
+void tst_bench_QGeoCameraTiles::sweep()
+{
+    QFETCH(int, sweep);
+    QFETCH(bool, rebuild);
+
+    QGeoCameraTiles tiles;
+    setUp(tiles);
+
+    int count = 0;
+    QBENCHMARK {
+        for (int step = 0; step < stepsPerSweep; ++step) {
+            const QGeoCameraData camera = cameraAt(Sweep(sweep), step);
+            if (rebuild) {
+                QGeoCameraTiles fresh;
+                setUp(fresh);
+                fresh.setCameraData(camera);
+                count += fresh.visibleTiles().size();
+            } else {
+                tiles.setCameraData(camera);
+                count += tiles.visibleTiles().size();
+            }
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QGeoCameraTiles)
+
+#include "tst_bench_qgeocameratiles.moc"
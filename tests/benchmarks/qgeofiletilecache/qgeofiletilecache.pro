@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeofiletilecache
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_bench_qgeofiletilecache.cpp
+
+QT += location testlib
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+
+#include "qgeofiletilecache_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+/*
+    Simulates panning over tiles which are only in the disk cache. Each
+    iteration is one frame requesting a row of cold tiles; the measured time
+    is what the GUI thread spends on them.
+*/
+class tst_bench_QGeoFileTileCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void frameTime_data();
+    void frameTime();
+
+private:
+    QTemporaryDir dir_;
+    QList<QGeoTileSpec> specs_;
+};
+
+static const int tilesPerFrame = 16;
+static const int tileCount = 512;
+
+void tst_bench_QGeoFileTileCache::initTestCase()
+{
+    QVERIFY(dir_.isValid());
+
+    QImage image(256, 256, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgb(x, y, (x * y) & 0xff));
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+
+    QGeoFileTileCache cache(dir_.path(), QGeoFileTileCache::PackedStorage);
+    cache.setMaxDiskUsage(tileCount * bytes.size() * 2);
+    for (int i = 0; i < tileCount; ++i) {
+        const QGeoTileSpec spec(QStringLiteral("bench"), 1, 12, i % 32, i / 32);
+        cache.insert(spec, bytes, QStringLiteral("png"), QGeoTiledMappingManagerEngine::DiskCache);
+        specs_.append(spec);
+    }
+}
+
+void tst_bench_QGeoFileTileCache::frameTime_data()
+{
+    QTest::addColumn<bool>("async");
+    QTest::newRow("blocking") << false;
+    QTest::newRow("async") << true;
+}
+
+void tst_bench_QGeoFileTileCache::frameTime()
+{
+    QFETCH(bool, async);
+
+    QGeoFileTileCache cache(dir_.path(), QGeoFileTileCache::PackedStorage);
+    cache.setMaxDiskUsage(1024 * 1024 * 1024);
+    // keep every tile cold
+    cache.setMaxMemoryUsage(0);
+    cache.setMinTextureUsage(0);
+    cache.setExtraTextureUsage(0);
+
+    int frame = 0;
+    QBENCHMARK {
+        const int first = (frame++ * tilesPerFrame) % tileCount;
+        for (int i = first; i < first + tilesPerFrame; ++i) {
+            const QGeoTileSpec &spec = specs_.at(i);
+            if (async) {
+                bool pending = false;
+                cache.getAsync(spec, &pending);
+            } else {
+                cache.get(spec);
+            }
+        }
+        // deliver whatever finished since the previous frame
+        QCoreApplication::processEvents();
+    }
+
+    cache.waitForPendingLoads();
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QGeoFileTileCache)
+
+#include "tst_bench_qgeofiletilecache.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeomapscene
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_bench_qgeomapscene.cpp
+
+QT += location positioning-private quick testlib
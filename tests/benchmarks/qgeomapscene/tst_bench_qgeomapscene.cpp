@@ -0,0 +1,230 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFramebufferObject>
+#include <QtGui/QOpenGLFunctions>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickRenderControl>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGGeometryNode>
+
+#include "qgeomapscene_p.h"
+#include "qgeocameratiles_p.h"
+#include "qgeocameradata_p.h"
+#include "qabstractgeotilecache_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+/*
+    Renders a QGeoMapScene through QQuickRenderControl into an offscreen
+    framebuffer, so no window system is needed. Run with
+    QT_QPA_PLATFORM=offscreen and LIBGL_ALWAYS_SOFTWARE=1 to measure the
+    llvmpipe path without a GPU. Each iteration renders a sweep of frames while
+    the camera tilts, which is when the most tiles are visible.
+*/
+class MapSceneItem : public QQuickItem
+{
+public:
+    explicit MapSceneItem(QGeoMapScene *scene)
+        : scene_(scene), root_(0)
+    {
+        setFlag(ItemHasContents);
+    }
+
+    QSGNode *root() const { return root_; }
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) Q_DECL_OVERRIDE
+    {
+        root_ = scene_->updateSceneGraph(oldNode, window());
+        return root_;
+    }
+
+private:
+    QGeoMapScene *scene_;
+    QSGNode *root_;
+};
+
+class tst_bench_QGeoMapScene : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_bench_QGeoMapScene()
+        : context_(0), surface_(0), control_(0), window_(0), fbo_(0) {}
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void tiltSweep_data();
+    void tiltSweep();
+
+private:
+    void renderFrame();
+
+    QOpenGLContext *context_;
+    QOffscreenSurface *surface_;
+    QQuickRenderControl *control_;
+    QQuickWindow *window_;
+    QOpenGLFramebufferObject *fbo_;
+};
+
+static const QSize screenSize(1920, 1080);
+static const int framesPerSweep = 30;
+
+static QGeoCameraData cameraAt(int frame)
+{
+    QGeoCameraData camera;
+    camera.setCenter(QGeoCoordinate(52.5, 13.4));
+    camera.setZoomLevel(14.0);
+    camera.setTilt(frame * (60.0 / framesPerSweep));
+    return camera;
+}
+
+static int drawCalls(QSGNode *node)
+{
+    int count = 0;
+    if (node->type() == QSGNode::GeometryNode
+            && static_cast<QSGGeometryNode *>(node)->geometry()->vertexCount() > 0)
+        ++count;
+    for (QSGNode *child = node->firstChild(); child; child = child->nextSibling())
+        count += drawCalls(child);
+    return count;
+}
+
+void tst_bench_QGeoMapScene::initTestCase()
+{
+    context_ = new QOpenGLContext;
+    if (!context_->create())
+        QSKIP("No OpenGL context available");
+
+    surface_ = new QOffscreenSurface;
+    surface_->setFormat(context_->format());
+    surface_->create();
+    QVERIFY(context_->makeCurrent(surface_));
+
+    control_ = new QQuickRenderControl;
+    window_ = new QQuickWindow(control_);
+    window_->setGeometry(QRect(QPoint(0, 0), screenSize));
+
+    fbo_ = new QOpenGLFramebufferObject(screenSize, QOpenGLFramebufferObject::CombinedDepthStencil);
+    window_->setRenderTarget(fbo_);
+    control_->initialize(context_);
+}
+
+void tst_bench_QGeoMapScene::cleanupTestCase()
+{
+    if (control_) {
+        context_->makeCurrent(surface_);
+        delete window_;
+        delete control_;
+        delete fbo_;
+        context_->doneCurrent();
+    }
+    delete surface_;
+    delete context_;
+}
+
+void tst_bench_QGeoMapScene::renderFrame()
+{
+    control_->polishItems();
+    control_->sync();
+    control_->render();
+    context_->functions()->glFinish();
+}
+
+void tst_bench_QGeoMapScene::tiltSweep_data()
+{
+    QTest::addColumn<QSize>("imageSize");
+
+    // tiles matching the slot size, and tiles that have to be scaled on upload
+    QTest::newRow("256px tiles") << QSize(256, 256);
+    QTest::newRow("512px tiles") << QSize(512, 512);
+}
+
+void tst_bench_QGeoMapScene::tiltSweep()
+{
+    QFETCH(QSize, imageSize);
+
+    QImage image(imageSize, QImage::Format_RGB32);
+    image.fill(Qt::darkGreen);
+
+    QGeoCameraTiles cameraTiles;
+    cameraTiles.setMaximumZoomLevel(20);
+    cameraTiles.setTileSize(256);
+    cameraTiles.setScreenSize(screenSize);
+    cameraTiles.setPluginString(QStringLiteral("bench"));
+
+    QGeoMapScene scene;
+    scene.setTileSize(256);
+    scene.setScreenSize(screenSize);
+
+    MapSceneItem *item = new MapSceneItem(&scene);
+    item->setSize(screenSize);
+    item->setParentItem(window_->contentItem());
+
+    int maxTiles = 0;
+    int maxDrawCalls = 0;
+    QBENCHMARK {
+        for (int frame = 0; frame < framesPerSweep; ++frame) {
+            const QGeoCameraData camera = cameraAt(frame);
+            cameraTiles.setCameraData(camera);
+            scene.setCameraData(camera);
+            scene.setVisibleTiles(cameraTiles.visibleTiles());
+
+            foreach (const QGeoTileSpec &spec, cameraTiles.visibleTiles() - scene.texturedTiles()) {
+                QSharedPointer<QGeoTileTexture> texture(new QGeoTileTexture);
+                texture->spec = spec;
+                texture->image = image;
+                scene.addTile(spec, texture);
+            }
+
+            item->update();
+            renderFrame();
+
+            maxTiles = qMax(maxTiles, cameraTiles.visibleTiles().size());
+            if (item->root())
+                maxDrawCalls = qMax(maxDrawCalls, drawCalls(item->root()));
+        }
+    }
+
+    // the point of the atlas: far fewer draw calls than tiles
+    QVERIFY(maxTiles > 0);
+    QVERIFY(maxDrawCalls < maxTiles);
+
+    delete item;
+}
+
+QTEST_MAIN(tst_bench_QGeoMapScene)
+
+#include "tst_bench_qgeomapscene.moc"
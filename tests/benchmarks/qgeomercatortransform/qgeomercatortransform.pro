@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeomercatortransform
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_bench_qgeomercatortransform.cpp
+
+QT += location positioning-private testlib
@@ -0,0 +1,141 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include "qgeomapscene_p.h"
+#include "qgeomercatortransform_p.h"
+#include "qgeocameradata_p.h"
+
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <cmath>
+
+QT_USE_NAMESPACE
+
+/*
+    Measures what a map item with a long track pays to reproject its path
+    while the map pans or zooms. The "per vertex" rows go through
+    QGeoMapScene::mercatorToItemPosition() for every coordinate, which is what
+    QGeoTiledMap::coordinateToItemPosition() does; the other rows convert the
+    track to mercator space once and apply the scene's QGeoMercatorTransform
+    to the whole array for every frame.
+*/
+class tst_bench_QGeoMercatorTransform : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void project_data();
+    void project();
+};
+
+static const int vertices = 50000;
+static const int frames = 10;
+
+static QList<QGeoCoordinate> track()
+{
+    // a wiggly track across central Europe
+    QList<QGeoCoordinate> path;
+    path.reserve(vertices);
+    for (int i = 0; i < vertices; ++i) {
+        const double t = double(i) / vertices;
+        path.append(QGeoCoordinate(47.0 + 4.0 * t + 0.05 * std::sin(i * 0.1),
+                                   5.0 + 15.0 * t + 0.05 * std::cos(i * 0.07)));
+    }
+    return path;
+}
+
+void tst_bench_QGeoMercatorTransform::project_data()
+{
+    QTest::addColumn<bool>("zoom");
+    QTest::addColumn<bool>("perVertex");
+
+    QTest::newRow("pan") << false << false;
+    QTest::newRow("pan per vertex") << false << true;
+    QTest::newRow("zoom") << true << false;
+    QTest::newRow("zoom per vertex") << true << true;
+}
+
+void tst_bench_QGeoMercatorTransform::project()
+{
+    QFETCH(bool, zoom);
+    QFETCH(bool, perVertex);
+
+    const QList<QGeoCoordinate> path = track();
+
+    QVector<double> mercator;
+    mercator.reserve(vertices * 2);
+    foreach (const QGeoCoordinate &coord, path) {
+        QDoubleVector2D m = QGeoProjection::coordToMercator(coord);
+        mercator << m.x() << m.y();
+    }
+    QVector<double> positions(vertices * 2);
+
+    QGeoMapScene scene;
+    scene.setTileSize(256);
+    scene.setScreenSize(QSize(1024, 768));
+
+    QVector<QGeoCameraData> cameras;
+    for (int i = 0; i < frames; ++i) {
+        QGeoCameraData camera;
+        camera.setCenter(QGeoCoordinate(49.0, 12.0 + (zoom ? 0.0 : 0.1 * i)));
+        camera.setZoomLevel(zoom ? 6.0 + 0.1 * i : 8.0);
+        cameras.append(camera);
+    }
+
+    double checksum = 0.0;
+
+    QBENCHMARK {
+        checksum = 0.0;
+        foreach (const QGeoCameraData &camera, cameras) {
+            scene.setCameraData(camera);
+
+            if (perVertex) {
+                for (int i = 0; i < vertices; ++i) {
+                    QDoubleVector2D pos = scene.mercatorToItemPosition(
+                                QGeoProjection::coordToMercator(path.at(i)));
+                    positions[2 * i] = pos.x();
+                    positions[2 * i + 1] = pos.y();
+                }
+            } else {
+                scene.mercatorTransform().map(mercator.constData(), positions.data(), vertices);
+            }
+
+            checksum += positions.at(vertices) + positions.at(vertices + 1);
+        }
+    }
+
+    QVERIFY(qIsFinite(checksum));
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QGeoMercatorTransform)
+
+#include "tst_bench_qgeomercatortransform.moc"
@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qgeotilerequesttable
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_bench_qgeotilerequesttable.cpp
+
+QT += location testlib
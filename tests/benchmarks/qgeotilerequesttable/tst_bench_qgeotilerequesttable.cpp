@@ -0,0 +1,203 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include "qgeotilerequesttable_p.h"
+#include "qgeotilespec_p.h"
+
+QT_USE_NAMESPACE
+
+/*
+    Measures the bookkeeping QGeoTiledMappingManagerEngine does for tile
+    requests while several map views pan over overlapping areas: every step
+    each map drops the column of tiles it left and requests the one it
+    entered, and the tiles requested a few steps earlier finish. The "hash"
+    rows replay the same traffic through the per-map and per-tile QSets the
+    engine used before QGeoTileRequestTable.
+*/
+class tst_bench_QGeoTileRequestTable : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void pan_data();
+    void pan();
+};
+
+static const int columns = 10;
+static const int rows = 6;
+static const int steps = 200;
+static const int finishDelay = 3;
+
+typedef QHash<QGeoTiledMap *, QSet<QGeoTileSpec> > MapHash;
+typedef QHash<QGeoTileSpec, QSet<QGeoTiledMap *> > TileHash;
+
+static QGeoTiledMap *fakeMap(int index)
+{
+    // never dereferenced, only used as a key
+    return reinterpret_cast<QGeoTiledMap *>(quintptr(index + 1) * 16);
+}
+
+static QSet<QGeoTileSpec> column(int x)
+{
+    QSet<QGeoTileSpec> tiles;
+    for (int y = 0; y < rows; ++y)
+        tiles.insert(QGeoTileSpec(QStringLiteral("bench"), 1, 14, 8000 + x, 5000 + y));
+    return tiles;
+}
+
+static void hashUpdate(MapHash &mapHash, TileHash &tileHash, QGeoTiledMap *map,
+                       const QSet<QGeoTileSpec> &added, const QSet<QGeoTileSpec> &removed,
+                       int *requests)
+{
+    QSet<QGeoTileSpec> oldTiles = mapHash.value(map);
+    foreach (const QGeoTileSpec &spec, removed)
+        oldTiles.remove(spec);
+    foreach (const QGeoTileSpec &spec, added)
+        oldTiles.insert(spec);
+    mapHash.insert(map, oldTiles);
+
+    foreach (const QGeoTileSpec &spec, removed) {
+        QSet<QGeoTiledMap *> mapSet = tileHash.value(spec);
+        mapSet.remove(map);
+        if (mapSet.isEmpty())
+            tileHash.remove(spec);
+        else
+            tileHash.insert(spec, mapSet);
+    }
+
+    foreach (const QGeoTileSpec &spec, added) {
+        QSet<QGeoTiledMap *> mapSet = tileHash.value(spec);
+        if (mapSet.isEmpty())
+            ++*requests;
+        mapSet.insert(map);
+        tileHash.insert(spec, mapSet);
+    }
+}
+
+static void hashFinish(MapHash &mapHash, TileHash &tileHash, const QGeoTileSpec &spec)
+{
+    QSet<QGeoTiledMap *> maps = tileHash.value(spec);
+    foreach (QGeoTiledMap *map, maps) {
+        QSet<QGeoTileSpec> tileSet = mapHash.value(map);
+        tileSet.remove(spec);
+        if (tileSet.isEmpty())
+            mapHash.remove(map);
+        else
+            mapHash.insert(map, tileSet);
+    }
+    tileHash.remove(spec);
+}
+
+void tst_bench_QGeoTileRequestTable::pan_data()
+{
+    QTest::addColumn<int>("maps");
+    QTest::addColumn<bool>("hash");
+
+    QTest::newRow("1 map") << 1 << false;
+    QTest::newRow("1 map hash") << 1 << true;
+    QTest::newRow("4 maps") << 4 << false;
+    QTest::newRow("4 maps hash") << 4 << true;
+    QTest::newRow("8 maps") << 8 << false;
+    QTest::newRow("8 maps hash") << 8 << true;
+}
+
+void tst_bench_QGeoTileRequestTable::pan()
+{
+    QFETCH(int, maps);
+    QFETCH(bool, hash);
+
+    // the columns each step touches, prepared outside of the measurement;
+    // maps are two columns apart so their views overlap
+    const int spread = 2 * (maps - 1) + columns + steps + 1;
+    QVector<QSet<QGeoTileSpec> > columnTiles;
+    for (int x = 0; x < spread; ++x)
+        columnTiles.append(column(x));
+
+    int requests = 0;
+    int outstanding = 0;
+
+    QBENCHMARK {
+        QGeoTileRequestTable table;
+        MapHash mapHash;
+        TileHash tileHash;
+        requests = 0;
+
+        for (int step = 0; step < steps; ++step) {
+            for (int m = 0; m < maps; ++m) {
+                const int left = 2 * m + step;
+                if (step == 0) {
+                    for (int x = left; x < left + columns; ++x) {
+                        if (hash) {
+                            hashUpdate(mapHash, tileHash, fakeMap(m), columnTiles.at(x), QSet<QGeoTileSpec>(), &requests);
+                        } else {
+                            foreach (const QGeoTileSpec &spec, columnTiles.at(x))
+                                requests += table.addRef(spec, fakeMap(m));
+                        }
+                    }
+                    continue;
+                }
+
+                const QSet<QGeoTileSpec> &added = columnTiles.at(left + columns - 1);
+                const QSet<QGeoTileSpec> &removed = columnTiles.at(left - 1);
+                if (hash) {
+                    hashUpdate(mapHash, tileHash, fakeMap(m), added, removed, &requests);
+                } else {
+                    foreach (const QGeoTileSpec &spec, removed)
+                        table.release(spec, fakeMap(m));
+                    foreach (const QGeoTileSpec &spec, added)
+                        requests += table.addRef(spec, fakeMap(m));
+                }
+            }
+
+            // the column the last map entered a few steps ago has arrived
+            if (step >= finishDelay) {
+                const int x = 2 * (maps - 1) + step - finishDelay + columns - 1;
+                foreach (const QGeoTileSpec &spec, columnTiles.at(x)) {
+                    if (hash) {
+                        hashFinish(mapHash, tileHash, spec);
+                    } else {
+                        QGeoTileRequestTable::MapList waiting;
+                        table.take(spec, &waiting);
+                    }
+                }
+            }
+        }
+
+        outstanding = hash ? tileHash.size() : table.size();
+    }
+
+    QVERIFY(requests > 0);
+    QVERIFY(outstanding > 0);
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QGeoTileRequestTable)
+
+#include "tst_bench_qgeotilerequesttable.moc"
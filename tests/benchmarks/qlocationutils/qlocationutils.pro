@@ -0,0 +1,7 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_bench_qlocationutils
+
+SOURCES += tst_bench_qlocationutils.cpp
+
+QT += positioning-private testlib
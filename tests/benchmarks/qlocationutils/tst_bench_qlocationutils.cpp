@@ -0,0 +1,140 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include <QtPositioning/qgeopositioninfo.h>
+#include <QtPositioning/private/qlocationutils_p.h>
+
+QT_USE_NAMESPACE
+
+/*
+    Measures QLocationUtils::getPosInfoFromNmea() on the sentences a
+    receiver typically sends. Every iteration parses a batch of
+    sentencesPerBatch sentences, so the reported time per iteration is the
+    time for one thousand sentences; its inverse is thousands of sentences
+    per second.
+*/
+class tst_bench_QLocationUtils : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void getPosInfoFromNmea_data();
+    void getPosInfoFromNmea();
+};
+
+static const int sentencesPerBatch = 1000;
+
+static QByteArray withChecksum(const QByteArray &sentence)
+{
+    // XOR byte value of all characters between '$' and '*'
+    int result = 0;
+    for (int i = 1; i < sentence.size(); ++i)
+        result ^= sentence.at(i);
+    return "$" + sentence + "*" + QByteArray::number(result, 16).rightJustified(2, '0') + "\r\n";
+}
+
+static QByteArray gga(int i)
+{
+    return withChecksum(QString::asprintf("GPGGA,%02d%02d%02d.%02d0,2734.%05d,S,15305.%05d,E,1,08,0.9,%d.%d,M,39.2,M,,",
+                                          (i / 3600) % 24, (i / 60) % 60, i % 60, (i * 10) % 100,
+                                          (i * 37) % 100000, (i * 53) % 100000, 40 + i % 20, i % 10).toLatin1());
+}
+
+static QByteArray rmc(int i)
+{
+    return withChecksum(QString::asprintf("GPRMC,%02d%02d%02d.%02d0,A,2730.%05d,S,15301.%05d,E,%d.%d,%d.%d,%02d%02d16,11.2,W,A",
+                                          (i / 3600) % 24, (i / 60) % 60, i % 60, (i * 10) % 100,
+                                          (i * 37) % 100000, (i * 53) % 100000, i % 30, i % 10,
+                                          i % 360, i % 10, 1 + i % 28, 1 + i % 12).toLatin1());
+}
+
+static QByteArray gsa(int i)
+{
+    return withChecksum(QString::asprintf("GPGSA,A,3,04,05,,09,12,,,24,,,,,%d.%d,%d.%d,%d.%d",
+                                          1 + i % 4, i % 10, 1 + i % 3, i % 10, 1 + i % 5, i % 10).toLatin1());
+}
+
+static QByteArray vtg(int i)
+{
+    return withChecksum(QString::asprintf("GPVTG,%d.%d,T,,M,%d.%d,N,%d.%d,K,A",
+                                          i % 360, i % 10, i % 30, i % 10, i % 55, i % 10).toLatin1());
+}
+
+void tst_bench_QLocationUtils::getPosInfoFromNmea_data()
+{
+    QTest::addColumn<QList<QByteArray> >("sentences");
+
+    QList<QByteArray> ggaSentences;
+    QList<QByteArray> rmcSentences;
+    QList<QByteArray> gsaSentences;
+    QList<QByteArray> mixedSentences;
+    for (int i = 0; i < sentencesPerBatch; ++i) {
+        ggaSentences << gga(i);
+        rmcSentences << rmc(i);
+        gsaSentences << gsa(i);
+        // what a 10 Hz receiver sends in one second, repeated
+        switch (i % 4) {
+        case 0: mixedSentences << gga(i); break;
+        case 1: mixedSentences << rmc(i); break;
+        case 2: mixedSentences << gsa(i); break;
+        default: mixedSentences << vtg(i); break;
+        }
+    }
+
+    QTest::newRow("GGA") << ggaSentences;
+    QTest::newRow("RMC") << rmcSentences;
+    QTest::newRow("GSA") << gsaSentences;
+    QTest::newRow("mixed") << mixedSentences;
+}
+
+void tst_bench_QLocationUtils::getPosInfoFromNmea()
+{
+    QFETCH(QList<QByteArray>, sentences);
+
+    QGeoPositionInfo info;
+    bool hasFix = false;
+    int parsed = 0;
+
+    QBENCHMARK {
+        parsed = 0;
+        foreach (const QByteArray &sentence, sentences) {
+            if (QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(),
+                                                   &info, 5.1, &hasFix)) {
+                ++parsed;
+            }
+        }
+    }
+
+    QCOMPARE(parsed, sentences.count());
+}
+
+QTEST_GUILESS_MAIN(tst_bench_QLocationUtils)
+
+#include "tst_bench_qlocationutils.moc"